@@ -0,0 +1,9 @@
+#pragma once
+
+/// @brief Starts 100k coroutine behaviors that sleep for a random number of ticks or wait on a condition, and
+///        times the scheduler ticking them next to short lived behaviors started and finished every tick
+/// @details Every behavior is checked to wake exactly as often as it should. The same entities as countdowns and
+///          flags looked at every tick, the way the game used to, are timed for comparison.
+/// @param ticks Ticks to run the scheduler for
+/// @return Whether every behavior woke when it should have and steady ticks did not allocate
+bool runBehaviorBenchmark(int ticks);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "game.h"
+#include "input.h"
+#include "navigation.h"
+
+/// @brief Plays both sides of a match: each player follows NavGraph routes to the coin worth the most per tick
+/// @details A little per-bot randomness (hesitating on the ground, jumping when there is nothing to chase) keeps
+///          seeded matches from all playing out alike. A hesitation can cost a player the move it planned, it then
+///          plans again from wherever it lands.
+class BotInput : public IL::InputSource {
+public:
+    /// @param graph Shared by every match the bots play on the same level, it keeps the routes it learns
+    BotInput(uint64_t seed, NavGraph& graph) : graph(graph) { random.Seed(seed); }
+
+    /// @brief Picks the keys both players hold for the next tick, call before every UpdateGame
+    void Think(const State_t& state);
+
+    bool IsKeyDown(IL::Key key) const override;
+
+private:
+    // Left, right and jump for each player
+    static constexpr int KEYS_PER_PLAYER = 3;
+    static constexpr IL::Key PLAYER_KEYS[2][KEYS_PER_PLAYER] = {
+        { IL::KEY_A, IL::KEY_D, IL::KEY_W },
+        { IL::KEY_LEFT, IL::KEY_RIGHT, IL::KEY_UP },
+    };
+
+    NavGraph& graph;
+    NavBot bots[2];
+    std::vector<NavTarget> targets;
+    Random random;
+    bool held[2][KEYS_PER_PLAYER] = {};
+
+    void ThinkFor(const State_t& state, int playerIndex);
+};
@@ -0,0 +1,10 @@
+#pragma once
+
+/// @brief Times full screen redraws of the braille dot plane, per primitive and through a whole canvas frame
+/// @details The SSE2 glyph packing is checked cell for cell against the scalar reference.
+/// @param frames Redraws timed per scene
+/// @return Whether both packing paths agreed
+bool runBrailleBenchmark(int frames);
+
+/// @brief Prints a frame drawn with dots: lines, circles and bitmaps
+void showBrailleDemo();
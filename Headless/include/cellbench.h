@@ -0,0 +1,9 @@
+#pragma once
+
+/// @brief Times LayoutCells on lines of ASCII, CJK, mixed text and surrogate pairs, against the scalar reference
+///        that looks every code point up in the width table
+/// @details Lines are laid out as the canvas does, into a line of the canvas's width, so long lines are cut off.
+///          Both have to lay out every line into the same cells.
+/// @param rounds Times every line is laid out per text kind
+/// @return Whether both laid out every line the same
+bool runCellLayoutBenchmark(int rounds);
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+constexpr float DEFAULT_PERF_THRESHOLD = 0.25f;
+
+/// @brief Checks the image conversions and plays the sessions listed in a golden directory, checking every frame
+///        and the time each phase takes
+/// @details `images.txt` holds one conversion per line: `<image> <dither> <ink> <hash>`, a PGM or PPM file next to it
+///          converted to the canvas size by the SSE2 and the scalar path, which have to agree with each other and the
+///          hash. `sessions.txt` holds one session per line: `<name> <seed> <ticks> <level seed> <input>`, where input
+///          is `default` for the built in script, `bots` for bots on both sides or a key script next to it. Each tick's
+///          presented cells and attributes are hashed and compared with `<name>.golden`, the first frame that differs
+///          is printed as text. Sessions are played several times and the quickest median of each phase (update,
+///          render, hash) is compared with `baseline.txt`.
+/// @param directory Where the sessions, golden hashes and baseline are kept
+/// @param update Write the hashes and timings of this run as the new golden files and baseline instead
+/// @param threshold How much slower than the baseline a phase may get, 0.25 is 25%
+/// @return Whether every image and frame matched and no phase got slower than the threshold allows
+bool runGoldenSessions(const std::string& directory, bool update, float threshold);
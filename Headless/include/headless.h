@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "canvas.h"
+#include "framering.h"
+#include "input.h"
+
+/// @brief Canvas that keeps frames in memory, optionally as ANSI text for a terminal
+class HeadlessCanvas : public IL::Canvas {
+public:
+    /// @param keepAnsi Whether every presented frame is converted to ANSI text, see GetAnsiFrame
+    explicit HeadlessCanvas(bool keepAnsi = false) : keepAnsi(keepAnsi) {}
+
+    /// @brief Frames presented so far
+    uint64_t GetFrameCount() const { return frames; }
+
+    /// @brief The last presented frame as UTF-8 with ANSI escapes, empty unless keepAnsi was set
+    const std::string& GetAnsiFrame() const { return ansi; }
+
+    /// @brief Also publishes every presented frame into a shared memory ring, as Notepad::PublishFrames
+    bool PublishFrames(std::string_view name) { return frameRing.Create(name, IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT); }
+
+protected:
+    void Present() override;
+
+private:
+    bool keepAnsi;
+    uint64_t frames = 0;
+    std::string ansi;
+    IL::FrameRingWriter frameRing;
+};
+
+/// @brief Replays a key script, one step per line: `<ticks> [key...]`
+/// @details Keys are named as in input.h without the prefix (`W`, `LEFT`, `SPACE`, ...), a step without keys
+///          releases everything. `#` starts a comment. The script loops once it runs out.
+class ScriptedInput : public IL::InputSource {
+public:
+    /// @brief Parses a script
+    /// @param script The script text
+    /// @param error Set to a description of the first bad line when parsing fails
+    /// @return Whether the script was valid and holds at least one tick
+    bool Load(std::string_view script, std::string& error);
+
+    /// @brief Moves to the next tick, call once after every UpdateGame
+    void Advance();
+
+    bool IsKeyDown(IL::Key key) const override;
+
+    /// @brief A short match where both players run across the level, jump and turn around
+    static const char* DEFAULT_SCRIPT;
+
+private:
+    struct Step {
+        uint32_t ticks;
+        std::vector<IL::Key> keys;
+    };
+
+    std::vector<Step> steps;
+    size_t step = 0;
+    uint32_t tick = 0;
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "glyphimage.h"
+
+/// @brief Times GlyphConverter on a generated 1920x1080 RGBA frame for every dither mode
+/// @details The SSE2 path is checked cell for cell against the scalar reference, and a hash of each result is
+///          printed so output changes show up between runs.
+/// @param iterations Conversions timed per mode
+/// @return Whether both paths agreed
+bool runImageBenchmark(int iterations);
+
+/// @brief Loads a binary 8-bit PGM (P5) or PPM (P6) image
+/// @param path The file to load
+/// @param pixels Receives the pixel rows
+/// @param image Set to a view of pixels
+bool loadPnm(const std::string& path, std::vector<uint8_t>& pixels, IL::ImageView& image);
+
+/// @brief Converts a binary PGM (P5) or PPM (P6) image to the canvas size and prints it
+bool showImage(const std::string& path, IL::Dither dither);
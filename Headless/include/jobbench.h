@@ -0,0 +1,10 @@
+#pragma once
+
+/// @brief Runs a heavy scene as a per-frame job graph on 1, 2, 4... threads up to the hardware's, timing the
+///        frames, and times the job system's own cost per job
+/// @details The scene is 64k bodies stepped in chunks, 16 particle pools fed from the bodies and a canvas drawing
+///          each pool. Every thread count has to make the same frames as one thread, without allocating once warm.
+///          Counts above the hardware's (at least 4 are always run) are marked as oversubscribed.
+/// @param frames Frames to time per thread count
+/// @return Whether every thread count made the same frames and steady frames did not allocate
+bool runJobBenchmark(int frames);
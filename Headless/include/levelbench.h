@@ -0,0 +1,7 @@
+#pragma once
+
+/// @brief Generates and validates levels from consecutive seeds on every core, for the game's world and a larger
+///        one, then generates a share of them again on one thread to check each seed gives the same level
+/// @param levels Levels to generate for each world
+/// @return Whether every seed gave a valid level and the same one both times
+bool runLevelBenchmark(int levels);
@@ -0,0 +1,11 @@
+#pragma once
+
+/// @brief Logs from 1, 2, 4 and 8 producer threads at once through the lock-free logger into a file, timing each
+///        message, then hammers a single rate limited call site from every thread
+/// @details Each message of the first part comes from a call site of its own so none is rate limited, the ones
+///          the writer could not keep up with are dropped. The file is read back afterwards: every message that was
+///          not dropped has to be in it exactly once, and every call to the hot site has to be written, counted as
+///          suppressed or dropped.
+/// @param messages Messages each producer logs
+/// @return Whether no message went missing
+bool runLogBenchmark(int messages);
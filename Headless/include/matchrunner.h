@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "game.h"
+
+// Runs many independent bot matches across all cores and reduces what happened in them.
+//
+// Every worker owns a range of match indices and takes matches from its front. A worker that runs dry steals the
+// back half of another worker's range, so slow matches or a busy core never leave the others idle. Each worker
+// accumulates its own statistics, which are then merged pairwise in log2(workers) rounds.
+
+struct MatchSetup {
+    uint64_t matches = 10000;
+    uint32_t ticksPerMatch = 3600; // One minute at 60fps
+    uint64_t seed = 1;             // Match i is seeded from seed and i, so results do not depend on the thread count
+    unsigned int threads = 0;      // 0 uses every hardware thread
+    GameRules rules;
+};
+
+struct MatchTotals {
+    static constexpr int SCORE_BUCKET = 10;  // Scores move in steps of 10
+    static constexpr int SCORE_BUCKETS = 256; // The last bucket also holds every higher score
+
+    uint64_t matches = 0;
+    uint64_t ticks = 0;
+    uint64_t wins[2] = {};
+    uint64_t draws = 0;
+    uint64_t coinsSpawned = 0;
+    uint64_t coinsCollected = 0;
+    uint64_t coinsExpired = 0;
+    uint64_t scoreSum[2] = {};
+    uint64_t scoreHistogram[2][SCORE_BUCKETS] = {}; // Final score of each player, SCORE_BUCKET points per bucket
+
+    void Add(const State_t& state);
+    void Merge(const MatchTotals& other);
+
+    /// @brief The score below which a fraction of the player's final scores fall, to bucket precision
+    int ScorePercentile(int player, double fraction) const;
+};
+
+struct MatchReport {
+    MatchTotals totals;
+    unsigned int threads = 0;
+    uint64_t steals = 0; // Ranges taken from another worker
+    double seconds = 0.0;
+};
+
+/// @brief Plays setup.matches bot matches to the end and collects their statistics
+MatchReport runMatches(const MatchSetup& setup);
@@ -0,0 +1,7 @@
+#pragma once
+
+/// @brief Plays 4096 navigation bots on the game's level while the match spawns and expires coins, timing how
+///        long planning every bot's keys takes per frame against a 1 ms budget
+/// @param frames Frames to play
+/// @return Whether planning stayed within the budget on average once the routes were learnt
+bool runNavigationBenchmark(int frames);
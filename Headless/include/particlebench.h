@@ -0,0 +1,7 @@
+#pragma once
+
+/// @brief Runs 100k live particles from fountains, trails and bursts through update and render, every frame
+/// @details A second pool stepped with the scalar update is checked against the SSE2 one frame by frame.
+/// @param frames Frames to simulate
+/// @return Whether both pools drew the same frames
+bool runParticleBenchmark(int frames);
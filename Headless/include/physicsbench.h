@@ -0,0 +1,7 @@
+#pragma once
+
+/// @brief Steps 16k bodies jumping around the game's level, timing the physics step per body
+/// @details A second set stepped with the scalar code is checked against the SSE2 one every tick.
+/// @param ticks Ticks to simulate
+/// @return Whether both sets stayed identical
+bool runPhysicsBenchmark(int ticks);
@@ -0,0 +1,11 @@
+#pragma once
+
+/// @brief Times AppendAnsiFrame on a monochrome frame, a game frame, a frame coloured in runs and a worst case
+///        whose attributes alternate every cell
+/// @details Next to the time and size of each ANSI frame it counts the text calls and DC state changes the
+///          notepad WM_PAINT handler makes for the same frame, which batches runs of equal attributes the same way.
+///          Every ANSI frame has to hold the same text as AppendTextFrame with one escape per run, without
+///          allocating once the output string has grown.
+/// @param frames Frames to time per kind
+/// @return Whether every frame's text and escapes were right and steady frames did not allocate
+bool runPresentBenchmark(int frames);
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+/// @brief Reads every frame published to a shared memory ring until its writer closes it, then reports how many
+///        were read, missed or torn and how long after publishing they were read
+/// @details Waits a while for the ring to appear, so it can be started before the game or a `--publish` run.
+bool watchFrameRing(const std::string& name);
+
+/// @brief Publishes frames as fast as they go and paced, to rings read by one or more consumers on their own
+///        mappings, and reports throughput, missed frames and publish to read latency
+/// @param frames Frames published in each unpaced run
+/// @return Whether no consumer ever validated a frame whose contents were not the frame published
+bool runFrameRingBenchmark(int frames);
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+/// @brief Searches the executable sections of a PE file for random wildcard patterns, with FindSignature and with
+///        the scalar reference, and reports how fast each gets through the bytes
+/// @details Most patterns are cut from the sections themselves with some of their bytes turned into wildcards, so
+///          they are found somewhere along the way, the rest are random and usually scan every byte. Both searches
+///          have to report the same first match for every pattern.
+/// @param path The PE file to read, an .exe or a .dll
+/// @param patterns Patterns to search for
+/// @return Whether the file was a PE image and both searches agreed on every pattern
+bool runSigscanBenchmark(const std::string& path, int patterns);
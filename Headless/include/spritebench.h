@@ -0,0 +1,9 @@
+#pragma once
+
+/// @brief Blits 1k, 10k and 100k players a frame from the compile-time atlas through Canvas::Blit, in every look,
+///        pose and blink and partly off screen, timing each sprite
+/// @details Every frame is compared cell for cell with the same sprites composed one cell at a time from copies
+///          of each atlas entry drawn alone, so clipping and transparency are checked too.
+/// @param frames Frames to time per sprite count
+/// @return Whether every frame matched and steady frames did not allocate
+bool runSpriteBenchmark(int frames);
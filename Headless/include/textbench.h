@@ -0,0 +1,7 @@
+#pragma once
+
+/// @brief Draws a HUD of 48 word wrapped text boxes every frame, laying every box out again versus through the
+///        canvas's layout cache, a few boxes change every frame
+/// @param frames Frames to draw each way
+/// @return Whether both ways drew the same frames
+bool runTextLayoutBenchmark(int frames);
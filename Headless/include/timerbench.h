@@ -0,0 +1,7 @@
+#pragma once
+
+/// @brief Schedules a million timers on a timing wheel, cancels half and runs the wheel until the rest have fired
+/// @details Every timer is checked to fire exactly once and on its deadline. Ticking the same timers as plain
+///          countdowns, the way the game used to, is timed for comparison.
+/// @return Whether every timer fired when it should have
+bool runTimerBenchmark();
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+#include "glyphimage.h"
+
+/// @brief Converts every PGM and PPM in a directory, in file name order, into a glyph video of the canvas size
+bool encodeVideo(const std::string& framesDirectory, const std::string& output, double fps, IL::Dither dither);
+
+/// @brief Plays a glyph video in the terminal at its frame rate
+bool playVideo(const std::string& path);
+
+/// @brief Encodes a generated clip, then times sequential decoding and random seeks and checks every decoded frame
+/// @return Whether every frame decoded to what was encoded
+bool runVideoBenchmark();
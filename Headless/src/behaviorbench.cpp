@@ -0,0 +1,166 @@
+#include "behaviorbench.h"
+#include "allocstats.h"
+#include "behavior.h"
+#include "game.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+    constexpr uint32_t BENCH_BEHAVIORS = 100000;
+    constexpr uint32_t WATCHER_SHARE = 10;     // One in this many waits on a condition rather than sleeping
+    constexpr uint32_t MIN_PERIOD = 60;        // Ticks a sleeper sleeps, about one to ten seconds at 60fps
+    constexpr uint32_t MAX_PERIOD = 600;
+    constexpr uint32_t SIGNALS_PER_TICK = 100; // Watchers whose condition comes true each tick
+    constexpr uint32_t BURSTS_PER_TICK = 500;  // Short lived behaviors started each tick
+    constexpr uint32_t MAX_BURST_TICKS = 32;
+    constexpr int WARMUP_TICKS = 64;           // The pool and the wheel reach their working size
+
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedNs(Clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    struct Entity {
+        uint32_t period = 0; // Sleepers only
+        uint32_t wakes = 0;
+        uint8_t signal = 0;  // Watchers only
+    };
+
+    IL::Behavior Sleeper(IL::BehaviorScheduler&, Entity& entity) {
+        for (;;) {
+            co_await IL::Frames(entity.period);
+            entity.wakes++;
+        }
+    }
+
+    IL::Behavior Watcher(IL::BehaviorScheduler&, Entity& entity) {
+        for (;;) {
+            co_await IL::Until([&entity] { return entity.signal != 0; });
+            entity.signal = 0;
+            entity.wakes++;
+        }
+    }
+
+    IL::Behavior Burst(IL::BehaviorScheduler&, uint32_t ticks, uint64_t& finished) {
+        co_await IL::Frames(ticks);
+        finished++;
+    }
+}
+
+bool runBehaviorBenchmark(int ticks) {
+    Random random;
+    random.Seed(49);
+
+    std::vector<Entity> entities(BENCH_BEHAVIORS);
+    for (uint32_t i = 0; i < BENCH_BEHAVIORS; i++) {
+        if (i % WATCHER_SHARE != 0) {
+            entities[i].period = MIN_PERIOD + random.Next() % (MAX_PERIOD - MIN_PERIOD + 1);
+        }
+    }
+
+    IL::BehaviorScheduler behaviors;
+    behaviors.Reserve(BENCH_BEHAVIORS + BURSTS_PER_TICK * (MAX_BURST_TICKS + 1));
+    std::vector<IL::BehaviorId> ids(BENCH_BEHAVIORS);
+    Clock::time_point start = Clock::now();
+    for (uint32_t i = 0; i < BENCH_BEHAVIORS; i++) {
+        Entity& entity = entities[i];
+        ids[i] = behaviors.Start(entity.period == 0 ? Watcher(behaviors, entity) : Sleeper(behaviors, entity));
+    }
+    double startNs = elapsedNs(start) / BENCH_BEHAVIORS;
+    size_t reserved = behaviors.GetPool().GetReserved();
+
+    // Idle ticks: only sleepers that are due and watchers whose condition came true run
+    uint64_t signalled = 0;
+    double idleNs = 0.0;
+    for (int tick = 0; tick < ticks; tick++) {
+        for (uint32_t s = 0; s < SIGNALS_PER_TICK; s++) {
+            Entity& entity = entities[(random.Next() % (BENCH_BEHAVIORS / WATCHER_SHARE)) * WATCHER_SHARE];
+            signalled += entity.signal == 0 ? 1 : 0;
+            entity.signal = 1;
+        }
+
+        Clock::time_point tickStart = Clock::now();
+        behaviors.Tick();
+        idleNs += elapsedNs(tickStart);
+    }
+
+    bool correct = true;
+    uint64_t wakes = 0;
+    uint64_t watcherWakes = 0;
+    for (const Entity& entity : entities) {
+        if (entity.period != 0) {
+            correct = correct && entity.wakes == static_cast<uint32_t>(ticks) / entity.period;
+            wakes += entity.wakes;
+        } else {
+            watcherWakes += entity.wakes;
+        }
+    }
+    correct = correct && watcherWakes == signalled;
+
+    // The same entities the way the game used to run them: every countdown and flag looked at every tick
+    std::vector<uint32_t> countdowns(BENCH_BEHAVIORS);
+    for (uint32_t i = 0; i < BENCH_BEHAVIORS; i++) {
+        countdowns[i] = entities[i].period;
+    }
+    uint64_t countdownWakes = 0;
+    start = Clock::now();
+    for (int tick = 0; tick < ticks; tick++) {
+        for (uint32_t i = 0; i < BENCH_BEHAVIORS; i++) {
+            Entity& entity = entities[i];
+            if (entity.period != 0) {
+                if (--countdowns[i] == 0) {
+                    countdowns[i] = entity.period;
+                    countdownWakes++;
+                }
+            } else if (entity.signal != 0) {
+                entity.signal = 0;
+                countdownWakes++;
+            }
+        }
+    }
+    double countdownNs = elapsedNs(start) / ticks;
+    correct = correct && countdownWakes == wakes;
+
+    // Churn: short lived behaviors started every tick reuse the frames the finished ones gave back
+    uint64_t finished = 0;
+    uint64_t burstsStarted = 0;
+    uint64_t steadyAllocations = 0;
+    double churnNs = 0.0;
+    for (int tick = 0; tick < WARMUP_TICKS + ticks; tick++) {
+        IL::AllocationScope scope;
+        Clock::time_point tickStart = Clock::now();
+        for (uint32_t b = 0; b < BURSTS_PER_TICK; b++) {
+            behaviors.Start(Burst(behaviors, 1 + random.Next() % MAX_BURST_TICKS, finished));
+        }
+        behaviors.Tick();
+        if (tick >= WARMUP_TICKS) {
+            churnNs += elapsedNs(tickStart);
+            steadyAllocations += scope.GetCount();
+        }
+        burstsStarted += BURSTS_PER_TICK;
+    }
+    size_t live = behaviors.GetRunning();
+    correct = correct && finished + (live - BENCH_BEHAVIORS) == burstsStarted && steadyAllocations == 0;
+
+    start = Clock::now();
+    for (IL::BehaviorId id : ids) {
+        correct = behaviors.Stop(id) && correct;
+    }
+    double stopNs = elapsedNs(start) / BENCH_BEHAVIORS;
+
+    std::printf("%u behaviors: %u sleeping %u-%u ticks, %u waiting on a condition (%u signalled a tick)\n", BENCH_BEHAVIORS,
+        BENCH_BEHAVIORS - BENCH_BEHAVIORS / WATCHER_SHARE, MIN_PERIOD, MAX_PERIOD, BENCH_BEHAVIORS / WATCHER_SHARE, SIGNALS_PER_TICK);
+    std::printf("start     %7.1f ns per behavior, %.1f MiB of pooled frames\n", startNs, reserved / (1024.0 * 1024.0));
+    std::printf("tick      %7.1f us over %d ticks, %.0f sleepers woken and %u conditions checked a tick\n",
+        idleNs / ticks / 1000.0, ticks, static_cast<double>(wakes) / ticks, BENCH_BEHAVIORS / WATCHER_SHARE);
+    std::printf("countdown %7.1f us a tick for the same entities (%.1fx the scheduler)\n", countdownNs / 1000.0,
+        countdownNs / (idleNs / ticks));
+    std::printf("churn     %7.1f us a tick starting and finishing %u more, %llu heap allocations after warming up\n",
+        churnNs / ticks / 1000.0, BURSTS_PER_TICK, static_cast<unsigned long long>(steadyAllocations));
+    std::printf("stop      %7.1f ns per behavior\n", stopNs);
+    std::printf("every behavior woke %s\n", correct ? "when it should have" : "INCORRECTLY");
+    return correct;
+}
@@ -0,0 +1,48 @@
+#include "bot.h"
+
+namespace {
+    constexpr int LEFT = 0;
+    constexpr int RIGHT = 1;
+    constexpr int JUMP = 2;
+
+    constexpr uint32_t HESITATE_PERCENT = 10; // Ticks a standing player stands still
+    constexpr uint32_t EAGER_JUMP_PERCENT = 2; // Ticks a player with nothing to chase jumps
+}
+
+void BotInput::Think(const State_t& state) {
+    graph.Build(state);
+    graph.FindTargets(state, targets);
+    ThinkFor(state, 0);
+    ThinkFor(state, 1);
+}
+
+void BotInput::ThinkFor(const State_t& state, int playerIndex) {
+    bool* keys = held[playerIndex];
+    keys[LEFT] = keys[RIGHT] = keys[JUMP] = false;
+
+    const Player& player = state.players[playerIndex];
+    if (player.physics.isOnGround && random.Next() % 100 < HESITATE_PERCENT) {
+        return;
+    }
+
+    NavBot& bot = bots[playerIndex];
+    NavKeys chosen = bot.Think(graph, player, targets, state.timers.Now());
+    keys[LEFT] = chosen.left;
+    keys[RIGHT] = chosen.right;
+    keys[JUMP] = chosen.jump;
+
+    if (bot.GetTarget() < 0 && player.physics.isOnGround) {
+        keys[JUMP] = random.Next() % 100 < EAGER_JUMP_PERCENT;
+    }
+}
+
+bool BotInput::IsKeyDown(IL::Key key) const {
+    for (int player = 0; player < 2; player++) {
+        for (int i = 0; i < KEYS_PER_PLAYER; i++) {
+            if (PLAYER_KEYS[player][i] == key) {
+                return held[player][i];
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,161 @@
+#include "braillebench.h"
+#include "headless.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr int LINES_PER_FRAME = 1000;
+    constexpr int CIRCLES_PER_FRAME = 200;
+    constexpr int BITMAPS_PER_FRAME = 1000;
+
+    constexpr auto SHIP = IL::BakeBitmap(
+        "......##......",
+        ".....####.....",
+        ".....#..#.....",
+        "....######....",
+        "...##.##.##...",
+        "..##########..",
+        ".####.##.####.",
+        "##############",
+        "#..#......#..#",
+        "#............#");
+
+    struct Shape {
+        int x0, y0, x1, y1;
+    };
+
+    // Shapes are generated up front so the timings only cover drawing, a margin puts some of them off the edges
+    std::vector<Shape> makeShapes(int count, int width, int height, uint32_t seed) {
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<int> xs(-20, width + 20);
+        std::uniform_int_distribution<int> ys(-20, height + 20);
+        std::vector<Shape> shapes(count);
+        for (Shape& shape : shapes) {
+            shape = { xs(random), ys(random), xs(random), ys(random) };
+        }
+        return shapes;
+    }
+
+    uint64_t hashCells(const IL::Cell* cells, size_t count) {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < count; i++) {
+            hash = (hash ^ cells[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    template<typename Fn>
+    double timeUs(int iterations, Fn fn) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            fn();
+        }
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / iterations;
+    }
+
+    void drawLines(IL::BraillePlane& plane, const std::vector<Shape>& shapes, IL::PixelOp op) {
+        for (const Shape& shape : shapes) {
+            plane.Line(shape.x0, shape.y0, shape.x1, shape.y1, op);
+        }
+    }
+
+    void drawCircles(IL::BraillePlane& plane, const std::vector<Shape>& shapes, IL::PixelOp op) {
+        for (const Shape& shape : shapes) {
+            plane.FillCircle(shape.x0, shape.y0, 2 + std::abs(shape.x1) % 30, op);
+        }
+    }
+
+    void drawBitmaps(IL::BraillePlane& plane, const std::vector<Shape>& shapes, IL::PixelOp op) {
+        for (const Shape& shape : shapes) {
+            plane.Blit(SHIP.View(), shape.x0, shape.y0, op);
+        }
+    }
+
+    void printScene(const char* name, double us, double perFrame, const char* unit) {
+        std::printf("%-9s %8.1f us per frame   %8.0f frames/s   %6.1f M%s/s\n", name, us, 1e6 / us, perFrame / us, unit);
+    }
+}
+
+bool runBrailleBenchmark(int frames) {
+    IL::BraillePlane plane(IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT);
+    std::vector<IL::Cell> packed(IL::CANVAS_CELLS);
+    std::vector<IL::Cell> reference(IL::CANVAS_CELLS);
+    int width = plane.GetWidth();
+    int height = plane.GetHeight();
+
+    std::vector<Shape> lines = makeShapes(LINES_PER_FRAME, width, height, 1);
+    std::vector<Shape> circles = makeShapes(CIRCLES_PER_FRAME, width, height, 2);
+    std::vector<Shape> bitmaps = makeShapes(BITMAPS_PER_FRAME, width, height, 3);
+
+    std::printf("%dx%d dots (%dx%d cells), %d frames per scene\n", width, height, IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT, frames);
+
+    // Inverting keeps every frame different from the last without clearing in between
+    double us = timeUs(frames, [&]() { drawLines(plane, lines, IL::PixelOp::Invert); });
+    printScene("lines", us, LINES_PER_FRAME, "lines");
+    us = timeUs(frames, [&]() { drawCircles(plane, circles, IL::PixelOp::Invert); });
+    printScene("circles", us, CIRCLES_PER_FRAME, "circles");
+    us = timeUs(frames, [&]() { drawBitmaps(plane, bitmaps, IL::PixelOp::Invert); });
+    printScene("bitmaps", us, BITMAPS_PER_FRAME, "blits");
+
+    // Packing, checked on a busy frame
+    plane.Clear();
+    drawLines(plane, lines, IL::PixelOp::Set);
+    drawCircles(plane, circles, IL::PixelOp::Invert);
+    drawBitmaps(plane, bitmaps, IL::PixelOp::Invert);
+    double simdUs = timeUs(frames, [&]() { plane.Pack(packed.data()); });
+    double scalarUs = timeUs(frames, [&]() { plane.PackScalar(reference.data()); });
+    uint64_t hash = hashCells(packed.data(), packed.size());
+    bool same = hash == hashCells(reference.data(), reference.size());
+    std::printf("pack      sse2 %6.2f us   scalar %6.2f us   %.1fx   hash %016llx%s\n", simdUs, scalarUs, scalarUs / simdUs,
+        static_cast<unsigned long long>(hash), same ? "" : "   MISMATCH");
+
+    // Whole frames through a canvas: clear, a tenth of each scene, pack and composite
+    HeadlessCanvas canvas;
+    std::vector<Shape> frameLines(lines.begin(), lines.begin() + LINES_PER_FRAME / 10);
+    std::vector<Shape> frameCircles(circles.begin(), circles.begin() + CIRCLES_PER_FRAME / 10);
+    std::vector<Shape> frameBitmaps(bitmaps.begin(), bitmaps.begin() + BITMAPS_PER_FRAME / 10);
+    us = timeUs(frames, [&]() {
+        canvas.Begin();
+        IL::BraillePlane& pixels = canvas.BeginPixels();
+        drawLines(pixels, frameLines, IL::PixelOp::Set);
+        drawCircles(pixels, frameCircles, IL::PixelOp::Invert);
+        drawBitmaps(pixels, frameBitmaps, IL::PixelOp::Set);
+        canvas.End();
+    });
+    std::printf("canvas    %8.1f us per frame   %8.0f frames/s\n", us, 1e6 / us);
+
+    return same;
+}
+
+void showBrailleDemo() {
+    HeadlessCanvas canvas(true);
+    canvas.Begin();
+    IL::BraillePlane& pixels = canvas.BeginPixels();
+    int width = pixels.GetWidth();
+    int height = pixels.GetHeight();
+
+    // A starburst, a ring and a row of ships, with text drawn over the dots on a higher layer
+    for (int i = 0; i < 24; i++) {
+        double angle = i * 3.14159265358979 / 12.0;
+        pixels.Line(width / 4, height / 2, width / 4 + static_cast<int>(70 * std::cos(angle)),
+            height / 2 + static_cast<int>(70 * std::sin(angle)));
+    }
+    pixels.FillCircle(width * 3 / 4, height / 2, 60);
+    pixels.FillCircle(width * 3 / 4, height / 2, 45, IL::PixelOp::Clear);
+    pixels.FillCircle(width * 3 / 4, height / 2, 20, IL::PixelOp::Invert);
+    for (int i = 0; i < 8; i++) {
+        pixels.Blit(SHIP.View(), 10 + i * 40, height - 14 + (i % 2) * 2);
+    }
+
+    canvas.BeginLayer(IL::Layer::HUD);
+    canvas.Text("330x152 dots", 1, 0);
+    canvas.End();
+
+    std::fwrite(canvas.GetAnsiFrame().data(), 1, canvas.GetAnsiFrame().size(), stdout);
+    std::printf("\033[0m\n");
+}
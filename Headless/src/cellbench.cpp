@@ -0,0 +1,128 @@
+#include "cellbench.h"
+#include "canvas.h"
+#include "cellwidth.h"
+#include "game.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+    constexpr int LINES = 4096;
+    constexpr uint32_t MIN_LINE = 8;   // Code units per line, HUD labels up to lines wider than the canvas
+    constexpr uint32_t MAX_LINE = 200;
+
+    using Clock = std::chrono::steady_clock;
+    using Layout = size_t (*)(const IL::Cell* text, size_t count, IL::Cell* out, size_t capacity);
+
+    // Every line back to back, with where each starts
+    struct Text {
+        const char* name;
+        std::vector<IL::Cell> units;
+        std::vector<size_t> starts;
+        size_t cells = 0; // Laid out, summed over the lines
+    };
+
+    void appendCodepoint(char32_t codepoint, std::vector<IL::Cell>& units) {
+        if (codepoint < 0x10000) {
+            units.push_back(static_cast<IL::Cell>(codepoint));
+        } else {
+            units.push_back(static_cast<IL::Cell>(0xD800 + ((codepoint - 0x10000) >> 10)));
+            units.push_back(static_cast<IL::Cell>(0xDC00 + ((codepoint - 0x10000) & 0x3FF)));
+        }
+    }
+
+    char32_t asciiCodepoint(Random& random) {
+        // Words of lower case letters between spaces, with the odd digit or punctuation
+        uint32_t pick = random.Next() % 8;
+        return pick == 0 ? U' ' : pick == 1 ? static_cast<char32_t>(U'!' + random.Next() % 32) : static_cast<char32_t>(U'a' + random.Next() % 26);
+    }
+
+    char32_t cjkCodepoint(Random& random) {
+        return static_cast<char32_t>(0x4E00 + random.Next() % (0x9FFF - 0x4E00 + 1));
+    }
+
+    char32_t surrogateCodepoint(Random& random) {
+        return static_cast<char32_t>(0x1F300 + random.Next() % (0x1F64F - 0x1F300 + 1));
+    }
+
+    // Mostly ASCII words, with accented letters, combining marks, CJK and emoji now and then, as in the HUD
+    char32_t mixedCodepoint(Random& random) {
+        uint32_t pick = random.Next() % 32;
+        if (pick == 0) return cjkCodepoint(random);
+        if (pick == 1) return surrogateCodepoint(random);
+        if (pick == 2) return static_cast<char32_t>(0xE0 + random.Next() % 0x20);
+        if (pick == 3) return static_cast<char32_t>(0x300 + random.Next() % 0x70);
+        return asciiCodepoint(random);
+    }
+
+    Text makeText(const char* name, char32_t (*codepoint)(Random&), Random& random) {
+        Text text;
+        text.name = name;
+        for (int line = 0; line < LINES; line++) {
+            text.starts.push_back(text.units.size());
+            size_t end = text.units.size() + MIN_LINE + random.Next() % (MAX_LINE - MIN_LINE + 1);
+            while (text.units.size() < end) {
+                appendCodepoint(codepoint(random), text.units);
+            }
+        }
+        text.starts.push_back(text.units.size());
+        return text;
+    }
+
+    // Lays every line out into its own canvas wide line of out, returning the time per code unit
+    double timeLayout(Layout layout, const Text& text, int rounds, std::vector<IL::Cell>& out, size_t& cells) {
+        Clock::time_point start = Clock::now();
+        for (int round = 0; round < rounds; round++) {
+            cells = 0;
+            for (int line = 0; line < LINES; line++) {
+                size_t begin = text.starts[line];
+                cells += layout(&text.units[begin], text.starts[line + 1] - begin, &out[line * IL::CANVAS_WIDTH], IL::CANVAS_WIDTH);
+            }
+        }
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (static_cast<double>(rounds) * text.units.size());
+    }
+}
+
+bool runCellLayoutBenchmark(int rounds) {
+    Random random;
+    random.Seed(29);
+    Text texts[] = {
+        makeText("ascii", asciiCodepoint, random),
+        makeText("cjk", cjkCodepoint, random),
+        makeText("mixed", mixedCodepoint, random),
+        makeText("surrogates", surrogateCodepoint, random),
+    };
+
+    std::printf("%d lines of %u-%u code units per kind into lines of %d cells, %d rounds\n", LINES, MIN_LINE, MAX_LINE,
+        IL::CANVAS_WIDTH, rounds);
+    std::printf("text        scalar ns/unit  ascii runs ns/unit  speedup     cells\n");
+    bool identical = true;
+    std::vector<IL::Cell> scalarCells(LINES * IL::CANVAS_WIDTH);
+    std::vector<IL::Cell> fastCells(LINES * IL::CANVAS_WIDTH);
+    for (const Text& text : texts) {
+        size_t scalarCount = 0;
+        size_t fastCount = 0;
+        double scalarNs = timeLayout(IL::LayoutCellsScalar, text, rounds, scalarCells, scalarCount);
+        double fastNs = timeLayout(IL::LayoutCells, text, rounds, fastCells, fastCount);
+
+        // Only the cells each line wrote count, the rest of its line is left over from an earlier text
+        bool same = scalarCount == fastCount;
+        for (int line = 0; line < LINES && same; line++) {
+            size_t begin = text.starts[line];
+            size_t count = text.starts[line + 1] - begin;
+            size_t cells = IL::LayoutCellsScalar(&text.units[begin], count, nullptr, IL::CANVAS_WIDTH);
+            same = IL::LayoutCells(&text.units[begin], count, nullptr, IL::CANVAS_WIDTH) == cells;
+            for (size_t cell = 0; cell < cells && same; cell++) {
+                same = scalarCells[line * IL::CANVAS_WIDTH + cell] == fastCells[line * IL::CANVAS_WIDTH + cell];
+            }
+        }
+        identical = identical && same;
+
+        std::printf("%-10s  %14.2f  %18.2f  %6.2fx  %8zu%s\n", text.name, scalarNs, fastNs, scalarNs / fastNs, fastCount,
+            same ? "" : "  DIFFER");
+    }
+
+    std::printf("layouts %s\n", identical ? "identical" : "DIFFER");
+    return identical;
+}
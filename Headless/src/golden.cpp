@@ -0,0 +1,524 @@
+#include "golden.h"
+#include "bot.h"
+#include "headless.h"
+#include "imagebench.h"
+#include "present.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string_view>
+#include <vector>
+
+namespace {
+    constexpr int RUNS = 5;                    // Plays of each session, the quickest median of every phase counts
+    constexpr double MIN_REGRESSION_NS = 500.0; // Slower by less than this is timer noise, even past the threshold
+
+    using Clock = std::chrono::steady_clock;
+
+    enum Phase {
+        PHASE_UPDATE = 0, // Bots thinking included
+        PHASE_RENDER,     // Drawing, compositing and presenting
+        PHASE_HASH,
+        PHASES,
+    };
+
+    constexpr const char* PHASE_NAMES[PHASES] = { "update", "render", "hash" };
+
+    struct Session {
+        std::string name;
+        unsigned int seed = 0;
+        uint32_t ticks = 0;
+        uint32_t levelSeed = 0;
+        std::string input; // default, bots or a script file
+    };
+
+    struct Played {
+        std::vector<uint64_t> hashes;
+        int64_t diverged = -1; // The first tick whose frame differs from the golden one
+        std::string frame;     // That frame as text
+        double medians[PHASES] = {};
+    };
+
+    struct BaselineEntry {
+        std::string session;
+        std::string phase;
+        double ns;
+    };
+
+    struct ImageCase {
+        std::string image; // A PGM or PPM file in the golden directory
+        std::string dither;
+        std::string ink;   // dark as in notepad, or light as --image prints to a terminal
+        uint64_t hash = 0;
+    };
+
+    struct DitherName {
+        IL::Dither dither;
+        const char* name;
+    };
+
+    constexpr DitherName DITHER_NAMES[] = {
+        { IL::Dither::None, "none" },
+        { IL::Dither::Ordered, "ordered" },
+        { IL::Dither::ErrorDiffusion, "diffusion" },
+    };
+
+    bool readText(const std::string& path, std::string& contents) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+
+        std::ostringstream stream;
+        stream << file.rdbuf();
+        contents = stream.str();
+        return true;
+    }
+
+    // Calls line(words, lineNumber) for every line that is not blank or a `#` comment
+    template<typename F>
+    bool forEachLine(std::string_view text, F&& line) {
+        int lineNumber = 0;
+        while (!text.empty()) {
+            size_t end = std::min(text.find('\n'), text.size());
+            std::string_view current = text.substr(0, end);
+            text.remove_prefix(std::min(end + 1, text.size()));
+            lineNumber++;
+
+            current = current.substr(0, std::min(current.find('#'), current.size()));
+            std::vector<std::string_view> words;
+            for (size_t start = current.find_first_not_of(" \t\r"); start != std::string_view::npos;
+                 start = current.find_first_not_of(" \t\r", start)) {
+                size_t wordEnd = std::min(current.find_first_of(" \t\r", start), current.size());
+                words.push_back(current.substr(start, wordEnd - start));
+                start = wordEnd;
+            }
+
+            if (!words.empty() && !line(words, lineNumber)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<typename T>
+    bool parseWord(std::string_view word, T& value, int base = 10) {
+        auto result = std::from_chars(word.data(), word.data() + word.size(), value, base);
+        return result.ec == std::errc() && result.ptr == word.data() + word.size();
+    }
+
+    bool parseWord(std::string_view word, double& value) {
+        std::string copy(word);
+        char* end = nullptr;
+        value = std::strtod(copy.c_str(), &end);
+        return end != copy.c_str() && *end == '\0';
+    }
+
+    bool loadSessions(const std::string& directory, std::vector<Session>& sessions) {
+        std::string path = directory + "/sessions.txt";
+        std::string text;
+        if (!readText(path, text)) {
+            std::fprintf(stderr, "Failed to read %s\n", path.c_str());
+            return false;
+        }
+
+        return forEachLine(text, [&](const std::vector<std::string_view>& words, int lineNumber) {
+            Session session;
+            if (words.size() != 5 || !parseWord(words[1], session.seed) || !parseWord(words[2], session.ticks) ||
+                session.ticks == 0 || !parseWord(words[3], session.levelSeed)) {
+                std::fprintf(stderr, "%s:%d: expected '<name> <seed> <ticks> <level seed> <input>'\n", path.c_str(), lineNumber);
+                return false;
+            }
+            session.name = words[0];
+            session.input = words[4];
+            sessions.push_back(std::move(session));
+            return true;
+        });
+    }
+
+    bool loadGolden(const std::string& path, std::vector<uint64_t>& hashes) {
+        std::string text;
+        if (!readText(path, text)) {
+            return false;
+        }
+
+        return forEachLine(text, [&](const std::vector<std::string_view>& words, int lineNumber) {
+            uint64_t hash;
+            if (words.size() != 1 || !parseWord(words[0], hash, 16)) {
+                std::fprintf(stderr, "%s:%d: expected a hash\n", path.c_str(), lineNumber);
+                return false;
+            }
+            hashes.push_back(hash);
+            return true;
+        });
+    }
+
+    bool loadBaseline(const std::string& path, std::vector<BaselineEntry>& baseline) {
+        std::string text;
+        if (!readText(path, text)) {
+            return false;
+        }
+
+        return forEachLine(text, [&](const std::vector<std::string_view>& words, int lineNumber) {
+            BaselineEntry entry;
+            if (words.size() != 3 || !parseWord(words[2], entry.ns)) {
+                std::fprintf(stderr, "%s:%d: expected '<session> <phase> <ns>'\n", path.c_str(), lineNumber);
+                return false;
+            }
+            entry.session = words[0];
+            entry.phase = words[1];
+            baseline.push_back(std::move(entry));
+            return true;
+        });
+    }
+
+    bool loadImageCases(const std::string& path, std::vector<ImageCase>& cases) {
+        std::string text;
+        if (!readText(path, text)) {
+            std::fprintf(stderr, "Failed to read %s\n", path.c_str());
+            return false;
+        }
+
+        return forEachLine(text, [&](const std::vector<std::string_view>& words, int lineNumber) {
+            ImageCase imageCase;
+            if (words.size() != 4 || !parseWord(words[3], imageCase.hash, 16)) {
+                std::fprintf(stderr, "%s:%d: expected '<image> <dither> <ink> <hash>'\n", path.c_str(), lineNumber);
+                return false;
+            }
+            imageCase.image = words[0];
+            imageCase.dither = words[1];
+            imageCase.ink = words[2];
+            cases.push_back(std::move(imageCase));
+            return true;
+        });
+    }
+
+    bool writeImageCases(const std::string& path, const std::vector<ImageCase>& cases) {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            std::fprintf(stderr, "Failed to create %s\n", path.c_str());
+            return false;
+        }
+
+        std::fprintf(file, "# Image conversions --golden checks: <image> <dither> <ink> <hash>\n");
+        std::fprintf(file, "# Each image is converted to the canvas size by Convert and ConvertScalar, which have to agree. The hash\n");
+        std::fprintf(file, "# is of the glyphs, written by --golden-update\n");
+        for (const ImageCase& imageCase : cases) {
+            std::fprintf(file, "%-13s %-10s %-6s %016llx\n", imageCase.image.c_str(), imageCase.dither.c_str(),
+                imageCase.ink.c_str(), static_cast<unsigned long long>(imageCase.hash));
+        }
+        return std::fclose(file) == 0;
+    }
+
+    constexpr uint64_t MULTIPLIER = 0x9E3779B97F4A7C15ull;
+
+    uint64_t mix(uint64_t hash, uint64_t value) {
+        hash = (hash ^ value) * MULTIPLIER;
+        return hash ^ (hash >> 29);
+    }
+
+    // Eight bytes per multiply as TextLayoutCache keys its text, in four lanes so the multiplies do not wait on
+    // each other, a single chain took half as long as rendering the frame
+    void hashPlane(const void* data, size_t size, uint64_t (&lanes)[4]) {
+        const char* bytes = static_cast<const char*>(data);
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            uint64_t words[4];
+            memcpy(words, bytes + i, sizeof(words));
+            for (int lane = 0; lane < 4; lane++) {
+                lanes[lane] = mix(lanes[lane], words[lane]);
+            }
+        }
+        for (; i < size; i += 8) {
+            uint64_t word = 0;
+            memcpy(&word, bytes + i, std::min<size_t>(8, size - i));
+            lanes[0] = mix(lanes[0], word);
+        }
+    }
+
+    uint64_t hashFrame(const HeadlessCanvas& canvas) {
+        constexpr size_t CELLS = static_cast<size_t>(IL::CANVAS_WIDTH) * IL::CANVAS_HEIGHT;
+        uint64_t lanes[4] = { CELLS, 1, 2, 3 };
+        hashPlane(canvas.GetCells(), CELLS * sizeof(IL::Cell), lanes);
+        hashPlane(canvas.GetAttrs(), CELLS * sizeof(IL::CellAttr), lanes);
+
+        uint64_t hash = 0;
+        for (uint64_t lane : lanes) {
+            hash = mix(hash, lane);
+        }
+        return hash;
+    }
+
+    uint64_t hashGlyphs(const IL::GlyphConverter& converter) {
+        size_t cells = static_cast<size_t>(converter.GetColumns()) * converter.GetRows();
+        uint64_t lanes[4] = { cells, 1, 2, 3 };
+        hashPlane(converter.GetCells(), cells * sizeof(IL::Cell), lanes);
+
+        uint64_t hash = 0;
+        for (uint64_t lane : lanes) {
+            hash = mix(hash, lane);
+        }
+        return hash;
+    }
+
+    // Converts every image case with both paths and compares the glyphs with the golden hash, or records them
+    bool checkImages(const std::string& directory, bool update) {
+        std::string path = directory + "/images.txt";
+        std::vector<ImageCase> cases;
+        if (!loadImageCases(path, cases)) {
+            return false;
+        }
+
+        bool ok = true;
+        IL::GlyphConverter simd(IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT);
+        IL::GlyphConverter scalar(IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT);
+        for (ImageCase& imageCase : cases) {
+            IL::GlyphOptions options;
+            const DitherName* dither = std::find_if(std::begin(DITHER_NAMES), std::end(DITHER_NAMES),
+                [&](const DitherName& name) { return imageCase.dither == name.name; });
+            if (dither == std::end(DITHER_NAMES) || (imageCase.ink != "dark" && imageCase.ink != "light")) {
+                std::fprintf(stderr, "%s: dither has to be none, ordered or diffusion and ink dark or light\n", path.c_str());
+                return false;
+            }
+            options.dither = dither->dither;
+            options.darkInk = imageCase.ink == "dark";
+
+            std::vector<uint8_t> pixels;
+            IL::ImageView image;
+            std::string imagePath = directory + "/" + imageCase.image;
+            if (!loadPnm(imagePath, pixels, image)) {
+                std::fprintf(stderr, "Failed to load %s, only binary 8-bit PGM and PPM are supported\n", imagePath.c_str());
+                return false;
+            }
+
+            simd.Convert(image, options);
+            scalar.ConvertScalar(image, options);
+            uint64_t hash = hashGlyphs(simd);
+            bool agreed = hash == hashGlyphs(scalar);
+            bool matched = update || hash == imageCase.hash;
+            std::printf("%-13s %-10s %-6s glyphs %s%s\n", imageCase.image.c_str(), imageCase.dither.c_str(),
+                imageCase.ink.c_str(), update ? "written" : matched ? "match" : "DIFFER",
+                agreed ? "" : ", SSE2 AND SCALAR DISAGREE");
+            if (!matched) {
+                std::printf("  %016llx, golden %016llx\n", static_cast<unsigned long long>(hash),
+                    static_cast<unsigned long long>(imageCase.hash));
+            }
+            ok = ok && agreed && matched;
+            imageCase.hash = hash;
+        }
+
+        if (update) {
+            return writeImageCases(path, cases) && ok;
+        }
+        return ok;
+    }
+
+    double median(std::vector<double>& samples) {
+        std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+        return samples[samples.size() / 2];
+    }
+
+    // Plays a session once, comparing each frame with golden when it is not empty
+    void play(const Session& session, const std::string& script, const std::vector<uint64_t>& golden, Played& played) {
+        bool bots = session.input == "bots";
+        ScriptedInput scripted;
+        std::string error;
+        scripted.Load(script, error);
+
+        GameRules rules;
+        rules.levelSeed = session.levelSeed;
+        State_t state;
+        InitializeGame(state, session.seed, rules);
+        NavGraph graph;
+        BotInput botInput(session.seed, graph);
+        const IL::InputSource& input = bots ? static_cast<const IL::InputSource&>(botInput) : scripted;
+
+        HeadlessCanvas canvas;
+        std::vector<double> samples[PHASES];
+        for (std::vector<double>& phase : samples) {
+            phase.reserve(session.ticks);
+        }
+        played.hashes.clear();
+        played.hashes.reserve(session.ticks);
+
+        for (uint32_t tick = 0; tick < session.ticks; tick++) {
+            Clock::time_point start = Clock::now();
+            if (bots) {
+                botInput.Think(state);
+            }
+            UpdateGame(state, input);
+            Clock::time_point updated = Clock::now();
+            RenderGame(state, canvas);
+            Clock::time_point rendered = Clock::now();
+            uint64_t hash = hashFrame(canvas);
+            Clock::time_point hashed = Clock::now();
+            scripted.Advance();
+
+            samples[PHASE_UPDATE].push_back(std::chrono::duration<double, std::nano>(updated - start).count());
+            samples[PHASE_RENDER].push_back(std::chrono::duration<double, std::nano>(rendered - updated).count());
+            samples[PHASE_HASH].push_back(std::chrono::duration<double, std::nano>(hashed - rendered).count());
+            played.hashes.push_back(hash);
+
+            if (played.diverged < 0 && !golden.empty() && (tick >= golden.size() || golden[tick] != hash)) {
+                played.diverged = tick;
+                IL::AppendTextFrame(canvas.GetCells(), IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT, played.frame);
+            }
+        }
+
+        for (int phase = 0; phase < PHASES; phase++) {
+            played.medians[phase] = median(samples[phase]);
+        }
+    }
+
+    bool writeGolden(const std::string& path, const Session& session, const std::vector<uint64_t>& hashes) {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            std::fprintf(stderr, "Failed to create %s\n", path.c_str());
+            return false;
+        }
+
+        std::fprintf(file, "# %s: seed %u, %u ticks, level seed %u, %s input\n", session.name.c_str(), session.seed,
+            session.ticks, session.levelSeed, session.input.c_str());
+        std::fprintf(file, "# One hash of the presented cells and attributes per tick, written by --golden-update\n");
+        for (uint64_t hash : hashes) {
+            std::fprintf(file, "%016llx\n", static_cast<unsigned long long>(hash));
+        }
+        return std::fclose(file) == 0;
+    }
+
+    bool writeBaseline(const std::string& path, const std::vector<BaselineEntry>& baseline) {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            std::fprintf(stderr, "Failed to create %s\n", path.c_str());
+            return false;
+        }
+
+        std::fprintf(file, "# Median nanoseconds per tick of each phase, the quickest of %d plays, written by --golden-update\n", RUNS);
+        for (const BaselineEntry& entry : baseline) {
+            std::fprintf(file, "%s %s %.0f\n", entry.session.c_str(), entry.phase.c_str(), entry.ns);
+        }
+        return std::fclose(file) == 0;
+    }
+
+    const BaselineEntry* findBaseline(const std::vector<BaselineEntry>& baseline, const std::string& session, const char* phase) {
+        for (const BaselineEntry& entry : baseline) {
+            if (entry.session == session && entry.phase == phase) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+}
+
+bool runGoldenSessions(const std::string& directory, bool update, float threshold) {
+    std::vector<Session> sessions;
+    if (!loadSessions(directory, sessions)) {
+        return false;
+    }
+
+    std::string baselinePath = directory + "/baseline.txt";
+    std::vector<BaselineEntry> baseline;
+    if (!update && !loadBaseline(baselinePath, baseline)) {
+        std::fprintf(stderr, "Failed to read %s, write one with --golden-update\n", baselinePath.c_str());
+        return false;
+    }
+
+    bool ok = checkImages(directory, update);
+    std::vector<BaselineEntry> measured;
+    for (const Session& session : sessions) {
+        std::string script = ScriptedInput::DEFAULT_SCRIPT;
+        if (session.input != "default" && session.input != "bots") {
+            std::string scriptPath = directory + "/" + session.input;
+            if (!readText(scriptPath, script)) {
+                std::fprintf(stderr, "%s: failed to read %s\n", session.name.c_str(), scriptPath.c_str());
+                return false;
+            }
+        }
+
+        ScriptedInput check;
+        std::string error;
+        if (!check.Load(script, error)) {
+            std::fprintf(stderr, "%s: bad script: %s\n", session.name.c_str(), error.c_str());
+            return false;
+        }
+
+        std::string goldenPath = directory + "/" + session.name + ".golden";
+        std::vector<uint64_t> golden;
+        if (!update && !loadGolden(goldenPath, golden)) {
+            std::fprintf(stderr, "%s: failed to read %s, write it with --golden-update\n", session.name.c_str(), goldenPath.c_str());
+            ok = false;
+            continue;
+        }
+
+        // Every play has to give the same frames, what is compared with the baseline is the quickest
+        Played first;
+        play(session, script, golden, first);
+        double best[PHASES];
+        std::copy(std::begin(first.medians), std::end(first.medians), best);
+        bool repeatable = true;
+        for (int run = 1; run < RUNS; run++) {
+            Played again;
+            play(session, script, {}, again);
+            repeatable = repeatable && again.hashes == first.hashes;
+            for (int phase = 0; phase < PHASES; phase++) {
+                best[phase] = std::min(best[phase], again.medians[phase]);
+            }
+        }
+
+        bool matched = golden.size() == first.hashes.size() && first.diverged < 0;
+        const char* verdict = update ? "written" : matched ? "match" : "DIFFER";
+        std::printf("%-12s %6u ticks  frames %s%s\n", session.name.c_str(), session.ticks, verdict,
+            repeatable ? "" : ", NOT REPEATABLE between plays");
+        ok = ok && repeatable;
+
+        if (!update && !matched) {
+            ok = false;
+            if (first.diverged >= 0) {
+                uint64_t expected = static_cast<uint64_t>(first.diverged) < golden.size() ? golden[first.diverged] : 0;
+                std::printf("  first different frame on tick %lld: %016llx, golden %016llx\n", static_cast<long long>(first.diverged),
+                    static_cast<unsigned long long>(first.hashes[first.diverged]), static_cast<unsigned long long>(expected));
+                std::fwrite(first.frame.data(), 1, first.frame.size(), stdout);
+            } else {
+                std::printf("  golden holds %zu ticks, the session played %u\n", golden.size(), session.ticks);
+            }
+        }
+
+        for (int phase = 0; phase < PHASES; phase++) {
+            measured.push_back({ session.name, PHASE_NAMES[phase], best[phase] });
+            if (update) {
+                std::printf("  %-8s %9.2f us\n", PHASE_NAMES[phase], best[phase] / 1000.0);
+                continue;
+            }
+
+            const BaselineEntry* entry = findBaseline(baseline, session.name, PHASE_NAMES[phase]);
+            if (!entry) {
+                std::printf("  %-8s %9.2f us  no baseline\n", PHASE_NAMES[phase], best[phase] / 1000.0);
+                ok = false;
+                continue;
+            }
+
+            bool regressed = best[phase] > entry->ns * (1.0 + threshold) && best[phase] - entry->ns > MIN_REGRESSION_NS;
+            double change = entry->ns > 0.0 ? 100.0 * (best[phase] - entry->ns) / entry->ns : 0.0;
+            std::printf("  %-8s %9.2f us  baseline %9.2f us  %+6.1f%%%s\n", PHASE_NAMES[phase], best[phase] / 1000.0,
+                entry->ns / 1000.0, change, regressed ? "  REGRESSED" : "");
+            ok = ok && !regressed;
+        }
+
+        if (update && !writeGolden(goldenPath, session, first.hashes)) {
+            return false;
+        }
+    }
+
+    if (update) {
+        return writeBaseline(baselinePath, measured) && ok;
+    }
+
+    std::printf("%s (threshold %.0f%%)\n", ok ? "passed" : "FAILED", 100.0 * threshold);
+    return ok;
+}
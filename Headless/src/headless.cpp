@@ -0,0 +1,125 @@
+#include "headless.h"
+#include "present.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace {
+    struct KeyName {
+        const char* name;
+        IL::Key key;
+    };
+
+    constexpr KeyName KEY_NAMES[] = {
+        { "UP", IL::KEY_UP }, { "DOWN", IL::KEY_DOWN }, { "LEFT", IL::KEY_LEFT }, { "RIGHT", IL::KEY_RIGHT },
+        { "W", IL::KEY_W }, { "A", IL::KEY_A }, { "S", IL::KEY_S }, { "D", IL::KEY_D },
+        { "SPACE", IL::KEY_SPACE }, { "ENTER", IL::KEY_ENTER }, { "ESCAPE", IL::KEY_ESCAPE },
+    };
+
+    bool findKey(std::string_view name, IL::Key& key) {
+        for (const KeyName& entry : KEY_NAMES) {
+            if (name == entry.name) {
+                key = entry.key;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Splits off the next whitespace separated word
+    std::string_view nextWord(std::string_view& text) {
+        size_t start = text.find_first_not_of(" \t\r");
+        if (start == std::string_view::npos) {
+            text = {};
+            return {};
+        }
+        size_t end = std::min(text.find_first_of(" \t\r", start), text.size());
+        std::string_view word = text.substr(start, end - start);
+        text.remove_prefix(end);
+        return word;
+    }
+}
+
+const char* ScriptedInput::DEFAULT_SCRIPT =
+    "# P1 runs right while P2 runs left, both jumping now and then\n"
+    "40 D LEFT\n"
+    "1 D W LEFT UP\n"
+    "30 D LEFT\n"
+    "10\n"
+    "40 A RIGHT\n"
+    "1 A W RIGHT UP\n"
+    "30 A RIGHT\n"
+    "20 W UP\n";
+
+void HeadlessCanvas::Present() {
+    frames++;
+    if (keepAnsi) {
+        ansi.clear();
+        IL::AppendAnsiFrame(GetCells(), GetAttrs(), IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT, ansi);
+    }
+    frameRing.Publish(GetCells(), GetAttrs());
+}
+
+bool ScriptedInput::Load(std::string_view script, std::string& error) {
+    steps.clear();
+    step = 0;
+    tick = 0;
+
+    size_t lineNumber = 0;
+    while (!script.empty()) {
+        size_t end = std::min(script.find('\n'), script.size());
+        std::string_view line = script.substr(0, end);
+        script.remove_prefix(std::min(end + 1, script.size()));
+        lineNumber++;
+
+        line = line.substr(0, std::min(line.find('#'), line.size()));
+        std::string_view word = nextWord(line);
+        if (word.empty()) {
+            continue;
+        }
+
+        Step parsed = {};
+        auto result = std::from_chars(word.data(), word.data() + word.size(), parsed.ticks);
+        if (result.ec != std::errc() || result.ptr != word.data() + word.size() || parsed.ticks == 0) {
+            error = "line " + std::to_string(lineNumber) + ": expected a tick count, got '" + std::string(word) + "'";
+            return false;
+        }
+
+        for (word = nextWord(line); !word.empty(); word = nextWord(line)) {
+            IL::Key key;
+            if (!findKey(word, key)) {
+                error = "line " + std::to_string(lineNumber) + ": unknown key '" + std::string(word) + "'";
+                return false;
+            }
+            parsed.keys.push_back(key);
+        }
+        steps.push_back(std::move(parsed));
+    }
+
+    if (steps.empty()) {
+        error = "script holds no steps";
+        return false;
+    }
+    return true;
+}
+
+void ScriptedInput::Advance() {
+    if (steps.empty()) {
+        return;
+    }
+
+    if (++tick >= steps[step].ticks) {
+        tick = 0;
+        step = (step + 1) % steps.size();
+    }
+}
+
+bool ScriptedInput::IsKeyDown(IL::Key key) const {
+    if (steps.empty()) {
+        return false;
+    }
+
+    const std::vector<IL::Key>& keys = steps[step].keys;
+    return std::find(keys.begin(), keys.end(), key) != keys.end();
+}
@@ -0,0 +1,157 @@
+#include "imagebench.h"
+#include "headless.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+namespace {
+    constexpr int BENCH_WIDTH = 1920;
+    constexpr int BENCH_HEIGHT = 1080;
+
+    struct DitherMode {
+        IL::Dither dither;
+        const char* name;
+    };
+
+    constexpr DitherMode DITHER_MODES[] = {
+        { IL::Dither::None, "none" },
+        { IL::Dither::Ordered, "ordered" },
+        { IL::Dither::ErrorDiffusion, "diffusion" },
+    };
+
+    // Gradients, a soft disc and stripes, enough to exercise every glyph
+    std::vector<uint8_t> makeTestFrame() {
+        std::vector<uint8_t> pixels(static_cast<size_t>(BENCH_WIDTH) * BENCH_HEIGHT * 4);
+        for (int y = 0; y < BENCH_HEIGHT; y++) {
+            for (int x = 0; x < BENCH_WIDTH; x++) {
+                double dx = x - BENCH_WIDTH * 0.6;
+                double dy = y - BENCH_HEIGHT * 0.5;
+                double disc = std::exp(-(dx * dx + dy * dy) / (2.0 * 220.0 * 220.0));
+                double stripes = ((x / 40 + y / 90) % 2 == 0 && x < BENCH_WIDTH / 4) ? 0.3 : 0.0;
+                double horizontal = static_cast<double>(x) / BENCH_WIDTH;
+                double vertical = static_cast<double>(y) / BENCH_HEIGHT;
+
+                uint8_t* pixel = &pixels[(static_cast<size_t>(y) * BENCH_WIDTH + x) * 4];
+                pixel[0] = static_cast<uint8_t>(std::fmin(255.0, 255.0 * (0.6 * horizontal + disc + stripes)));
+                pixel[1] = static_cast<uint8_t>(std::fmin(255.0, 255.0 * (0.5 * vertical + 0.8 * disc + stripes)));
+                pixel[2] = static_cast<uint8_t>(std::fmin(255.0, 255.0 * (0.3 + 0.4 * horizontal * vertical + stripes)));
+                pixel[3] = 255;
+            }
+        }
+        return pixels;
+    }
+
+    // FNV-1a over the glyphs
+    uint64_t hashCells(const IL::GlyphConverter& converter) {
+        uint64_t hash = 14695981039346656037ull;
+        size_t count = static_cast<size_t>(converter.GetColumns()) * converter.GetRows();
+        for (size_t i = 0; i < count; i++) {
+            hash = (hash ^ converter.GetCells()[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    template<typename Fn>
+    double timeMs(int iterations, Fn fn) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            fn();
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / iterations;
+    }
+
+    bool readToken(std::istream& stream, int& value) {
+        // Skips whitespace and # comments between header fields
+        while (true) {
+            int c = stream.peek();
+            if (c == '#') {
+                std::string comment;
+                std::getline(stream, comment);
+            } else if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+                stream.get();
+            } else {
+                break;
+            }
+        }
+        return static_cast<bool>(stream >> value);
+    }
+}
+
+bool loadPnm(const std::string& path, std::vector<uint8_t>& pixels, IL::ImageView& image) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[2] = {};
+    if (!file.read(magic, 2) || magic[0] != 'P' || (magic[1] != '5' && magic[1] != '6')) {
+        return false;
+    }
+
+    int width = 0, height = 0, maxValue = 0;
+    if (!readToken(file, width) || !readToken(file, height) || !readToken(file, maxValue) || maxValue != 255 ||
+        width <= 0 || height <= 0) {
+        return false;
+    }
+    file.get(); // The single whitespace before the raster
+
+    image.format = magic[1] == '5' ? IL::PixelFormat::Gray8 : IL::PixelFormat::Rgb8;
+    image.width = width;
+    image.height = height;
+    image.stride = static_cast<size_t>(width) * (magic[1] == '5' ? 1 : 3);
+    pixels.resize(image.stride * height);
+    if (!file.read(reinterpret_cast<char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()))) {
+        return false;
+    }
+    image.pixels = pixels.data();
+    return true;
+}
+
+bool runImageBenchmark(int iterations) {
+    std::vector<uint8_t> pixels = makeTestFrame();
+    IL::ImageView image = { pixels.data(), BENCH_WIDTH, BENCH_HEIGHT, static_cast<size_t>(BENCH_WIDTH) * 4, IL::PixelFormat::Rgba8 };
+
+    IL::GlyphConverter simd(IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT);
+    IL::GlyphConverter scalar(IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT);
+
+    std::printf("%dx%d RGBA -> %dx%d cells, %d iterations\n", BENCH_WIDTH, BENCH_HEIGHT, IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT, iterations);
+    bool agreed = true;
+    for (const DitherMode& mode : DITHER_MODES) {
+        IL::GlyphOptions options;
+        options.dither = mode.dither;
+
+        double simdMs = timeMs(iterations, [&]() { simd.Convert(image, options); });
+        double scalarMs = timeMs(iterations, [&]() { scalar.ConvertScalar(image, options); });
+        uint64_t hash = hashCells(simd);
+        bool same = hash == hashCells(scalar);
+        agreed = agreed && same;
+
+        std::printf("%-10s sse2 %6.3f ms   scalar %6.3f ms   %.1fx   hash %016llx%s\n", mode.name, simdMs, scalarMs,
+            scalarMs / simdMs, static_cast<unsigned long long>(hash), same ? "" : "   MISMATCH");
+    }
+    return agreed;
+}
+
+bool showImage(const std::string& path, IL::Dither dither) {
+    std::vector<uint8_t> pixels;
+    IL::ImageView image;
+    if (!loadPnm(path, pixels, image)) {
+        std::fprintf(stderr, "Failed to load %s, only binary 8-bit PGM and PPM are supported\n", path.c_str());
+        return false;
+    }
+
+    IL::GlyphConverter converter(IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT);
+    IL::GlyphOptions options;
+    options.dither = dither;
+    options.darkInk = false; // Terminals draw light glyphs on a dark background
+    converter.Convert(image, options);
+
+    HeadlessCanvas canvas(true);
+    canvas.Begin();
+    canvas.Blit(converter.View(), 0, 0, false);
+    canvas.End();
+
+    std::fwrite(canvas.GetAnsiFrame().data(), 1, canvas.GetAnsiFrame().size(), stdout);
+    std::printf("\033[0m\n");
+    return true;
+}
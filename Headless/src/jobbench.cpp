@@ -0,0 +1,274 @@
+#include "jobbench.h"
+#include "allocstats.h"
+#include "canvas.h"
+#include "jobs.h"
+#include "particles.h"
+#include "physics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr int SCENE_CHUNKS = 64;
+    constexpr size_t CHUNK_BODIES = 1024;
+    constexpr int SCENE_POOLS = 16;
+    constexpr int CHUNKS_PER_POOL = SCENE_CHUNKS / SCENE_POOLS;
+    constexpr size_t POOL_BODIES = CHUNK_BODIES * CHUNKS_PER_POOL;
+    constexpr size_t POOL_PARTICLES = 16384;
+    constexpr int BURSTS_PER_POOL = 48;  // Each frame, from the pool's bodies in turn
+    constexpr int SCENE_LEDGES = 24;
+    constexpr int WARMUP_FRAMES = 30;    // The pools fill up
+    constexpr unsigned int MIN_THREADS = 4; // Run even on smaller machines, so stealing is always exercised
+    constexpr int OVERHEAD_JOBS = 4000;
+    constexpr int OVERHEAD_RUNS = 50;
+
+    constexpr IL::EmitterConfig SPARKS = { .rate = 8.0f, .speedMin = 0.1f, .speedMax = 0.6f, .lifeMin = 20, .lifeMax = 40 };
+
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedNs(Clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    // FNV-1a, to compare frames made on different thread counts
+    uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // Two scenes built from the same seed and run for the same frames stay identical, whatever runs them
+    struct Scene {
+        std::vector<IL::Fixed> y, velocityY;
+        std::vector<int32_t> left, right, height;
+        std::vector<uint8_t> grounded;
+        std::vector<IL::Ledge> ledges;
+        IL::FallRules fall = { IL::ToFixed(0.25f), IL::CellsToFixed(2), IL::CANVAS_HEIGHT - 1 };
+        IL::Fixed jump = IL::ToFixed(-3.0f);
+        std::vector<IL::ParticlePool> pools;
+        std::vector<std::unique_ptr<IL::OffscreenCanvas>> canvases; // One per pool, its particles and bodies
+        std::vector<int32_t> splatIndices;                          // Where each body is drawn, by pool
+        std::vector<IL::Cell> splatCells;
+        std::vector<IL::CellAttr> splatAttrs;
+        uint64_t frame = 0;
+
+        explicit Scene(uint32_t seed) {
+            std::mt19937 random(seed);
+            size_t bodies = CHUNK_BODIES * SCENE_CHUNKS;
+            for (size_t i = 0; i < bodies; i++) {
+                int x = static_cast<int>(random() % (IL::CANVAS_WIDTH - 1));
+                y.push_back(static_cast<IL::Fixed>(random() % IL::CellsToFixed(IL::CANVAS_HEIGHT - 2)));
+                velocityY.push_back(0);
+                left.push_back(x);
+                right.push_back(x + 1);
+                height.push_back(1);
+                grounded.push_back(0);
+            }
+            for (int i = 0; i < SCENE_LEDGES; i++) {
+                int x = static_cast<int>(random() % (IL::CANVAS_WIDTH - 20));
+                ledges.push_back({ x, x + 8 + static_cast<int>(random() % 12), 4 + static_cast<int>(random() % (IL::CANVAS_HEIGHT - 8)) });
+            }
+
+            pools.reserve(SCENE_POOLS);
+            for (int i = 0; i < SCENE_POOLS; i++) {
+                pools.emplace_back(POOL_PARTICLES, seed + i);
+                pools.back().AddStyle(u"*+:.", { IL::Color::Yellow, IL::Color::Default, 0 });
+                canvases.push_back(std::make_unique<IL::OffscreenCanvas>());
+            }
+            splatIndices.resize(bodies);
+            splatCells.assign(POOL_BODIES, u'o');
+            splatAttrs.assign(POOL_BODIES, IL::DEFAULT_ATTR);
+        }
+
+        // Falls, and whatever landed jumps again so the scene stays busy
+        void StepChunk(int chunk) {
+            size_t first = chunk * CHUNK_BODIES;
+            IL::BodyArrays bodies = { &y[first], &velocityY[first], &left[first], &right[first], &height[first], &grounded[first], CHUNK_BODIES };
+            IL::StepBodies(bodies, fall, ledges.data(), ledges.size());
+            for (size_t i = first; i < first + CHUNK_BODIES; i++) {
+                if (grounded[i]) {
+                    velocityY[i] = jump;
+                }
+            }
+        }
+
+        // Sparks fly from the pool's bodies where they are now
+        void UpdatePool(int pool) {
+            IL::ParticlePool& particles = pools[pool];
+            size_t first = pool * POOL_BODIES;
+            for (int b = 0; b < BURSTS_PER_POOL; b++) {
+                size_t body = first + (frame * BURSTS_PER_POOL + b) % POOL_BODIES;
+                particles.Burst(SPARKS, left[body] + 0.5f, IL::FixedToCell(y[body]) + 0.5f);
+            }
+            particles.Update();
+        }
+
+        void RenderPool(int pool) {
+            IL::OffscreenCanvas& canvas = *canvases[pool];
+            canvas.Begin();
+            canvas.BeginLayer(IL::Layer::World);
+            pools[pool].Render(canvas);
+
+            size_t first = pool * POOL_BODIES;
+            for (size_t i = 0; i < POOL_BODIES; i++) {
+                int row = IL::FixedToCell(y[first + i]);
+                splatIndices[first + i] = row < IL::CANVAS_HEIGHT ? row * IL::CANVAS_WIDTH + left[first + i] : -1;
+            }
+            canvas.BeginLayer(IL::Layer::Entities);
+            canvas.Splat(&splatIndices[first], splatCells.data(), splatAttrs.data(), POOL_BODIES);
+            canvas.End();
+        }
+
+        // Chunks fall side by side, each pool waits for its own chunks and is drawn as soon as it is updated
+        void BuildFrame(IL::JobGraph& graph) {
+            graph.Clear();
+            IL::JobIndex chunks[SCENE_CHUNKS];
+            for (int c = 0; c < SCENE_CHUNKS; c++) {
+                chunks[c] = graph.Add([this, c] { StepChunk(c); });
+            }
+            for (int p = 0; p < SCENE_POOLS; p++) {
+                IL::JobIndex update = graph.Add([this, p] { UpdatePool(p); });
+                for (int c = p * CHUNKS_PER_POOL; c < (p + 1) * CHUNKS_PER_POOL; c++) {
+                    graph.Depend(update, chunks[c]);
+                }
+                graph.Depend(graph.Add([this, p] { RenderPool(p); }), update);
+            }
+        }
+
+        uint64_t Hash() const {
+            uint64_t hash = 14695981039346656037ull;
+            hash = hashBytes(hash, y.data(), y.size() * sizeof(IL::Fixed));
+            for (const std::unique_ptr<IL::OffscreenCanvas>& canvas : canvases) {
+                hash = hashBytes(hash, canvas->GetCells(), IL::CANVAS_CELLS * sizeof(IL::Cell));
+                hash = hashBytes(hash, canvas->GetAttrs(), IL::CANVAS_CELLS * sizeof(IL::CellAttr));
+            }
+            return hash;
+        }
+    };
+
+    struct SceneRun {
+        double frameNs = 0.0;
+        uint64_t hash = 0;            // Of every timed frame
+        uint64_t allocations = 0;     // After warming up
+        size_t jobs = 0;
+        size_t particles = 0;
+    };
+
+    SceneRun runScene(IL::JobSystem& system, int frames) {
+        Scene scene(50);
+        IL::JobGraph graph;
+        graph.Reserve(SCENE_CHUNKS + SCENE_POOLS * 2, SCENE_CHUNKS + SCENE_POOLS);
+
+        SceneRun run;
+        for (int frame = 0; frame < WARMUP_FRAMES + frames; frame++) {
+            IL::AllocationScope scope;
+            Clock::time_point start = Clock::now();
+            scene.BuildFrame(graph);
+            system.Run(graph);
+            double ns = elapsedNs(start);
+            scene.frame++;
+
+            if (frame >= WARMUP_FRAMES) {
+                run.frameNs += ns;
+                run.allocations += scope.GetCount();
+                run.hash = hashBytes(run.hash, &scene.frame, sizeof(scene.frame)) ^ scene.Hash();
+            }
+        }
+
+        run.frameNs /= frames;
+        run.jobs = graph.GetCount();
+        for (const IL::ParticlePool& pool : scene.pools) {
+            run.particles += pool.GetCount();
+        }
+        return run;
+    }
+
+    // Empty jobs, so all that is timed is the system: side by side, then each waiting on the one before
+    void timeOverhead(IL::JobSystem& system, double& wideNs, double& chainNs, double& buildNs) {
+        IL::JobGraph wide;
+        wide.Reserve(OVERHEAD_JOBS, 0);
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < OVERHEAD_JOBS; i++) {
+            wide.Add([] {});
+        }
+        buildNs = elapsedNs(start) / OVERHEAD_JOBS;
+
+        uint64_t count = 0;
+        IL::JobGraph chain;
+        chain.Reserve(OVERHEAD_JOBS, OVERHEAD_JOBS);
+        for (int i = 0; i < OVERHEAD_JOBS; i++) {
+            IL::JobIndex job = chain.Add([&count] { count++; });
+            if (i > 0) {
+                chain.Depend(job, job - 1);
+            }
+        }
+
+        system.Run(wide);
+        start = Clock::now();
+        for (int run = 0; run < OVERHEAD_RUNS; run++) {
+            system.Run(wide);
+        }
+        wideNs = elapsedNs(start) / (static_cast<double>(OVERHEAD_RUNS) * OVERHEAD_JOBS);
+
+        system.Run(chain);
+        start = Clock::now();
+        for (int run = 0; run < OVERHEAD_RUNS; run++) {
+            system.Run(chain);
+        }
+        chainNs = elapsedNs(start) / (static_cast<double>(OVERHEAD_RUNS) * OVERHEAD_JOBS);
+    }
+}
+
+bool runJobBenchmark(int frames) {
+    unsigned int hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned int> counts;
+    for (unsigned int threads = 1; threads < std::max(hardware, MIN_THREADS); threads *= 2) {
+        counts.push_back(threads);
+    }
+    counts.push_back(std::max(hardware, MIN_THREADS));
+
+    std::printf("%zu bodies in %d chunks, %d particle pools of up to %zu, %d frames on 1 to %u threads (%u in hardware)\n",
+        CHUNK_BODIES * SCENE_CHUNKS, SCENE_CHUNKS, SCENE_POOLS, POOL_PARTICLES, frames, counts.back(), hardware);
+    std::printf("threads  frame us  speedup  efficiency\n");
+
+    bool identical = true;
+    uint64_t allocations = 0;
+    double serialNs = 0.0;
+    uint64_t serialHash = 0;
+    SceneRun last;
+    for (unsigned int threads : counts) {
+        IL::JobSystem system(threads - 1);
+        SceneRun run = runScene(system, frames);
+        if (threads == 1) {
+            serialNs = run.frameNs;
+            serialHash = run.hash;
+        }
+        identical = identical && run.hash == serialHash;
+        allocations += run.allocations;
+        last = run;
+
+        double speedup = serialNs / run.frameNs;
+        std::printf("%7u  %8.1f  %6.2fx  %9.0f%%%s\n", threads, run.frameNs / 1000.0, speedup, 100.0 * speedup / threads,
+            threads > hardware ? "  oversubscribed" : "");
+    }
+    std::printf("%zu jobs a frame, %zu particles alive at the end\n", last.jobs, last.particles);
+
+    for (unsigned int threads : { 1u, std::max(hardware, MIN_THREADS) }) {
+        IL::JobSystem system(threads - 1);
+        double wideNs, chainNs, buildNs;
+        timeOverhead(system, wideNs, chainNs, buildNs);
+        std::printf("overhead on %u thread%s: %.0f ns a job side by side, %.0f ns a job in a chain, %.0f ns to add one\n",
+            threads, threads == 1 ? "" : "s", wideNs, chainNs, buildNs);
+    }
+
+    std::printf("frames %s, %llu heap allocations after warming up\n", identical ? "identical on every thread count" : "DIFFER",
+        static_cast<unsigned long long>(allocations));
+    return identical && allocations == 0;
+}
@@ -0,0 +1,125 @@
+#include "levelbench.h"
+#include "levelgen.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr int RECHECKED_LEVELS = 256; // Generated again on one thread
+    constexpr uint64_t FIRST_SEED = 1;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct World {
+        const char* name;
+        LevelSpec spec;
+    };
+
+    // FNV-1a over the platforms, equal for equal levels
+    uint64_t hashLevel(const std::vector<Platform>& platforms) {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (const Platform& platform : platforms) {
+            for (int value : { platform.x, platform.y, platform.width, platform.height }) {
+                hash = (hash ^ static_cast<uint32_t>(value)) * 0x100000001B3ull;
+            }
+        }
+        return hash;
+    }
+
+    // Own cache line each, counted on every level
+    struct alignas(64) Tally {
+        uint64_t valid = 0;
+        uint64_t candidates = 0;
+        uint64_t repairs = 0;
+        uint64_t platforms = 0;
+        double coverage = 0.0;
+    };
+
+    bool runWorld(const World& world, int levels, unsigned int threads) {
+        std::vector<uint64_t> hashes(levels);
+        std::vector<Tally> tallies(threads);
+        std::atomic<int> next = 0;
+
+        auto work = [&](unsigned int self) {
+            LevelGenerator generator(world.spec);
+            std::vector<Platform> platforms;
+            GameRules rules;
+            Tally& tally = tallies[self];
+            for (int i = next.fetch_add(1, std::memory_order_relaxed); i < levels; i = next.fetch_add(1, std::memory_order_relaxed)) {
+                LevelReport report = generator.Generate(FIRST_SEED + i, rules, platforms);
+                hashes[i] = hashLevel(platforms);
+                tally.valid += report.valid ? 1 : 0;
+                tally.candidates += report.candidates;
+                tally.repairs += report.repairs;
+                tally.platforms += platforms.size();
+                tally.coverage += report.airCoverage;
+            }
+        };
+
+        Clock::time_point start = Clock::now();
+        std::vector<std::thread> workers;
+        for (unsigned int t = 1; t < threads; t++) {
+            workers.emplace_back(work, t);
+        }
+        work(0);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        Tally total;
+        for (const Tally& tally : tallies) {
+            total.valid += tally.valid;
+            total.candidates += tally.candidates;
+            total.repairs += tally.repairs;
+            total.platforms += tally.platforms;
+            total.coverage += tally.coverage;
+        }
+
+        // The same seeds on one thread, after the others warmed up their generators differently
+        LevelGenerator generator(world.spec);
+        std::vector<Platform> platforms;
+        int rechecked = std::min(levels, RECHECKED_LEVELS);
+        int same = 0;
+        for (int i = 0; i < rechecked; i++) {
+            generator.Generate(FIRST_SEED + i, GameRules(), platforms);
+            same += hashLevel(platforms) == hashes[i] ? 1 : 0;
+        }
+
+        std::printf("%-8s %3dx%-3d %8.0f levels/s %9.0f candidates/s  %5.1f%% valid  %.2f candidates  %.2f repairs  %4.1f platforms  %3.0f%% air  %s\n",
+            world.name, world.spec.width, world.spec.floor, levels / seconds, total.candidates / seconds,
+            100.0 * total.valid / levels, static_cast<double>(total.candidates) / levels, static_cast<double>(total.repairs) / levels,
+            static_cast<double>(total.platforms) / levels, 100.0 * total.coverage / levels,
+            same == rechecked ? "deterministic" : "NOT DETERMINISTIC");
+        return same == rechecked && total.valid == static_cast<uint64_t>(levels);
+    }
+}
+
+bool runLevelBenchmark(int levels) {
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+
+    World wide = { "wide", {} };
+    wide.spec.width = 160;
+    wide.spec.floor = 60;
+    wide.spec.minPlatforms = 16;
+    wide.spec.maxPlatforms = 28;
+    const World worlds[] = { { "game", {} }, wide };
+
+    // For comparison, the hand-placed level checked against the game world's spec
+    State_t original;
+    InitializeGame(original, 1);
+    LevelReport handPlaced = LevelGenerator().Validate(original.platforms, original.rules);
+    std::printf("hand-placed level: %s, %d unreachable platforms, %d unreachable coin spots, %.0f%% of the air reachable\n",
+        handPlaced.valid ? "valid" : "invalid", handPlaced.unreachable, handPlaced.unreachableCoins, 100.0 * handPlaced.airCoverage);
+    std::printf("%d levels per world on %u threads\n", levels, threads);
+
+    bool ok = true;
+    for (const World& world : worlds) {
+        ok = runWorld(world, levels, threads) && ok;
+    }
+    return ok;
+}
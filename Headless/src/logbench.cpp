@@ -0,0 +1,181 @@
+#include "logbench.h"
+#include "log.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr unsigned int MAX_PRODUCERS = 8;
+    constexpr int HOT_CALLS = 200000; // Calls per producer to the one rate limited site
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Run {
+        double messageNs = 0.0; // Per message, averaged over the producers
+        uint64_t dropped = 0;   // Because the ring was full
+        uint64_t written = 0;
+        uint64_t missing = 0;   // Neither written nor dropped, or written twice
+    };
+
+    struct HotRun {
+        double callNs = 0.0;
+        uint64_t written = 0;
+        uint64_t suppressed = 0; // Rate limited or repeats, reported with the next message written or still pending
+        uint64_t dropped = 0;
+    };
+
+    double elapsedNs(Clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    // Starts the producers together and returns the time each spent logging
+    template<typename Produce>
+    std::vector<double> runProducers(unsigned int producers, Produce produce) {
+        std::vector<double> ns(producers);
+        std::atomic<unsigned int> ready = 0;
+        std::vector<std::thread> threads;
+        for (unsigned int p = 0; p < producers; p++) {
+            threads.emplace_back([&, p] {
+                ready.fetch_add(1);
+                while (ready.load() < producers) {
+                    std::this_thread::yield();
+                }
+                Clock::time_point start = Clock::now();
+                produce(p);
+                ns[p] = elapsedNs(start);
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        return ns;
+    }
+
+    double average(const std::vector<double>& values) {
+        double sum = 0.0;
+        for (double value : values) {
+            sum += value;
+        }
+        return sum / values.size();
+    }
+
+    Run runUnlimited(const std::filesystem::path& path, unsigned int producers, int messages) {
+        // One site per message, so nothing is rate limited or folded
+        std::deque<IL::LogSite> sites;
+        for (unsigned int i = 0; i < producers * static_cast<unsigned int>(messages); i++) {
+            sites.emplace_back("runLogBenchmark", __FILE__, static_cast<int>(i));
+        }
+
+        Run run;
+        std::filesystem::remove(path);
+        uint64_t droppedBefore = IL::Logger::Dropped();
+        {
+            IL::Logger logger(path.string());
+            std::vector<double> ns = runProducers(producers, [&](unsigned int producer) {
+                for (int i = 0; i < messages; i++) {
+                    IL::LogSite& site = sites[producer * messages + i];
+                    IL::Logger::Write(site, IL::LogLevel::Info, "message {} from producer {}", i, producer);
+                }
+            });
+            run.messageNs = average(ns) / messages;
+        }
+        run.dropped = IL::Logger::Dropped() - droppedBefore;
+
+        // Every message written once, and written plus dropped accounts for all of them
+        std::vector<uint8_t> seen(producers * messages);
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            size_t at = line.find("] message ");
+            int index = 0;
+            unsigned int producer = 0;
+            if (at == std::string::npos || std::sscanf(line.c_str() + at, "] message %d from producer %u", &index, &producer) != 2 ||
+                producer >= producers || index < 0 || index >= messages) {
+                continue;
+            }
+
+            uint8_t& count = seen[producer * messages + index];
+            run.missing += count != 0 ? 1 : 0;
+            count = 1;
+            run.written++;
+        }
+        uint64_t sent = static_cast<uint64_t>(producers) * messages;
+        run.missing += run.written + run.dropped > sent ? run.written + run.dropped - sent : sent - run.written - run.dropped;
+        return run;
+    }
+
+    HotRun runHot(const std::filesystem::path& path, unsigned int producers) {
+        // A site of its own, so each run starts with a fresh rate limit window
+        IL::LogSite site("runLogBenchmark", __FILE__, __LINE__);
+
+        HotRun run;
+        std::filesystem::remove(path);
+        uint64_t droppedBefore = IL::Logger::Dropped();
+        {
+            IL::Logger logger(path.string());
+            std::vector<double> ns = runProducers(producers, [&site](unsigned int producer) {
+                for (int i = 0; i < HOT_CALLS; i++) {
+                    IL::Logger::Write(site, IL::LogLevel::Warning, "hot {} from producer {}", i, producer);
+                }
+            });
+            run.callNs = average(ns) / HOT_CALLS;
+        }
+        run.dropped = IL::Logger::Dropped() - droppedBefore;
+        run.suppressed = site.suppressed.exchange(0);
+
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.find("] hot ") == std::string::npos) {
+                continue;
+            }
+            run.written++;
+
+            size_t at = line.find(" [");
+            unsigned int suppressed = 0;
+            while (at != std::string::npos && std::sscanf(line.c_str() + at, " [%u similar messages suppressed]", &suppressed) != 1) {
+                at = line.find(" [", at + 1);
+            }
+            run.suppressed += at != std::string::npos ? suppressed : 0;
+        }
+        return run;
+    }
+}
+
+bool runLogBenchmark(int messages) {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "inbetweenlines-logbench.log";
+    unsigned int hardware = std::thread::hardware_concurrency();
+
+    std::printf("%d messages per producer, each from a site of its own, through a ring of %zu (%u in hardware)\n",
+        messages, IL::Logger::CAPACITY, hardware);
+    std::printf("producers  ns/message   written   dropped  missing\n");
+    bool correct = true;
+    for (unsigned int producers = 1; producers <= MAX_PRODUCERS; producers *= 2) {
+        Run run = runUnlimited(path, producers, messages);
+        std::printf("%9u  %10.1f  %8llu  %8llu  %7llu\n", producers, run.messageNs, static_cast<unsigned long long>(run.written),
+            static_cast<unsigned long long>(run.dropped), static_cast<unsigned long long>(run.missing));
+        correct = correct && run.missing == 0;
+    }
+
+    std::printf("\n%d calls per producer to one site, rate limited to %u messages a second\n", HOT_CALLS, IL::Logger::MAX_PER_SECOND);
+    std::printf("producers     ns/call   written  suppressed   dropped\n");
+    for (unsigned int producers = 1; producers <= MAX_PRODUCERS; producers *= 2) {
+        HotRun run = runHot(path, producers);
+        uint64_t calls = static_cast<uint64_t>(producers) * HOT_CALLS;
+        std::printf("%9u  %10.1f  %8llu  %10llu  %8llu\n", producers, run.callNs, static_cast<unsigned long long>(run.written),
+            static_cast<unsigned long long>(run.suppressed), static_cast<unsigned long long>(run.dropped));
+        correct = correct && run.written + run.suppressed + run.dropped == calls;
+    }
+
+    std::filesystem::remove(path);
+    std::printf("every message %s\n", correct ? "written or counted as dropped" : "NOT ACCOUNTED FOR");
+    return correct;
+}
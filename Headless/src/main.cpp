@@ -0,0 +1,582 @@
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "allocstats.h"
+#include "game.h"
+#include "behaviorbench.h"
+#include "braillebench.h"
+#include "cellbench.h"
+#include "golden.h"
+#include "headless.h"
+#include "imagebench.h"
+#include "jobbench.h"
+#include "levelbench.h"
+#include "logbench.h"
+#include "matchrunner.h"
+#include "navbench.h"
+#include "particlebench.h"
+#include "physicsbench.h"
+#include "presentbench.h"
+#include "ringtool.h"
+#include "sigscanbench.h"
+#include "spritebench.h"
+#include "textbench.h"
+#include "timerbench.h"
+#include "videotool.h"
+
+// Runs the game without notepad, as fast as it goes, and reports how many ticks it simulated per second.
+// With --matches it instead plays many bot matches in parallel and reports balance statistics and throughput.
+
+constexpr uint64_t DEFAULT_TICKS = 100000;
+constexpr unsigned int DEFAULT_SEED = 1;
+constexpr int IMAGE_BENCH_ITERATIONS = 200;
+constexpr int BRAILLE_BENCH_FRAMES = 200;
+constexpr int PARTICLE_BENCH_FRAMES = 600;
+constexpr int TEXT_BENCH_FRAMES = 2000;
+constexpr int PHYSICS_BENCH_TICKS = 2000;
+constexpr int NAV_BENCH_FRAMES = 600;
+constexpr int LEVEL_BENCH_LEVELS = 4000;
+constexpr int RING_BENCH_FRAMES = 20000;
+constexpr int BEHAVIOR_BENCH_TICKS = 1200;
+constexpr int JOB_BENCH_FRAMES = 300;
+constexpr int SIGSCAN_BENCH_PATTERNS = 512;
+constexpr int LOG_BENCH_MESSAGES = 20000;
+constexpr int PRESENT_BENCH_FRAMES = 2000;
+constexpr int CELL_BENCH_ROUNDS = 200;
+constexpr int SPRITE_BENCH_FRAMES = 100;
+constexpr double DEFAULT_VIDEO_FPS = 30.0;
+constexpr uint64_t ALLOC_WARMUP_TICKS = 600; // Containers reach their working size within the first ten seconds
+
+struct Options {
+    uint64_t ticks = DEFAULT_TICKS;
+    bool ticksSet = false;
+    unsigned int seed = DEFAULT_SEED;
+    std::string scriptPath;
+    bool render = true;
+    bool dump = false;
+    bool checkAllocs = false;
+    unsigned int jobThreads = 0;
+    uint64_t matches = 0;
+    unsigned int threads = 0;
+    GameRules rules;
+    bool benchImage = false;
+    std::string imagePath;
+    IL::Dither dither = IL::Dither::Ordered;
+    bool benchVideo = false;
+    std::string encodeVideoPath;
+    std::string framesDirectory;
+    double fps = DEFAULT_VIDEO_FPS;
+    std::string playVideoPath;
+    bool benchBraille = false;
+    bool brailleDemo = false;
+    bool benchParticles = false;
+    bool benchSprites = false;
+    bool benchTimers = false;
+    bool benchBehaviors = false;
+    bool benchJobs = false;
+    bool benchLog = false;
+    bool benchText = false;
+    bool benchPresent = false;
+    bool benchCells = false;
+    std::string sigscanPath;
+    bool benchPhysics = false;
+    bool benchNav = false;
+    bool benchLevels = false;
+    std::string goldenDirectory;
+    bool goldenUpdate = false;
+    std::string publishName;
+    std::string watchName;
+    bool benchRing = false;
+    float perfThreshold = DEFAULT_PERF_THRESHOLD;
+};
+
+void printUsage(const char* program) {
+    std::printf(
+        "Usage: %s [options]\n"
+        "  --ticks N      Ticks to simulate (default: %llu)\n"
+        "  --seed S       Random seed, the same seed and script replay the same match (default: %u)\n"
+        "  --script PATH  Key script, one '<ticks> [key...]' step per line (default: a built in demo)\n"
+        "  --no-render    Only run the simulation, skip drawing\n"
+        "  --dump         Print the last frame to the terminal\n"
+        "  --publish NAME Also publish every frame to the shared memory ring NAME\n"
+        "  --check-allocs Fail if any tick after the first %llu allocates\n"
+        "  --jobs T       Update and render each tick as a job graph on T threads, the frames are the same\n"
+        "\n"
+        "Mass simulation, bots play both sides:\n"
+        "  --matches N    Matches to play, --ticks is then the length of each (default: %u)\n"
+        "  --threads T    Worker threads (default: every hardware thread)\n"
+        "  --coin-interval N, --coin-lifetime N, --max-coins N, --jump-force F, --gravity F\n"
+        "                 Balance knobs, for single runs too\n"
+        "\n"
+        "Images:\n"
+        "  --bench-image  Time the image to glyph conversion of a 1920x1080 frame\n"
+        "  --image PATH   Print a binary PGM or PPM converted to glyphs\n"
+        "  --dither MODE  none, ordered or diffusion (default: ordered)\n"
+        "\n"
+        "Glyph video:\n"
+        "  --encode-video OUT --frames DIR [--fps F]\n"
+        "                 Encode the PGM/PPM frames in DIR, in name order (default: %.0f fps)\n"
+        "  --play-video PATH\n"
+        "                 Play a video in the terminal\n"
+        "  --bench-video  Time decoding and seeking a generated clip\n"
+        "\n"
+        "Braille dots:\n"
+        "  --bench-braille\n"
+        "                 Time full screen redraws of lines, circles and bitmaps\n"
+        "  --braille      Print a frame drawn with dots\n"
+        "\n"
+        "Sprites:\n"
+        "  --bench-sprites\n"
+        "                 Time blitting 1k to 100k players a frame from the sprite atlas\n"
+        "\n"
+        "Particles:\n"
+        "  --bench-particles\n"
+        "                 Time 100k live particles through update and render\n"
+        "\n"
+        "Timers:\n"
+        "  --bench-timers Time a million timers through the timing wheel\n"
+        "\n"
+        "Behaviors:\n"
+        "  --bench-behaviors\n"
+        "                 Time 100k coroutine behaviors waiting on ticks and conditions\n"
+        "\n"
+        "Jobs:\n"
+        "  --bench-jobs   Time a heavy scene as a job graph on 1 thread up to every hardware thread\n"
+        "\n"
+        "Logging:\n"
+        "  --bench-log    Time logging from 1 to 8 threads and check every message is written or counted\n"
+        "\n"
+        "Physics:\n"
+        "  --bench-physics\n"
+        "                 Time the fixed point physics step for 16k bodies\n"
+        "\n"
+        "Bots:\n"
+        "  --bench-nav    Time route planning for 4096 bots a frame\n"
+        "\n"
+        "Levels:\n"
+        "  --level-seed N Play a generated level, 0 plays the hand-placed one (default: 0)\n"
+        "  --bench-levels Time generating and validating levels on every core\n"
+        "\n"
+        "Text layout:\n"
+        "  --bench-text   Time a HUD of wrapped text boxes with and without the layout cache\n"
+        "  --bench-cells  Time laying ASCII, CJK, mixed and surrogate pair text out into cells\n"
+        "\n"
+        "Presenting:\n"
+        "  --bench-present\n"
+        "                 Time ANSI frames from monochrome to attributes alternating every cell\n"
+        "\n"
+        "Shared memory frames:\n"
+        "  --watch NAME   Read every frame published to the ring NAME until its writer stops\n"
+        "  --bench-ring   Time publishing to rings read by 1, 2 and 4 consumers\n"
+        "\n"
+        "Signatures:\n"
+        "  --bench-sigscan FILE\n"
+        "                 Time searching a PE file's code for %d wildcard patterns, AVX2 against scalar\n"
+        "\n"
+        "Regression checks:\n"
+        "  --golden DIR   Convert the images in DIR and play its sessions, compare the glyphs and every frame\n"
+        "                 with their golden hashes and each phase's time with the baseline\n"
+        "  --golden-update\n"
+        "                 Write this run's hashes and timings to DIR instead\n"
+        "  --perf-threshold F\n"
+        "                 How much slower than the baseline a phase may get (default: %.2f)\n",
+        program, static_cast<unsigned long long>(DEFAULT_TICKS), DEFAULT_SEED, static_cast<unsigned long long>(ALLOC_WARMUP_TICKS), MatchSetup().ticksPerMatch, DEFAULT_VIDEO_FPS, SIGSCAN_BENCH_PATTERNS, DEFAULT_PERF_THRESHOLD);
+}
+
+template<typename T>
+bool parseNumber(const char* text, T& value) {
+    std::string_view view(text);
+    auto result = std::from_chars(view.data(), view.data() + view.size(), value);
+    return result.ec == std::errc() && result.ptr == view.data() + view.size();
+}
+
+// from_chars for floats is missing from older standard libraries
+bool parseNumber(const char* text, float& value) {
+    char* end = nullptr;
+    value = std::strtof(text, &end);
+    return end != text && *end == '\0';
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--ticks" && hasValue) {
+            if (!parseNumber(argv[++i], options.ticks)) {
+                return false;
+            }
+            options.ticksSet = true;
+        } else if (arg == "--seed" && hasValue) {
+            if (!parseNumber(argv[++i], options.seed)) {
+                return false;
+            }
+        } else if (arg == "--script" && hasValue) {
+            options.scriptPath = argv[++i];
+        } else if (arg == "--no-render") {
+            options.render = false;
+        } else if (arg == "--dump") {
+            options.dump = true;
+        } else if (arg == "--check-allocs") {
+            options.checkAllocs = true;
+        } else if (arg == "--matches" && hasValue) {
+            if (!parseNumber(argv[++i], options.matches) || options.matches > UINT32_MAX) {
+                return false;
+            }
+        } else if (arg == "--threads" && hasValue) {
+            if (!parseNumber(argv[++i], options.threads)) {
+                return false;
+            }
+        } else if (arg == "--coin-interval" && hasValue) {
+            if (!parseNumber(argv[++i], options.rules.coinSpawnInterval) || options.rules.coinSpawnInterval <= 0) {
+                return false;
+            }
+        } else if (arg == "--coin-lifetime" && hasValue) {
+            if (!parseNumber(argv[++i], options.rules.coinLifetime) || options.rules.coinLifetime <= 0) {
+                return false;
+            }
+        } else if (arg == "--max-coins" && hasValue) {
+            if (!parseNumber(argv[++i], options.rules.maxCoinsOnScreen)) {
+                return false;
+            }
+        } else if (arg == "--jump-force" && hasValue) {
+            if (!parseNumber(argv[++i], options.rules.jumpForce)) {
+                return false;
+            }
+        } else if (arg == "--gravity" && hasValue) {
+            if (!parseNumber(argv[++i], options.rules.gravity)) {
+                return false;
+            }
+        } else if (arg == "--level-seed" && hasValue) {
+            if (!parseNumber(argv[++i], options.rules.levelSeed)) {
+                return false;
+            }
+        } else if (arg == "--bench-image") {
+            options.benchImage = true;
+        } else if (arg == "--image" && hasValue) {
+            options.imagePath = argv[++i];
+        } else if (arg == "--bench-braille") {
+            options.benchBraille = true;
+        } else if (arg == "--bench-particles") {
+            options.benchParticles = true;
+        } else if (arg == "--bench-physics") {
+            options.benchPhysics = true;
+        } else if (arg == "--bench-nav") {
+            options.benchNav = true;
+        } else if (arg == "--bench-levels") {
+            options.benchLevels = true;
+        } else if (arg == "--jobs" && hasValue) {
+            if (!parseNumber(argv[++i], options.jobThreads)) {
+                return false;
+            }
+        } else if (arg == "--bench-jobs") {
+            options.benchJobs = true;
+        } else if (arg == "--publish" && hasValue) {
+            options.publishName = argv[++i];
+        } else if (arg == "--watch" && hasValue) {
+            options.watchName = argv[++i];
+        } else if (arg == "--bench-ring") {
+            options.benchRing = true;
+        } else if (arg == "--golden" && hasValue) {
+            options.goldenDirectory = argv[++i];
+        } else if (arg == "--golden-update") {
+            options.goldenUpdate = true;
+        } else if (arg == "--perf-threshold" && hasValue) {
+            if (!parseNumber(argv[++i], options.perfThreshold) || options.perfThreshold < 0.0f) {
+                return false;
+            }
+        } else if (arg == "--bench-text") {
+            options.benchText = true;
+        } else if (arg == "--bench-timers") {
+            options.benchTimers = true;
+        } else if (arg == "--bench-behaviors") {
+            options.benchBehaviors = true;
+        } else if (arg == "--braille") {
+            options.brailleDemo = true;
+        } else if (arg == "--bench-video") {
+            options.benchVideo = true;
+        } else if (arg == "--encode-video" && hasValue) {
+            options.encodeVideoPath = argv[++i];
+        } else if (arg == "--frames" && hasValue) {
+            options.framesDirectory = argv[++i];
+        } else if (arg == "--fps" && hasValue) {
+            float fps;
+            if (!parseNumber(argv[++i], fps) || fps <= 0.0f) {
+                return false;
+            }
+            options.fps = fps;
+        } else if (arg == "--play-video" && hasValue) {
+            options.playVideoPath = argv[++i];
+        } else if (arg == "--dither" && hasValue) {
+            std::string_view mode = argv[++i];
+            if (mode == "none") {
+                options.dither = IL::Dither::None;
+            } else if (mode == "ordered") {
+                options.dither = IL::Dither::Ordered;
+            } else if (mode == "diffusion") {
+                options.dither = IL::Dither::ErrorDiffusion;
+            } else {
+                return false;
+            }
+        } else if (arg == "--bench-sprites") {
+            options.benchSprites = true;
+        } else if (arg == "--bench-log") {
+            options.benchLog = true;
+        } else if (arg == "--bench-sigscan" && hasValue) {
+            options.sigscanPath = argv[++i];
+        } else if (arg == "--bench-cells") {
+            options.benchCells = true;
+        } else if (arg == "--bench-present") {
+            options.benchPresent = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool readFile(const std::string& path, std::string& contents) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    contents = stream.str();
+    return true;
+}
+
+int runMatchesAndReport(const Options& options) {
+    MatchSetup setup;
+    setup.matches = options.matches;
+    setup.seed = options.seed;
+    setup.threads = options.threads;
+    setup.rules = options.rules;
+    if (options.ticksSet) {
+        if (options.ticks > UINT32_MAX) {
+            std::fprintf(stderr, "--ticks is too long for a match\n");
+            return 1;
+        }
+        setup.ticksPerMatch = static_cast<uint32_t>(options.ticks);
+    }
+
+    MatchReport report = runMatches(setup);
+    const MatchTotals& totals = report.totals;
+    double matches = static_cast<double>(totals.matches);
+    double matchesPerSecond = report.seconds > 0.0 ? matches / report.seconds : 0.0;
+    uint64_t coinsEnded = totals.coinsCollected + totals.coinsExpired;
+
+    std::printf("matches:    %llu x %u ticks on %u threads (%llu steals)\n", static_cast<unsigned long long>(totals.matches),
+        setup.ticksPerMatch, report.threads, static_cast<unsigned long long>(report.steals));
+    std::printf("elapsed:    %.3f s\n", report.seconds);
+    std::printf("matches/s:  %.0f (%.1f per thread)\n", matchesPerSecond, matchesPerSecond / report.threads);
+    std::printf("ticks/s:    %.0f\n", report.seconds > 0.0 ? static_cast<double>(totals.ticks) / report.seconds : 0.0);
+    std::printf("results:    P1 %.1f%%, P2 %.1f%%, draw %.1f%%\n", 100.0 * totals.wins[0] / matches,
+        100.0 * totals.wins[1] / matches, 100.0 * totals.draws / matches);
+    std::printf("coins:      %.1f spawned, %.1f collected, %.1f expired per match (%.1f%% collected)\n",
+        totals.coinsSpawned / matches, totals.coinsCollected / matches, totals.coinsExpired / matches,
+        coinsEnded > 0 ? 100.0 * totals.coinsCollected / coinsEnded : 0.0);
+    for (int player = 0; player < 2; player++) {
+        std::printf("P%d score:   mean %.1f, p10 %d, p50 %d, p90 %d\n", player + 1, totals.scoreSum[player] / matches,
+            totals.ScorePercentile(player, 0.1), totals.ScorePercentile(player, 0.5), totals.ScorePercentile(player, 0.9));
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (options.matches > 0) {
+        return runMatchesAndReport(options);
+    }
+
+    if (options.benchImage) {
+        return runImageBenchmark(IMAGE_BENCH_ITERATIONS) ? 0 : 1;
+    }
+
+    if (!options.imagePath.empty()) {
+        return showImage(options.imagePath, options.dither) ? 0 : 1;
+    }
+
+    if (options.benchBraille) {
+        return runBrailleBenchmark(BRAILLE_BENCH_FRAMES) ? 0 : 1;
+    }
+
+    if (options.brailleDemo) {
+        showBrailleDemo();
+        return 0;
+    }
+
+    if (options.benchSprites) {
+        return runSpriteBenchmark(SPRITE_BENCH_FRAMES) ? 0 : 1;
+    }
+
+    if (options.benchParticles) {
+        return runParticleBenchmark(PARTICLE_BENCH_FRAMES) ? 0 : 1;
+    }
+
+    if (options.benchPhysics) {
+        return runPhysicsBenchmark(PHYSICS_BENCH_TICKS) ? 0 : 1;
+    }
+
+    if (options.benchNav) {
+        return runNavigationBenchmark(NAV_BENCH_FRAMES) ? 0 : 1;
+    }
+
+    if (options.benchLevels) {
+        return runLevelBenchmark(LEVEL_BENCH_LEVELS) ? 0 : 1;
+    }
+
+    if (!options.watchName.empty()) {
+        return watchFrameRing(options.watchName) ? 0 : 1;
+    }
+
+    if (options.benchRing) {
+        return runFrameRingBenchmark(RING_BENCH_FRAMES) ? 0 : 1;
+    }
+
+    if (!options.sigscanPath.empty()) {
+        return runSigscanBenchmark(options.sigscanPath, SIGSCAN_BENCH_PATTERNS) ? 0 : 1;
+    }
+
+    if (!options.goldenDirectory.empty()) {
+        return runGoldenSessions(options.goldenDirectory, options.goldenUpdate, options.perfThreshold) ? 0 : 1;
+    }
+
+    if (options.benchText) {
+        return runTextLayoutBenchmark(TEXT_BENCH_FRAMES) ? 0 : 1;
+    }
+
+    if (options.benchCells) {
+        return runCellLayoutBenchmark(CELL_BENCH_ROUNDS) ? 0 : 1;
+    }
+
+    if (options.benchPresent) {
+        return runPresentBenchmark(PRESENT_BENCH_FRAMES) ? 0 : 1;
+    }
+
+    if (options.benchLog) {
+        return runLogBenchmark(LOG_BENCH_MESSAGES) ? 0 : 1;
+    }
+
+    if (options.benchTimers) {
+        return runTimerBenchmark() ? 0 : 1;
+    }
+
+    if (options.benchBehaviors) {
+        return runBehaviorBenchmark(BEHAVIOR_BENCH_TICKS) ? 0 : 1;
+    }
+
+    if (options.benchJobs) {
+        return runJobBenchmark(JOB_BENCH_FRAMES) ? 0 : 1;
+    }
+
+    if (options.benchVideo) {
+        return runVideoBenchmark() ? 0 : 1;
+    }
+
+    if (!options.encodeVideoPath.empty()) {
+        if (options.framesDirectory.empty()) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return encodeVideo(options.framesDirectory, options.encodeVideoPath, options.fps, options.dither) ? 0 : 1;
+    }
+
+    if (!options.playVideoPath.empty()) {
+        return playVideo(options.playVideoPath) ? 0 : 1;
+    }
+
+    std::string script = ScriptedInput::DEFAULT_SCRIPT;
+    if (!options.scriptPath.empty() && !readFile(options.scriptPath, script)) {
+        std::fprintf(stderr, "Failed to read %s\n", options.scriptPath.c_str());
+        return 1;
+    }
+
+    ScriptedInput input;
+    std::string error;
+    if (!input.Load(script, error)) {
+        std::fprintf(stderr, "Bad script: %s\n", error.c_str());
+        return 1;
+    }
+
+    HeadlessCanvas canvas(options.dump);
+    if (!options.publishName.empty() && !canvas.PublishFrames(options.publishName)) {
+        std::fprintf(stderr, "Failed to create the shared memory ring %s\n", options.publishName.c_str());
+        return 1;
+    }
+
+    State_t state;
+    InitializeGame(state, options.seed, options.rules);
+
+    // The caller is one of the threads
+    std::unique_ptr<IL::JobSystem> jobSystem;
+    std::unique_ptr<FrameJobs> frameJobs;
+    if (options.jobThreads > 0) {
+        jobSystem = std::make_unique<IL::JobSystem>(options.jobThreads - 1);
+        frameJobs = std::make_unique<FrameJobs>(*jobSystem);
+    }
+
+    // Uncapped, the only pacing the game ever had was the host's Sleep
+    uint64_t steadyAllocations = 0;
+    uint64_t firstAllocatingTick = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t tick = 0; tick < options.ticks; tick++) {
+        IL::AllocationScope frame;
+        UpdateGame(state, input, frameJobs.get());
+        if (options.render) {
+            RenderGame(state, canvas, frameJobs.get());
+        }
+        input.Advance();
+
+        if (tick >= ALLOC_WARMUP_TICKS && frame.GetCount() > 0) {
+            if (steadyAllocations == 0) {
+                firstAllocatingTick = tick;
+            }
+            steadyAllocations += frame.GetCount();
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (options.dump) {
+        std::fwrite(canvas.GetAnsiFrame().data(), 1, canvas.GetAnsiFrame().size(), stdout);
+        std::printf("\033[0m\n");
+    }
+
+    double seconds = elapsed.count();
+    double ticksPerSecond = seconds > 0.0 ? static_cast<double>(options.ticks) / seconds : 0.0;
+    double nsPerTick = options.ticks > 0 ? seconds * 1e9 / static_cast<double>(options.ticks) : 0.0;
+
+    std::printf("ticks:      %llu (%s)\n", static_cast<unsigned long long>(options.ticks), options.render ? "update + render" : "update only");
+    if (jobSystem) {
+        std::printf("jobs:       %u threads\n", jobSystem->GetThreads());
+    }
+    std::printf("frames:     %llu\n", static_cast<unsigned long long>(canvas.GetFrameCount()));
+    std::printf("elapsed:    %.3f s\n", seconds);
+    std::printf("ticks/s:    %.0f\n", ticksPerSecond);
+    std::printf("ns/tick:    %.1f\n", nsPerTick);
+    std::printf("score:      P1 %d, P2 %d\n", state.players[0].score, state.players[1].score);
+
+    uint64_t steadyTicks = options.ticks > ALLOC_WARMUP_TICKS ? options.ticks - ALLOC_WARMUP_TICKS : 0;
+    std::printf("allocs:     %llu in %llu ticks after warming up", static_cast<unsigned long long>(steadyAllocations),
+        static_cast<unsigned long long>(steadyTicks));
+    if (steadyAllocations > 0) {
+        std::printf(", the first on tick %llu", static_cast<unsigned long long>(firstAllocatingTick));
+    }
+    std::printf("\n");
+
+    return options.checkAllocs && steadyAllocations > 0 ? 1 : 0;
+}
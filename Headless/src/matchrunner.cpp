@@ -0,0 +1,211 @@
+#include "matchrunner.h"
+#include "bot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+    // A worker's remaining match indices [begin, end) packed into one word, so the owner taking from the front
+    // and thieves taking from the back agree through a single compare and swap
+    uint64_t packRange(uint32_t begin, uint32_t end) {
+        return (static_cast<uint64_t>(end) << 32) | begin;
+    }
+
+    uint32_t rangeBegin(uint64_t range) {
+        return static_cast<uint32_t>(range);
+    }
+
+    uint32_t rangeEnd(uint64_t range) {
+        return static_cast<uint32_t>(range >> 32);
+    }
+
+    // Own cache line each, the range is written on every match
+    struct alignas(64) Worker {
+        std::atomic<uint64_t> range = 0;
+        uint64_t steals = 0;
+        MatchTotals totals;
+    };
+
+    bool popFront(Worker& worker, uint32_t& index) {
+        uint64_t range = worker.range.load(std::memory_order_acquire);
+        while (rangeBegin(range) < rangeEnd(range)) {
+            uint64_t rest = packRange(rangeBegin(range) + 1, rangeEnd(range));
+            if (worker.range.compare_exchange_weak(range, rest, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                index = rangeBegin(range);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Takes the back half of the fullest other range, keeps the rest of it and returns its first match
+    bool steal(Worker* workers, unsigned int count, unsigned int self, uint32_t& index) {
+        while (true) {
+            unsigned int victim = count;
+            uint32_t most = 0;
+            for (unsigned int i = 0; i < count; i++) {
+                uint64_t range = workers[i].range.load(std::memory_order_relaxed);
+                uint32_t remaining = rangeEnd(range) > rangeBegin(range) ? rangeEnd(range) - rangeBegin(range) : 0;
+                if (i != self && remaining > most) {
+                    victim = i;
+                    most = remaining;
+                }
+            }
+            if (victim == count) {
+                return false;
+            }
+
+            uint64_t range = workers[victim].range.load(std::memory_order_acquire);
+            uint32_t begin = rangeBegin(range);
+            uint32_t end = rangeEnd(range);
+            if (begin >= end) {
+                continue;
+            }
+
+            uint32_t middle = begin + (end - begin) / 2;
+            if (workers[victim].range.compare_exchange_strong(range, packRange(begin, middle), std::memory_order_acq_rel)) {
+                workers[self].range.store(packRange(middle + 1, end), std::memory_order_release);
+                workers[self].steals++;
+                index = middle;
+                return true;
+            }
+        }
+    }
+
+    // splitmix64, spreads neighbouring match indices over unrelated seeds
+    uint64_t mixSeed(uint64_t value) {
+        value += 0x9E3779B97F4A7C15ull;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+    void playMatch(const MatchSetup& setup, uint32_t index, State_t& state, NavGraph& graph, MatchTotals& totals) {
+        uint64_t matchSeed = mixSeed(setup.seed ^ mixSeed(index));
+        // Nobody watches bot matches, so they skip the particles
+        GameRules rules = setup.rules;
+        rules.effects = false;
+        InitializeGame(state, static_cast<unsigned int>(matchSeed), rules);
+
+        BotInput bots(matchSeed >> 32, graph);
+        for (uint32_t tick = 0; tick < setup.ticksPerMatch; tick++) {
+            bots.Think(state);
+            UpdateGame(state, bots);
+        }
+
+        totals.Add(state);
+    }
+}
+
+void MatchTotals::Add(const State_t& state) {
+    matches++;
+    ticks += state.stats.ticks;
+    coinsSpawned += state.stats.coinsSpawned;
+    coinsCollected += state.stats.coinsCollected;
+    coinsExpired += state.stats.coinsExpired;
+
+    int scores[2] = { state.players[0].score, state.players[1].score };
+    if (scores[0] == scores[1]) {
+        draws++;
+    } else {
+        wins[scores[0] > scores[1] ? 0 : 1]++;
+    }
+
+    for (int player = 0; player < 2; player++) {
+        scoreSum[player] += scores[player];
+        int bucket = std::clamp(scores[player] / SCORE_BUCKET, 0, SCORE_BUCKETS - 1);
+        scoreHistogram[player][bucket]++;
+    }
+}
+
+void MatchTotals::Merge(const MatchTotals& other) {
+    matches += other.matches;
+    ticks += other.ticks;
+    draws += other.draws;
+    coinsSpawned += other.coinsSpawned;
+    coinsCollected += other.coinsCollected;
+    coinsExpired += other.coinsExpired;
+
+    for (int player = 0; player < 2; player++) {
+        wins[player] += other.wins[player];
+        scoreSum[player] += other.scoreSum[player];
+        for (int bucket = 0; bucket < SCORE_BUCKETS; bucket++) {
+            scoreHistogram[player][bucket] += other.scoreHistogram[player][bucket];
+        }
+    }
+}
+
+int MatchTotals::ScorePercentile(int player, double fraction) const {
+    uint64_t target = static_cast<uint64_t>(fraction * static_cast<double>(matches));
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < SCORE_BUCKETS; bucket++) {
+        seen += scoreHistogram[player][bucket];
+        if (seen > target) {
+            return bucket * SCORE_BUCKET;
+        }
+    }
+    return (SCORE_BUCKETS - 1) * SCORE_BUCKET;
+}
+
+MatchReport runMatches(const MatchSetup& setup) {
+    MatchReport report;
+    if (setup.matches == 0) {
+        return report;
+    }
+
+    unsigned int count = setup.threads != 0 ? setup.threads : std::max(1u, std::thread::hardware_concurrency());
+    count = static_cast<unsigned int>(std::min<uint64_t>(count, setup.matches));
+    uint32_t matches = static_cast<uint32_t>(std::min<uint64_t>(setup.matches, UINT32_MAX));
+
+    // Even shares up front, stealing only evens out what is left at the end
+    std::unique_ptr<Worker[]> workers(new Worker[count]);
+    for (unsigned int w = 0; w < count; w++) {
+        uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(matches) * w / count);
+        uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(matches) * (w + 1) / count);
+        workers[w].range.store(packRange(begin, end), std::memory_order_relaxed);
+    }
+
+    std::barrier sync(static_cast<std::ptrdiff_t>(count));
+    auto work = [&](unsigned int self) {
+        Worker& worker = workers[self];
+        State_t state;
+        NavGraph graph; // Every match is on the same level, so routes learnt in one serve the next
+        uint32_t index;
+        while (popFront(worker, index) || steal(workers.get(), count, self, index)) {
+            playMatch(setup, index, state, graph, worker.totals);
+        }
+
+        // Tree reduction, in each round every worker at an even multiple of the stride folds in its neighbour
+        for (unsigned int stride = 1; stride < count; stride *= 2) {
+            sync.arrive_and_wait();
+            if (self % (stride * 2) == 0 && self + stride < count) {
+                worker.totals.Merge(workers[self + stride].totals);
+            }
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    threads.reserve(count - 1);
+    for (unsigned int w = 1; w < count; w++) {
+        threads.emplace_back(work, w);
+    }
+    work(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    report.totals = workers[0].totals;
+    report.threads = count;
+    report.seconds = elapsed.count();
+    for (unsigned int w = 0; w < count; w++) {
+        report.steals += workers[w].steals;
+    }
+    return report;
+}
@@ -0,0 +1,150 @@
+#include "navbench.h"
+#include "game.h"
+#include "navigation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr size_t BENCH_BOTS = 4096;
+    constexpr int WARMUP_FRAMES = 60;     // Routes are still being learnt, reported apart
+    constexpr double BUDGET_US = 1000.0;  // Per frame, for every bot
+
+    using Clock = std::chrono::steady_clock;
+
+    // The match only runs for its coins, its own players stand still
+    class NoInput : public IL::InputSource {
+    public:
+        bool IsKeyDown(IL::Key) const override { return false; }
+    };
+
+    // The bots' bodies, stepped together like any other bodies
+    struct Crowd {
+        std::vector<IL::Fixed> y, velocityY;
+        std::vector<int32_t> left, right, height;
+        std::vector<uint8_t> grounded;
+        std::vector<NavBot> bots;
+        std::vector<NavKeys> keys;
+        std::vector<uint8_t> reached; // By coin id * BENCH_BOTS + bot
+
+        explicit Crowd(uint32_t seed) : bots(BENCH_BOTS), keys(BENCH_BOTS) {
+            std::mt19937 random(seed);
+            std::uniform_int_distribution<int> xs(0, SCREEN_WIDTH - PLAYER_WIDTH);
+            std::uniform_int_distribution<int> ys(0, IL::CellsToFixed(25));
+            for (size_t i = 0; i < BENCH_BOTS; i++) {
+                int x = xs(random);
+                y.push_back(ys(random));
+                velocityY.push_back(0);
+                left.push_back(x);
+                right.push_back(x + PLAYER_WIDTH);
+                height.push_back(PLAYER_HEIGHT);
+                grounded.push_back(0);
+            }
+        }
+
+        // The keys as UpdateGame plays them, then the fall
+        void Move(const IL::FallRules& fall, IL::Fixed jumpForce, const std::vector<IL::Ledge>& ledges) {
+            for (size_t i = 0; i < BENCH_BOTS; i++) {
+                int x = left[i] + (keys[i].right ? 1 : 0) - (keys[i].left ? 1 : 0);
+                left[i] = std::clamp(x, 0, SCREEN_WIDTH - PLAYER_WIDTH);
+                right[i] = left[i] + PLAYER_WIDTH;
+                if (keys[i].jump && grounded[i]) {
+                    velocityY[i] = jumpForce;
+                    grounded[i] = 0;
+                }
+            }
+
+            IL::BodyArrays bodies = { y.data(), velocityY.data(), left.data(), right.data(), height.data(), grounded.data(), BENCH_BOTS };
+            IL::StepBodies(bodies, fall, ledges.data(), ledges.size());
+        }
+
+        // Bots getting to a coin they had not reached yet, the coins stay for everyone else
+        uint64_t CountReached(const std::vector<Coin>& coins) {
+            uint64_t count = 0;
+            for (size_t i = 0; i < BENCH_BOTS; i++) {
+                int top = IL::FixedToCell(y[i]);
+                for (const Coin& coin : coins) {
+                    bool touching = left[i] <= coin.x && right[i] > coin.x && top <= coin.y && top + PLAYER_HEIGHT > coin.y;
+                    if (!coin.active || !touching) {
+                        continue;
+                    }
+
+                    size_t index = static_cast<size_t>(coin.id) * BENCH_BOTS + i;
+                    if (index >= reached.size()) {
+                        reached.resize(index + 1);
+                    }
+                    if (!reached[index]) {
+                        reached[index] = 1;
+                        count++;
+                    }
+                }
+            }
+            return count;
+        }
+    };
+}
+
+bool runNavigationBenchmark(int frames) {
+    State_t level;
+    InitializeGame(level, 1);
+    IL::FallRules fall = { IL::ToFixed(level.rules.gravity), Physics_t().terminalVelocity, Physics_t().groundLevel };
+    IL::Fixed jumpForce = IL::ToFixed(level.rules.jumpForce);
+    NoInput idle;
+
+    NavGraph graph;
+    Clock::time_point start = Clock::now();
+    graph.Build(level);
+    double buildUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+    Crowd crowd(45);
+    std::vector<NavTarget> targets;
+    std::vector<double> frameUs;
+    frameUs.reserve(frames);
+    uint64_t reached = 0;
+    uint64_t warmSearches = 0;
+    for (int frame = 0; frame < frames; frame++) {
+        uint64_t now = level.timers.Now();
+        start = Clock::now();
+        graph.FindTargets(level, targets);
+        for (size_t i = 0; i < BENCH_BOTS; i++) {
+            crowd.keys[i] = crowd.bots[i].Think(graph, crowd.left[i], IL::FixedToCell(crowd.y[i]), crowd.grounded[i] != 0, targets, now);
+        }
+        frameUs.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+
+        if (frame + 1 == WARMUP_FRAMES) {
+            warmSearches = graph.GetSearches();
+        }
+
+        crowd.Move(fall, jumpForce, level.ledges);
+        reached += crowd.CountReached(level.coins);
+        UpdateGame(level, idle);
+    }
+
+    int warm = std::min(frames, WARMUP_FRAMES);
+    double warmupUs = 0.0;
+    for (int frame = 0; frame < warm; frame++) {
+        warmupUs += frameUs[frame];
+    }
+
+    std::vector<double> steady(frameUs.begin() + warm, frameUs.end());
+    double steadyUs = 0.0;
+    for (double us : steady) {
+        steadyUs += us;
+    }
+    double meanUs = steady.empty() ? 0.0 : steadyUs / steady.size();
+    std::sort(steady.begin(), steady.end());
+    double p99Us = steady.empty() ? 0.0 : steady[std::min(steady.size() - 1, steady.size() * 99 / 100)];
+
+    std::printf("%d frames of %zu bots on %d surfaces, %d stands\n", frames, BENCH_BOTS, graph.GetSurfaceCount(), graph.GetStandCount());
+    std::printf("build     %7.1f us, every move simulated\n", buildUs);
+    std::printf("warmup    %7.1f us per frame over the first %d, %llu searches\n", warmupUs / warm, warm,
+        static_cast<unsigned long long>(warmSearches));
+    std::printf("plan      %7.1f us per frame (p99 %.1f us), %.1f ns per bot, %.0f%% of the %.0f us budget\n", meanUs, p99Us,
+        meanUs * 1000.0 / BENCH_BOTS, 100.0 * meanUs / BUDGET_US, BUDGET_US);
+    std::printf("routes    %zu known, %llu searches in all\n", graph.GetKnownRoutes(), static_cast<unsigned long long>(graph.GetSearches()));
+    std::printf("coins     %.1f reached per bot per minute of play\n", static_cast<double>(reached) / BENCH_BOTS * 3600.0 / frames);
+    return meanUs <= BUDGET_US;
+}
@@ -0,0 +1,143 @@
+#include "particlebench.h"
+#include "headless.h"
+#include "particles.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr size_t BENCH_PARTICLES = 100000;
+    constexpr double FRAME_BUDGET_MS = 1000.0 / 60.0;
+
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    uint64_t hashCells(const IL::Cell* cells, size_t count) {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < count; i++) {
+            hash = (hash ^ cells[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // A pool with the benchmark's styles and emitters, two of them driven alike stay identical
+    struct Scene {
+        IL::ParticlePool pool{ BENCH_PARTICLES, 7 };
+        std::vector<IL::ParticleEmitter> emitters;
+        IL::EmitterConfig burst;
+        std::mt19937 random{ 7 };
+
+        Scene() {
+            int spark = pool.AddStyle(u"@Oo*+:.", { IL::Color::Yellow, IL::Color::Default, 0 });
+            int smoke = pool.AddStyle(u"#%=-. ", { IL::Color::DarkGray, IL::Color::Default, 0 });
+
+            IL::EmitterConfig fountain;
+            fountain.kind = IL::EmitterKind::Fountain;
+            fountain.rate = 400.0f;
+            fountain.spread = 0.5f;
+            fountain.speedMin = 0.4f;
+            fountain.speedMax = 0.9f;
+            fountain.gravity = 0.02f;
+            fountain.lifeMin = 60;
+            fountain.lifeMax = 180;
+            fountain.style = spark;
+            for (int i = 0; i < 6; i++) {
+                emitters.emplace_back(fountain, 12.0f + i * 28.0f, IL::CANVAS_HEIGHT - 1.0f);
+            }
+
+            IL::EmitterConfig trail;
+            trail.kind = IL::EmitterKind::Trail;
+            trail.rate = 300.0f;
+            trail.speedMin = 0.0f;
+            trail.speedMax = 0.05f;
+            trail.lifeMin = 120;
+            trail.lifeMax = 240;
+            trail.style = smoke;
+            emitters.emplace_back(trail, 0.0f, IL::CANVAS_HEIGHT / 2.0f);
+
+            // Bursts top the pool up to capacity every frame
+            burst.speedMin = 0.02f;
+            burst.speedMax = 0.3f;
+            burst.lifeMin = 90;
+            burst.lifeMax = 240;
+            burst.style = spark;
+        }
+
+        void Emit(int frame) {
+            float angle = frame * 0.05f;
+            emitters.back().MoveTo(IL::CANVAS_WIDTH * (0.5f + 0.45f * std::sin(angle)), IL::CANVAS_HEIGHT * (0.5f + 0.4f * std::cos(angle * 1.7f)));
+            for (IL::ParticleEmitter& emitter : emitters) {
+                emitter.Update(pool);
+            }
+
+            std::uniform_real_distribution<float> xs(0.0f, static_cast<float>(IL::CANVAS_WIDTH));
+            std::uniform_real_distribution<float> ys(0.0f, static_cast<float>(IL::CANVAS_HEIGHT));
+            while (pool.GetCount() + 64 <= pool.GetCapacity()) {
+                burst.rate = 64.0f;
+                pool.Burst(burst, xs(random), ys(random));
+            }
+        }
+    };
+
+    void render(const IL::ParticlePool& pool, HeadlessCanvas& canvas) {
+        canvas.Begin();
+        canvas.BeginLayer(IL::Layer::World);
+        pool.Render(canvas);
+        canvas.End();
+    }
+}
+
+bool runParticleBenchmark(int frames) {
+    Scene simd;
+    Scene scalar;
+    HeadlessCanvas simdCanvas;
+    HeadlessCanvas scalarCanvas;
+
+    double emitMs = 0.0, updateMs = 0.0, scalarMs = 0.0, renderMs = 0.0, worstMs = 0.0;
+    uint64_t live = 0;
+    bool same = true;
+    for (int frame = 0; frame < frames; frame++) {
+        Clock::time_point start = Clock::now();
+        simd.Emit(frame);
+        double emit = elapsedMs(start);
+
+        start = Clock::now();
+        simd.pool.Update();
+        double update = elapsedMs(start);
+        live += simd.pool.GetCount();
+
+        start = Clock::now();
+        render(simd.pool, simdCanvas);
+        double draw = elapsedMs(start);
+
+        emitMs += emit;
+        updateMs += update;
+        renderMs += draw;
+        worstMs = std::max(worstMs, emit + update + draw);
+
+        scalar.Emit(frame);
+        start = Clock::now();
+        scalar.pool.UpdateScalar();
+        scalarMs += elapsedMs(start);
+        render(scalar.pool, scalarCanvas);
+
+        same = same && simd.pool.GetCount() == scalar.pool.GetCount() &&
+            hashCells(simdCanvas.GetCells(), IL::CANVAS_CELLS) == hashCells(scalarCanvas.GetCells(), IL::CANVAS_CELLS);
+    }
+
+    double total = (emitMs + updateMs + renderMs) / frames;
+    std::printf("%d frames, %.0f live particles on average (capacity %zu)\n", frames, static_cast<double>(live) / frames, BENCH_PARTICLES);
+    std::printf("emit      %7.3f ms per frame\n", emitMs / frames);
+    std::printf("update    %7.3f ms per frame (scalar %.3f ms, %.1fx)\n", updateMs / frames, scalarMs / frames, scalarMs / updateMs);
+    std::printf("render    %7.3f ms per frame\n", renderMs / frames);
+    std::printf("total     %7.3f ms per frame, worst %.3f ms, %.0f%% of a 60 FPS frame\n", total, worstMs, 100.0 * total / FRAME_BUDGET_MS);
+    std::printf("scalar and SSE2 frames %s\n", same ? "match" : "DO NOT MATCH");
+    return same;
+}
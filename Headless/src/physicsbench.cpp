@@ -0,0 +1,92 @@
+#include "physicsbench.h"
+#include "game.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr size_t BENCH_BODIES = 16384;
+    constexpr uint32_t JUMP_PERCENT = 5; // Grounded bodies that jump each tick
+
+    using Clock = std::chrono::steady_clock;
+
+    // Bodies spread over the level, two of them built from the same seed stay identical
+    struct Bodies {
+        std::vector<IL::Fixed> y, velocityY;
+        std::vector<int32_t> left, right, height;
+        std::vector<uint8_t> grounded;
+
+        explicit Bodies(uint32_t seed) {
+            std::mt19937 random(seed);
+            std::uniform_int_distribution<int> xs(0, SCREEN_WIDTH - PLAYER_WIDTH);
+            std::uniform_int_distribution<int> ys(0, IL::CellsToFixed(25));
+            for (size_t i = 0; i < BENCH_BODIES; i++) {
+                int x = xs(random);
+                y.push_back(ys(random));
+                velocityY.push_back(0);
+                left.push_back(x);
+                right.push_back(x + PLAYER_WIDTH);
+                height.push_back(PLAYER_HEIGHT);
+                grounded.push_back(0);
+            }
+        }
+
+        IL::BodyArrays View() {
+            return { y.data(), velocityY.data(), left.data(), right.data(), height.data(), grounded.data(), y.size() };
+        }
+
+        // Some grounded bodies jump, the same ones for every set stepped alike
+        void Jump(std::mt19937& random, IL::Fixed force) {
+            for (size_t i = 0; i < y.size(); i++) {
+                if (grounded[i] && random() % 100 < JUMP_PERCENT) {
+                    velocityY[i] = force;
+                }
+            }
+        }
+    };
+}
+
+bool runPhysicsBenchmark(int ticks) {
+    State_t level;
+    InitializeGame(level, 1);
+    GameRules rules;
+    IL::FallRules fall = { IL::ToFixed(rules.gravity), Physics_t().terminalVelocity, Physics_t().groundLevel };
+    IL::Fixed jump = IL::ToFixed(rules.jumpForce);
+
+    Bodies simd(44);
+    Bodies scalar(44);
+    std::mt19937 simdJumps(7);
+    std::mt19937 scalarJumps(7);
+
+    double simdNs = 0.0;
+    double scalarNs = 0.0;
+    uint64_t grounded = 0;
+    bool same = true;
+    for (int tick = 0; tick < ticks; tick++) {
+        simd.Jump(simdJumps, jump);
+        Clock::time_point start = Clock::now();
+        IL::StepBodies(simd.View(), fall, level.ledges.data(), level.ledges.size());
+        simdNs += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+        scalar.Jump(scalarJumps, jump);
+        start = Clock::now();
+        IL::StepBodiesScalar(scalar.View(), fall, level.ledges.data(), level.ledges.size());
+        scalarNs += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+        same = same && simd.y == scalar.y && simd.velocityY == scalar.velocityY && simd.grounded == scalar.grounded;
+        for (uint8_t standing : simd.grounded) {
+            grounded += standing;
+        }
+    }
+
+    double steps = static_cast<double>(ticks) * BENCH_BODIES;
+    std::printf("%d ticks of %zu bodies against %zu ledges and the floor, %.0f%% standing on average\n", ticks, BENCH_BODIES,
+        level.ledges.size(), 100.0 * grounded / steps);
+    std::printf("step      %7.2f ns per body (scalar %.2f ns, %.1fx)\n", simdNs / steps, scalarNs / steps, scalarNs / simdNs);
+    std::printf("          %7.1f us per tick for all of them\n", simdNs / ticks / 1000.0);
+    std::printf("scalar and SSE2 bodies %s\n", same ? "match" : "DO NOT MATCH");
+    return same;
+}
@@ -0,0 +1,187 @@
+#include "presentbench.h"
+#include "allocstats.h"
+#include "game.h"
+#include "headless.h"
+#include "present.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr int GAME_TICKS = 600; // Into the demo match, coins, players and the HUD are all on screen
+    constexpr int MIN_RUN = 4;      // Run lengths of the coloured frame, in cells
+    constexpr int MAX_RUN = 24;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Frame {
+        const char* name;
+        std::vector<IL::Cell> cells = std::vector<IL::Cell>(IL::CANVAS_CELLS);
+        std::vector<IL::CellAttr> attrs = std::vector<IL::CellAttr>(IL::CANVAS_CELLS);
+    };
+
+    // What the WM_PAINT handler would do for a frame
+    struct PaintCalls {
+        int textCalls = 0;   // ExtTextOutW, one per run within a line
+        int stateChanges = 0; // Runs whose attributes differ from the DC's, each sets colours and maybe the font
+    };
+
+    IL::CellAttr randomAttr(Random& random) {
+        IL::CellAttr attr;
+        attr.fg = static_cast<IL::Color>(1 + random.Next() % 16);
+        attr.bg = static_cast<IL::Color>(random.Next() % 17);
+        attr.style = random.Next() % 4 == 0 ? IL::STYLE_BOLD : 0;
+        return attr;
+    }
+
+    void fillText(Frame& frame, Random& random) {
+        for (IL::Cell& cell : frame.cells) {
+            cell = static_cast<IL::Cell>(u'!' + random.Next() % 94);
+        }
+    }
+
+    Frame monochromeFrame(Random& random) {
+        Frame frame{ "monochrome" };
+        fillText(frame, random);
+        return frame;
+    }
+
+    Frame gameFrame() {
+        Frame frame{ "game" };
+        State_t state;
+        InitializeGame(state, 1);
+        ScriptedInput input;
+        std::string error;
+        input.Load(ScriptedInput::DEFAULT_SCRIPT, error);
+        HeadlessCanvas canvas;
+        for (int tick = 0; tick < GAME_TICKS; tick++) {
+            UpdateGame(state, input);
+            input.Advance();
+        }
+        RenderGame(state, canvas);
+        frame.cells.assign(canvas.GetCells(), canvas.GetCells() + IL::CANVAS_CELLS);
+        frame.attrs.assign(canvas.GetAttrs(), canvas.GetAttrs() + IL::CANVAS_CELLS);
+        return frame;
+    }
+
+    Frame colouredFrame(Random& random) {
+        Frame frame{ "coloured" };
+        fillText(frame, random);
+        int cell = 0;
+        while (cell < IL::CANVAS_CELLS) {
+            IL::CellAttr attr = randomAttr(random);
+            int end = cell + MIN_RUN + static_cast<int>(random.Next() % (MAX_RUN - MIN_RUN + 1));
+            for (; cell < end && cell < IL::CANVAS_CELLS; cell++) {
+                frame.attrs[cell] = attr;
+            }
+        }
+        return frame;
+    }
+
+    Frame alternatingFrame(Random& random) {
+        Frame frame{ "alternating" };
+        fillText(frame, random);
+        IL::CellAttr attrs[2] = { { IL::Color::Red, IL::Color::Black, IL::STYLE_BOLD }, { IL::Color::Cyan, IL::Color::Blue, 0 } };
+        for (int cell = 0; cell < IL::CANVAS_CELLS; cell++) {
+            frame.attrs[cell] = attrs[(cell + cell / IL::CANVAS_WIDTH) % 2];
+        }
+        return frame;
+    }
+
+    // The run loop of the WM_PAINT handler without the drawing
+    PaintCalls countPaintCalls(const Frame& frame) {
+        PaintCalls calls;
+        IL::CellAttr current = IL::DEFAULT_ATTR;
+        for (int y = 0; y < IL::CANVAS_HEIGHT; y++) {
+            const IL::CellAttr* line = &frame.attrs[y * IL::CANVAS_WIDTH];
+            int runStart = 0;
+            while (runStart < IL::CANVAS_WIDTH) {
+                int runEnd = runStart + 1;
+                while (runEnd < IL::CANVAS_WIDTH && line[runEnd] == line[runStart]) {
+                    runEnd++;
+                }
+                if (line[runStart] != current) {
+                    current = line[runStart];
+                    calls.stateChanges++;
+                }
+                calls.textCalls++;
+                runStart = runEnd;
+            }
+        }
+        return calls;
+    }
+
+    // Runs of equal attributes in reading order, AppendAnsiFrame starts one escape for each that differs from the
+    // attributes before it
+    int countEscapes(const Frame& frame) {
+        int escapes = 0;
+        IL::CellAttr current = IL::DEFAULT_ATTR;
+        for (const IL::CellAttr& attr : frame.attrs) {
+            if (attr != current) {
+                current = attr;
+                escapes++;
+            }
+        }
+        return escapes;
+    }
+
+    // The frame's text with every escape taken out, to compare with AppendTextFrame. Besides the runs' escapes
+    // there are three, homing the cursor and resetting the attributes first and last.
+    bool checkAnsi(const Frame& frame, const std::string& ansi) {
+        std::string text;
+        int escapes = -3;
+        for (size_t i = 0; i < ansi.size(); i++) {
+            if (ansi[i] != '\x1b') {
+                text += ansi[i];
+                continue;
+            }
+            i = ansi.find_first_of("Hm", i);
+            escapes++;
+        }
+
+        std::string expected;
+        IL::AppendTextFrame(frame.cells.data(), IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT, expected);
+        return text == expected && escapes == countEscapes(frame);
+    }
+}
+
+bool runPresentBenchmark(int frames) {
+    Random random;
+    random.Seed(30);
+    Frame kinds[] = { monochromeFrame(random), gameFrame(), colouredFrame(random), alternatingFrame(random) };
+
+    std::printf("%dx%d cells, %d frames per kind\n", IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT, frames);
+    std::printf("frame        ansi us  vs mono   KiB  escapes   text calls  DC changes\n");
+    bool correct = true;
+    uint64_t steadyAllocations = 0;
+    double monochromeNs = 0.0;
+    std::string ansi;
+    for (const Frame& frame : kinds) {
+        ansi.clear();
+        IL::AppendAnsiFrame(frame.cells.data(), frame.attrs.data(), IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT, ansi);
+        correct = checkAnsi(frame, ansi) && correct;
+
+        // The string keeps its capacity between frames, as the headless canvas's does
+        IL::AllocationScope scope;
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < frames; i++) {
+            ansi.clear();
+            IL::AppendAnsiFrame(frame.cells.data(), frame.attrs.data(), IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT, ansi);
+        }
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / frames;
+        steadyAllocations += scope.GetCount();
+        if (monochromeNs == 0.0) {
+            monochromeNs = ns;
+        }
+
+        PaintCalls calls = countPaintCalls(frame);
+        std::printf("%-11s  %7.1f  %6.1fx  %4.0f  %7d   %10d  %10d\n", frame.name, ns / 1000.0, ns / monochromeNs,
+            ansi.size() / 1024.0, countEscapes(frame), calls.textCalls, calls.stateChanges);
+    }
+
+    std::printf("text and escapes %s, %llu heap allocations after the first frame of each kind\n", correct ? "match" : "DIFFER",
+        static_cast<unsigned long long>(steadyAllocations));
+    return correct && steadyAllocations == 0;
+}
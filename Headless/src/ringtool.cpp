@@ -0,0 +1,214 @@
+#include "ringtool.h"
+#include "canvas.h"
+#include "framering.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr int WATCH_WAIT_MS = 10000;  // How long --watch waits for the ring to appear
+    constexpr int WATCH_POLL_US = 200;    // Sleep between looks at an idle ring, a watcher should not take a core
+    constexpr int PACED_FRAMES = 1000;
+    constexpr int PACED_RATE = 1000;      // Frames per second of the paced run
+    constexpr int BENCH_SLOTS = 8;
+
+    using Clock = std::chrono::steady_clock;
+
+    int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    // Own cache line each, written by one consumer
+    struct alignas(64) Consumed {
+        uint64_t read = 0;
+        uint64_t missed = 0;  // Overwritten before the consumer got to them
+        uint64_t torn = 0;    // Overwritten while the consumer read them
+        uint64_t corrupt = 0; // Validated, but not what was published
+        std::vector<double> latencies; // Microseconds from publishing to acquiring, of the frames read
+    };
+
+    // Reads every frame from next on, in order, until the ring is closed and drained. check looks at a frame in
+    // place and says whether it holds what it should.
+    template<typename Check, typename Idle>
+    void consume(const IL::FrameRingReader& ring, uint64_t next, Consumed& consumed, Check&& check, Idle&& idle) {
+        uint64_t slots = static_cast<uint64_t>(ring.GetSlots());
+        for (;;) {
+            uint64_t latest = ring.GetLatest();
+            if (next > latest) {
+                // Closed is set after the last frame, so a drained ring that is closed stays drained
+                if (ring.IsClosed() && next > ring.GetLatest()) {
+                    return;
+                }
+                idle();
+                continue;
+            }
+
+            // A frame more than a ring behind the latest is gone
+            uint64_t oldest = latest >= slots ? latest - slots + 1 : 1;
+            if (next < oldest) {
+                consumed.missed += oldest - next;
+                next = oldest;
+            }
+
+            IL::SharedFrame frame;
+            if (!ring.Acquire(next, frame)) {
+                consumed.missed++;
+                next++;
+                continue;
+            }
+            double latency = static_cast<double>(nowNs() - frame.publishedNs) / 1000.0;
+
+            bool intact = check(frame);
+            if (!ring.Validate(frame)) {
+                consumed.torn++;
+            } else {
+                consumed.read++;
+                consumed.corrupt += intact ? 0 : 1;
+                consumed.latencies.push_back(latency);
+            }
+            next++;
+        }
+    }
+
+    double percentile(std::vector<double>& values, double fraction) {
+        if (values.empty()) {
+            return 0.0;
+        }
+        size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+
+    // Every cell of a bench frame holds its sequence number
+    bool isBenchFrame(const IL::SharedFrame& frame) {
+        IL::Cell expected = static_cast<IL::Cell>(frame.sequence);
+        bool intact = true;
+        for (int i = 0; i < IL::CANVAS_CELLS; i++) {
+            intact &= frame.cells[i] == expected;
+        }
+        return intact && frame.attrs[0].style == static_cast<uint8_t>(frame.sequence) &&
+            frame.attrs[IL::CANVAS_CELLS - 1].style == static_cast<uint8_t>(frame.sequence);
+    }
+
+    bool runScenario(const char* name, int consumers, int frames, int framesPerSecond) {
+        std::string ringName = "InbetweenLinesBench" + std::to_string(nowNs());
+        IL::FrameRingWriter writer;
+        if (!writer.Create(ringName, IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT, BENCH_SLOTS)) {
+            std::fprintf(stderr, "Failed to create the shared memory ring %s\n", ringName.c_str());
+            return false;
+        }
+
+        // Each consumer maps the ring itself, as another process would
+        std::vector<Consumed> results(consumers);
+        std::atomic<int> ready = 0;
+        std::atomic<bool> failed = false;
+        std::vector<std::thread> threads;
+        for (int c = 0; c < consumers; c++) {
+            results[c].latencies.reserve(frames);
+            threads.emplace_back([&, c] {
+                IL::FrameRingReader reader;
+                if (!reader.Open(ringName)) {
+                    failed = true;
+                    ready++;
+                    return;
+                }
+                ready++;
+                consume(reader, 1, results[c], isBenchFrame, [] { std::this_thread::yield(); });
+            });
+        }
+        while (ready.load() < consumers) {
+            std::this_thread::yield();
+        }
+
+        std::vector<IL::Cell> cells(IL::CANVAS_CELLS);
+        std::vector<IL::CellAttr> attrs(IL::CANVAS_CELLS);
+        Clock::duration publishing = {};
+        Clock::time_point start = Clock::now();
+        for (int i = 1; i <= frames; i++) {
+            if (framesPerSecond > 0) {
+                std::this_thread::sleep_until(start + std::chrono::nanoseconds(1000000000ll * i / framesPerSecond));
+            }
+
+            std::fill(cells.begin(), cells.end(), static_cast<IL::Cell>(i));
+            std::fill(attrs.begin(), attrs.end(), IL::CellAttr{ IL::Color::Default, IL::Color::Default, static_cast<uint8_t>(i) });
+            Clock::time_point before = Clock::now();
+            writer.Publish(cells.data(), attrs.data());
+            publishing += Clock::now() - before;
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        writer.Close();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        if (failed) {
+            std::fprintf(stderr, "A consumer failed to open the shared memory ring %s\n", ringName.c_str());
+            return false;
+        }
+
+        Consumed total;
+        for (Consumed& result : results) {
+            total.read += result.read;
+            total.torn += result.torn;
+            total.corrupt += result.corrupt;
+            total.latencies.insert(total.latencies.end(), result.latencies.begin(), result.latencies.end());
+        }
+
+        double p50 = percentile(total.latencies, 0.5);
+        double p99 = percentile(total.latencies, 0.99);
+        std::printf("%-6s %d consumer%s %9.0f frames/s  %5.2f us/publish  %5.1f%% read  %6llu torn  latency p50 %7.1f us  p99 %8.1f us  %s\n",
+            name, consumers, consumers == 1 ? " " : "s", frames / seconds,
+            std::chrono::duration<double, std::micro>(publishing).count() / frames,
+            100.0 * total.read / (static_cast<double>(frames) * consumers), static_cast<unsigned long long>(total.torn), p50, p99,
+            total.corrupt == 0 ? "intact" : "CORRUPT");
+        return total.corrupt == 0;
+    }
+}
+
+bool watchFrameRing(const std::string& name) {
+    IL::FrameRingReader ring;
+    Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(WATCH_WAIT_MS);
+    while (!ring.Open(name)) {
+        if (Clock::now() >= deadline) {
+            std::fprintf(stderr, "No frame ring named %s appeared\n", name.c_str());
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::printf("watching %s: %dx%d cells, %d slots\n", name.c_str(), ring.GetWidth(), ring.GetHeight(), ring.GetSlots());
+
+    // From the newest frame on, what came before it is history
+    int cells = ring.GetWidth() * ring.GetHeight();
+    uint64_t blank = 0;
+    Consumed consumed;
+    Clock::time_point start = Clock::now();
+    consume(ring, std::max<uint64_t>(1, ring.GetLatest()), consumed,
+        [&](const IL::SharedFrame& frame) {
+            blank += std::all_of(frame.cells, frame.cells + cells, [](IL::Cell cell) { return cell == 0 || cell == u' '; }) ? 1 : 0;
+            return true;
+        },
+        [] { std::this_thread::sleep_for(std::chrono::microseconds(WATCH_POLL_US)); });
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::printf("frames:     %llu read, %llu missed, %llu torn, %llu blank\n", static_cast<unsigned long long>(consumed.read),
+        static_cast<unsigned long long>(consumed.missed), static_cast<unsigned long long>(consumed.torn), static_cast<unsigned long long>(blank));
+    std::printf("elapsed:    %.3f s (%.0f frames/s read)\n", seconds, seconds > 0.0 ? consumed.read / seconds : 0.0);
+    std::printf("latency:    p50 %.1f us, p99 %.1f us\n", percentile(consumed.latencies, 0.5), percentile(consumed.latencies, 0.99));
+    return true;
+}
+
+bool runFrameRingBenchmark(int frames) {
+    std::printf("%d frames of %dx%d cells (%zu bytes) through %d slots\n", frames, IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT,
+        IL::CANVAS_CELLS * (sizeof(IL::Cell) + sizeof(IL::CellAttr)), BENCH_SLOTS);
+
+    bool ok = true;
+    for (int consumers : { 1, 2, 4 }) {
+        ok = runScenario("flood", consumers, frames, 0) && ok;
+    }
+    ok = runScenario("1 kHz", 4, PACED_FRAMES, PACED_RATE) && ok;
+    return ok;
+}
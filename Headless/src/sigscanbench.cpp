@@ -0,0 +1,140 @@
+#include "sigscanbench.h"
+#include "game.h"
+#include "pe.h"
+#include "sigscan.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <vector>
+
+namespace {
+    constexpr uint32_t MIN_LENGTH = 6;       // Pattern lengths, in bytes
+    constexpr uint32_t MAX_LENGTH = 32;
+    constexpr uint32_t WILDCARD_SHARE = 4;   // About one byte in this many is a wildcard
+    constexpr uint32_t ABSENT_SHARE = 8;     // One pattern in this many is random rather than cut from the image
+    constexpr double MIN_SECONDS = 0.25;     // Each search repeats every pattern until it has run this long
+
+    using Clock = std::chrono::steady_clock;
+    using Search = size_t (*)(const uint8_t* data, size_t size, const IL::Signature& signature);
+
+    struct Pattern {
+        IL::Signature signature;
+        size_t section = 0;
+    };
+
+    // Where a search found the pattern, or SIZE_MAX
+    struct Timing {
+        std::vector<size_t> found;
+        double seconds = 0.0;
+        double bytes = 0.0; // Looked at until the first match or the end of the section
+    };
+
+    Pattern makePattern(const std::vector<std::span<const uint8_t>>& sections, Random& random) {
+        Pattern pattern;
+        pattern.section = random.Next() % sections.size();
+        std::span<const uint8_t> bytes = sections[pattern.section];
+
+        uint32_t length = MIN_LENGTH + random.Next() % (MAX_LENGTH - MIN_LENGTH + 1);
+        if (length > bytes.size()) {
+            length = static_cast<uint32_t>(bytes.size());
+        }
+
+        bool absent = random.Next() % ABSENT_SHARE == 0;
+        size_t start = random.Next() % (bytes.size() - length + 1);
+        for (uint32_t i = 0; i < length; i++) {
+            // FindSignature wants at least one byte that must match, the first always does
+            bool wildcard = i > 0 && random.Next() % WILDCARD_SHARE == 0;
+            uint8_t value = absent ? static_cast<uint8_t>(random.Next()) : bytes[start + i];
+            pattern.signature.bytes.push_back(wildcard ? 0 : value);
+            pattern.signature.mask.push_back(wildcard ? 0 : 0xFF);
+        }
+        return pattern;
+    }
+
+    Timing timeSearch(Search search, const std::vector<std::span<const uint8_t>>& sections, const std::vector<Pattern>& patterns) {
+        Timing timing;
+        timing.found.resize(patterns.size());
+
+        int rounds = 0;
+        Clock::time_point start = Clock::now();
+        do {
+            for (size_t i = 0; i < patterns.size(); i++) {
+                std::span<const uint8_t> bytes = sections[patterns[i].section];
+                timing.found[i] = search(bytes.data(), bytes.size(), patterns[i].signature);
+            }
+            rounds++;
+            timing.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        } while (timing.seconds < MIN_SECONDS);
+
+        for (size_t i = 0; i < patterns.size(); i++) {
+            size_t size = sections[patterns[i].section].size();
+            timing.bytes += timing.found[i] == SIZE_MAX ? size : timing.found[i] + patterns[i].signature.bytes.size();
+        }
+        timing.bytes *= rounds;
+        return timing;
+    }
+}
+
+bool runSigscanBenchmark(const std::string& path, int patterns) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::fprintf(stderr, "Failed to open %s\n", path.c_str());
+        return false;
+    }
+    std::vector<uint8_t> image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    IL::PeImage pe;
+    if (!IL::ParsePeImage(image.data(), image.size(), pe)) {
+        std::fprintf(stderr, "%s is not a PE image\n", path.c_str());
+        return false;
+    }
+
+    // Patterns are searched for where a scanner would look for code
+    std::vector<std::span<const uint8_t>> sections;
+    size_t scanned = 0;
+    for (const IL::PeSection& section : pe.sections) {
+        std::span<const uint8_t> bytes = IL::PeSectionBytes(image.data(), image.size(), section, false);
+        if ((section.characteristics & IL::PE_SECTION_EXECUTE) != 0 && bytes.size() >= MAX_LENGTH) {
+            sections.push_back(bytes);
+            scanned += bytes.size();
+        }
+    }
+    std::printf("%s: machine 0x%04x, %zu sections, %zu executable (%.1f KiB)\n", path.c_str(), pe.machine,
+        pe.sections.size(), sections.size(), scanned / 1024.0);
+    if (sections.empty()) {
+        std::fprintf(stderr, "No executable section to search\n");
+        return false;
+    }
+
+    Random random;
+    random.Seed(34);
+    std::vector<Pattern> searches;
+    for (int i = 0; i < patterns; i++) {
+        searches.push_back(makePattern(sections, random));
+    }
+
+    Timing scalar = timeSearch(IL::FindSignatureScalar, sections, searches);
+    Timing fast = timeSearch(IL::FindSignature, sections, searches);
+
+    int found = 0;
+    int mismatches = 0;
+    for (size_t i = 0; i < searches.size(); i++) {
+        found += fast.found[i] != SIZE_MAX ? 1 : 0;
+        mismatches += fast.found[i] != scalar.found[i] ? 1 : 0;
+    }
+
+    double scalarRate = scalar.bytes / scalar.seconds / 1e9;
+    double fastRate = fast.bytes / fast.seconds / 1e9;
+    std::printf("%d patterns of %u-%u bytes, 1 in %u bytes a wildcard, %d found\n", patterns, MIN_LENGTH, MAX_LENGTH,
+        WILDCARD_SHARE, found);
+    std::printf("scalar      %6.2f GB/s\n", scalarRate);
+    std::printf("sigscan     %6.2f GB/s (%.1fx, AVX2 where the CPU has it)\n", fastRate, fastRate / scalarRate);
+    std::printf("first matches %s\n", mismatches == 0 ? "agree" : "DIFFER");
+    if (mismatches > 0) {
+        std::printf("%d patterns differ\n", mismatches);
+    }
+    return mismatches == 0;
+}
@@ -0,0 +1,149 @@
+#include "spritebench.h"
+#include "allocstats.h"
+#include "game.h"
+#include "headless.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+    constexpr int SPRITE_COUNTS[] = { 1000, 10000, 100000 };
+    constexpr int POSES = 4;                    // Idle, squash, jump and fall, as GetPlayerPose picks them
+    constexpr int ORIGIN_X = 20;                // Where each atlas entry is drawn alone, in player units
+    constexpr int ORIGIN_Y = 10;
+    constexpr int FOOTPRINT_WIDTH = (PLAYER_WIDTH + 2) * 2; // Covers every pose's sprite and offset, in cells
+    constexpr int FOOTPRINT_HEIGHT = PLAYER_HEIGHT + 4;
+    constexpr int FOOTPRINT_TOP = -2;
+
+    using Clock = std::chrono::steady_clock;
+
+    // An atlas entry as it lands on the canvas relative to the player's position, 0 where it is transparent
+    struct Footprint {
+        IL::Cell cells[FOOTPRINT_WIDTH * FOOTPRINT_HEIGHT] = {};
+        IL::CellAttr attrs[FOOTPRINT_WIDTH * FOOTPRINT_HEIGHT] = {};
+    };
+
+    struct Sprite {
+        Player player;
+        int look = 0;
+        int footprint = 0; // Into the footprints, by look, pose and blink
+    };
+
+    // The fields GetPlayerPose looks at, set for one pose
+    void setPose(Player& player, int pose) {
+        player.physics.isOnGround = pose < 2;
+        player.isMovingHorizontal = pose == 1;
+        player.physics.velocityY = pose == 2 ? -IL::CellsToFixed(1) : pose == 3 ? IL::CellsToFixed(3) : 0;
+    }
+
+    void drawPlayers(HeadlessCanvas& canvas, const Sprite* sprites, size_t count) {
+        canvas.Begin();
+        canvas.BeginLayer(IL::Layer::Entities);
+        for (size_t i = 0; i < count; i++) {
+            RenderPlayer(canvas, sprites[i].player, sprites[i].look);
+        }
+        canvas.End();
+    }
+
+    // Draws every atlas entry alone and keeps what it left on the canvas
+    std::vector<Footprint> captureFootprints(HeadlessCanvas& canvas) {
+        std::vector<Footprint> footprints;
+        for (int look = 0; look < 2; look++) {
+            for (int pose = 0; pose < POSES; pose++) {
+                for (int blinking = 0; blinking < 2; blinking++) {
+                    Sprite sprite;
+                    sprite.look = look;
+                    sprite.player.position = { ORIGIN_X, ORIGIN_Y };
+                    sprite.player.isBlinking = blinking != 0;
+                    setPose(sprite.player, pose);
+                    drawPlayers(canvas, &sprite, 1);
+
+                    Footprint& footprint = footprints.emplace_back();
+                    for (int y = 0; y < FOOTPRINT_HEIGHT; y++) {
+                        for (int x = 0; x < FOOTPRINT_WIDTH; x++) {
+                            int index = (ORIGIN_Y + FOOTPRINT_TOP + y) * IL::CANVAS_WIDTH + ORIGIN_X * 2 + x;
+                            footprint.cells[y * FOOTPRINT_WIDTH + x] = canvas.GetCells()[index];
+                            footprint.attrs[y * FOOTPRINT_WIDTH + x] = canvas.GetAttrs()[index];
+                        }
+                    }
+                }
+            }
+        }
+        return footprints;
+    }
+
+    // The same frame a cell at a time, later sprites over earlier ones and everything off screen dropped
+    bool matchesReference(const HeadlessCanvas& canvas, const std::vector<Sprite>& sprites, size_t count,
+        const std::vector<Footprint>& footprints, std::vector<IL::Cell>& cells, std::vector<IL::CellAttr>& attrs) {
+        cells.assign(IL::CANVAS_CELLS, 0);
+        attrs.assign(IL::CANVAS_CELLS, IL::DEFAULT_ATTR);
+        for (size_t i = 0; i < count; i++) {
+            const Footprint& footprint = footprints[sprites[i].footprint];
+            int left = sprites[i].player.position.x * 2;
+            int top = sprites[i].player.position.y + FOOTPRINT_TOP;
+            for (int y = 0; y < FOOTPRINT_HEIGHT; y++) {
+                for (int x = 0; x < FOOTPRINT_WIDTH; x++) {
+                    IL::Cell cell = footprint.cells[y * FOOTPRINT_WIDTH + x];
+                    int cx = left + x;
+                    int cy = top + y;
+                    if (cell != 0 && cx >= 0 && cx < IL::CANVAS_WIDTH && cy >= 0 && cy < IL::CANVAS_HEIGHT) {
+                        cells[cy * IL::CANVAS_WIDTH + cx] = cell;
+                        attrs[cy * IL::CANVAS_WIDTH + cx] = footprint.attrs[y * FOOTPRINT_WIDTH + x];
+                    }
+                }
+            }
+        }
+
+        for (int i = 0; i < IL::CANVAS_CELLS; i++) {
+            if (canvas.GetCells()[i] != cells[i] || canvas.GetAttrs()[i] != attrs[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+bool runSpriteBenchmark(int frames) {
+    HeadlessCanvas canvas;
+    std::vector<Footprint> footprints = captureFootprints(canvas);
+
+    // Anywhere on the canvas, including partly off every edge
+    Random random;
+    random.Seed(27);
+    std::vector<Sprite> sprites(SPRITE_COUNTS[std::size(SPRITE_COUNTS) - 1]);
+    for (Sprite& sprite : sprites) {
+        int pose = static_cast<int>(random.Next() % POSES);
+        sprite.look = static_cast<int>(random.Next() % 2);
+        sprite.player.isBlinking = random.Next() % 8 == 0;
+        sprite.player.position.x = static_cast<int>(random.Next() % (IL::CANVAS_WIDTH / 2 + PLAYER_WIDTH + 2)) - PLAYER_WIDTH - 1;
+        sprite.player.position.y = static_cast<int>(random.Next() % (IL::CANVAS_HEIGHT + PLAYER_HEIGHT + 4)) - PLAYER_HEIGHT - 2;
+        sprite.footprint = (sprite.look * POSES + pose) * 2 + (sprite.player.isBlinking ? 1 : 0);
+        setPose(sprite.player, pose);
+    }
+
+    std::printf("%zu atlas entries, %d frames per count\n", footprints.size(), frames);
+    std::printf("sprites  frame us  ns/sprite\n");
+    bool identical = true;
+    uint64_t steadyAllocations = 0;
+    std::vector<IL::Cell> cells;
+    std::vector<IL::CellAttr> attrs;
+    for (int count : SPRITE_COUNTS) {
+        drawPlayers(canvas, sprites.data(), count);
+        identical = matchesReference(canvas, sprites, count, footprints, cells, attrs) && identical;
+
+        IL::AllocationScope scope;
+        Clock::time_point start = Clock::now();
+        for (int frame = 0; frame < frames; frame++) {
+            drawPlayers(canvas, sprites.data(), count);
+        }
+        double frameNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / frames;
+        steadyAllocations += scope.GetCount();
+
+        std::printf("%7d  %8.1f  %9.1f\n", count, frameNs / 1000.0, frameNs / count);
+    }
+
+    std::printf("frames %s, %llu heap allocations after the first frame of each count\n",
+        identical ? "match the reference" : "DIFFER", static_cast<unsigned long long>(steadyAllocations));
+    return identical && steadyAllocations == 0;
+}
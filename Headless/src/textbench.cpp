@@ -0,0 +1,112 @@
+#include "textbench.h"
+#include "headless.h"
+#include "textlayout.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string_view>
+#include <vector>
+
+namespace {
+    constexpr int COLUMNS = 6;
+    constexpr int ROWS = 8;
+    constexpr int BOXES = COLUMNS * ROWS;
+    constexpr int BOX_WIDTH = 26;
+    constexpr int BOX_HEIGHT = 4;
+    constexpr int LIVE_EVERY = 12; // One box in this many shows numbers that change every frame
+
+    using Clock = std::chrono::steady_clock;
+
+    constexpr std::string_view PARAGRAPHS[] = {
+        "Collect coins before they explode, high value coins are worth twice as much.",
+        "P1: WASD to move and jump.\nP2: arrows to move and jump.",
+        "Platforms can be jumped through from below but not fallen through from above.",
+        "Objective: be the first to reach the target score, or hold the lead when time runs out.",
+        "Tip: the top platform sees the most coins but is the hardest to reach in time.",
+        "Ünïcödé wörks tóö, and so do wide glyphs like 漢字 and かな mixed into a sentence.",
+        "A word that does not fit, supercalifragilisticexpialidocious, is split across lines.",
+        "Short line.",
+    };
+
+    uint64_t hashFrame(const HeadlessCanvas& canvas) {
+        uint64_t hash = 14695981039346656037ull;
+        for (int i = 0; i < IL::CANVAS_CELLS; i++) {
+            hash = (hash ^ canvas.GetCells()[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // The box's text this frame and where it goes
+    struct Box {
+        int x;
+        int y;
+        IL::TextAlign align;
+        std::string_view text;
+    };
+
+    Box boxAt(HeadlessCanvas& canvas, int index, int frame) {
+        Box box;
+        box.x = (index % COLUMNS) * (BOX_WIDTH + 1);
+        box.y = (index / COLUMNS) * BOX_HEIGHT + 1;
+        box.align = static_cast<IL::TextAlign>(index % 3);
+        box.text = index % LIVE_EVERY == 0
+            ? canvas.Format("Frame {} of the run, {} boxes drawn so far", frame, static_cast<long long>(frame) * BOXES + index)
+            : PARAGRAPHS[index % std::size(PARAGRAPHS)];
+        return box;
+    }
+}
+
+bool runTextLayoutBenchmark(int frames) {
+    HeadlessCanvas uncached;
+    HeadlessCanvas cached;
+    std::vector<IL::TextLayout> layouts(BOXES);
+
+    double uncachedMs = 0.0;
+    double cachedMs = 0.0;
+    double blitMs = 0.0;
+    bool same = true;
+    for (int frame = 0; frame < frames; frame++) {
+        // Only the boxes are timed, not clearing and compositing the frame
+        uncached.Begin();
+        uncached.BeginLayer(IL::Layer::HUD);
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < BOXES; i++) {
+            Box box = boxAt(uncached, i, frame);
+            layouts[i].Layout(box.text, BOX_WIDTH, BOX_HEIGHT, box.align);
+            uncached.Blit(layouts[i].View(), box.x, box.y, false);
+        }
+        uncachedMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        // What drawing costs anyway, the same layouts blitted again
+        start = Clock::now();
+        for (int i = 0; i < BOXES; i++) {
+            Box box = boxAt(uncached, i, frame);
+            uncached.Blit(layouts[i].View(), box.x, box.y, false);
+        }
+        blitMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        uncached.End();
+
+        cached.Begin();
+        cached.BeginLayer(IL::Layer::HUD);
+        start = Clock::now();
+        for (int i = 0; i < BOXES; i++) {
+            Box box = boxAt(cached, i, frame);
+            cached.TextBox(box.text, box.x, box.y, BOX_WIDTH, BOX_HEIGHT, box.align, false);
+        }
+        cachedMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        cached.End();
+
+        same = same && hashFrame(uncached) == hashFrame(cached);
+    }
+
+    const IL::TextLayoutCache& cache = cached.GetTextLayouts();
+    double lookups = static_cast<double>(cache.GetHits() + cache.GetMisses());
+    std::printf("%d frames of %d text boxes (%dx%d cells), %d changing every frame\n", frames, BOXES, BOX_WIDTH, BOX_HEIGHT, BOXES / LIVE_EVERY);
+    std::printf("uncached  %7.1f us per frame\n", uncachedMs * 1000.0 / frames);
+    std::printf("cached    %7.1f us per frame, %.1f%% of layouts from the cache\n",
+        cachedMs * 1000.0 / frames, lookups > 0.0 ? 100.0 * cache.GetHits() / lookups : 0.0);
+    std::printf("blit only %7.1f us per frame, layout costs %.1f us uncached and %.1f us cached (%.1fx)\n", blitMs * 1000.0 / frames,
+        (uncachedMs - blitMs) * 1000.0 / frames, (cachedMs - blitMs) * 1000.0 / frames, (uncachedMs - blitMs) / (cachedMs - blitMs));
+    std::printf("cached and uncached frames %s\n", same ? "match" : "DO NOT MATCH");
+    return same;
+}
@@ -0,0 +1,118 @@
+#include "timerbench.h"
+#include "timingwheel.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr uint32_t BENCH_TIMERS = 1 << 20;
+    constexpr int INDEX_BITS = 20;
+    constexpr uint64_t SHORT_DELAYS = uint64_t(1) << 17;   // Most timers, about half an hour at 60fps
+    constexpr int LONG_PERCENT = 1;                         // The rest wait past the wheel's reach
+    constexpr int COUNTDOWN_TICKS = 200;
+
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedNs(Clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    enum TimerState : uint8_t {
+        PENDING,
+        CANCELLED,
+        FIRED,
+    };
+}
+
+bool runTimerBenchmark() {
+    std::mt19937_64 random(41);
+    std::uniform_int_distribution<uint64_t> shortDelays(1, SHORT_DELAYS);
+    std::uniform_int_distribution<uint64_t> longDelays(IL::TimingWheel::MAX_DELAY, 2 * IL::TimingWheel::MAX_DELAY);
+    std::uniform_int_distribution<int> percent(0, 99);
+
+    std::vector<uint64_t> delays(BENCH_TIMERS);
+    for (uint64_t& delay : delays) {
+        delay = percent(random) < LONG_PERCENT ? longDelays(random) : shortDelays(random);
+    }
+
+    // The payload carries the deadline and the timer's index so firing can be checked
+    IL::TimingWheel wheel;
+    std::vector<IL::TimerId> ids(BENCH_TIMERS);
+    Clock::time_point start = Clock::now();
+    for (uint32_t i = 0; i < BENCH_TIMERS; i++) {
+        ids[i] = wheel.Schedule(delays[i], (delays[i] << INDEX_BITS) | i);
+    }
+    double scheduleNs = elapsedNs(start);
+
+    std::vector<uint8_t> states(BENCH_TIMERS, PENDING);
+    start = Clock::now();
+    for (uint32_t i = 0; i < BENCH_TIMERS; i += 2) {
+        wheel.Cancel(ids[i]);
+    }
+    double cancelNs = elapsedNs(start);
+    for (uint32_t i = 0; i < BENCH_TIMERS; i += 2) {
+        states[i] = CANCELLED;
+    }
+
+    size_t remaining = wheel.GetPending();
+    bool correct = remaining == BENCH_TIMERS / 2;
+
+    uint64_t fired = 0;
+    uint64_t misfired = 0;
+    uint64_t shortTicks = 0;
+    double shortNs = 0.0;
+    start = Clock::now();
+    while (wheel.GetPending() > 0) {
+        wheel.Advance([&](uint64_t payload) {
+            uint32_t index = static_cast<uint32_t>(payload & ((1u << INDEX_BITS) - 1));
+            if ((payload >> INDEX_BITS) != wheel.Now() || states[index] != PENDING) {
+                misfired++;
+            }
+            states[index] = FIRED;
+            fired++;
+        });
+
+        if (wheel.Now() == SHORT_DELAYS) {
+            shortTicks = wheel.Now();
+            shortNs = elapsedNs(start);
+        }
+    }
+    double advanceNs = elapsedNs(start);
+    uint64_t ticks = wheel.Now();
+
+    for (uint32_t i = 0; i < BENCH_TIMERS; i++) {
+        correct = correct && states[i] == (i % 2 == 0 ? CANCELLED : FIRED);
+    }
+    correct = correct && misfired == 0 && fired == remaining;
+
+    // The same live timers as countdowns decremented every tick, only a few ticks as each one visits all of them
+    std::vector<uint32_t> countdowns;
+    countdowns.reserve(remaining);
+    for (uint32_t i = 1; i < BENCH_TIMERS; i += 2) {
+        countdowns.push_back(static_cast<uint32_t>(delays[i] < UINT32_MAX ? delays[i] : UINT32_MAX));
+    }
+    uint64_t countdownFired = 0;
+    start = Clock::now();
+    for (int tick = 0; tick < COUNTDOWN_TICKS; tick++) {
+        for (uint32_t& countdown : countdowns) {
+            if (countdown > 0 && --countdown == 0) {
+                countdownFired++;
+            }
+        }
+    }
+    double countdownNs = elapsedNs(start) / COUNTDOWN_TICKS;
+
+    std::printf("%u timers, 1 in %d waiting longer than the wheel's reach\n", BENCH_TIMERS, 100 / LONG_PERCENT);
+    std::printf("schedule  %7.1f ns per timer\n", scheduleNs / BENCH_TIMERS);
+    std::printf("cancel    %7.1f ns per timer (%u cancelled)\n", cancelNs / (BENCH_TIMERS / 2), BENCH_TIMERS / 2);
+    std::printf("advance   %7.1f ns per tick over %llu ticks, %.1f ns per tick while most timers are due (%llu ticks)\n",
+        advanceNs / ticks, static_cast<unsigned long long>(ticks), shortNs / shortTicks, static_cast<unsigned long long>(shortTicks));
+    std::printf("fired     %llu timers, %.1f million per second of advancing\n",
+        static_cast<unsigned long long>(fired), fired / advanceNs * 1000.0);
+    std::printf("countdown %7.0f ns per tick for the same %zu timers (%.0fx the wheel's busy ticks, %llu fired)\n",
+        countdownNs, remaining, countdownNs / (shortNs / shortTicks), static_cast<unsigned long long>(countdownFired));
+    std::printf("every timer fired %s\n", correct ? "once, on its deadline" : "INCORRECTLY");
+    return correct;
+}
@@ -0,0 +1,195 @@
+#include "videotool.h"
+#include "glyphvideo.h"
+#include "headless.h"
+#include "imagebench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr int BENCH_FRAMES = 1800;       // 30 seconds at 60fps
+    constexpr int BENCH_SOURCE_WIDTH = 660;  // Four pixels per cell across
+    constexpr int BENCH_SOURCE_HEIGHT = 304; // Eight pixels per cell down
+    constexpr int BENCH_SEEKS = 2000;
+
+    // A ball bouncing over a slowly scrolling gradient, with a hard cut every ten seconds
+    void drawBenchFrame(int frame, std::vector<uint8_t>& pixels) {
+        double t = frame / 60.0;
+        double ballX = BENCH_SOURCE_WIDTH * (0.5 + 0.4 * std::sin(t * 1.3));
+        double ballY = BENCH_SOURCE_HEIGHT * (0.8 - 0.6 * std::fabs(std::sin(t * 2.1)));
+        bool inverted = (frame / 600) % 2 == 1;
+
+        for (int y = 0; y < BENCH_SOURCE_HEIGHT; y++) {
+            for (int x = 0; x < BENCH_SOURCE_WIDTH; x++) {
+                double dx = x - ballX;
+                double dy = (y - ballY) * 2.0;
+                double value = std::fmod(x / static_cast<double>(BENCH_SOURCE_WIDTH) + t * 0.05, 1.0) * 0.6;
+                if (dx * dx + dy * dy < 40.0 * 40.0) {
+                    value = 1.0;
+                }
+                if (inverted) {
+                    value = 1.0 - value;
+                }
+                pixels[static_cast<size_t>(y) * BENCH_SOURCE_WIDTH + x] = static_cast<uint8_t>(value * 255.0);
+            }
+        }
+    }
+
+    uint64_t hashCells(const IL::Cell* cells, size_t count) {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < count; i++) {
+            hash = (hash ^ cells[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+}
+
+bool encodeVideo(const std::string& framesDirectory, const std::string& output, double fps, IL::Dither dither) {
+    std::vector<fs::path> frames;
+    std::error_code ec;
+    for (const auto& item : fs::directory_iterator(framesDirectory, ec)) {
+        std::string extension = item.path().extension().string();
+        if (extension == ".pgm" || extension == ".ppm") {
+            frames.push_back(item.path());
+        }
+    }
+    std::sort(frames.begin(), frames.end());
+    if (frames.empty()) {
+        std::fprintf(stderr, "No PGM or PPM frames in %s\n", framesDirectory.c_str());
+        return false;
+    }
+
+    IL::GlyphConverter converter(IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT);
+    IL::GlyphOptions options;
+    options.dither = dither;
+
+    IL::GlyphVideoWriter writer;
+    if (!writer.Open(output, IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT, fps)) {
+        std::fprintf(stderr, "Failed to create %s\n", output.c_str());
+        return false;
+    }
+
+    std::vector<uint8_t> pixels;
+    for (const fs::path& frame : frames) {
+        IL::ImageView image;
+        if (!loadPnm(frame.string(), pixels, image)) {
+            std::fprintf(stderr, "Failed to load %s\n", frame.string().c_str());
+            return false;
+        }
+        converter.Convert(image, options);
+        writer.AddFrame(converter.GetCells());
+    }
+
+    if (!writer.Finish()) {
+        std::fprintf(stderr, "Failed to write %s\n", output.c_str());
+        return false;
+    }
+
+    std::printf("%zu frames, %llu bytes (%.0f bytes per frame)\n", frames.size(),
+        static_cast<unsigned long long>(writer.GetBytesWritten()), static_cast<double>(writer.GetBytesWritten()) / frames.size());
+    return true;
+}
+
+bool playVideo(const std::string& path) {
+    IL::GlyphVideoPlayer player;
+    if (!player.Open(path)) {
+        std::fprintf(stderr, "Failed to open %s\n", path.c_str());
+        return false;
+    }
+
+    HeadlessCanvas canvas(true);
+    auto frameTime = std::chrono::duration<double>(1.0 / player.GetFrameRate());
+    player.Play();
+    while (player.Update()) {
+        canvas.Begin();
+        canvas.BeginLayer(IL::Layer::World);
+        canvas.Blit(player.View(), 0, 0, false);
+        canvas.End();
+        std::fwrite(canvas.GetAnsiFrame().data(), 1, canvas.GetAnsiFrame().size(), stdout);
+        std::fflush(stdout);
+        std::this_thread::sleep_for(frameTime);
+    }
+    std::printf("\033[0m\n");
+    return true;
+}
+
+bool runVideoBenchmark() {
+    fs::path path = fs::temp_directory_path() / "InbetweenLines-bench.ilgv";
+    size_t cellCount = static_cast<size_t>(IL::CANVAS_WIDTH) * IL::CANVAS_HEIGHT;
+
+    // Encode, remembering what every frame should decode to
+    std::vector<uint64_t> expected(BENCH_FRAMES);
+    {
+        std::vector<uint8_t> pixels(static_cast<size_t>(BENCH_SOURCE_WIDTH) * BENCH_SOURCE_HEIGHT);
+        IL::ImageView image = { pixels.data(), BENCH_SOURCE_WIDTH, BENCH_SOURCE_HEIGHT, BENCH_SOURCE_WIDTH, IL::PixelFormat::Gray8 };
+        IL::GlyphConverter converter(IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT);
+        IL::GlyphVideoWriter writer;
+        if (!writer.Open(path, IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT, 60.0)) {
+            std::fprintf(stderr, "Failed to create %s\n", path.string().c_str());
+            return false;
+        }
+
+        for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+            drawBenchFrame(frame, pixels);
+            converter.Convert(image);
+            writer.AddFrame(converter.GetCells());
+            expected[frame] = hashCells(converter.GetCells(), cellCount);
+        }
+        writer.Finish();
+
+        uint64_t raw = static_cast<uint64_t>(BENCH_FRAMES) * cellCount * sizeof(IL::Cell);
+        std::printf("%d frames of %dx%d: %llu bytes, %.0f bytes per frame (raw %.1fx larger)\n", BENCH_FRAMES,
+            IL::CANVAS_WIDTH, IL::CANVAS_HEIGHT, static_cast<unsigned long long>(writer.GetBytesWritten()),
+            static_cast<double>(writer.GetBytesWritten()) / BENCH_FRAMES, static_cast<double>(raw) / writer.GetBytesWritten());
+    }
+
+    IL::GlyphVideoPlayer player;
+    if (!player.Open(path)) {
+        std::fprintf(stderr, "Failed to open %s\n", path.string().c_str());
+        return false;
+    }
+
+    // Sequential playback, checked frame by frame on the first pass
+    bool matched = true;
+    constexpr int PASSES = 5;
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < PASSES; pass++) {
+        player.Seek(0);
+        for (int frame = 1; frame < BENCH_FRAMES; frame++) {
+            if (!player.DecodeNext()) {
+                matched = false;
+                break;
+            }
+            if (pass == 0 && hashCells(player.GetCells(), cellCount) != expected[frame]) {
+                matched = false;
+            }
+        }
+    }
+    std::chrono::duration<double, std::micro> sequential = std::chrono::steady_clock::now() - start;
+    std::printf("sequential: %.2f us per frame\n", sequential.count() / (PASSES * BENCH_FRAMES));
+
+    std::mt19937 random(1);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_SEEKS; i++) {
+        uint32_t frame = random() % BENCH_FRAMES;
+        if (!player.Seek(frame) || hashCells(player.GetCells(), cellCount) != expected[frame]) {
+            matched = false;
+        }
+    }
+    std::chrono::duration<double, std::micro> seeks = std::chrono::steady_clock::now() - start;
+    std::printf("random seek: %.1f us per seek\n", seeks.count() / BENCH_SEEKS);
+    std::printf("decoded frames %s\n", matched ? "match" : "DO NOT MATCH");
+
+    player.Close();
+    std::error_code ec;
+    fs::remove(path, ec);
+    return matched;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+namespace IL {
+    /// @brief Heap allocations made by the calling thread so far, counted by the replaced global operator new
+    /// @details Covers everything that goes through new: containers, strings, std::function and make_unique.
+    ///          Direct malloc calls and allocations made by the operating system are not seen.
+    uint64_t GetAllocationCount();
+
+    /// @brief Bytes requested by those allocations
+    uint64_t GetAllocatedBytes();
+
+    /// @brief Counts the calling thread's heap allocations from construction on, e.g. around a frame
+    class AllocationScope {
+    public:
+        AllocationScope() : startCount(GetAllocationCount()), startBytes(GetAllocatedBytes()) {}
+
+        uint64_t GetCount() const { return GetAllocationCount() - startCount; }
+        uint64_t GetBytes() const { return GetAllocatedBytes() - startBytes; }
+
+    private:
+        uint64_t startCount;
+        uint64_t startBytes;
+    };
+}
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <vector>
+
+#include "timingwheel.h"
+
+namespace IL {
+    class BehaviorScheduler;
+
+    /// @brief Memory for coroutine frames: blocks in size classes of 64 bytes carved from large chunks and kept on
+    ///        free lists, so starting a behavior that ends up in a freed block does not touch the heap
+    /// @details Each block starts with the pool it came from, so a frame is freed without knowing its scheduler.
+    ///          Frames larger than the biggest class go to the heap. Not thread safe, frames are allocated and
+    ///          freed on the thread that runs their scheduler.
+    class CoroutineFramePool {
+    public:
+        CoroutineFramePool() = default;
+        ~CoroutineFramePool();
+
+        CoroutineFramePool(const CoroutineFramePool&) = delete;
+        CoroutineFramePool& operator=(const CoroutineFramePool&) = delete;
+
+        void* Allocate(size_t size);
+
+        /// @brief Returns a frame to the pool it came from
+        static void Free(void* frame);
+
+        size_t GetLive() const { return live; }
+
+        /// @brief Bytes of chunks taken from the heap
+        size_t GetReserved() const { return reserved; }
+
+    private:
+        static constexpr size_t GRANULE = 64;
+        static constexpr uint32_t CLASSES = 16;          // Frames up to 1 KiB less the header are pooled
+        static constexpr uint32_t LARGE = CLASSES;       // Size class of frames from the heap
+        static constexpr size_t CHUNK_BYTES = 64 * 1024;
+
+        struct alignas(16) Header {
+            CoroutineFramePool* pool;
+            uint32_t sizeClass;
+        };
+
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        FreeBlock* freeLists[CLASSES] = {};
+        std::vector<std::unique_ptr<std::byte[]>> chunks;
+        size_t live = 0;
+        size_t reserved = 0;
+    };
+
+    /// @brief Names a started behavior, stale ids are safe to stop or query
+    using BehaviorId = uint64_t;
+    constexpr BehaviorId INVALID_BEHAVIOR = 0;
+
+    /// @brief A coroutine the scheduler resumes only once what it waits for has happened
+    /// @details Write one as a free function returning Behavior whose first parameter is the BehaviorScheduler it
+    ///          runs on (only used to pick the frame pool, so it can stay unnamed), and wait with
+    ///          `co_await Frames(n)` or `co_await Until(condition)`. It starts suspended
+    ///          and runs up to its first wait when handed to BehaviorScheduler::Start. Parameters are copied into
+    ///          the frame as usual, so take what outlives the behavior (the match state) by reference.
+    class Behavior {
+    public:
+        struct promise_type {
+            BehaviorScheduler* scheduler;
+            uint32_t slot = 0;
+            TimerId timer = INVALID_TIMER; // Pending while it waits on Frames
+            int32_t poll = -1;             // Its entry in the scheduler's polls while it waits on Until
+
+            template<typename... Args>
+            promise_type(BehaviorScheduler& scheduler, Args&...) : scheduler(&scheduler) {}
+
+            template<typename... Args>
+            static void* operator new(size_t size, BehaviorScheduler& scheduler, Args&...);
+
+            static void operator delete(void* frame, size_t) { CoroutineFramePool::Free(frame); }
+
+            Behavior get_return_object() { return Behavior(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+
+        using Handle = std::coroutine_handle<promise_type>;
+
+        Behavior(Behavior&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+        Behavior(const Behavior&) = delete;
+        Behavior& operator=(const Behavior&) = delete;
+        Behavior& operator=(Behavior&&) = delete;
+
+        /// @brief Destroys a behavior that was never started
+        ~Behavior() {
+            if (handle) {
+                handle.destroy();
+            }
+        }
+
+    private:
+        friend class BehaviorScheduler;
+
+        explicit Behavior(Handle handle) : handle(handle) {}
+
+        Handle handle;
+    };
+
+    /// @brief Runs behaviors, resuming each only on the tick its wait is over
+    /// @details Behaviors waiting on Frames sit in a TimingWheel and cost nothing until they are due. Behaviors
+    ///          waiting on Until have their condition checked once a tick. Those ready on the same tick resume in
+    ///          the order they were started, so runs replay. A behavior that returns is freed. Behaviors and
+    ///          their frames belong to the thread running the scheduler.
+    class BehaviorScheduler {
+    public:
+        BehaviorScheduler() = default;
+        ~BehaviorScheduler() { Clear(); }
+
+        BehaviorScheduler(BehaviorScheduler&& other) noexcept { *this = std::move(other); }
+        BehaviorScheduler& operator=(BehaviorScheduler&& other) noexcept;
+
+        BehaviorScheduler(const BehaviorScheduler&) = delete;
+        BehaviorScheduler& operator=(const BehaviorScheduler&) = delete;
+
+        /// @brief Takes a behavior over and runs it up to its first wait
+        /// @return Its id, INVALID_BEHAVIOR if it already returned
+        BehaviorId Start(Behavior behavior);
+
+        /// @brief Destroys a behavior wherever it waits
+        /// @return Whether it was still running
+        bool Stop(BehaviorId id);
+
+        bool IsRunning(BehaviorId id) const { return Find(id) != NONE; }
+
+        /// @brief Moves to the next tick and resumes the behaviors whose wait ends on it
+        void Tick();
+
+        /// @brief Destroys every behavior
+        void Clear();
+
+        /// @brief Makes room for this many behaviors, starting up to it then never allocates past the frames
+        void Reserve(size_t behaviors);
+
+        /// @brief The number of Tick calls so far
+        uint64_t Now() const { return wheel.Now(); }
+
+        size_t GetRunning() const { return running; }
+        size_t GetPolling() const { return polls.size(); }
+        const CoroutineFramePool& GetPool() const { return *pool; }
+
+    private:
+        friend class Behavior;
+        friend struct FramesAwaiter;
+        template<typename Condition> friend struct UntilAwaiter;
+
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        struct Slot {
+            Behavior::Handle handle;
+            uint32_t generation = 1;  // Bumped when the behavior ends so old ids stop matching
+            uint64_t order = 0;       // When it was started, ready behaviors resume in this order
+        };
+
+        struct Poll {
+            uint32_t slot;
+            void* awaiter;
+            bool (*ready)(void* awaiter);
+        };
+
+        struct Ready {
+            uint64_t order;
+            uint32_t slot;
+            uint32_t generation;
+        };
+
+        // On the heap so frames keep their pool when the scheduler moves
+        std::unique_ptr<CoroutineFramePool> pool = std::make_unique<CoroutineFramePool>();
+        TimingWheel wheel;
+        std::vector<Slot> slots;
+        std::vector<uint32_t> freeSlots;
+        std::vector<Poll> polls;
+        std::vector<Ready> ready; // Scratch for Tick
+        size_t running = 0;
+        uint64_t started = 0;
+
+        uint32_t Find(BehaviorId id) const;
+
+        void Sleep(Behavior::promise_type& promise, uint32_t ticks);
+        void Wait(Behavior::promise_type& promise, void* awaiter, bool (*ready)(void*));
+        void RemovePoll(Behavior::promise_type& promise);
+
+        /// @brief Resumes a behavior and frees it once it has returned
+        void Resume(uint32_t slot);
+
+        void Release(uint32_t slot);
+    };
+
+    template<typename... Args>
+    void* Behavior::promise_type::operator new(size_t size, BehaviorScheduler& scheduler, Args&...) {
+        return scheduler.pool->Allocate(size);
+    }
+
+    struct FramesAwaiter {
+        uint32_t ticks;
+
+        bool await_ready() const { return ticks == 0; }
+        void await_suspend(Behavior::Handle handle) { handle.promise().scheduler->Sleep(handle.promise(), ticks); }
+        void await_resume() const {}
+    };
+
+    template<typename Condition>
+    struct UntilAwaiter {
+        Condition condition;
+
+        bool await_ready() { return condition(); }
+        void await_suspend(Behavior::Handle handle) { handle.promise().scheduler->Wait(handle.promise(), this, &Check); }
+        void await_resume() const {}
+
+        static bool Check(void* awaiter) { return static_cast<UntilAwaiter*>(awaiter)->condition(); }
+    };
+
+    /// @brief Waits this many ticks, 0 does not wait
+    inline FramesAwaiter Frames(uint32_t ticks) {
+        return { ticks };
+    }
+
+    /// @brief Waits until condition returns true, checked once a tick after the behaviors waiting on Frames ran
+    template<typename Condition>
+    UntilAwaiter<Condition> Until(Condition condition) {
+        return { std::move(condition) };
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "cellwidth.h"
+
+namespace IL {
+    constexpr int BRAILLE_DOTS_X = 2; // Dot columns per cell
+    constexpr int BRAILLE_DOTS_Y = 4; // Dot rows per cell
+    constexpr Cell BRAILLE_BLANK = u'\u2800';
+
+    /// @brief How a primitive combines with the dots already on the plane
+    enum class PixelOp {
+        Set,    // Turn dots on
+        Clear,  // Turn dots off
+        Invert, // Flip dots, drawing twice restores the plane
+    };
+
+    /// @brief Non-owning view of a 1-bit bitmap, bit x of a row is bit x % 64 of word x / 64
+    struct BitmapView {
+        const uint64_t* words = nullptr;
+        int width = 0;
+        int height = 0;
+        int stride = 0; // Words from one row to the next
+    };
+
+    /// @brief A 1-bit bitmap baked at compile time, see BakeBitmap
+    template<int Width, int Height>
+    struct Bitmap {
+        static constexpr int STRIDE = (Width + 63) / 64;
+
+        uint64_t words[STRIDE * Height] = {};
+
+        constexpr BitmapView View() const {
+            return { words, Width, Height, STRIDE };
+        }
+    };
+
+    /// @brief Bakes a bitmap from rows of equal length, '#' is a set dot, e.g. BakeBitmap(".##.", "#..#")
+    template<size_t N, typename... Rows>
+    consteval Bitmap<static_cast<int>(N - 1), static_cast<int>(sizeof...(Rows) + 1)> BakeBitmap(const char (&first)[N], const Rows&... rest) {
+        static_assert((std::is_same_v<Rows, char[N]> && ...), "Every bitmap row must have the same length");
+
+        using Baked = Bitmap<static_cast<int>(N - 1), static_cast<int>(sizeof...(Rows) + 1)>;
+        Baked bitmap;
+        const char* rows[] = { first, rest... };
+        for (int y = 0; y < static_cast<int>(sizeof...(Rows) + 1); y++) {
+            for (int x = 0; x < static_cast<int>(N - 1); x++) {
+                if (rows[y][x] == '#') {
+                    bitmap.words[y * Baked::STRIDE + x / 64] |= uint64_t(1) << (x % 64);
+                }
+            }
+        }
+
+        return bitmap;
+    }
+
+    /// @brief A bit-packed plane of dots drawn as braille glyphs, two dots across and four down per cell
+    /// @details Rows are arrays of 64-bit words so spans, circles and bitmaps are drawn a word at a time. Pack turns
+    ///          the plane into glyphs sixteen cells at a time with SSE2. Primitives clip to the plane.
+    class BraillePlane {
+    public:
+        /// @param columns The width of the plane in cells
+        /// @param rows The height of the plane in cells
+        BraillePlane(int columns, int rows);
+
+        /// @brief The width of the plane in dots
+        int GetWidth() const { return width; }
+
+        /// @brief The height of the plane in dots
+        int GetHeight() const { return height; }
+
+        /// @brief Turns every dot off
+        void Clear();
+
+        /// @brief Whether a dot is on, dots outside the plane are off
+        bool GetPixel(int x, int y) const;
+
+        void SetPixel(int x, int y, PixelOp op = PixelOp::Set);
+
+        /// @brief Draws a filled rectangle
+        void FillRect(int x, int y, int width, int height, PixelOp op = PixelOp::Set);
+
+        /// @brief Draws a one dot wide line with Bresenham's algorithm, including both end points
+        /// @details Mostly horizontal lines are drawn as runs along each row rather than dot by dot.
+        void Line(int x0, int y0, int x1, int y1, PixelOp op = PixelOp::Set);
+
+        /// @brief Draws a filled circle, one span per row
+        void FillCircle(int centerX, int centerY, int radius, PixelOp op = PixelOp::Set);
+
+        /// @brief Draws the set bits of a bitmap with its top left dot at x, y, clear bits leave the plane untouched
+        void Blit(const BitmapView& bitmap, int x, int y, PixelOp op = PixelOp::Set);
+
+        /// @brief Converts the plane into columns * rows cells, row major
+        /// @param cells Receives a braille glyph for every cell with a dot on, and zero for empty cells
+        void Pack(Cell* cells) const;
+
+        /// @brief Scalar reference implementation of Pack, produces identical cells
+        void PackScalar(Cell* cells) const;
+
+    private:
+        int columns;
+        int rows;
+        int width;
+        int height;
+        int stride; // Words per row, padded so Pack can read whole 32-bit groups past the last column
+        std::vector<uint64_t> words;
+
+        uint64_t* Row(int y) { return &words[static_cast<size_t>(y) * stride]; }
+        const uint64_t* Row(int y) const { return &words[static_cast<size_t>(y) * stride]; }
+
+        /// @brief Applies op to the dots [x0, x1) of row y, already clipped
+        void Span(int y, int x0, int x1, PixelOp op);
+    };
+}
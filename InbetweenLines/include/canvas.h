@@ -0,0 +1,297 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+#include "braille.h"
+#include "cellattr.h"
+#include "cellwidth.h"
+#include "fixedtext.h"
+#include "framearena.h"
+#include "sprite.h"
+#include "textlayout.h"
+
+namespace IL {
+    constexpr int CANVAS_WIDTH = 165;
+    constexpr int CANVAS_HEIGHT = 38;
+    constexpr int CANVAS_CELLS = CANVAS_WIDTH * CANVAS_HEIGHT;
+
+    /// @brief Render layers, composited bottom to top at End
+    enum class Layer : int {
+        Background = 0, // Static scenery, retained across frames by default
+        World,          // Coins, explosions and other level objects
+        Entities,       // Players
+        HUD,            // Scores and overlays
+        Count
+    };
+
+    constexpr int LAYER_COUNT = static_cast<int>(Layer::Count);
+
+    /// @brief Render target the game draws to, a layered and clipped grid of cells
+    /// @details Drawing, layering and compositing are platform independent. Implementations only decide what
+    ///          happens to a finished frame by overriding Present, e.g. Notepad copies it into the edit control.
+    class Canvas {
+    public:
+        Canvas();
+        virtual ~Canvas() = default;
+
+        Canvas(const Canvas&) = delete;
+        Canvas& operator=(const Canvas&) = delete;
+
+        /// @brief Writes text to the canvas, wide glyphs take two cells and combining marks are dropped
+        /// @param text The text to write
+        /// @param x The x position to write the text
+        /// @param y The y position to write the text
+        /// @param widthEqualsHeight Whether the width of x index should be the same as the height of y index (default: true)
+        /// @param attr The colour and style of the written cells (default: the presenter's default look)
+        template<typename... Args>
+        void Text(int x, int y, const std::string_view& fmt, Args... args) {
+            Text(x, y, true, fmt, args...);
+        }
+        template<typename... Args>
+        void Text(int x, int y, bool widthEqualsHeight, const std::string_view& fmt, Args... args) {
+            FrameString text(&arena);
+            std::vformat_to(std::back_inserter(text), fmt, std::make_format_args(args...));
+            Text(text, x, y, widthEqualsHeight);
+        }
+        void Text(const std::string_view& text, int x, int y, bool widthEqualsHeight = true, CellAttr attr = DEFAULT_ATTR);
+
+        /// @brief Writes text transcoded at compile time (see the _np literal), the cells are copied as is
+        template<FixedString S>
+        void Text(StaticText<S> text, int x, int y, bool widthEqualsHeight = true, CellAttr attr = DEFAULT_ATTR) {
+            WriteCells(text.cells, text.length, x, y, widthEqualsHeight, attr);
+        }
+
+        /// @brief Writes compile-time text with `{}` fields, only the field values are formatted and converted at runtime
+        template<FixedString S, typename... Args>
+        void Text(int x, int y, StaticText<S> text, const Args&... args) {
+            Text(x, y, DEFAULT_ATTR, text, args...);
+        }
+        template<FixedString S, typename... Args>
+        void Text(int x, int y, CellAttr attr, StaticText<S> text, const Args&... args) {
+            static_assert(sizeof...(Args) == StaticText<S>::fieldCount, "Argument count does not match the number of fields");
+
+            if constexpr (sizeof...(Args) == 0) {
+                WriteCells(text.cells, text.length, x, y, true, attr);
+            } else {
+                Cell line[CANVAS_WIDTH];
+                size_t length = 0;
+                size_t copied = 0;
+                AppendFields<S>(line, length, copied, std::index_sequence_for<Args...>{}, args...);
+                AppendCells(line, length, text.cells + copied, text.length - copied);
+                WriteCells(line, length, x, y, true, attr);
+            }
+        }
+
+        /// @brief Writes word wrapped text into a box, see TextLayout. Layouts are cached by text and box, so text
+        ///        that did not change since it was last drawn is only blitted.
+        /// @param text The UTF-8 text, `\n` starts a new line
+        /// @param x The x position of the box
+        /// @param y The y position of the box
+        /// @param width The width of the box
+        /// @param height The most lines shown, text past them is cut off with an ellipsis
+        /// @param align Where each line sits in the box (default: left)
+        /// @param widthEqualsHeight Whether the width of x index should be the same as the height of y index (default: true)
+        /// @param attr The colour and style of the written cells (default: the presenter's default look)
+        void TextBox(std::string_view text, int x, int y, int width, int height, TextAlign align = TextAlign::Left,
+            bool widthEqualsHeight = true, CellAttr attr = DEFAULT_ATTR);
+
+        /// @brief The layouts TextBox draws from
+        const TextLayoutCache& GetTextLayouts() const { return textLayouts; }
+
+        /// @brief Formats text into the frame arena, for strings that are only needed while drawing this frame
+        /// @return The text, valid until the next Begin
+        template<typename... Args>
+        std::string_view Format(std::format_string<Args...> fmt, Args&&... args) {
+            size_t size = std::formatted_size(fmt, std::forward<Args>(args)...);
+            char* text = static_cast<char*>(arena.allocate(size != 0 ? size : 1, alignof(char)));
+            std::format_to_n(text, size, fmt, std::forward<Args>(args)...);
+            return { text, size };
+        }
+
+        /// @brief Scratch memory for the frame being drawn, reset at Begin, e.g. for a FrameString or pmr vector
+        FrameArena& GetFrameArena() { return arena; }
+
+        /// @brief Draws a rectangle to the canvas
+        /// @param x The x position to draw the rectangle
+        /// @param y The y position to draw the rectangle
+        /// @param width The width of the rectangle
+        /// @param height The height of the rectangle
+        /// @param fill Whether to fill the rectangle (default: false)
+        /// @param widthEqualsHeight Whether the width of x index should be the same as the height of y index (default: true)
+        /// @param fillChar The glyph to draw with (default: full block)
+        /// @param attr The colour and style of the drawn cells (default: the presenter's default look)
+        void Rectangle(int x, int y, int width, int height, bool fill = false, bool widthEqualsHeight = true, Cell fillChar = u'\u2588', CellAttr attr = DEFAULT_ATTR);
+
+        /// @brief Draws a baked sprite with a single masked blit, transparent cells leave the layer untouched
+        /// @param sprite The sprite to draw
+        /// @param x The x position of the sprite's top left cell
+        /// @param y The y position of the sprite's top left cell
+        /// @param widthEqualsHeight Whether the width of x index should be the same as the height of y index (default: true)
+        /// @param attr The colour and style of the sprite's opaque cells (default: the presenter's default look)
+        void Blit(const SpriteView& sprite, int x, int y, bool widthEqualsHeight = true, CellAttr attr = DEFAULT_ATTR);
+
+        /// @brief Writes single cells at scattered positions with one call, later writes win shared cells
+        /// @param indices The cell each write goes to (y * CANVAS_WIDTH + x), writes with negative indices are skipped
+        /// @param cells The glyph of each write
+        /// @param attrs The colour and style of each write
+        /// @param count The number of writes
+        void Splat(const int32_t* indices, const Cell* cells, const CellAttr* attrs, size_t count);
+
+        /// @brief Starts drawing dots this frame, two across and four down per cell, packed into braille glyphs at End
+        /// @details The plane is cleared at the next Begin. Cells without a dot leave the layer untouched, and the clip
+        ///          stack does not apply to dots.
+        /// @param layer The layer the glyphs are written to, an immediate one unless the dots never change
+        /// @param attr The colour and style of the glyphs (default: the presenter's default look)
+        /// @return The dot plane, CANVAS_WIDTH * 2 by CANVAS_HEIGHT * 4
+        BraillePlane& BeginPixels(Layer layer = Layer::World, CellAttr attr = DEFAULT_ATTR);
+
+        /// @brief Pushes a scissor rectangle, following draw calls only touch cells inside it and the rectangles below it
+        /// @param x The x position of the clip rectangle
+        /// @param y The y position of the clip rectangle
+        /// @param width The width of the clip rectangle
+        /// @param height The height of the clip rectangle
+        /// @param widthEqualsHeight Whether the width of x index should be the same as the height of y index (default: true)
+        void PushClip(int x, int y, int width, int height, bool widthEqualsHeight = true);
+
+        /// @brief Restores the clip rectangle active before the matching PushClip
+        void PopClip();
+
+        /// @brief Begins a frame, clearing the immediate layers drawn last frame, the clip stack and the frame arena
+        void Begin();
+
+        /// @brief Selects the layer that following draw calls write to
+        /// @param layer The layer to draw to
+        /// @return Whether the layer needs to be drawn. Always true for immediate layers, for retained layers only
+        ///         when they were invalidated (the layer is cleared first). When false the cached content is reused.
+        bool BeginLayer(Layer layer);
+
+        /// @brief Marks a retained layer as stale so the next BeginLayer redraws it
+        void Invalidate(Layer layer);
+
+        /// @brief Sets whether a layer keeps its content across frames (default: only Layer::Background)
+        void SetRetained(Layer layer, bool retained);
+
+        /// @brief Swaps an immediate layer with the same layer of another canvas, so a layer drawn on another thread
+        ///        into a canvas of its own is composited at End without copying it
+        /// @details Call between Begin and End, once the other canvas is done with the layer. Its dots are packed
+        ///          into the layer first when they were drawn to it.
+        /// @param layer The layer to take, retained layers keep their own content
+        /// @param from The canvas it was drawn to, it gets this canvas's layer in return and clears it at its next Begin
+        void TakeLayer(Layer layer, Canvas& from);
+
+        /// @brief Ends the frame, composites the layers and presents the result
+        void End();
+
+        /// @brief The composited glyphs of the last frame, zero cells are empty
+        const Cell* GetCells() const { return backCells.get(); }
+
+        /// @brief The composited attributes of the last frame
+        const CellAttr* GetAttrs() const { return backAttrs.get(); }
+
+    protected:
+        /// @brief Hands a composited frame to the platform, see GetCells and GetAttrs
+        virtual void Present() = 0;
+
+    private:
+        // Composited frame
+        std::unique_ptr<Cell[]> backCells = std::make_unique<Cell[]>(CANVAS_CELLS);
+        std::unique_ptr<CellAttr[]> backAttrs = std::make_unique<CellAttr[]>(CANVAS_CELLS);
+
+        struct LayerState {
+            std::unique_ptr<Cell[]> cells = std::make_unique<Cell[]>(CANVAS_CELLS); // Zero means transparent
+            std::unique_ptr<CellAttr[]> attrs = std::make_unique<CellAttr[]>(CANVAS_CELLS);
+            bool retained = false;   // Content survives Begin, only redrawn when invalidated
+            bool invalid = true;     // Retained layer must be redrawn on the next BeginLayer
+            bool hasContent = false; // Something was drawn since the last clear
+        };
+
+        LayerState layers[LAYER_COUNT];
+        Layer currentLayer = Layer::World;
+
+        FrameArena arena;
+        TextLayoutCache textLayouts;
+
+        // Dots drawn since Begin, packed into pixelLayer at End
+        BraillePlane pixels{ CANVAS_WIDTH, CANVAS_HEIGHT };
+        std::unique_ptr<Cell[]> pixelCells = std::make_unique<Cell[]>(CANVAS_CELLS);
+        Layer pixelLayer = Layer::World;
+        CellAttr pixelAttr = DEFAULT_ATTR;
+        bool pixelsUsed = false;
+
+        // Half-open cell rectangle, the bottom of the stack is the whole canvas
+        struct ClipRect {
+            int left = 0;
+            int top = 0;
+            int right = CANVAS_WIDTH;
+            int bottom = CANVAS_HEIGHT;
+
+            bool Contains(int x, int y, int width, int height) const {
+                return x >= left && y >= top && x + width <= right && y + height <= bottom;
+            }
+        };
+
+        static constexpr int MAX_CLIP_DEPTH = 16;
+        ClipRect clipStack[MAX_CLIP_DEPTH + 1];
+        int clipDepth = 0;
+        int clipOverflow = 0; // Pushes past MAX_CLIP_DEPTH, ignored but still expected to be popped
+
+        const ClipRect& Clip() const { return clipStack[clipDepth]; }
+
+        /// @brief Copies a run of cells into the current layer, clipped to the current clip rectangle
+        void WriteCells(const Cell* cells, size_t count, int x, int y, bool widthEqualsHeight, CellAttr attr);
+
+        /// @brief Appends as many cells as fit in a line
+        static void AppendCells(Cell* line, size_t& length, const Cell* cells, size_t count) {
+            if (count > CANVAS_WIDTH - length) {
+                count = CANVAS_WIDTH - length;
+            }
+            memcpy(&line[length], cells, count * sizeof(Cell));
+            length += count;
+        }
+
+        /// @brief Appends the static cells before each field followed by the formatted field
+        template<FixedString S, size_t... I, typename... Args>
+        static void AppendFields(Cell* line, size_t& length, size_t& copied, std::index_sequence<I...>, const Args&... args) {
+            (AppendField<S, I>(line, length, copied, args), ...);
+        }
+
+        template<FixedString S, size_t I, typename Arg>
+        static void AppendField(Cell* line, size_t& length, size_t& copied, const Arg& arg) {
+            using Static = StaticText<S>;
+            AppendCells(line, length, Static::cells + copied, Static::template fieldAt<I> - copied);
+            copied = Static::template fieldAt<I>;
+
+            char formatted[CANVAS_WIDTH];
+            auto result = std::format_to_n(formatted, CANVAS_WIDTH, Static::template fieldSpec<I>, arg);
+            size_t size = result.size < CANVAS_WIDTH ? static_cast<size_t>(result.size) : CANVAS_WIDTH;
+
+            Cell units[CANVAS_WIDTH];
+            size_t count = Utf8ToUtf16(std::string_view(formatted, size), units, CANVAS_WIDTH);
+            length += LayoutCells(units, count, &line[length], CANVAS_WIDTH - length);
+        }
+
+        /// @brief Returns the current layer and marks it as drawn to
+        LayerState& Target();
+
+        /// @brief Clears a layer's glyphs and attributes
+        static void ClearLayer(LayerState& layer);
+
+        /// @brief Packs the dot plane into glyphs over its layer
+        void PackPixels();
+
+        /// @brief Composites every layer with content into the back buffer
+        void Composite();
+    };
+
+    /// @brief A canvas that is never presented, for drawing a layer on another thread, see Canvas::TakeLayer
+    class OffscreenCanvas : public Canvas {
+    protected:
+        void Present() override {}
+    };
+}
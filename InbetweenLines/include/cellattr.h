@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+namespace IL {
+    /// @brief 16 colour palette in ANSI order, Default leaves the presenter's own colour
+    enum class Color : uint8_t {
+        Default = 0,
+        Black, DarkRed, DarkGreen, DarkYellow, DarkBlue, DarkMagenta, DarkCyan, Gray,
+        DarkGray, Red, Green, Yellow, Blue, Magenta, Cyan, White,
+    };
+
+    constexpr uint8_t STYLE_BOLD = 1 << 0;
+
+    /// @brief Colour and style of a cell, all zero is the default look so clearing a plane resets it
+    struct CellAttr {
+        Color fg = Color::Default;
+        Color bg = Color::Default;
+        uint8_t style = 0;
+        uint8_t reserved = 0;
+
+        constexpr bool operator==(const CellAttr&) const = default;
+    };
+
+    static_assert(sizeof(CellAttr) == 4, "Cell attributes are blended as 32-bit lanes");
+
+    constexpr CellAttr DEFAULT_ATTR = {};
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <emmintrin.h>
+
+#include "cellwidth_table.h"
+
+namespace IL {
+    /// @brief A grid cell holds one UTF-16 code unit, char16_t rather than wchar_t so cells are 16 bits everywhere
+    using Cell = char16_t;
+
+    /// @brief Fills the second cell of a wide glyph so the grid stays aligned, it draws as nothing
+    constexpr Cell CELL_CONTINUATION = u'\u200B';
+
+    /// @brief Returns how many cells a code point occupies: 0 (combining, control), 1 or 2 (wide)
+    constexpr int CellWidth(char32_t codepoint) {
+        if (codepoint < 0x7F) {
+            return codepoint >= 0x20 ? 1 : 0;
+        }
+
+        if (codepoint >= 0x110000) {
+            return 1;
+        }
+
+        uint8_t block = CELL_WIDTH_STAGE1[codepoint / CELL_WIDTH_BLOCK_SIZE];
+        uint32_t offset = codepoint % CELL_WIDTH_BLOCK_SIZE;
+        uint8_t packed = CELL_WIDTH_STAGE2[block * (CELL_WIDTH_BLOCK_SIZE / 4) + offset / 4];
+        return (packed >> ((offset % 4) * 2)) & 3;
+    }
+
+    /// @brief Returns how many leading code units are printable ASCII, checking 8 at a time
+    inline size_t AsciiPrefix(const Cell* text, size_t count) {
+        size_t i = 0;
+        const __m128i space = _mm_set1_epi16(0x20);
+        const __m128i range = _mm_set1_epi16(0x7E - 0x20);
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 8 <= count; i += 8) {
+            __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&text[i]));
+
+            // Printable when (unit - 0x20) <= 0x5E as an unsigned value, saturation leaves zero for those
+            __m128i over = _mm_subs_epu16(_mm_sub_epi16(units, space), range);
+            int printable = _mm_movemask_epi8(_mm_cmpeq_epi16(over, zero));
+            if (printable != 0xFFFF) {
+                return i + std::countr_zero(static_cast<unsigned>(~printable)) / 2;
+            }
+        }
+
+        while (i < count && text[i] >= 0x20 && text[i] < 0x7F) {
+            i++;
+        }
+
+        return i;
+    }
+
+    /// @brief LayoutCells, with or without copying runs of plain ASCII found by AsciiPrefix ahead of the table
+    template<bool AsciiRuns>
+    constexpr size_t LayoutCellsImpl(const Cell* text, size_t count, Cell* out, size_t capacity) {
+        size_t written = 0;
+        size_t i = 0;
+        while (i < count) {
+            // Runs of plain ASCII map one to one, so copy them without any lookups. Only look for a run where one
+            // starts, text without ASCII would otherwise pay for a vector compare on every code point.
+            if (AsciiRuns && text[i] >= 0x20 && text[i] < 0x7F && !std::is_constant_evaluated()) {
+                size_t run = AsciiPrefix(&text[i], count - i);
+                if (run > capacity - written) {
+                    run = capacity - written;
+                }
+                if (out != nullptr) {
+                    for (size_t j = 0; j < run; j++) {
+                        out[written + j] = text[i + j];
+                    }
+                }
+                written += run;
+                i += run;
+                if (i >= count || written >= capacity) {
+                    break;
+                }
+            }
+
+            char32_t codepoint = text[i];
+            size_t units = 1;
+            if (codepoint >= 0xD800 && codepoint <= 0xDBFF && i + 1 < count && text[i + 1] >= 0xDC00 && text[i + 1] <= 0xDFFF) {
+                codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (text[i + 1] - 0xDC00);
+                units = 2;
+            }
+
+            int width = CellWidth(codepoint);
+            size_t cells = units > static_cast<size_t>(width) ? units : static_cast<size_t>(width);
+            if (width == 0) {
+                cells = 0;
+            }
+
+            if (written + cells > capacity) {
+                break;
+            }
+
+            if (out != nullptr && cells > 0) {
+                out[written] = text[i];
+                if (units == 2) {
+                    out[written + 1] = text[i + 1];
+                } else if (cells == 2) {
+                    out[written + 1] = CELL_CONTINUATION;
+                }
+            }
+
+            written += cells;
+            i += units;
+        }
+
+        return written;
+    }
+
+    /// @brief Lays UTF-16 text out into grid cells
+    /// @details Wide glyphs take two cells, the second holding CELL_CONTINUATION unless the glyph is a surrogate
+    ///          pair which already spans two units. Zero width code points are dropped since a cell holds one
+    ///          code unit, so they cannot shift the text after them. A wide glyph is never split at the end.
+    /// @param text The UTF-16 text
+    /// @param count The number of code units in text
+    /// @param out The cells to write, or nullptr to only measure
+    /// @param capacity The number of cells out can hold
+    /// @return The number of cells written (or needed when out is nullptr)
+    constexpr size_t LayoutCells(const Cell* text, size_t count, Cell* out = nullptr, size_t capacity = SIZE_MAX) {
+        return LayoutCellsImpl<true>(text, count, out, capacity);
+    }
+
+    /// @brief Scalar reference implementation of LayoutCells, every code point is looked up in the width table
+    constexpr size_t LayoutCellsScalar(const Cell* text, size_t count, Cell* out = nullptr, size_t capacity = SIZE_MAX) {
+        return LayoutCellsImpl<false>(text, count, out, capacity);
+    }
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+#include "cellwidth.h"
+
+namespace IL {
+    /// @brief Decodes UTF-8 into UTF-16, usable both at compile time and at runtime
+    /// @param text The UTF-8 text, invalid sequences become U+FFFD
+    /// @param out The UTF-16 output, or nullptr to only measure
+    /// @param capacity The number of code units out can hold, the output is truncated at a whole code point
+    /// @return The number of code units written (or needed when out is nullptr)
+    constexpr size_t Utf8ToUtf16(std::string_view text, Cell* out = nullptr, size_t capacity = 0) {
+        size_t written = 0;
+        size_t i = 0;
+        while (i < text.size()) {
+            unsigned char lead = static_cast<unsigned char>(text[i]);
+            char32_t codepoint = 0xFFFD;
+            size_t length = 1;
+
+            if (lead < 0x80) {
+                codepoint = lead;
+            } else if ((lead & 0xE0) == 0xC0) {
+                codepoint = lead & 0x1F;
+                length = 2;
+            } else if ((lead & 0xF0) == 0xE0) {
+                codepoint = lead & 0x0F;
+                length = 3;
+            } else if ((lead & 0xF8) == 0xF0) {
+                codepoint = lead & 0x07;
+                length = 4;
+            }
+
+            // Consume the continuation bytes, a truncated sequence decodes to a single replacement character
+            for (size_t j = 1; j < length; j++) {
+                if (i + j >= text.size() || (static_cast<unsigned char>(text[i + j]) & 0xC0) != 0x80) {
+                    codepoint = 0xFFFD;
+                    length = j;
+                    break;
+                }
+                codepoint = (codepoint << 6) | (static_cast<unsigned char>(text[i + j]) & 0x3F);
+            }
+            i += length;
+
+            if (codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+                codepoint = 0xFFFD;
+            }
+
+            size_t units = codepoint >= 0x10000 ? 2 : 1;
+            if (out != nullptr) {
+                if (written + units > capacity) {
+                    break;
+                }
+
+                if (units == 2) {
+                    codepoint -= 0x10000;
+                    out[written] = static_cast<Cell>(0xD800 + (codepoint >> 10));
+                    out[written + 1] = static_cast<Cell>(0xDC00 + (codepoint & 0x3FF));
+                } else {
+                    out[written] = static_cast<Cell>(codepoint);
+                }
+            }
+            written += units;
+        }
+
+        return written;
+    }
+
+    /// @brief A UTF-8 string literal usable as a template argument
+    template<size_t N>
+    struct FixedString {
+        char data[N] = {};
+
+        consteval FixedString(const char (&text)[N]) {
+            for (size_t i = 0; i < N; i++) {
+                data[i] = text[i];
+            }
+        }
+
+        constexpr std::string_view View() const { return { data, N - 1 }; }
+    };
+
+    /// @brief Text transcoded to UTF-16 and laid out into cells at compile time, created with the _np literal
+    /// @details `{}` and `{:spec}` fields are split out of the static cells so that only the field values are
+    ///          formatted and converted at runtime. `{{` and `}}` are literal braces.
+    template<FixedString S>
+    struct StaticText {
+    private:
+        static constexpr size_t CAPACITY = sizeof(S.data);
+
+        struct Parsed {
+            Cell cells[CAPACITY] = {};
+            size_t length = 0;
+            size_t fieldCount = 0;
+            size_t fieldAt[CAPACITY] = {};     // Static cell index each field is inserted at
+            size_t specBegin[CAPACITY] = {};   // Byte range of each field's `{...}` in S
+            size_t specLength[CAPACITY] = {};
+        };
+
+        static consteval Parsed Parse() {
+            Parsed parsed;
+            std::string_view text = S.View();
+
+            size_t runBegin = 0;
+            auto flush = [&](size_t runEnd) {
+                Cell units[CAPACITY] = {};
+                size_t count = Utf8ToUtf16(text.substr(runBegin, runEnd - runBegin), units, CAPACITY);
+                parsed.length += LayoutCells(units, count, &parsed.cells[parsed.length], CAPACITY - parsed.length);
+            };
+
+            for (size_t i = 0; i < text.size(); i++) {
+                if (text[i] == '{' && i + 1 < text.size() && text[i + 1] == '{') {
+                    flush(i + 1); // Keep one brace
+                    runBegin = i + 2;
+                    i++;
+                } else if (text[i] == '}' && i + 1 < text.size() && text[i + 1] == '}') {
+                    flush(i + 1);
+                    runBegin = i + 2;
+                    i++;
+                } else if (text[i] == '{') {
+                    size_t close = text.find('}', i);
+                    if (close == std::string_view::npos) {
+                        throw "Unterminated field in static text";
+                    }
+                    if (close != i + 1 && text[i + 1] != ':') {
+                        throw "Static text only supports automatic field numbering";
+                    }
+
+                    flush(i);
+                    parsed.fieldAt[parsed.fieldCount] = parsed.length;
+                    parsed.specBegin[parsed.fieldCount] = i;
+                    parsed.specLength[parsed.fieldCount] = close - i + 1;
+                    parsed.fieldCount++;
+
+                    runBegin = close + 1;
+                    i = close;
+                } else if (text[i] == '}') {
+                    throw "Unmatched '}' in static text";
+                }
+            }
+            flush(text.size());
+
+            return parsed;
+        }
+
+        static constexpr Parsed parsed = Parse();
+
+    public:
+        /// @brief The static cells, with every field removed
+        static constexpr const Cell* cells = parsed.cells;
+        static constexpr size_t length = parsed.length;
+        static constexpr size_t fieldCount = parsed.fieldCount;
+
+        /// @brief Where field I is inserted into the static cells
+        template<size_t I>
+        static constexpr size_t fieldAt = parsed.fieldAt[I];
+
+        /// @brief The `{...}` format string of field I
+        template<size_t I>
+        static constexpr std::string_view fieldSpec = S.View().substr(parsed.specBegin[I], parsed.specLength[I]);
+    };
+
+    namespace literals {
+        /// @brief Creates text that is transcoded to UTF-16 at compile time, e.g. "P1 Score: {}"_np
+        template<FixedString S>
+        consteval StaticText<S> operator""_np() {
+            return {};
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string>
+
+namespace IL {
+    /// @brief Linear allocator for data that only lives until the end of a frame
+    /// @details Allocating bumps a pointer and freeing does nothing, Reset releases everything at once. Frames
+    ///          that do not fit spill into blocks from the heap, and the next Reset grows the buffer to the most
+    ///          a frame has used so steady frames never reach the heap. Pass it to std::pmr containers.
+    class FrameArena : public std::pmr::memory_resource {
+    public:
+        static constexpr size_t DEFAULT_CAPACITY = 16 * 1024;
+
+        explicit FrameArena(size_t capacity = DEFAULT_CAPACITY);
+        ~FrameArena() override;
+
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        /// @brief Frees everything allocated since the last Reset, pointers into the arena become invalid
+        void Reset();
+
+        /// @brief Bytes handed out since the last Reset, padding included
+        size_t GetUsed() const { return used + spilled; }
+
+        /// @brief Size of the buffer allocations are bumped out of
+        size_t GetCapacity() const { return capacity; }
+
+        /// @brief Allocations since the last Reset that did not fit the buffer and went to the heap
+        size_t GetSpills() const { return spills; }
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void*, size_t, size_t) override {}
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    private:
+        // Heap blocks for allocations past the buffer, linked through a header in front of each
+        struct Spill {
+            Spill* next;
+            size_t alignment; // The block's own, needed to free it
+        };
+
+        std::unique_ptr<std::byte[]> buffer;
+        size_t capacity;
+        size_t used = 0;
+        size_t spilled = 0;
+        size_t spills = 0;
+        size_t highWater = 0;
+        Spill* spillList = nullptr;
+
+        void FreeSpills();
+    };
+
+    /// @brief A string built in a FrameArena, e.g. FrameString text(&arena)
+    using FrameString = std::pmr::string;
+}
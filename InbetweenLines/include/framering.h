@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "cellattr.h"
+#include "cellwidth.h"
+
+namespace IL {
+    /// @brief Named memory shared between processes, a file mapping backed by the paging file on Windows and POSIX
+    ///        shared memory elsewhere
+    class SharedMemory {
+    public:
+        SharedMemory() = default;
+        ~SharedMemory();
+
+        SharedMemory(const SharedMemory&) = delete;
+        SharedMemory& operator=(const SharedMemory&) = delete;
+
+        /// @brief Creates the memory zeroed, replacing what a previous owner of the name left behind
+        bool Create(std::string_view name, size_t size);
+
+        /// @brief Maps memory another process created, read only
+        bool Open(std::string_view name);
+
+        /// @brief Unmaps the memory, the name goes away with its creator
+        void Close();
+
+        uint8_t* GetData() const { return data; }
+        size_t GetSize() const { return size; }
+
+    private:
+        uint8_t* data = nullptr;
+        size_t size = 0;
+        bool owner = false;
+#ifdef _WIN32
+        void* mappingHandle = nullptr;
+#else
+        char path[256] = {};
+#endif
+    };
+
+    /// @brief A frame in a ring, pointing straight into the shared memory
+    struct SharedFrame {
+        uint64_t sequence = 0;
+        int64_t publishedNs = 0; // steady_clock when it was published, the same clock in every process
+        const Cell* cells = nullptr;
+        const CellAttr* attrs = nullptr;
+    };
+
+    /// @brief Publishes frames into a named ring of slots in shared memory for other processes to read in place
+    /// @details Frames are numbered from 1 and go round the slots. A slot's sequence number is cleared while its
+    ///          frame is written and set once it is complete, so readers never wait on a lock and the writer never
+    ///          waits on a reader: a reader that falls a whole ring behind finds the sequence changed and skips
+    ///          ahead. One writer per ring.
+    class FrameRingWriter {
+    public:
+        static constexpr int DEFAULT_SLOTS = 8;
+
+        FrameRingWriter() = default;
+        ~FrameRingWriter() { Close(); }
+
+        FrameRingWriter(const FrameRingWriter&) = delete;
+        FrameRingWriter& operator=(const FrameRingWriter&) = delete;
+
+        /// @brief Creates the ring, replacing an abandoned one of the same name
+        bool Create(std::string_view name, int width, int height, int slots = DEFAULT_SLOTS);
+
+        /// @brief Copies a frame into the next slot and makes it the latest, does nothing unless the ring is open
+        void Publish(const Cell* cells, const CellAttr* attrs);
+
+        /// @brief Tells readers no more frames are coming and removes the ring
+        void Close();
+
+        bool IsOpen() const { return memory.GetData() != nullptr; }
+        uint64_t GetPublished() const { return published; }
+
+    private:
+        SharedMemory memory;
+        uint64_t published = 0;
+    };
+
+    /// @brief Reads frames from a FrameRingWriter in another process, or another thread, without copying them
+    /// @details Acquire a frame, use its cells and attributes where they lie, then Validate: if the writer came
+    ///          round to the slot meanwhile what was read may be torn and should be dropped. Any number of readers
+    ///          can share a ring, the writer does not know about them.
+    class FrameRingReader {
+    public:
+        /// @brief Maps a ring, fails until its writer has created it
+        bool Open(std::string_view name);
+
+        void Close() { memory.Close(); }
+
+        int GetWidth() const;
+        int GetHeight() const;
+        int GetSlots() const;
+
+        /// @brief The newest complete frame, 0 before the first
+        uint64_t GetLatest() const;
+
+        /// @brief Whether the writer has closed the ring, GetLatest is then the last frame there will be
+        bool IsClosed() const;
+
+        /// @brief Finds a frame in its slot
+        /// @return False when it is not published yet, or was already overwritten by a newer one
+        bool Acquire(uint64_t sequence, SharedFrame& frame) const;
+
+        /// @brief Whether an acquired frame is still whole, call after reading it
+        bool Validate(const SharedFrame& frame) const;
+
+    private:
+        SharedMemory memory;
+    };
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "behavior.h"
+#include "canvas.h"
+#include "input.h"
+#include "jobs.h"
+#include "particles.h"
+#include "physics.h"
+#include "timingwheel.h"
+
+// Screen boundaries
+constexpr int SCREEN_WIDTH = 80;  // Typical Notepad width in characters
+constexpr int SCREEN_HEIGHT = 35; // Typical Notepad height in lines
+constexpr int PLAYER_WIDTH = 5;   // Width of the player
+constexpr int PLAYER_HEIGHT = 5;  // Height of the player
+constexpr int MAX_PARTICLES = 1024; // Explosion particles alive at once
+
+/// @brief The left edge of a player's body when a match starts, they drop in from the top of the world
+constexpr int SpawnX(int playerIndex, int worldWidth = SCREEN_WIDTH) {
+    return (worldWidth * (playerIndex == 0 ? 1 : 3)) / 4 - PLAYER_WIDTH / 2;
+}
+
+struct Vector2 {
+    int x = 0;
+    int y = 0;
+};
+
+struct Platform {
+    int x, y, width, height;
+};
+
+// Define a structure for coins with lifetime tracking
+struct Coin {
+    int x, y;         // Position
+    bool active;      // Whether the coin is currently visible
+    uint32_t id;      // Names the coin in its expiry timer
+    uint64_t firstTick; // The first tick counted towards the coin's lifetime
+    IL::TimerId expiry; // Fires on the tick the coin explodes
+    bool exploding;   // Whether the coin is currently exploding
+    int explosionFrame; // Current frame of explosion animation
+    int value;        // Value of the coin (added for multiplayer)
+};
+
+struct Physics_t {
+    IL::Fixed y = 0;            // Top of the player in sub-cells, position.y holds its whole cells
+    IL::Fixed velocityY = 0;    // Sub-cells per tick, positive is down
+    bool isOnGround = false;
+    int groundLevel = 33;
+    IL::Fixed terminalVelocity = IL::CellsToFixed(5);  // Maximum falling speed
+};
+
+// New Player struct for multiplayer
+struct Player {
+    Vector2 position = {0, 0};
+    Physics_t physics;
+    bool isBlinking = false;    // Whether eyes are currently blinking
+    bool isMovingHorizontal = false;  // Is player currently moving horizontally
+    int lastMoveDirection = 0;  // Last movement direction (-1 left, 1 right, 0 none)
+    uint64_t movingUntil = 0;   // The last tick the player counts as moving
+    IL::TimerId moveTimer = IL::INVALID_TIMER; // Ends isMovingHorizontal once movingUntil has passed
+    int currentWidth = PLAYER_WIDTH;  // Current animation dimensions
+    int currentHeight = PLAYER_HEIGHT;
+    int xOffset = 0;
+    int yOffset = 0;
+    int score = 0;              // Player's score
+};
+
+// Balance knobs, fixed for the length of a match
+struct GameRules {
+    int coinSpawnInterval = 20; // Spawn check every ~2 seconds at 60fps
+    int maxCoinsOnScreen = 10;  // Maximum number of coins allowed at once
+    int coinLifetime = 200;     // Coin lifetime in frames (10 seconds at 60fps)
+    float gravity = 0.5f;
+    float jumpForce = -4.0f;
+    bool effects = true;        // Explosion particles, cosmetic so unwatched matches can skip them
+    uint32_t levelSeed = 0;     // Plays a generated level (see LevelGenerator), 0 plays the hand-placed one
+};
+
+// Per-match random numbers (PCG32), matches running side by side never share or disturb a sequence
+struct Random {
+    uint64_t state = 0;
+
+    void Seed(uint64_t seed) {
+        state = 0;
+        Next();
+        state += seed;
+        Next();
+    }
+
+    uint32_t Next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ull + 1442695040888963407ull;
+        uint32_t xorshifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+        uint32_t rotation = static_cast<uint32_t>(old >> 59);
+        return (xorshifted >> rotation) | (xorshifted << ((32 - rotation) & 31));
+    }
+};
+
+// What happened during a match, for balance testing
+struct MatchStats {
+    uint64_t ticks = 0;
+    int coinsSpawned = 0;
+    int coinsCollected = 0;
+    int coinsExpired = 0;
+};
+
+// Everything a match needs, any number of matches can run at once on separate states. The blink behaviors
+// InitializeGame starts hold references into their state, so a state never moves, it is only reset in place.
+struct State_t {
+    State_t() = default;
+    State_t(State_t&&) = delete;
+    State_t& operator=(State_t&&) = delete;
+
+    /// @brief Stops the behaviors and empties the timers and containers in place, keeping their memory, so the
+    ///        state plays on exactly as a new one
+    void Reset();
+
+    Player players[2];   // Two players: 0=left (WASD), 1=right (arrows)
+    std::vector<Platform> platforms; // Platforms to jump between
+    std::vector<IL::Ledge> ledges;   // The platforms' tops, what players land on
+    std::vector<Coin> coins; // Collectable coins
+    IL::TimerId spawnTimer = IL::INVALID_TIMER; // Fires on the next coin spawn check
+    IL::ParticlePool particles{ MAX_PARTICLES }; // Explosions, cosmetic and seeded apart from random
+    IL::TimingWheel timers;           // Coin lifetimes, spawn checks and movement, one tick per UpdateGame
+    IL::BehaviorScheduler behaviors;  // Blinks, one tick per UpdateGame
+    std::vector<uint64_t> dueTimers;  // Payloads of the timers fired this tick
+    uint32_t nextCoinId = 0;
+    GameRules rules;
+    Random random;
+    MatchStats stats;
+};
+
+// The most jobs of a frame that can run at once, more threads than this have nothing to do
+constexpr unsigned int FRAME_JOB_WIDTH = 3;
+
+/// @brief Spreads UpdateGame and RenderGame over a job system's threads, they make the same frames as without
+/// @details The players fall side by side and explosions update next to the rest of the tick. The world and
+///          entity layers are drawn into canvases of their own while the canvas gets the background and the HUD.
+struct FrameJobs {
+    explicit FrameJobs(IL::JobSystem& system) : system(system) { graph.Reserve(8, 8); }
+
+    IL::JobSystem& system;
+    IL::JobGraph graph;            // Refilled by every UpdateGame and RenderGame
+    IL::OffscreenCanvas world;     // Coins and explosions, taken by the canvas before End
+    IL::OffscreenCanvas entities;  // Players
+};
+
+/// @brief Starts a new match: platforms, the first coins and both players
+/// @param state The match to reset
+/// @param seed Seeds the match's random number generator, the same seed and inputs replay the same match
+/// @param rules The balance knobs to play with
+void InitializeGame(State_t& state, unsigned int seed, const GameRules& rules = {});
+
+/// @brief Advances the match by one tick
+/// @param state The match to advance
+/// @param input The keys held this tick, WASD for the left player and the arrows for the right one
+/// @param jobs Runs the tick's independent steps in parallel, or nothing to run them one after another
+void UpdateGame(State_t& state, const IL::InputSource& input, FrameJobs* jobs = nullptr);
+
+/// @brief Draws the match, rendering has no effect on the simulation
+/// @param jobs Draws independent layers in parallel, or nothing to draw them one after another
+void RenderGame(const State_t& state, IL::Canvas& canvas, FrameJobs* jobs = nullptr);
+
+/// @brief Blits a player's sprite from the compile-time atlas, as RenderGame does for both players
+/// @param playerIndex Picks the look, 0 for the left player and 1 for the right one
+void RenderPlayer(IL::Canvas& canvas, const Player& player, int playerIndex);
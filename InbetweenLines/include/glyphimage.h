@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "cellwidth.h"
+#include "sprite.h"
+
+namespace IL {
+    enum class PixelFormat {
+        Gray8, // One byte per pixel
+        Rgb8,  // R, G, B
+        Rgba8, // R, G, B, A, alpha is ignored
+        Bgra8, // B, G, R, A as in Windows DIBs, alpha is ignored
+    };
+
+    /// @brief Non-owning view of 8-bit pixel rows
+    struct ImageView {
+        const uint8_t* pixels = nullptr;
+        int width = 0;
+        int height = 0;
+        size_t stride = 0; // Bytes from one row to the next
+        PixelFormat format = PixelFormat::Gray8;
+    };
+
+    enum class Dither {
+        None,           // Nearest glyph, flat areas band
+        Ordered,        // 4x4 Bayer offsets per cell, stable from frame to frame which suits video
+        ErrorDiffusion, // Floyd-Steinberg across cells, finer gradients but noisy when animated
+    };
+
+    struct GlyphOptions {
+        Dither dither = Dither::Ordered;
+        bool darkInk = true; // Glyphs are drawn dark on a light background, as in notepad
+    };
+
+    /// @brief Turns images into a grid of shade and half-block glyphs (` ░▒▓█▀▄▌▐`)
+    /// @details Each cell samples its source box as 2x2 quadrants of average luminance and picks the glyph whose
+    ///          coverage is closest to them. Luminance, the vertical part of the box filter and glyph matching run
+    ///          four to sixteen pixels or four cells at a time with SSE2. Buffers are kept between calls, so
+    ///          converting one video frame after another does not allocate.
+    class GlyphConverter {
+    public:
+        /// @param columns The width of the glyph grid in cells
+        /// @param rows The height of the glyph grid in cells
+        GlyphConverter(int columns, int rows);
+
+        /// @brief Converts an image, stretched to cover the whole grid
+        void Convert(const ImageView& image, const GlyphOptions& options = {});
+
+        /// @brief Scalar reference implementation of Convert, produces identical cells
+        void ConvertScalar(const ImageView& image, const GlyphOptions& options = {});
+
+        int GetColumns() const { return columns; }
+        int GetRows() const { return rows; }
+
+        /// @brief The glyphs of the last conversion, row major
+        const Cell* GetCells() const { return cells.data(); }
+
+        /// @brief The grid as an opaque sprite, ready for Canvas::Blit
+        SpriteView View() const { return { cells.data(), mask.data(), columns, rows, columns }; }
+
+    private:
+        int columns;
+        int rows;
+        std::vector<Cell> cells;
+        std::vector<Cell> mask;
+
+        // Source pixel bounds of each half cell, quadrant column i starts at xBounds[i] and spans at least one pixel
+        std::vector<int> xBounds;
+        std::vector<int> yBounds;
+        int boundsWidth = 0;
+        int boundsHeight = 0;
+
+        std::vector<uint32_t> columnSums; // Luminance * 256 summed down the rows of one quadrant row
+        std::vector<float> ink[4];        // Per cell ink of the top left, top right, bottom left and bottom right quadrant
+        std::vector<float> diffusion;     // Error carried to the current and the next row of cells
+
+        void Prepare(const ImageView& image);
+        void Downsample(const ImageView& image, bool simd, bool darkInk);
+        void Match(Dither dither, bool simd);
+    };
+}
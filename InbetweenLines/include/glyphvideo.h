@@ -0,0 +1,147 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "cellwidth.h"
+#include "mappedfile.h"
+#include "sprite.h"
+
+// Glyph video container (.ilgv), little endian:
+//
+//   VideoHeader
+//   Frames        One byte frame type, then the body
+//                 Key:   runs of (varint count, u16 cell) covering the whole grid
+//                 Delta: varint span count, then per span (varint cells skipped, varint length, u16 cells...)
+//                        against the previous frame
+//   Index         One VideoIndexEntry per frame, at VideoHeader::indexOffset
+//
+// Keyframes start every keyInterval frames, so a seek decodes at most keyInterval frames.
+
+namespace IL {
+    constexpr uint32_t VIDEO_MAGIC = 0x56474C49; // "ILGV"
+    constexpr uint32_t VIDEO_VERSION = 1;
+
+    enum VideoFrameType : uint8_t {
+        VIDEO_FRAME_KEY = 0,
+        VIDEO_FRAME_DELTA = 1,
+    };
+
+    struct VideoHeader {
+        uint32_t magic = VIDEO_MAGIC;
+        uint32_t version = VIDEO_VERSION;
+        uint16_t columns = 0;
+        uint16_t rows = 0;
+        uint32_t frameCount = 0;
+        uint32_t fpsMilli = 0;     // Frames per 1000 seconds
+        uint32_t keyInterval = 0;
+        uint32_t maxFrameSize = 0; // Largest frame body in bytes, the player's window is sized from it
+        uint32_t reserved = 0;
+        uint64_t indexOffset = 0;
+    };
+
+    struct VideoIndexEntry {
+        uint64_t offset;
+        uint32_t size;
+        uint32_t flags; // VIDEO_ENTRY_KEY for keyframes
+    };
+
+    constexpr uint32_t VIDEO_ENTRY_KEY = 1;
+
+    static_assert(sizeof(VideoHeader) == 40 && sizeof(VideoIndexEntry) == 16, "Video structures are written as is");
+
+    /// @brief Encodes frames of cells into a glyph video file, streaming them to disk as they come
+    class GlyphVideoWriter {
+    public:
+        GlyphVideoWriter() = default;
+        ~GlyphVideoWriter();
+
+        GlyphVideoWriter(const GlyphVideoWriter&) = delete;
+        GlyphVideoWriter& operator=(const GlyphVideoWriter&) = delete;
+
+        /// @brief Creates the file
+        /// @param path The file to write
+        /// @param columns The width of every frame in cells
+        /// @param rows The height of every frame in cells
+        /// @param fps The playback rate
+        /// @param keyInterval Frames from one keyframe to the next
+        bool Open(const std::filesystem::path& path, int columns, int rows, double fps, uint32_t keyInterval = 60);
+
+        /// @brief Appends a frame of columns * rows cells, stored as a delta unless a keyframe is due or smaller
+        bool AddFrame(const Cell* cells);
+
+        /// @brief Writes the index and header and closes the file
+        bool Finish();
+
+        uint64_t GetBytesWritten() const { return offset; }
+
+    private:
+        std::ofstream file;
+        VideoHeader header;
+        uint64_t offset = 0;
+        std::vector<Cell> previous;
+        std::vector<uint8_t> key;
+        std::vector<uint8_t> delta;
+        std::vector<VideoIndexEntry> index;
+    };
+
+    /// @brief Streams a glyph video from a memory mapped window, decoding into a single frame of cells
+    /// @details Memory use is one frame plus two fixed size windows on the file (frames and index), whatever the
+    ///          length of the video. After each frame the next READ_AHEAD_BYTES are handed to the OS to prefetch.
+    class GlyphVideoPlayer {
+    public:
+        static constexpr size_t FRAME_WINDOW = 4 << 20;
+        static constexpr size_t INDEX_WINDOW = 64 << 10;
+        static constexpr size_t READ_AHEAD_BYTES = 256 << 10;
+
+        /// @brief Maps a video and checks its header and index
+        bool Open(const std::filesystem::path& path);
+
+        void Close();
+
+        int GetColumns() const { return header.columns; }
+        int GetRows() const { return header.rows; }
+        uint32_t GetFrameCount() const { return header.frameCount; }
+        double GetFrameRate() const { return header.fpsMilli / 1000.0; }
+
+        /// @brief The frame in GetCells, or UINT32_MAX before the first one is decoded
+        uint32_t GetFrame() const { return current; }
+
+        const Cell* GetCells() const { return cells.data(); }
+
+        /// @brief The decoded frame as an opaque sprite, ready for Canvas::Blit
+        SpriteView View() const { return { cells.data(), mask.data(), header.columns, header.rows, header.columns }; }
+
+        /// @brief Decodes a frame, from the nearest keyframe at or before it unless it follows the current one
+        /// @return Whether the frame exists and decoded cleanly
+        bool Seek(uint32_t frame);
+
+        /// @brief Decodes the frame after the current one
+        bool DecodeNext();
+
+        /// @brief Starts timed playback at a frame
+        void Play(uint32_t frame = 0);
+
+        /// @brief Brings the decoded frame up to the one due now, skipping frames when running late
+        /// @return Whether there are frames left to show
+        bool Update();
+
+    private:
+        MappedFile file;
+        MappedFile::Window frames;
+        MappedFile::Window indexWindow;
+        VideoHeader header;
+        std::vector<Cell> cells;
+        std::vector<Cell> mask;
+        uint32_t current = UINT32_MAX;
+
+        std::chrono::steady_clock::time_point playStart;
+        uint32_t playFrom = 0;
+
+        bool ReadEntry(uint32_t frame, VideoIndexEntry& entry);
+        bool DecodeFrame(uint32_t frame);
+    };
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+namespace IL {
+    /// @brief Key codes, the values match Win32 virtual key codes
+    using Key = uint32_t;
+
+    constexpr Key KEY_UP = 0x26;
+    constexpr Key KEY_DOWN = 0x28;
+    constexpr Key KEY_LEFT = 0x25;
+    constexpr Key KEY_RIGHT = 0x27;
+    constexpr Key KEY_W = 0x57;
+    constexpr Key KEY_A = 0x41;
+    constexpr Key KEY_S = 0x53;
+    constexpr Key KEY_D = 0x44;
+    constexpr Key KEY_SPACE = 0x20;
+    constexpr Key KEY_ENTER = 0x0D;
+    constexpr Key KEY_ESCAPE = 0x1B;
+
+    /// @brief Where the game reads its input from, the notepad keyboard hook or a script
+    class InputSource {
+    public:
+        virtual ~InputSource() = default;
+
+        /// @brief Whether a key is held down this tick
+        virtual bool IsKeyDown(Key key) const = 0;
+    };
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace IL {
+    /// @brief Names a job within its graph, the order it was added in
+    using JobIndex = uint32_t;
+
+    /// @brief A frame's worth of jobs and what each has to wait for, run by a JobSystem or one after another
+    /// @details A job may only wait on jobs added before it, so every graph is acyclic and the order jobs were
+    ///          added in is always a valid serial schedule. Jobs are stored inline, a graph that is cleared and
+    ///          refilled every frame does not allocate once it has reached its working size.
+    class JobGraph {
+    public:
+        static constexpr size_t INLINE_BYTES = 48; // The largest callable a job holds
+
+        /// @brief Adds a job
+        /// @param function Called once with no arguments, capture what it works on by reference or pointer
+        template<typename Function>
+        JobIndex Add(const Function& function) {
+            static_assert(sizeof(Function) <= INLINE_BYTES, "Job captures too much, capture a struct by reference instead");
+            static_assert(alignof(Function) <= alignof(std::max_align_t), "Job callable is over aligned");
+            static_assert(std::is_trivially_copyable_v<Function> && std::is_trivially_destructible_v<Function>,
+                "Jobs are copied byte for byte and never destroyed");
+
+            Job& job = jobs.emplace_back();
+            std::memcpy(job.storage, &function, sizeof(Function));
+            job.run = [](void* storage) { (*std::launder(static_cast<Function*>(storage)))(); };
+            return static_cast<JobIndex>(jobs.size() - 1);
+        }
+
+        /// @brief Makes a job wait until another one has finished
+        /// @param job The job that waits
+        /// @param on A job added before it
+        void Depend(JobIndex job, JobIndex on);
+
+        /// @brief Runs every job on the calling thread in the order they were added
+        void RunSerial();
+
+        /// @brief Removes every job, keeping the memory for the next frame's
+        void Clear();
+
+        /// @brief Makes room for this many jobs and dependencies, filling the graph up to it then never allocates
+        void Reserve(size_t jobCount, size_t dependencies);
+
+        size_t GetCount() const { return jobs.size(); }
+
+    private:
+        friend class JobSystem;
+
+        struct Job {
+            alignas(std::max_align_t) std::byte storage[INLINE_BYTES];
+            void (*run)(void* storage);
+            uint32_t waitsOn = 0;        // Jobs it depends on
+            uint32_t pending = 0;        // Of those, the ones still running while the graph runs
+            uint32_t firstSuccessor = 0; // Into successors, the jobs that wait on this one
+            uint32_t successorCount = 0;
+        };
+
+        struct Edge {
+            JobIndex job;
+            JobIndex on;
+        };
+
+        std::vector<Job> jobs;
+        std::vector<Edge> edges;
+        std::vector<JobIndex> successors; // Grouped by the job they wait on, built when the graph runs
+        std::atomic<uint32_t> remaining = 0; // Jobs not yet finished while the graph runs
+
+        /// @brief Resets every job's pending count and groups the successors, before a run
+        void Prepare();
+    };
+
+    /// @brief Runs job graphs on a fixed set of worker threads that steal work from each other
+    /// @details Each thread has a Chase-Lev deque: it pushes the jobs it makes ready to the bottom and pops from
+    ///          there, so a chain of dependent jobs stays on the core that has its data in cache. Idle threads steal
+    ///          from the top of the others' deques. The thread calling Run works too, workers spin briefly once
+    ///          they run dry and then sleep until the next graph. Only one graph runs at a time.
+    class JobSystem {
+    public:
+        /// @param workers Threads besides the caller, 0 runs every graph on the calling thread
+        explicit JobSystem(unsigned int workers = DefaultWorkers());
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        /// @brief Runs every job of the graph, returning once the last one has finished
+        void Run(JobGraph& graph);
+
+        /// @brief The threads jobs run on, the workers and the caller
+        unsigned int GetThreads() const { return static_cast<unsigned int>(queues.size()); }
+
+        /// @brief One worker per hardware thread besides the caller's
+        static unsigned int DefaultWorkers();
+
+    private:
+        using Job = JobGraph::Job;
+
+        static constexpr int64_t QUEUE_CAPACITY = 4096; // A thread with this many ready jobs runs the next one itself
+        static_assert((QUEUE_CAPACITY & (QUEUE_CAPACITY - 1)) == 0, "Job queue capacity must be a power of two");
+
+        // A single producer deque, the owner pushes and pops at the bottom and thieves take from the top
+        struct alignas(64) Queue {
+            std::atomic<int64_t> top = 0;
+            alignas(64) std::atomic<int64_t> bottom = 0;
+            std::unique_ptr<std::atomic<Job*>[]> slots = std::make_unique<std::atomic<Job*>[]>(QUEUE_CAPACITY);
+
+            bool Push(Job* job);
+            Job* Pop();
+            Job* Steal();
+        };
+
+        std::vector<Queue> queues;          // The caller's first, then one per worker
+        std::vector<std::thread> threads;
+        JobGraph* graph = nullptr;          // The graph being run
+        alignas(64) std::atomic<uint32_t> wake = 0; // Bumped when jobs are pushed while workers sleep, they wait on it
+        std::atomic<uint32_t> sleeping = 0;
+        std::atomic<bool> stopping = false;
+
+        void WorkerMain(unsigned int thread);
+
+        /// @brief Takes a job from the thread's own deque or steals one from another
+        Job* Find(unsigned int thread);
+
+        /// @brief Runs a job and makes the jobs waiting only on it ready
+        void Execute(Job* job, unsigned int thread);
+
+        /// @brief Wakes sleeping workers after jobs were pushed
+        void Notify();
+    };
+}
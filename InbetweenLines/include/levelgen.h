@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "game.h"
+#include "navigation.h"
+
+// The kind of level to generate, sizes in cells
+struct LevelSpec {
+    int width = SCREEN_WIDTH;
+    int floor = Physics_t().groundLevel; // Where feet rest on the ground
+    int minPlatforms = 6;
+    int maxPlatforms = 10;
+    int minPlatformWidth = 8;
+    int maxPlatformWidth = 16;
+    int minTop = PLAYER_HEIGHT + 1;  // The highest a platform may sit, a player has to fit on top
+    int minSpacing = 4;              // Rows between platforms that overlap or nearly touch side by side
+    float minAirCoverage = 0.75f;    // Share of the coins spawned in the air a player must be able to reach
+    int maxRepairs = 12;             // Platforms moved or dropped before a candidate is thrown away
+    int maxCandidates = 64;          // Candidates tried before a seed gives up
+};
+
+// How a generated or checked level came out
+struct LevelReport {
+    bool valid = false;
+    int candidates = 0;        // Layouts generated, the last one is the level
+    int repairs = 0;           // Platforms moved or dropped to make them reachable, over every candidate
+    int unreachable = 0;       // Platforms nobody can stand on
+    int unreachableCoins = 0;  // Platform coin spots nobody can get to
+    float airCoverage = 0.0f;  // Share of the air coin spots somebody can get to
+};
+
+/// @brief Seeded platform layouts whose every platform and coin spot a player can get to
+/// @details A candidate is a random set of platforms kept apart by LevelSpec::minSpacing. It is checked on a
+///          NavGraph built with the match's physics: both players are dropped from where they spawn, every stand
+///          their moves lead to is reachable, and a coin spot is reachable when a straight jump from a reachable
+///          stand touches it, as bots aim for them. Platforms nobody reaches are lowered towards the ground until
+///          they are, or dropped while the level keeps enough of them. Candidates that still fail, or leave too
+///          much of the air out of reach, are thrown away for the next one from the same random sequence, so a
+///          seed always makes the same level. A generator reuses its memory, keep one per thread.
+class LevelGenerator {
+public:
+    explicit LevelGenerator(const LevelSpec& spec = {}) : spec(spec) {}
+
+    /// @brief Generates the level for a seed
+    /// @param rules Gravity and jump force to check reachability with
+    /// @param platforms Receives the level, the last candidate tried when none was valid
+    LevelReport Generate(uint64_t seed, const GameRules& rules, std::vector<Platform>& platforms);
+
+    /// @brief Checks a layout, e.g. a hand-placed one, against the spec's world and coverage
+    LevelReport Validate(const std::vector<Platform>& platforms, const GameRules& rules);
+
+    const LevelSpec& GetSpec() const { return spec; }
+
+private:
+    LevelSpec spec;
+    NavGraph graph;
+
+    // Scratch kept between levels
+    std::vector<IL::Ledge> ledges;
+    std::vector<uint8_t> reachable;  // By stand
+    std::vector<uint8_t> reached;    // By platform
+    std::vector<uint8_t> cells;      // Cells a player can touch, by y * width + x
+
+    /// @brief Adds up to count random platforms that keep their spacing
+    void Scatter(Random& random, int count, std::vector<Platform>& platforms) const;
+
+    /// @brief Whether a platform keeps its spacing to every other one
+    bool Fits(const Platform& platform, const std::vector<Platform>& platforms, size_t skip) const;
+
+    /// @brief Moves or drops the first platform nobody can reach
+    /// @return Whether there was anything left to try
+    bool Repair(std::vector<Platform>& platforms) const;
+};
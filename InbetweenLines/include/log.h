@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <format>
+#include <string>
+#include <thread>
+
+// Messages below this level are compiled out entirely (0: trace, 1: info, 2: warning, 3: error, 4: off)
+#ifndef IL_LOG_LEVEL
+#ifdef NDEBUG
+#define IL_LOG_LEVEL 1
+#else
+#define IL_LOG_LEVEL 0
+#endif
+#endif
+
+namespace IL {
+    enum class LogLevel : int {
+        Trace = 0,
+        Info,
+        Warning,
+        Error,
+    };
+
+    /// @brief Per call site state, used to rate limit and deduplicate messages from hot paths
+    struct LogSite {
+        const char* function;
+        const char* file;
+        int line;
+
+        std::atomic<int64_t> windowStart = 0;   // Start of the current rate limit window
+        std::atomic<uint32_t> windowCount = 0;  // Messages admitted in the current window
+        std::atomic<uint64_t> lastHash = 0;     // Hash of the last message written
+        std::atomic<int64_t> lastTime = 0;
+        std::atomic<uint32_t> suppressed = 0;   // Messages dropped since the last one written
+
+        constexpr LogSite(const char* function, const char* file, int line) : function(function), file(file), line(line) {}
+    };
+
+    /// @brief Lock-free logger, producers format into a bounded MPSC ring and a background thread writes it out
+    /// @details Logging never blocks: when the ring is full the message is counted as dropped. Each call site may
+    ///          write MAX_PER_SECOND messages per second and repeats of its last message are folded into a count.
+    ///          Only one Logger (the writer) may exist at a time.
+    class Logger {
+    public:
+        static constexpr size_t MESSAGE_SIZE = 256;
+        static constexpr size_t CAPACITY = 1024; // Must be a power of two
+        static constexpr uint32_t MAX_PER_SECOND = 10;
+        static constexpr int64_t DEDUP_WINDOW_NS = 1'000'000'000;
+
+        /// @brief Starts the writer thread
+        /// @param path The file to append to, or empty to write to stderr
+        explicit Logger(const std::string& path = {});
+
+        /// @brief Drains every queued message and stops the writer thread
+        ~Logger();
+
+        Logger(const Logger&) = delete;
+        Logger& operator=(const Logger&) = delete;
+
+        /// @brief Formats and queues a message, called through the IL_LOG macros
+        template<typename... Args>
+        static void Write(LogSite& site, LogLevel level, std::format_string<Args...> fmt, Args&&... args) {
+            int64_t now = Now();
+            if (!Admit(site, now)) {
+                return;
+            }
+
+            char text[MESSAGE_SIZE];
+            auto result = std::format_to_n(text, MESSAGE_SIZE, fmt, std::forward<Args>(args)...);
+            size_t length = result.size < static_cast<ptrdiff_t>(MESSAGE_SIZE) ? static_cast<size_t>(result.size) : MESSAGE_SIZE;
+            Push(site, level, now, text, length);
+        }
+
+        /// @brief Returns how many messages were dropped because the ring was full
+        static uint64_t Dropped() { return s_dropped.load(std::memory_order_relaxed); }
+
+    private:
+        struct Slot {
+            std::atomic<size_t> sequence;   // Relative to the slot index, see SlotSequence
+            LogLevel level;
+            const LogSite* site;
+            uint32_t suppressed;
+            int64_t time;
+            size_t length;
+            char text[MESSAGE_SIZE];
+        };
+
+        static int64_t Now() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        static size_t SlotSequence(size_t index);
+        static void SetSlotSequence(size_t index, size_t sequence);
+        static bool Admit(LogSite& site, int64_t now);
+        static void Push(LogSite& site, LogLevel level, int64_t now, const char* text, size_t length);
+        static bool Drain(FILE* out);
+        void Run();
+
+        static Slot s_slots[CAPACITY];
+        static std::atomic<size_t> s_enqueuePos;
+        static size_t s_dequeuePos;
+        static std::atomic<uint64_t> s_dropped;
+
+        FILE* out = stderr;
+        bool ownsFile = false;
+        std::atomic<bool> running = true;
+        std::thread writer;
+    };
+}
+
+#define IL_LOG(level, fmt, ...) do { \
+    if constexpr (static_cast<int>(level) >= IL_LOG_LEVEL) { \
+        static IL::LogSite ilLogSite(__FUNCTION__, __FILE__, __LINE__); \
+        IL::Logger::Write(ilLogSite, level, fmt, ##__VA_ARGS__); \
+    } \
+} while (false)
+
+#define IL_TRACE(fmt, ...) IL_LOG(IL::LogLevel::Trace, fmt, ##__VA_ARGS__)
+#define IL_INFO(fmt, ...) IL_LOG(IL::LogLevel::Info, fmt, ##__VA_ARGS__)
+#define IL_WARN(fmt, ...) IL_LOG(IL::LogLevel::Warning, fmt, ##__VA_ARGS__)
+#define IL_ERROR(fmt, ...) IL_LOG(IL::LogLevel::Error, fmt, ##__VA_ARGS__)
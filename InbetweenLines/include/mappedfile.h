@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace IL {
+    /// @brief Read-only file mapping that only ever maps one window of the file at a time
+    /// @details Address space and resident memory stay bounded by the window size however large the file is.
+    ///          Several windows can be opened on the same file, each is remapped independently as it moves.
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /// @brief Opens a file for mapping
+        /// @return Whether the file could be opened
+        bool Open(const std::filesystem::path& path);
+
+        void Close();
+
+        uint64_t GetSize() const { return size; }
+
+        /// @brief The mapping granularity, window offsets are rounded down to it
+        static size_t GetGranularity();
+
+        /// @brief A view into part of a file, moved on demand
+        class Window {
+        public:
+            Window() = default;
+            ~Window();
+
+            Window(const Window&) = delete;
+            Window& operator=(const Window&) = delete;
+
+            /// @param file The file to view, must outlive the window
+            /// @param windowSize The bytes mapped at once, rounded up to the mapping granularity
+            void Attach(const MappedFile& file, size_t windowSize);
+
+            /// @brief Returns a pointer to bytes [offset, offset + length), remapping the window if they are not in view
+            /// @return The bytes, or nullptr if they are past the end of the file, longer than the window or the
+            ///         mapping failed
+            const uint8_t* Get(uint64_t offset, size_t length);
+
+            /// @brief Asks the OS to start reading a range that is about to be used, the part outside the window is ignored
+            void ReadAhead(uint64_t offset, size_t length) const;
+
+            void Unmap();
+
+        private:
+            const MappedFile* file = nullptr;
+            size_t windowSize = 0;
+            const uint8_t* view = nullptr;
+            uint64_t viewOffset = 0;
+            size_t viewSize = 0;
+        };
+
+    private:
+        uint64_t size = 0;
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#else
+        int fd = -1;
+#endif
+    };
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "game.h"
+#include "physics.h"
+
+// Moves a standing player can make, the direction is held until they land again
+enum NavMove : uint8_t {
+    NAV_WALK_LEFT = 0,
+    NAV_WALK_RIGHT,
+    NAV_JUMP_LEFT,
+    NAV_JUMP_UP,
+    NAV_JUMP_RIGHT,
+    NAV_MOVES,
+};
+
+// The keys a bot holds for one tick
+struct NavKeys {
+    bool left = false;
+    bool right = false;
+    bool jump = false;
+};
+
+// Where a coin can be reached from: standing anywhere in [left, right] on a surface, jumping straight up if need be
+struct NavTarget {
+    int surface;
+    int left, right;   // Player x
+    bool jump;
+    int value;
+    uint64_t expires;  // The tick the coin explodes on
+};
+
+/// @brief Every place a player can stand and the moves between them, built from the level and the match's physics
+/// @details A stand is a surface (a platform top or the ground) and a player x on it. Each of the five moves from
+///          every stand is played out tick by tick with StepBodies and the same key handling as UpdateGame, so the
+///          graph only holds moves the game really allows and the stand they end on. Routes are found with A* over
+///          stands, costed in ticks and guided by the horizontal distance left (no move covers more than a cell a
+///          tick). Each route is searched for once and then kept, as is every stand a failed search proves cut off,
+///          so after the first few frames planning is table lookups. Ties between equally quick routes are broken
+///          the same way whatever was searched before, so replays and matches stay deterministic.
+class NavGraph {
+public:
+    static constexpr int32_t UNREACHABLE = INT32_MAX;
+    static constexpr int MAX_FLIGHT_TICKS = 240; // Moves still in the air after this are left out
+
+    // The quickest way from a stand to a surface
+    struct Route {
+        int32_t ticks = -1;   // -1 until searched, UNREACHABLE when there is no way
+        int16_t arrivalX = 0; // Where on the surface the route lands
+        NavMove move = NAV_JUMP_UP; // The first move
+    };
+
+    /// @brief Builds the graph for a match's level and rules
+    /// @details Keeps the graph and its routes when the level and rules are the ones it was built for, so bots
+    ///          can call this at the start of every match.
+    void Build(const State_t& state);
+
+    /// @brief Builds the graph for any set of platform tops, e.g. a level that is still being generated
+    /// @param width The world's width in cells, players stay inside it
+    void Build(const std::vector<IL::Ledge>& ledges, const IL::FallRules& fall, IL::Fixed jumpForce, int width = SCREEN_WIDTH);
+
+    /// @brief The stand of a grounded player whose idle body's top-left cell is (x, y), or -1
+    int StandAt(int x, int y) const;
+
+    /// @brief Where a player let go of with their idle body's top-left cell at (x, y) comes to stand, or -1
+    int DropAt(int x, int y) const;
+
+    /// @brief Marks every stand some sequence of moves leads to from the starts, the starts included
+    void FindReachable(std::span<const int> starts, std::vector<uint8_t>& reachable);
+
+    int SurfaceOf(int stand) const { return stands[stand].surface; }
+    int XOf(int stand) const { return stands[stand].x; }
+    int TopOf(int surface) const { return surfaces[surface].top; }
+
+    /// @brief The highest a player's top gets in a straight jump from a surface
+    int ApexOf(int surface) const { return surfaces[surface].apexY; }
+
+    /// @brief The index of the ledge a surface stands on, -1 for the ground
+    int LedgeOf(int surface) const { return surfaces[surface].ledge; }
+
+    int GetSurfaceCount() const { return static_cast<int>(surfaces.size()); }
+    int GetStandCount() const { return static_cast<int>(stands.size()); }
+
+    /// @brief Ticks from leaving the ground to the top of a straight jump
+    int GetRiseTicks() const { return riseTicks; }
+
+    /// @brief The quickest route from a stand to anywhere on a surface, searching only when it is not known yet
+    const Route& FindRoute(int stand, int surface);
+
+    /// @brief Lists where each active coin can be reached from, replacing the previous contents of targets
+    void FindTargets(const State_t& state, std::vector<NavTarget>& targets) const;
+
+    uint64_t GetSearches() const { return searches; }
+
+    /// @brief Routes known so far
+    size_t GetKnownRoutes() const { return knownRoutes; }
+
+private:
+    struct Surface {
+        int top;        // Where the feet rest
+        int minX, maxX; // Player x range standing on it
+        int apexY;      // The highest the player's top gets in a straight jump from here
+        int ledge;      // -1 for the ground
+    };
+
+    struct Stand {
+        int16_t surface;
+        int16_t x;
+        int32_t to[NAV_MOVES];       // The stand each move lands on, -1 when it leads nowhere new
+        uint16_t ticks[NAV_MOVES];
+    };
+
+    // What the graph was built from
+    std::vector<IL::Ledge> ledges;
+    IL::FallRules fall = {};
+    IL::Fixed jumpForce = 0;
+    int width = 0;
+    bool built = false;
+
+    std::vector<Surface> surfaces;
+    std::vector<Stand> stands;
+    std::vector<int32_t> standAt; // By y and x, -1 where nobody stands
+    int columns = 0; // Player x from 0 to columns - 1
+    int rows = 0;
+    int riseTicks = 0;
+
+    std::vector<Route> routes;    // By stand * surfaces + surface
+    size_t knownRoutes = 0;
+    uint64_t searches = 0;
+
+    // A* scratch, sized with the graph so searching never allocates
+    struct Open {
+        int32_t estimate;
+        int32_t stand;
+    };
+
+    std::vector<Open> open;
+    std::vector<int32_t> cost;
+    std::vector<int32_t> parent;
+    std::vector<uint8_t> parentMove;
+    std::vector<uint32_t> seen;   // Search number a stand was last reached in
+    std::vector<uint32_t> closed;
+    std::vector<int32_t> frontier;
+    uint32_t search = 0;
+
+    // Bodies playing out moves, see FlyMoves
+    struct Flight {
+        std::vector<IL::Fixed> y, velocityY;
+        std::vector<int32_t> left, right, height, direction;
+        std::vector<int32_t> move; // stand * NAV_MOVES + move
+        std::vector<uint8_t> grounded;
+    };
+
+    Flight flight;
+
+    /// @brief Plays out every move from every stand and links each to the stand it lands on
+    void FlyMoves();
+
+    /// @brief Falls from (x, y) holding a direction, returning the stand the body lands on or -1
+    int Fly(int x, IL::Fixed y, IL::Fixed velocity, int direction, int& ticks) const;
+
+    /// @brief Ticks of walking at least needed from x to a surface
+    int Distance(int x, const Surface& surface) const;
+
+    void Search(int start, int surface);
+};
+
+/// @brief Steers one player along NavGraph routes to the coin worth the most per tick of travel
+/// @details Coins that would explode before the player gets there are passed over. A bot only decides when
+///          standing, in the air it keeps holding the direction it took off in, as the graph's moves assume.
+class NavBot {
+public:
+    /// @brief Picks the keys for the next tick
+    /// @param x, y The top-left cell of the player's idle body
+    /// @param grounded Whether the player stands on something
+    /// @param now The match's tick, state.timers.Now()
+    NavKeys Think(NavGraph& graph, int x, int y, bool grounded, std::span<const NavTarget> targets, uint64_t now);
+
+    NavKeys Think(NavGraph& graph, const Player& player, std::span<const NavTarget> targets, uint64_t now) {
+        return Think(graph, player.position.x, player.position.y, player.physics.isOnGround, targets, now);
+    }
+
+    /// @brief The target chosen on the last Think, or -1
+    int GetTarget() const { return target; }
+
+private:
+    int flightDirection = 0;
+    int target = -1;
+};
@@ -2,67 +2,37 @@
 
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
-#include <string>
+#include <atomic>
+#include <chrono>
 #include <memory>
-#include <format>
 #include <unordered_set>
 
+#include "canvas.h"
+#include "framering.h"
+#include "input.h"
+
 namespace IL {
-    constexpr int NOTEPAD_WIDTH = 165;
-    constexpr int NOTEPAD_HEIGHT = 38;
-
-    constexpr UINT KEY_UP = 0x26;
-    constexpr UINT KEY_DOWN = 0x28;
-    constexpr UINT KEY_LEFT = 0x25;
-    constexpr UINT KEY_RIGHT = 0x27;
-    constexpr UINT KEY_W = 0x57;
-    constexpr UINT KEY_A = 0x41;
-    constexpr UINT KEY_S = 0x53;
-    constexpr UINT KEY_D = 0x44;
-    constexpr UINT KEY_SPACE = 0x20;
-    constexpr UINT KEY_ENTER = 0x0D;
-    constexpr UINT KEY_ESCAPE = 0x1B;
-
-    class Notepad {
+    constexpr int NOTEPAD_WIDTH = CANVAS_WIDTH;
+    constexpr int NOTEPAD_HEIGHT = CANVAS_HEIGHT;
+    constexpr int NOTEPAD_CELLS = CANVAS_CELLS;
+
+    /// @brief Win32 platform: presents frames through notepad's edit control and reads keys from a keyboard hook
+    class Notepad : public Canvas, public InputSource {
     public:
         Notepad();
         ~Notepad();
 
-        /// @brief Writes text to the notepad window
-        /// @param text The text to write
-        /// @param x The x position to write the text
-        /// @param y The y position to write the text
-        /// @param widthEqualsHeight Whether the width of x index should be the same as the height of y index (default: true)
-        template<typename... Args>
-        void Text(int x, int y, const std::string_view& fmt, Args... args) {
-            Text(std::vformat(fmt, std::make_format_args(args...)), x, y);
-        }
-        template<typename... Args>
-        void Text(int x, int y, bool widthEqualsHeight, const std::string_view& fmt, Args... args) {
-            Text(std::vformat(fmt, std::make_format_args(args...)), x, y, widthEqualsHeight);
-        }
-        void Text(const std::string_view& text, int x, int y, bool widthEqualsHeight = true);
-
-        /// @brief Draws a rectangle to the notepad window
-        /// @param x The x position to draw the rectangle
-        /// @param y The y position to draw the rectangle
-        /// @param width The width of the rectangle
-        /// @param height The height of the rectangle
-        /// @param fill Whether to fill the rectangle (default: false)
-        /// @param widthEqualsHeight Whether the width of x index should be the same as the height of y index (default: true)
-        void Rectangle(int x, int y, int width, int height, bool fill = false, bool widthEqualsHeight = true, wchar_t fillChar = L'\u2588');
-
-        /// @brief Begins writing to the notepad window
-        void Begin();
-
-        /// @brief Ends writing to the notepad window and flushes the text buffer
-        /// @param targetFPS The target frames per second to wait for before flushing the text buffer (default: 60)
-        void End(int targetFPS = 60);
+        /// @brief Sets the rate Present paces frames to (default: 60)
+        void SetTargetFPS(int fps) { targetFPS = fps; }
 
         /// @brief Flushes the text buffer to the notepad window
         void Flush();
 
-        /// @brief Gets the text buffer address
+        /// @brief Also publishes every presented frame into a shared memory ring, see FrameRingReader
+        /// @return Whether the ring could be created
+        bool PublishFrames(std::string_view name) { return frameRing.Create(name, NOTEPAD_WIDTH, NOTEPAD_HEIGHT); }
+
+        /// @brief Gets the text buffer address, nullptr until the edit control's text handle was located
         static wchar_t* GetBuffer();
 
         /// @brief Installs a keyboard hook to prevent typing in the notepad
@@ -74,14 +44,37 @@ namespace IL {
         /// @brief Returns a reference to the keys currently pressed
         static std::unordered_set<UINT>& GetKeysPressed() { return keysPressed; }
 
+        bool IsKeyDown(Key key) const override { return keysPressed.count(key) > 0; }
+
         /// @brief Checks if the notepad is valid
         bool IsValid() const;
+    protected:
+        /// @brief Paces to the target rate, copies the frame into the edit buffer and repaints
+        void Present() override;
+
     private:
         HWND mainhWnd = nullptr;
         HWND editWnd = nullptr;
 
-        std::shared_ptr<wchar_t> backBuffer = std::shared_ptr<wchar_t>(new wchar_t[NOTEPAD_WIDTH * NOTEPAD_HEIGHT * 2], std::default_delete<wchar_t[]>());
-        
+        // The window's style and size before the fixed frame was set, restored only if it was
+        bool reshaped = false;
+        LONG originalStyle = 0;
+        RECT originalRect = {};
+
+        // Attributes of the presented frame, read by WM_PAINT
+        std::unique_ptr<CellAttr[]> frontAttrs = std::make_unique<CellAttr[]>(NOTEPAD_CELLS);
+
+        // For recorders and other displays, closed unless PublishFrames was called
+        FrameRingWriter frameRing;
+
+        int targetFPS = 60;
+        std::chrono::steady_clock::time_point lastPresent = std::chrono::steady_clock::now();
+
+        /// @brief Locates the global in notepad.exe holding the edit control's text handle, see s_bufferSlot
+        bool ResolveBufferSlot();
+
+        int framesSinceSlotCheck = 0;
+
         // Static hook handle and procedure
         static LRESULT CALLBACK KeyboardProc(int nCode, WPARAM wParam, LPARAM lParam);
         static inline HHOOK s_keyboardHook = nullptr;
@@ -90,6 +83,9 @@ namespace IL {
 
         static inline WNDPROC oEditWndProc = nullptr;
 
+        // Notepad's global holding the HLOCAL of the edit control's text, the handle in turn points at the buffer
+        static inline std::atomic<HLOCAL*> s_bufferSlot = nullptr;
+
         static LRESULT CALLBACK EditWndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
     };
 }
\ No newline at end of file
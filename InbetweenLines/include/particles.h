@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "canvas.h"
+
+namespace IL {
+    /// @brief How an emitter releases particles
+    enum class EmitterKind {
+        Burst,    // Everything at once, then done
+        Fountain, // A steady stream from a fixed point
+        Trail,    // A steady stream spread along the path of a moving point, see ParticleEmitter::MoveTo
+    };
+
+    /// @brief What an emitter releases, positions and speeds are in cells and cells per tick
+    struct EmitterConfig {
+        EmitterKind kind = EmitterKind::Burst;
+        float rate = 16.0f;          // Particles per burst, or per tick for fountains and trails
+        float direction = -1.5708f;  // Radians, zero points right and the default straight up
+        float spread = 3.1416f;      // Radians either side of direction, pi sprays every way
+        float speedMin = 0.2f;
+        float speedMax = 0.6f;
+        float stretchX = 2.0f;       // Horizontal speed scale, cells are about twice as tall as wide
+        float gravity = 0.0f;        // Added to the vertical speed every tick
+        int lifeMin = 5;             // Ticks
+        int lifeMax = 10;
+        int style = 0;               // See ParticlePool::AddStyle
+    };
+
+    /// @brief A fixed capacity pool of particles stored as structure of arrays
+    /// @details Update integrates four particles at a time with SSE2 and culls dead ones by swapping the last live
+    ///          particle into their slot, so live particles stay packed at the front. Render works out every
+    ///          particle's cell and glyph first and writes them with a single Canvas::Splat.
+    class ParticlePool {
+    public:
+        static constexpr int MAX_STYLES = 8;
+        static constexpr int MAX_RAMP = 16;
+
+        /// @param capacity The most particles alive at once, emitting past it is ignored
+        /// @param seed Seeds the pool's own random numbers, emitting never touches anyone else's
+        explicit ParticlePool(size_t capacity, uint32_t seed = 1);
+
+        /// @brief Registers how particles look
+        /// @param ramp Glyphs shown over a particle's life, from birth to death (at most MAX_RAMP)
+        /// @param attr The colour and style of the glyphs
+        /// @return The style's index for EmitterConfig::style, or -1 when MAX_STYLES are already registered
+        int AddStyle(std::u16string_view ramp, CellAttr attr = DEFAULT_ATTR);
+
+        /// @brief Sets the area particles live in, in cells (default: the canvas), ones leaving the sides or the
+        ///        bottom die and ones above the top keep flying but are not drawn
+        void SetBounds(float width, float height);
+
+        /// @brief Adds one particle
+        /// @return Whether there was room for it
+        bool Emit(float x, float y, float velocityX, float velocityY, float gravity, int life, int style);
+
+        /// @brief Releases config.rate particles at a point, whatever the config's kind
+        void Burst(const EmitterConfig& config, float x, float y);
+
+        /// @brief Advances every particle by one tick and removes the dead ones
+        void Update();
+
+        /// @brief Scalar reference implementation of Update, leaves the pool in the same state
+        void UpdateScalar();
+
+        /// @brief Draws every particle to the canvas's current layer, later particles win shared cells
+        void Render(Canvas& canvas) const;
+
+        /// @brief Removes every particle
+        void Clear() { count = 0; }
+
+        size_t GetCount() const { return count; }
+        size_t GetCapacity() const { return capacity; }
+
+    private:
+        friend class ParticleEmitter;
+
+        struct Style {
+            Cell ramp[MAX_RAMP];
+            int length;
+            CellAttr attr;
+        };
+
+        size_t capacity;
+        size_t count = 0;
+        float boundsWidth = CANVAS_WIDTH;
+        float boundsHeight = CANVAS_HEIGHT;
+        uint32_t random;
+
+        std::vector<float> x, y, velocityX, velocityY, gravity, age, life;
+        std::vector<uint8_t> style;
+        std::vector<Style> styles;
+
+        // Render scratch, sized to capacity once so drawing does not allocate
+        mutable std::vector<int32_t> splatIndices;
+        mutable std::vector<float> splatProgress;
+        mutable std::vector<Cell> splatCells;
+        mutable std::vector<CellAttr> splatAttrs;
+
+        /// @brief Uniform in [0, 1)
+        float NextFloat();
+
+        /// @brief Emits one particle with a random speed, direction and life from the config
+        void EmitFrom(const EmitterConfig& config, float x, float y);
+
+        /// @brief Moves the last particle into slot i
+        void Remove(size_t i);
+
+        /// @brief Removes every particle that is out of life or out of bounds
+        void Cull(bool simd);
+    };
+
+    /// @brief Releases particles into a pool over time
+    class ParticleEmitter {
+    public:
+        ParticleEmitter(const EmitterConfig& config, float x, float y) : config(config), x(x), y(y), lastX(x), lastY(y) {}
+
+        /// @brief Moves the emitter, a trail spreads the next tick's particles along the way
+        void MoveTo(float x, float y);
+
+        /// @brief Emits this tick's particles, fractional rates carry over to later ticks
+        void Update(ParticlePool& pool);
+
+        /// @brief Whether a burst has gone off, fountains and trails never finish
+        bool IsDone() const { return done; }
+
+    private:
+        EmitterConfig config;
+        float x, y;
+        float lastX, lastY;
+        float carry = 0.0f;
+        bool done = false;
+    };
+}
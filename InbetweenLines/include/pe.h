@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace IL {
+    constexpr uint32_t PE_SECTION_EXECUTE = 0x20000000;
+    constexpr uint32_t PE_SECTION_READ = 0x40000000;
+    constexpr uint32_t PE_SECTION_WRITE = 0x80000000;
+
+    struct PeSection {
+        char name[9] = {};
+        uint32_t virtualAddress = 0;
+        uint32_t virtualSize = 0;
+        uint32_t rawOffset = 0;
+        uint32_t rawSize = 0;
+        uint32_t characteristics = 0;
+    };
+
+    /// @brief The parts of a PE header needed to find things in an image
+    struct PeImage {
+        uint16_t machine = 0;
+        uint32_t timeDateStamp = 0;
+        uint32_t sizeOfImage = 0;
+        std::vector<PeSection> sections;
+    };
+
+    /// @brief Parses the headers of a PE image, from a file on disk or a module loaded in memory
+    /// @param image The start of the image, where the DOS header is
+    /// @param size The number of readable bytes, the headers must lie within them
+    /// @param out Receives the parsed headers
+    /// @return Whether the headers were valid
+    bool ParsePeImage(const uint8_t* image, size_t size, PeImage& out);
+
+    /// @brief Returns the bytes of a section, clamped to the readable size
+    /// @param mapped Whether the image is laid out as loaded (sections at their RVA) rather than as the file on disk
+    std::span<const uint8_t> PeSectionBytes(const uint8_t* image, size_t size, const PeSection& section, bool mapped);
+}
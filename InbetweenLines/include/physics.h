@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace IL {
+    /// @brief A position or speed in sub-cells, 24.8 fixed point so 256 sub-cells make a cell
+    using Fixed = int32_t;
+
+    constexpr int FIXED_SHIFT = 8;
+    constexpr Fixed FIXED_ONE = 1 << FIXED_SHIFT;
+
+    constexpr Fixed CellsToFixed(int cells) {
+        return cells * FIXED_ONE;
+    }
+
+    /// @brief The whole cell a fixed point value lies in, rounding down
+    constexpr int FixedToCell(Fixed value) {
+        return value >> FIXED_SHIFT;
+    }
+
+    /// @brief Rounds to the nearest sub-cell, for tuning values given in cells
+    inline Fixed ToFixed(float cells) {
+        return static_cast<Fixed>(std::lround(cells * FIXED_ONE));
+    }
+
+    /// @brief The top of a one-way platform, bodies land on it from above and pass through from below, in cells
+    struct Ledge {
+        int left;   // First cell covered
+        int right;  // First cell past the end
+        int top;
+    };
+
+    /// @brief Bodies that fall and land, as structure of arrays, see StepBodies
+    struct BodyArrays {
+        Fixed* y;               // Top edge
+        Fixed* velocityY;       // Sub-cells per tick, positive is down
+        const int32_t* left;    // Horizontal extent in whole cells, [left, right)
+        const int32_t* right;
+        const int32_t* height;  // Cells from the top edge to the bottom one
+        uint8_t* grounded;      // Whether the body stands on a ledge or the floor after the step
+        size_t count;
+    };
+
+    /// @brief What every body falls through
+    struct FallRules {
+        Fixed gravity;           // Added to the speed every tick
+        Fixed terminalVelocity;  // The fastest a body falls
+        int floor;               // Bottom edges stop here wherever they come from, in cells
+    };
+
+    /// @brief Moves every body by one tick, four at a time with SSE2
+    /// @details Gravity is added and capped, then each falling body's bottom edge is swept from where it was to
+    ///          where it moves. It lands on the highest ledge top the sweep crosses while overlapping the ledge, so
+    ///          no speed can carry it through a platform. Bodies are stopped at the top of the world (y = 0). All
+    ///          arithmetic is on integers, so every machine computes the same steps.
+    void StepBodies(const BodyArrays& bodies, const FallRules& rules, const Ledge* ledges, size_t ledgeCount);
+
+    /// @brief Scalar reference implementation of StepBodies, leaves the bodies in the same state
+    void StepBodiesScalar(const BodyArrays& bodies, const FallRules& rules, const Ledge* ledges, size_t ledgeCount);
+}
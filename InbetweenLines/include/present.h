@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "cellattr.h"
+#include "cellwidth.h"
+
+namespace IL {
+    /// @brief Appends a frame as UTF-8 with ANSI escapes, one SGR sequence per run of equal attributes
+    /// @param cells The glyph plane, zero cells are written as spaces
+    /// @param attrs The attribute plane matching cells
+    /// @param width The number of cells per line
+    /// @param height The number of lines
+    /// @param out The string to append to, the cursor is homed first
+    void AppendAnsiFrame(const Cell* cells, const CellAttr* attrs, int width, int height, std::string& out);
+
+    /// @brief Appends a frame as plain UTF-8 without colours, e.g. for logs and diffs
+    /// @param cells The glyph plane, zero cells are written as spaces
+    /// @param width The number of cells per line
+    /// @param height The number of lines
+    /// @param out The string to append to, one line per row
+    void AppendTextFrame(const Cell* cells, int width, int height, std::string& out);
+}
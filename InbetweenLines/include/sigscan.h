@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace IL {
+    /// @brief A byte pattern with wildcards
+    struct Signature {
+        std::vector<uint8_t> bytes;
+        std::vector<uint8_t> mask; // 0xFF where the byte must match, 0 for a wildcard
+
+        /// @brief Parses IDA style text such as "48 8B 05 ?? ?? ?? ??", `?` and `??` are wildcards
+        /// @return Whether the text was valid and had at least one byte that must match
+        static bool Parse(std::string_view text, Signature& out);
+
+        /// @brief Builds a signature matching exactly the given bytes, such as the representation of a value
+        static Signature FromBytes(const void* data, size_t size);
+    };
+
+    /// @brief Finds the first match of a signature in a buffer
+    /// @details Candidates are filtered on two fixed bytes of the pattern 32 positions at a time with AVX2 when the
+    ///          CPU supports it, and with memchr otherwise, before the whole pattern is compared
+    /// @param data The buffer to search
+    /// @param size The number of bytes in the buffer
+    /// @param signature The pattern to look for
+    /// @return The offset of the match, or SIZE_MAX if there is none
+    size_t FindSignature(const uint8_t* data, size_t size, const Signature& signature);
+
+    /// @brief Scalar reference implementation of FindSignature
+    size_t FindSignatureScalar(const uint8_t* data, size_t size, const Signature& signature);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <emmintrin.h>
+
+#include "cellwidth.h"
+
+namespace IL {
+    /// @brief Non-owning view of a baked sprite, handed to Canvas::Blit
+    struct SpriteView {
+        const Cell* cells = nullptr; // Glyphs, row major with `stride` cells per row
+        const Cell* mask = nullptr;  // 0xFFFF for opaque cells, 0 for transparent ones
+        int width = 0;
+        int height = 0;
+        int stride = 0;
+    };
+
+    /// @brief A sprite baked at compile time into cell rows plus a transparency mask
+    /// @tparam MaxWidth The widest the sprite can be, used as the row stride
+    /// @tparam MaxHeight The tallest the sprite can be
+    template<int MaxWidth, int MaxHeight>
+    struct Sprite {
+        static constexpr Cell OPAQUE_MASK = static_cast<Cell>(0xFFFF);
+
+        int width = MaxWidth;
+        int height = MaxHeight;
+        Cell cells[MaxWidth * MaxHeight] = {};
+        Cell mask[MaxWidth * MaxHeight] = {};
+
+        constexpr Sprite() = default;
+        constexpr Sprite(int width, int height) : width(width), height(height) {}
+
+        /// @brief Sets an opaque cell, writes outside the sprite are ignored
+        constexpr void Set(int x, int y, Cell c) {
+            if (x < 0 || y < 0 || x >= width || y >= height) {
+                return;
+            }
+
+            cells[y * MaxWidth + x] = c;
+            mask[y * MaxWidth + x] = OPAQUE_MASK;
+        }
+
+        constexpr SpriteView View() const {
+            return { cells, mask, width, height, MaxWidth };
+        }
+    };
+
+    /// @brief Bakes a sprite from rows of equal length, e.g. BakeSprite(u" /\\ ", u"/__\\")
+    /// @tparam Transparent The glyph that is left see-through (default: space)
+    template<Cell Transparent = u' ', size_t N, typename... Rows>
+    consteval Sprite<static_cast<int>(N - 1), static_cast<int>(sizeof...(Rows) + 1)> BakeSprite(const Cell (&first)[N], const Rows&... rest) {
+        static_assert((std::is_same_v<Rows, Cell[N]> && ...), "Every sprite row must have the same length");
+
+        Sprite<static_cast<int>(N - 1), static_cast<int>(sizeof...(Rows) + 1)> sprite;
+        const Cell* rows[] = { first, rest... };
+        for (int y = 0; y < sprite.height; y++) {
+            for (int x = 0; x < sprite.width; x++) {
+                if (rows[y][x] != Transparent) {
+                    sprite.Set(x, y, rows[y][x]);
+                }
+            }
+        }
+
+        return sprite;
+    }
+
+    /// @brief Copies a sprite row over dst wherever its mask is set, 8 cells at a time
+    inline void BlendMasked(Cell* dst, const Cell* src, const Cell* mask, size_t count) {
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&dst[i]));
+            __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&mask[i]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&dst[i]), _mm_or_si128(_mm_and_si128(m, s), _mm_andnot_si128(m, d)));
+        }
+
+        for (; i < count; i++) {
+            if (mask[i] != 0) {
+                dst[i] = src[i];
+            }
+        }
+    }
+}
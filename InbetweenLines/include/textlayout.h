@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cellwidth.h"
+#include "sprite.h"
+
+namespace IL {
+    enum class TextAlign {
+        Left,
+        Center,
+        Right,
+    };
+
+    /// @brief Shown at the end of the last line when text does not fit its box
+    constexpr Cell ELLIPSIS = u'\u2026';
+
+    /// @brief Text wrapped into a box of cells, drawn with Canvas::Blit or Canvas::TextBox
+    /// @details Lines break after spaces, words wider than the box are split, and `\n` starts a new line. Spaces
+    ///          where a line breaks are dropped and wide glyphs are never split. When the text needs more lines
+    ///          than the box holds, the last one is cut to make room for an ellipsis. Cells inside a line are
+    ///          opaque (spaces included), the rest of the box is transparent.
+    class TextLayout {
+    public:
+        /// @brief Lays out text, reusing the memory of the previous layout
+        /// @param text UTF-8 text
+        /// @param width The box's width in cells
+        /// @param height The most lines shown
+        /// @param align Where each line sits in the box
+        void Layout(std::string_view text, int width, int height, TextAlign align = TextAlign::Left);
+
+        /// @brief The laid out box, as wide as the layout width and as tall as the lines used
+        SpriteView View() const;
+
+        int GetWidth() const { return width; }
+        int GetLines() const { return lines; }
+
+        /// @brief Whether text was cut off because the box is too short
+        bool IsTruncated() const { return truncated; }
+
+    private:
+        struct Line {
+            size_t start;  // Into glyphs
+            size_t length;
+        };
+
+        int width = 0;
+        int lines = 0;
+        bool truncated = false;
+        std::vector<Cell> cells;
+        std::vector<Cell> mask;
+
+        // Scratch kept between layouts
+        std::vector<Cell> units;
+        std::vector<Cell> glyphs;
+        std::vector<Line> breaks;
+
+        /// @brief Breaks one paragraph's glyphs into lines
+        void Wrap(size_t start, size_t end);
+    };
+
+    /// @brief Keeps the layouts of recently drawn text so unchanged text is only blitted
+    /// @details Layouts are found by a hash of the text, the box size and the alignment in an open addressed
+    ///          table, the text itself is compared on a hit. When full, the least recently used layout is laid out
+    ///          again for the new text and keeps its memory, so a cache that holds the working set stops allocating.
+    class TextLayoutCache {
+    public:
+        static constexpr size_t DEFAULT_CAPACITY = 128;
+
+        explicit TextLayoutCache(size_t capacity = DEFAULT_CAPACITY);
+
+        /// @brief Returns the layout of text in a box, laying it out on a miss
+        /// @return The layout, valid until the next Get
+        const TextLayout& Get(std::string_view text, int width, int height, TextAlign align = TextAlign::Left);
+
+        /// @brief Forgets every layout
+        void Clear();
+
+        uint64_t GetHits() const { return hits; }
+        uint64_t GetMisses() const { return misses; }
+
+    private:
+        struct Entry {
+            uint64_t key = 0;
+            std::string text;
+            int width = 0;
+            int height = 0;
+            TextAlign align = TextAlign::Left;
+            uint64_t lastUse = 0;
+            TextLayout layout;
+        };
+
+        static constexpr uint32_t EMPTY = UINT32_MAX;
+
+        size_t capacity;
+        std::vector<Entry> entries;
+        std::vector<uint32_t> table; // Entry indices by key, linear probing, at most half full
+        size_t tableMask;
+        uint64_t uses = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+
+        static uint64_t Key(std::string_view text, int width, int height, TextAlign align);
+
+        /// @brief The table slot holding key, or the empty slot it would go in
+        size_t Find(uint64_t key) const;
+
+        /// @brief Empties a table slot, moving later entries of the same probe run back into the gap
+        void Erase(size_t slot);
+    };
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace IL {
+    /// @brief Handle to a scheduled timer, stale handles are safe to cancel or query
+    using TimerId = uint64_t;
+
+    constexpr TimerId INVALID_TIMER = 0;
+
+    /// @brief Hierarchical timing wheel, timers cost nothing until the tick they are due
+    /// @details Four levels of 64 slots cover 2^24 ticks (about three days at 60fps), later deadlines wait in the top
+    ///          level and move down again. Schedule and Cancel are O(1). Each slot is a doubly linked list of
+    ///          timers in a single node array, so running the wheel does not allocate once the array has grown.
+    ///          Timers due on the same tick fire in an order that only depends on the calls made, so runs replay.
+    class TimingWheel {
+    public:
+        static constexpr int LEVELS = 4;
+        static constexpr int SLOT_BITS = 6;
+        static constexpr int SLOTS = 1 << SLOT_BITS;
+        static constexpr uint64_t MAX_DELAY = (uint64_t(1) << (LEVELS * SLOT_BITS)) - 1;
+
+        TimingWheel();
+
+        /// @brief The number of Advance calls so far
+        uint64_t Now() const { return now; }
+
+        /// @brief Timers waiting to fire
+        size_t GetPending() const { return pending; }
+
+        /// @brief Schedules a timer
+        /// @param delay Ticks from now, the timer fires during that many Advance calls later (at least 1)
+        /// @param payload Handed back when the timer fires, e.g. what the timer is for and who it belongs to
+        TimerId Schedule(uint64_t delay, uint64_t payload);
+
+        /// @brief Removes a pending timer
+        /// @return Whether the timer was still pending
+        bool Cancel(TimerId id);
+
+        /// @brief Whether a timer is still waiting to fire
+        bool IsPending(TimerId id) const { return Find(id) != NIL; }
+
+        /// @brief The tick a pending timer fires on, or 0 if it is not pending
+        uint64_t GetDeadline(TimerId id) const;
+
+        /// @brief Moves to the next tick and fires every timer due on it
+        /// @param fire Called with the payload of each due timer, it may schedule and cancel timers itself
+        template<typename Fn>
+        void Advance(Fn&& fire) {
+            now++;
+            Cascade();
+
+            uint32_t slot = static_cast<uint32_t>(now & (SLOTS - 1));
+            while (heads[slot] != NIL) {
+                uint32_t node = heads[slot];
+                uint64_t payload = nodes[node].payload;
+                Release(node);
+                fire(payload);
+            }
+        }
+
+        /// @brief Makes room for this many pending timers, scheduling up to it then never allocates
+        void Reserve(size_t timers) { nodes.reserve(timers); }
+
+        /// @brief Removes every timer, handles given out before stay invalid
+        void Clear();
+
+        /// @brief Removes every timer and starts over at tick 0, keeping the memory, so the timers scheduled next
+        ///        fire exactly as in a new wheel
+        void Reset() {
+            Clear();
+            now = 0;
+        }
+
+    private:
+        static constexpr uint32_t NIL = UINT32_MAX;
+
+        struct Node {
+            uint64_t deadline = 0;
+            uint64_t payload = 0;
+            uint32_t previous = NIL;
+            uint32_t next = NIL;       // Next in the slot, or in the free list
+            uint32_t generation = 1;   // Bumped on release so old handles stop matching
+            uint16_t slot = 0;         // level * SLOTS + slot, for unlinking
+            bool used = false;
+        };
+
+        uint64_t now = 0;
+        size_t pending = 0;
+        std::vector<Node> nodes;
+        uint32_t freeList = NIL;
+        uint32_t heads[LEVELS * SLOTS];
+        uint32_t tails[LEVELS * SLOTS];
+
+        /// @brief The node of a pending timer, or NIL
+        uint32_t Find(TimerId id) const;
+
+        /// @brief Links a node into the slot its deadline falls in
+        void Insert(uint32_t node);
+
+        void Unlink(uint32_t node);
+
+        /// @brief Unlinks a node and returns it to the free list
+        void Release(uint32_t node);
+
+        /// @brief Moves the timers of the upper level slots that start at now down a level
+        void Cascade();
+    };
+}
@@ -18,6 +18,9 @@
 #include <vector>
 #include <ctime>
 
+// Logging, queued and written by the IL::Logger thread so it never blocks the caller
+#include "log.h"
+
 #undef ERROR
-#define INFO(...) MessageBoxA(nullptr, std::format(__VA_ARGS__).c_str(), "InbetweenLines - Info", MB_OK)
-#define ERROR(fmt, ...) MessageBoxA(nullptr, std::format("[!] {} ({}, {}:{})", std::format(fmt, ##__VA_ARGS__), __FUNCTION__, __FILE__, __LINE__).c_str(), "InbetweenLines - Error", MB_OK)
\ No newline at end of file
+#define INFO(...) IL_INFO(__VA_ARGS__)
+#define ERROR(...) IL_ERROR(__VA_ARGS__)
\ No newline at end of file
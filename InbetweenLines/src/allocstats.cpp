@@ -0,0 +1,77 @@
+#include "allocstats.h"
+
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new and delete of whatever this file is linked into (the DLL, not notepad) to count
+// allocations per thread. Only the plain and aligned forms are replaced, the array and nothrow forms call them.
+
+namespace {
+    thread_local uint64_t t_count = 0;
+    thread_local uint64_t t_bytes = 0;
+
+    void* Allocate(size_t size) {
+        t_count++;
+        t_bytes += size;
+        return std::malloc(size != 0 ? size : 1);
+    }
+
+    void* AllocateAligned(size_t size, size_t alignment) {
+        t_count++;
+        t_bytes += size;
+#ifdef _MSC_VER
+        return _aligned_malloc(size != 0 ? size : 1, alignment);
+#else
+        // aligned_alloc wants the size to be a multiple of the alignment
+        return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment + (size == 0 ? alignment : 0));
+#endif
+    }
+
+    void FreeAligned(void* memory) {
+#ifdef _MSC_VER
+        _aligned_free(memory);
+#else
+        std::free(memory);
+#endif
+    }
+}
+
+uint64_t IL::GetAllocationCount() {
+    return t_count;
+}
+
+uint64_t IL::GetAllocatedBytes() {
+    return t_bytes;
+}
+
+void* operator new(size_t size) {
+    void* memory = Allocate(size);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    void* memory = AllocateAligned(size, static_cast<size_t>(alignment));
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    FreeAligned(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept {
+    FreeAligned(memory);
+}
@@ -0,0 +1,219 @@
+#include "behavior.h"
+
+#include <algorithm>
+#include <new>
+
+using namespace IL;
+
+CoroutineFramePool::~CoroutineFramePool() = default;
+
+void* CoroutineFramePool::Allocate(size_t size) {
+    size_t block = size + sizeof(Header);
+    uint32_t sizeClass = static_cast<uint32_t>((block + GRANULE - 1) / GRANULE) - 1;
+
+    Header* header;
+    if (sizeClass >= CLASSES) {
+        header = static_cast<Header*>(::operator new(block));
+        sizeClass = LARGE;
+    } else {
+        if (freeLists[sizeClass] == nullptr) {
+            // A chunk is split into blocks of one class, a behavior type tends to be started many times over
+            size_t blockBytes = (sizeClass + 1) * GRANULE;
+            chunks.push_back(std::make_unique<std::byte[]>(CHUNK_BYTES));
+            reserved += CHUNK_BYTES;
+            std::byte* chunk = chunks.back().get();
+            for (size_t offset = CHUNK_BYTES / blockBytes * blockBytes; offset > 0; offset -= blockBytes) {
+                FreeBlock* free = reinterpret_cast<FreeBlock*>(chunk + offset - blockBytes);
+                free->next = freeLists[sizeClass];
+                freeLists[sizeClass] = free;
+            }
+        }
+
+        FreeBlock* free = freeLists[sizeClass];
+        freeLists[sizeClass] = free->next;
+        header = reinterpret_cast<Header*>(free);
+    }
+
+    header->pool = this;
+    header->sizeClass = sizeClass;
+    live++;
+    return header + 1;
+}
+
+void CoroutineFramePool::Free(void* frame) {
+    Header* header = static_cast<Header*>(frame) - 1;
+    CoroutineFramePool* pool = header->pool;
+    pool->live--;
+    if (header->sizeClass == LARGE) {
+        ::operator delete(header);
+        return;
+    }
+
+    FreeBlock* free = reinterpret_cast<FreeBlock*>(header);
+    free->next = pool->freeLists[header->sizeClass];
+    pool->freeLists[header->sizeClass] = free;
+}
+
+BehaviorScheduler& BehaviorScheduler::operator=(BehaviorScheduler&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+
+    Clear();
+    pool = std::move(other.pool);
+    wheel = std::move(other.wheel);
+    slots = std::move(other.slots);
+    freeSlots = std::move(other.freeSlots);
+    polls = std::move(other.polls);
+    ready = std::move(other.ready);
+    running = other.running;
+    started = other.started;
+
+    // The behaviors come along and now wait on this scheduler, the other one gets a pool of its own again
+    for (Slot& slot : slots) {
+        if (slot.handle) {
+            slot.handle.promise().scheduler = this;
+        }
+    }
+    other.pool = std::make_unique<CoroutineFramePool>();
+    other.wheel = TimingWheel();
+    other.slots.clear();
+    other.freeSlots.clear();
+    other.polls.clear();
+    other.running = 0;
+    other.started = 0;
+    return *this;
+}
+
+BehaviorId BehaviorScheduler::Start(Behavior behavior) {
+    uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(slots.size());
+        slots.emplace_back();
+    }
+
+    Slot& entry = slots[slot];
+    entry.handle = behavior.handle;
+    entry.order = started++;
+    behavior.handle = nullptr;
+    entry.handle.promise().slot = slot;
+    running++;
+
+    BehaviorId id = (static_cast<uint64_t>(entry.generation) << 32) | slot;
+    Resume(slot);
+    return IsRunning(id) ? id : INVALID_BEHAVIOR;
+}
+
+uint32_t BehaviorScheduler::Find(BehaviorId id) const {
+    uint32_t slot = static_cast<uint32_t>(id);
+    if (slot >= slots.size() || !slots[slot].handle || slots[slot].generation != static_cast<uint32_t>(id >> 32)) {
+        return NONE;
+    }
+    return slot;
+}
+
+bool BehaviorScheduler::Stop(BehaviorId id) {
+    uint32_t slot = Find(id);
+    if (slot == NONE) {
+        return false;
+    }
+
+    Release(slot);
+    return true;
+}
+
+void BehaviorScheduler::Sleep(Behavior::promise_type& promise, uint32_t ticks) {
+    promise.timer = wheel.Schedule(ticks, promise.slot);
+}
+
+void BehaviorScheduler::Wait(Behavior::promise_type& promise, void* awaiter, bool (*check)(void*)) {
+    promise.poll = static_cast<int32_t>(polls.size());
+    polls.push_back({ promise.slot, awaiter, check });
+}
+
+void BehaviorScheduler::RemovePoll(Behavior::promise_type& promise) {
+    // The last poll takes the removed one's place
+    size_t index = static_cast<size_t>(promise.poll);
+    polls[index] = polls.back();
+    polls.pop_back();
+    if (index < polls.size()) {
+        slots[polls[index].slot].handle.promise().poll = static_cast<int32_t>(index);
+    }
+    promise.poll = -1;
+}
+
+void BehaviorScheduler::Tick() {
+    ready.clear();
+    wheel.Advance([this](uint64_t payload) {
+        uint32_t slot = static_cast<uint32_t>(payload);
+        slots[slot].handle.promise().timer = INVALID_TIMER;
+        ready.push_back({ slots[slot].order, slot, slots[slot].generation });
+    });
+    std::sort(ready.begin(), ready.end(), [](const Ready& a, const Ready& b) { return a.order < b.order; });
+
+    // A behavior may stop another one that is due on the same tick, the generation tells
+    for (const Ready& entry : ready) {
+        if (slots[entry.slot].handle && slots[entry.slot].generation == entry.generation) {
+            Resume(entry.slot);
+        }
+    }
+
+    ready.clear();
+    for (const Poll& poll : polls) {
+        if (poll.ready(poll.awaiter)) {
+            ready.push_back({ slots[poll.slot].order, poll.slot, slots[poll.slot].generation });
+        }
+    }
+    std::sort(ready.begin(), ready.end(), [](const Ready& a, const Ready& b) { return a.order < b.order; });
+
+    for (const Ready& entry : ready) {
+        if (slots[entry.slot].handle && slots[entry.slot].generation == entry.generation) {
+            RemovePoll(slots[entry.slot].handle.promise());
+            Resume(entry.slot);
+        }
+    }
+}
+
+void BehaviorScheduler::Resume(uint32_t slot) {
+    Behavior::Handle handle = slots[slot].handle;
+    handle.resume();
+    if (handle.done()) {
+        Release(slot);
+    }
+}
+
+void BehaviorScheduler::Release(uint32_t slot) {
+    Slot& entry = slots[slot];
+    Behavior::promise_type& promise = entry.handle.promise();
+    if (promise.timer != INVALID_TIMER) {
+        wheel.Cancel(promise.timer);
+    }
+    if (promise.poll >= 0) {
+        RemovePoll(promise);
+    }
+
+    entry.handle.destroy();
+    entry.handle = nullptr;
+    entry.generation++;
+    freeSlots.push_back(slot);
+    running--;
+}
+
+void BehaviorScheduler::Clear() {
+    for (uint32_t slot = 0; slot < slots.size(); slot++) {
+        if (slots[slot].handle) {
+            Release(slot);
+        }
+    }
+}
+
+void BehaviorScheduler::Reserve(size_t behaviors) {
+    slots.reserve(behaviors);
+    freeSlots.reserve(behaviors);
+    polls.reserve(behaviors);
+    ready.reserve(behaviors);
+    wheel.Reserve(behaviors);
+}
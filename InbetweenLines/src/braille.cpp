@@ -0,0 +1,281 @@
+#include "braille.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <emmintrin.h>
+
+using namespace IL;
+
+namespace {
+    constexpr int CELLS_PER_GROUP = 16; // Cells packed per SSE2 iteration, from 32 dots (4 bytes) of each row
+
+    // Braille dot numbering: dots 1-3 and 7 run down the left column, 4-6 and 8 down the right one
+    constexpr uint8_t DOT_BITS[BRAILLE_DOTS_Y][BRAILLE_DOTS_X] = {
+        { 0x01, 0x08 },
+        { 0x02, 0x10 },
+        { 0x04, 0x20 },
+        { 0x40, 0x80 },
+    };
+
+    void Apply(uint64_t& word, uint64_t bits, PixelOp op) {
+        switch (op) {
+        case PixelOp::Set:
+            word |= bits;
+            break;
+        case PixelOp::Clear:
+            word &= ~bits;
+            break;
+        case PixelOp::Invert:
+            word ^= bits;
+            break;
+        }
+    }
+
+    // Bits [start, end) of the word covering dots word * 64 to word * 64 + 63
+    uint64_t RangeMask(int word, int start, int end) {
+        int low = std::max(start - word * 64, 0);
+        int high = std::min(end - word * 64, 64);
+        uint64_t below = high == 64 ? ~uint64_t(0) : (uint64_t(1) << high) - 1;
+        return below & ~((uint64_t(1) << low) - 1);
+    }
+
+    // 64 bits of a bitmap row starting at a possibly negative bit offset, bits outside the row read as zero
+    uint64_t Extract(const uint64_t* row, int words, int offset) {
+        int word = offset >> 6;
+        int shift = offset & 63;
+        uint64_t low = word >= 0 && word < words ? row[word] >> shift : 0;
+        uint64_t high = shift != 0 && word + 1 >= 0 && word + 1 < words ? row[word + 1] << (64 - shift) : 0;
+        return low | high;
+    }
+}
+
+BraillePlane::BraillePlane(int columns, int rows)
+    : columns(columns), rows(rows), width(columns * BRAILLE_DOTS_X), height(rows * BRAILLE_DOTS_Y),
+      stride(((columns + CELLS_PER_GROUP - 1) / CELLS_PER_GROUP * 4 + 7) / 8),
+      words(static_cast<size_t>(stride) * height) {
+}
+
+void BraillePlane::Clear() {
+    std::fill(words.begin(), words.end(), 0);
+}
+
+bool BraillePlane::GetPixel(int x, int y) const {
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+        return false;
+    }
+
+    return (Row(y)[x >> 6] >> (x & 63)) & 1;
+}
+
+void BraillePlane::SetPixel(int x, int y, PixelOp op) {
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+        return;
+    }
+
+    Apply(Row(y)[x >> 6], uint64_t(1) << (x & 63), op);
+}
+
+void BraillePlane::Span(int y, int x0, int x1, PixelOp op) {
+    uint64_t* row = Row(y);
+    int first = x0 >> 6;
+    int last = (x1 - 1) >> 6;
+    for (int word = first; word <= last; word++) {
+        Apply(row[word], RangeMask(word, x0, x1), op);
+    }
+}
+
+void BraillePlane::FillRect(int x, int y, int width, int height, PixelOp op) {
+    int startX = std::max(x, 0);
+    int startY = std::max(y, 0);
+    int endX = std::min(x + width, this->width);
+    int endY = std::min(y + height, this->height);
+    if (startX >= endX) {
+        return;
+    }
+
+    for (int j = startY; j < endY; j++) {
+        Span(j, startX, endX, op);
+    }
+}
+
+void BraillePlane::Line(int x0, int y0, int x1, int y1, PixelOp op) {
+    int dx = std::abs(x1 - x0);
+    int dy = -std::abs(y1 - y0);
+    int stepX = x0 < x1 ? 1 : -1;
+    int stepY = y0 < y1 ? 1 : -1;
+    int error = dx + dy;
+
+    if (dx < -dy) {
+        // Steep, at most one dot per row
+        while (true) {
+            SetPixel(x0, y0, op);
+            if (x0 == x1 && y0 == y1) {
+                return;
+            }
+
+            int doubled = 2 * error;
+            if (doubled >= dy) {
+                error += dy;
+                x0 += stepX;
+            }
+            if (doubled <= dx) {
+                error += dx;
+                y0 += stepY;
+            }
+        }
+    }
+
+    // Shallow, the dots on each row form a run that is drawn as one span. Runs never overlap, so Invert is exact.
+    int runStart = x0;
+    auto flush = [&](int y, int runEnd) {
+        if (y < 0 || y >= height) {
+            return;
+        }
+
+        int start = std::max(std::min(runStart, runEnd), 0);
+        int end = std::min(std::max(runStart, runEnd) + 1, width);
+        if (start < end) {
+            Span(y, start, end, op);
+        }
+    };
+
+    while (x0 != x1 || y0 != y1) {
+        int lastX = x0;
+        int lastY = y0;
+        int doubled = 2 * error;
+        if (doubled >= dy) {
+            error += dy;
+            x0 += stepX;
+        }
+        if (doubled <= dx) {
+            error += dx;
+            y0 += stepY;
+        }
+
+        if (y0 != lastY) {
+            flush(lastY, lastX);
+            runStart = x0;
+        }
+    }
+    flush(y0, x0);
+}
+
+void BraillePlane::FillCircle(int centerX, int centerY, int radius, PixelOp op) {
+    if (radius < 0) {
+        return;
+    }
+
+    // Widest dx with dx^2 + dy^2 <= r^2 + r, the extra r rounds the outline instead of leaving single dot tips
+    int limit = radius * radius + radius;
+    int half = radius;
+    for (int dy = 0; dy <= radius; dy++) {
+        while (half * half + dy * dy > limit) {
+            half--;
+        }
+
+        int start = std::max(centerX - half, 0);
+        int end = std::min(centerX + half + 1, width);
+        if (start >= end) {
+            continue;
+        }
+
+        int below = centerY + dy;
+        int above = centerY - dy;
+        if (below >= 0 && below < height) {
+            Span(below, start, end, op);
+        }
+        if (dy != 0 && above >= 0 && above < height) {
+            Span(above, start, end, op);
+        }
+    }
+}
+
+void BraillePlane::Blit(const BitmapView& bitmap, int x, int y, PixelOp op) {
+    int startX = std::max(x, 0);
+    int startY = std::max(y, 0);
+    int endX = std::min(x + bitmap.width, width);
+    int endY = std::min(y + bitmap.height, height);
+    if (startX >= endX) {
+        return;
+    }
+
+    // Each destination word takes the 64 source bits lined up with it, shifted across at most two source words
+    int first = startX >> 6;
+    int last = (endX - 1) >> 6;
+    for (int j = startY; j < endY; j++) {
+        const uint64_t* source = &bitmap.words[static_cast<size_t>(j - y) * bitmap.stride];
+        uint64_t* row = Row(j);
+        for (int word = first; word <= last; word++) {
+            uint64_t bits = Extract(source, bitmap.stride, word * 64 - x) & RangeMask(word, startX, endX);
+            if (bits != 0) {
+                Apply(row[word], bits, op);
+            }
+        }
+    }
+}
+
+void BraillePlane::Pack(Cell* cells) const {
+    // Every source byte is repeated across four lanes, lane k then tests the two dots of cell k % 4 in that byte
+    const __m128i leftDots = _mm_set1_epi32(0x40100401);
+    const __m128i rightDots = _mm_set1_epi32(static_cast<int>(0x80200802));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i blank = _mm_set1_epi16(static_cast<short>(BRAILLE_BLANK));
+
+    Cell tail[CELLS_PER_GROUP];
+    for (int cy = 0; cy < rows; cy++) {
+        const uint8_t* dotRows[BRAILLE_DOTS_Y];
+        for (int r = 0; r < BRAILLE_DOTS_Y; r++) {
+            dotRows[r] = reinterpret_cast<const uint8_t*>(Row(cy * BRAILLE_DOTS_Y + r));
+        }
+
+        Cell* out = &cells[static_cast<size_t>(cy) * columns];
+        for (int cx = 0; cx < columns; cx += CELLS_PER_GROUP) {
+            __m128i pattern = zero;
+            for (int r = 0; r < BRAILLE_DOTS_Y; r++) {
+                uint32_t bytes;
+                memcpy(&bytes, dotRows[r] + cx / 4, sizeof(bytes));
+                __m128i spread = _mm_cvtsi32_si128(static_cast<int>(bytes));
+                spread = _mm_unpacklo_epi8(spread, spread);
+                spread = _mm_unpacklo_epi16(spread, spread);
+
+                __m128i left = _mm_cmpeq_epi8(_mm_and_si128(spread, leftDots), leftDots);
+                __m128i right = _mm_cmpeq_epi8(_mm_and_si128(spread, rightDots), rightDots);
+                pattern = _mm_or_si128(pattern, _mm_and_si128(left, _mm_set1_epi8(static_cast<char>(DOT_BITS[r][0]))));
+                pattern = _mm_or_si128(pattern, _mm_and_si128(right, _mm_set1_epi8(static_cast<char>(DOT_BITS[r][1]))));
+            }
+
+            // Widen to glyphs, cells without a dot stay zero
+            __m128i halves[2] = { _mm_unpacklo_epi8(pattern, zero), _mm_unpackhi_epi8(pattern, zero) };
+            for (__m128i& half : halves) {
+                __m128i empty = _mm_cmpeq_epi16(half, zero);
+                half = _mm_andnot_si128(empty, _mm_add_epi16(half, blank));
+            }
+
+            if (cx + CELLS_PER_GROUP <= columns) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(&out[cx]), halves[0]);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(&out[cx + 8]), halves[1]);
+            } else {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(&tail[0]), halves[0]);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(&tail[8]), halves[1]);
+                memcpy(&out[cx], tail, (columns - cx) * sizeof(Cell));
+            }
+        }
+    }
+}
+
+void BraillePlane::PackScalar(Cell* cells) const {
+    for (int cy = 0; cy < rows; cy++) {
+        for (int cx = 0; cx < columns; cx++) {
+            uint8_t pattern = 0;
+            for (int r = 0; r < BRAILLE_DOTS_Y; r++) {
+                for (int c = 0; c < BRAILLE_DOTS_X; c++) {
+                    if (GetPixel(cx * BRAILLE_DOTS_X + c, cy * BRAILLE_DOTS_Y + r)) {
+                        pattern |= DOT_BITS[r][c];
+                    }
+                }
+            }
+            cells[static_cast<size_t>(cy) * columns + cx] = pattern != 0 ? static_cast<Cell>(BRAILLE_BLANK + pattern) : 0;
+        }
+    }
+}
@@ -0,0 +1,387 @@
+#include "canvas.h"
+#include "log.h"
+
+#include <algorithm>
+#include <emmintrin.h>
+
+using namespace IL;
+
+Canvas::Canvas() {
+    layers[static_cast<int>(Layer::Background)].retained = true;
+}
+
+// Copies every non-zero cell of src and its attributes over dst, zero cells are transparent
+static void BlendLayer(Cell* dst, CellAttr* dstAttrs, const Cell* src, const CellAttr* srcAttrs, size_t count) {
+    size_t i = 0;
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&dst[i]));
+        __m128i transparent = _mm_cmpeq_epi16(s, zero);
+        __m128i blended = _mm_or_si128(_mm_and_si128(transparent, d), _mm_andnot_si128(transparent, s));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&dst[i]), blended);
+
+        // Widen the 16-bit mask to the 32-bit attribute lanes
+        __m128i masks[2] = { _mm_unpacklo_epi16(transparent, transparent), _mm_unpackhi_epi16(transparent, transparent) };
+        for (int half = 0; half < 2; half++) {
+            __m128i* dstLane = reinterpret_cast<__m128i*>(&dstAttrs[i + half * 4]);
+            __m128i sa = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&srcAttrs[i + half * 4]));
+            __m128i da = _mm_loadu_si128(dstLane);
+            _mm_storeu_si128(dstLane, _mm_or_si128(_mm_and_si128(masks[half], da), _mm_andnot_si128(masks[half], sa)));
+        }
+    }
+
+    for (; i < count; i++) {
+        if (src[i] != 0) {
+            dst[i] = src[i];
+            dstAttrs[i] = srcAttrs[i];
+        }
+    }
+}
+
+// Copies every non-zero cell of src over dst and gives it attr
+static void BlendGlyphs(Cell* dst, CellAttr* dstAttrs, const Cell* src, CellAttr attr, size_t count) {
+    uint32_t attrBits;
+    memcpy(&attrBits, &attr, sizeof(attrBits));
+    const __m128i attrs = _mm_set1_epi32(static_cast<int>(attrBits));
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&dst[i]));
+        __m128i transparent = _mm_cmpeq_epi16(s, zero);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&dst[i]), _mm_or_si128(_mm_and_si128(transparent, d), _mm_andnot_si128(transparent, s)));
+
+        __m128i masks[2] = { _mm_unpacklo_epi16(transparent, transparent), _mm_unpackhi_epi16(transparent, transparent) };
+        for (int half = 0; half < 2; half++) {
+            __m128i* dstLane = reinterpret_cast<__m128i*>(&dstAttrs[i + half * 4]);
+            __m128i da = _mm_loadu_si128(dstLane);
+            _mm_storeu_si128(dstLane, _mm_or_si128(_mm_and_si128(masks[half], da), _mm_andnot_si128(masks[half], attrs)));
+        }
+    }
+
+    for (; i < count; i++) {
+        if (src[i] != 0) {
+            dst[i] = src[i];
+            dstAttrs[i] = attr;
+        }
+    }
+}
+
+Canvas::LayerState& Canvas::Target() {
+    LayerState& layer = layers[static_cast<int>(currentLayer)];
+    layer.hasContent = true;
+    return layer;
+}
+
+void Canvas::ClearLayer(LayerState& layer) {
+    memset(layer.cells.get(), 0, CANVAS_CELLS * sizeof(Cell));
+    std::fill_n(layer.attrs.get(), CANVAS_CELLS, DEFAULT_ATTR);
+    layer.hasContent = false;
+}
+
+void Canvas::Text(const std::string_view& text, int x, int y, bool widthEqualsHeight, CellAttr attr) {
+    Cell units[CANVAS_CELLS];
+    size_t count = Utf8ToUtf16(text, units, CANVAS_CELLS);
+
+    // Lay the glyphs out so wide characters take two cells
+    Cell cells[CANVAS_CELLS];
+    size_t length = LayoutCells(units, count, cells, CANVAS_CELLS);
+
+    WriteCells(cells, length, x, y, widthEqualsHeight, attr);
+}
+
+// A cell that cannot be shown on its own once clipping cuts a glyph in half
+static bool IsLeadingHalf(const Cell* cells, size_t i, size_t count) {
+    return i + 1 < count && (cells[i + 1] == CELL_CONTINUATION || (cells[i] >= 0xD800 && cells[i] <= 0xDBFF));
+}
+
+static bool IsTrailingHalf(Cell cell) {
+    return cell == CELL_CONTINUATION || (cell >= 0xDC00 && cell <= 0xDFFF);
+}
+
+void Canvas::WriteCells(const Cell* cells, size_t count, int x, int y, bool widthEqualsHeight, CellAttr attr) {
+    if (widthEqualsHeight) {
+        x *= 2;
+    }
+
+    LayerState& layer = Target();
+    const ClipRect& clip = Clip();
+
+    // Fast path, the whole run is visible
+    if (clip.Contains(x, y, static_cast<int>(count), 1)) {
+        size_t index = y * CANVAS_WIDTH + x;
+        memcpy(&layer.cells[index], cells, count * sizeof(Cell));
+        std::fill_n(&layer.attrs[index], count, attr);
+        return;
+    }
+
+    if (y < clip.top || y >= clip.bottom) {
+        return;
+    }
+
+    int start = std::max(x, clip.left);
+    int end = std::min(x + static_cast<int>(count), clip.right);
+    if (start >= end) {
+        return;
+    }
+
+    size_t index = y * CANVAS_WIDTH + start;
+    size_t first = start - x;
+    size_t length = end - start;
+    memcpy(&layer.cells[index], &cells[first], length * sizeof(Cell));
+    std::fill_n(&layer.attrs[index], length, attr);
+
+    // Halves of wide glyphs and surrogate pairs cut by the clip edges are blanked rather than shown broken
+    if (first > 0 && IsTrailingHalf(cells[first])) {
+        layer.cells[index] = u' ';
+    }
+    if (IsLeadingHalf(cells, first + length - 1, count)) {
+        layer.cells[index + length - 1] = u' ';
+    }
+}
+
+void Canvas::Rectangle(int x, int y, int width, int height, bool fill, bool widthEqualsHeight, Cell fillChar, CellAttr attr) {
+    if (widthEqualsHeight) {
+        x *= 2;
+        width *= 2;
+    }
+
+    // Clip once, the border stays on the rectangle's own edges so clipped sides are left open
+    const ClipRect& clip = Clip();
+    int startX = std::max(x, clip.left);
+    int startY = std::max(y, clip.top);
+    int endX = std::min(x + width, clip.right);
+    int endY = std::min(y + height, clip.bottom);
+    if (startX >= endX || startY >= endY) {
+        return;
+    }
+
+    LayerState& layer = Target();
+    int span = endX - startX;
+    for (int j = startY; j < endY; j++) {
+        int index = j * CANVAS_WIDTH + startX;
+        if (fill || j == y || j == y + height - 1) {
+            std::fill_n(&layer.cells[index], span, fillChar);
+            std::fill_n(&layer.attrs[index], span, attr);
+            continue;
+        }
+
+        if (startX == x) {
+            layer.cells[index] = fillChar;
+            layer.attrs[index] = attr;
+        }
+        if (endX == x + width) {
+            layer.cells[index + span - 1] = fillChar;
+            layer.attrs[index + span - 1] = attr;
+        }
+    }
+}
+
+void Canvas::Blit(const SpriteView& sprite, int x, int y, bool widthEqualsHeight, CellAttr attr) {
+    if (widthEqualsHeight) {
+        x *= 2;
+    }
+
+    // Clip the sprite against the clip rectangle once, then blend whole rows
+    const ClipRect& clip = Clip();
+    int startX = std::max(x, clip.left);
+    int startY = std::max(y, clip.top);
+    int endX = std::min(x + sprite.width, clip.right);
+    int endY = std::min(y + sprite.height, clip.bottom);
+    if (startX >= endX || startY >= endY) {
+        return;
+    }
+
+    LayerState& layer = Target();
+    for (int j = startY; j < endY; j++) {
+        int offset = (j - y) * sprite.stride + (startX - x);
+        int index = j * CANVAS_WIDTH + startX;
+        BlendMasked(&layer.cells[index], &sprite.cells[offset], &sprite.mask[offset], endX - startX);
+        for (int i = 0; i < endX - startX; i++) {
+            if (sprite.mask[offset + i] != 0) {
+                layer.attrs[index + i] = attr;
+            }
+        }
+    }
+}
+
+void Canvas::TextBox(std::string_view text, int x, int y, int width, int height, TextAlign align, bool widthEqualsHeight, CellAttr attr) {
+    if (widthEqualsHeight) {
+        width *= 2;
+    }
+
+    Blit(textLayouts.Get(text, width, height, align).View(), x, y, widthEqualsHeight, attr);
+}
+
+void Canvas::Splat(const int32_t* indices, const Cell* cells, const CellAttr* attrs, size_t count) {
+    LayerState& layer = Target();
+    const ClipRect& clip = Clip();
+    bool clipped = clipDepth > 0;
+
+    for (size_t i = 0; i < count; i++) {
+        int32_t index = indices[i];
+        if (index < 0 || index >= CANVAS_CELLS) {
+            continue;
+        }
+        if (clipped && !clip.Contains(index % CANVAS_WIDTH, index / CANVAS_WIDTH, 1, 1)) {
+            continue;
+        }
+
+        layer.cells[index] = cells[i];
+        layer.attrs[index] = attrs[i];
+    }
+}
+
+BraillePlane& Canvas::BeginPixels(Layer layer, CellAttr attr) {
+    pixelLayer = layer;
+    pixelAttr = attr;
+    pixelsUsed = true;
+    return pixels;
+}
+
+void Canvas::PackPixels() {
+    pixels.Pack(pixelCells.get());
+
+    LayerState& layer = layers[static_cast<int>(pixelLayer)];
+    layer.hasContent = true;
+    BlendGlyphs(layer.cells.get(), layer.attrs.get(), pixelCells.get(), pixelAttr, CANVAS_CELLS);
+}
+
+void Canvas::PushClip(int x, int y, int width, int height, bool widthEqualsHeight) {
+    if (clipDepth == MAX_CLIP_DEPTH) {
+        IL_ERROR("Clip stack overflow, ignoring clip rectangle");
+        clipOverflow++;
+        return;
+    }
+
+    if (widthEqualsHeight) {
+        x *= 2;
+        width *= 2;
+    }
+
+    // Intersect with the current rectangle so nested clips can only shrink
+    const ClipRect& parent = Clip();
+    ClipRect& clip = clipStack[++clipDepth];
+    clip.left = std::max(x, parent.left);
+    clip.top = std::max(y, parent.top);
+    clip.right = std::max(clip.left, std::min(x + width, parent.right));
+    clip.bottom = std::max(clip.top, std::min(y + height, parent.bottom));
+}
+
+void Canvas::PopClip() {
+    if (clipOverflow > 0) {
+        clipOverflow--;
+        return;
+    }
+
+    if (clipDepth == 0) {
+        IL_ERROR("PopClip without a matching PushClip");
+        return;
+    }
+
+    clipDepth--;
+}
+
+void Canvas::Begin() {
+    // Only immediate layers that were drawn to last frame need clearing, retained layers keep their cache
+    for (LayerState& layer : layers) {
+        if (!layer.retained && layer.hasContent) {
+            ClearLayer(layer);
+        }
+    }
+
+    if (pixelsUsed) {
+        pixels.Clear();
+        pixelsUsed = false;
+    }
+
+    currentLayer = Layer::World;
+    clipDepth = 0;
+    clipOverflow = 0;
+    arena.Reset();
+}
+
+bool Canvas::BeginLayer(Layer layer) {
+    currentLayer = layer;
+
+    LayerState& state = layers[static_cast<int>(layer)];
+    if (!state.retained) {
+        return true;
+    }
+
+    if (!state.invalid) {
+        return false;
+    }
+
+    ClearLayer(state);
+    state.invalid = false;
+    return true;
+}
+
+void Canvas::Invalidate(Layer layer) {
+    layers[static_cast<int>(layer)].invalid = true;
+}
+
+void Canvas::SetRetained(Layer layer, bool retained) {
+    LayerState& state = layers[static_cast<int>(layer)];
+    if (state.retained != retained) {
+        state.retained = retained;
+        state.invalid = true;
+    }
+}
+
+void Canvas::TakeLayer(Layer layer, Canvas& from) {
+    LayerState& target = layers[static_cast<int>(layer)];
+    if (target.retained) {
+        IL_ERROR("Cannot take retained layer {} from another canvas", static_cast<int>(layer));
+        return;
+    }
+
+    if (from.pixelsUsed && from.pixelLayer == layer) {
+        from.PackPixels();
+        from.pixels.Clear();
+        from.pixelsUsed = false;
+    }
+
+    LayerState& source = from.layers[static_cast<int>(layer)];
+    std::swap(target.cells, source.cells);
+    std::swap(target.attrs, source.attrs);
+    std::swap(target.hasContent, source.hasContent);
+}
+
+void Canvas::Composite() {
+    Cell* dst = backCells.get();
+    CellAttr* dstAttrs = backAttrs.get();
+    size_t bufferSize = CANVAS_CELLS * sizeof(Cell);
+
+    // The bottom-most layer with content is copied as is, the rest are blended over it
+    int base = 0;
+    while (base < LAYER_COUNT && !layers[base].hasContent) {
+        base++;
+    }
+
+    if (base == LAYER_COUNT) {
+        memset(dst, 0, bufferSize);
+        std::fill_n(dstAttrs, CANVAS_CELLS, DEFAULT_ATTR);
+        return;
+    }
+
+    memcpy(dst, layers[base].cells.get(), bufferSize);
+    memcpy(dstAttrs, layers[base].attrs.get(), CANVAS_CELLS * sizeof(CellAttr));
+    for (int i = base + 1; i < LAYER_COUNT; i++) {
+        if (layers[i].hasContent) {
+            BlendLayer(dst, dstAttrs, layers[i].cells.get(), layers[i].attrs.get(), CANVAS_CELLS);
+        }
+    }
+}
+
+void Canvas::End() {
+    if (pixelsUsed) {
+        PackPixels();
+    }
+
+    Composite();
+    Present();
+}
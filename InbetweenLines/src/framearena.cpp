@@ -0,0 +1,66 @@
+#include "framearena.h"
+
+#include <cstdint>
+#include <new>
+
+using namespace IL;
+
+FrameArena::FrameArena(size_t capacity) : buffer(std::make_unique<std::byte[]>(capacity)), capacity(capacity) {
+}
+
+FrameArena::~FrameArena() {
+    FreeSpills();
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+    // Align the address rather than the offset, the buffer itself is only aligned for new
+    uintptr_t base = reinterpret_cast<uintptr_t>(buffer.get());
+    uintptr_t start = (base + used + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+    size_t end = static_cast<size_t>(start - base) + bytes;
+    if (end <= capacity) {
+        used = end;
+        return reinterpret_cast<void*>(start);
+    }
+
+    // The header is padded to the alignment so the allocation after it stays aligned
+    size_t header = (sizeof(Spill) + alignment - 1) & ~(alignment - 1);
+    size_t blockAlignment = alignment > alignof(Spill) ? alignment : alignof(Spill);
+    void* block = ::operator new(header + bytes, std::align_val_t(blockAlignment));
+    Spill* spill = static_cast<Spill*>(block);
+    spill->next = spillList;
+    spill->alignment = blockAlignment;
+    spillList = spill;
+
+    spilled += header + bytes + alignment;
+    spills++;
+    return static_cast<std::byte*>(block) + header;
+}
+
+void FrameArena::FreeSpills() {
+    while (spillList != nullptr) {
+        Spill* next = spillList->next;
+        ::operator delete(spillList, std::align_val_t(spillList->alignment));
+        spillList = next;
+    }
+}
+
+void FrameArena::Reset() {
+    size_t frame = used + spilled;
+    if (frame > highWater) {
+        highWater = frame;
+    }
+
+    if (spills > 0) {
+        FreeSpills();
+
+        // Grow once to fit the busiest frame so far, from then on those frames stay in the buffer
+        if (highWater > capacity) {
+            capacity = highWater;
+            buffer = std::make_unique<std::byte[]>(capacity);
+        }
+    }
+
+    used = 0;
+    spilled = 0;
+    spills = 0;
+}
@@ -0,0 +1,305 @@
+#include "framering.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace IL;
+
+namespace {
+    constexpr uint32_t RING_MAGIC = 0x52464C49; // "ILFR"
+    constexpr uint32_t RING_VERSION = 1;
+    constexpr size_t LINE = 64; // Slots start on their own cache line so the writer and readers of neighbours do not share one
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Ring sequence numbers are shared between processes");
+
+    struct alignas(LINE) RingHeader {
+        std::atomic<uint32_t> magic; // Set last, once the rest describes the ring
+        uint32_t version;
+        uint32_t width, height;
+        uint32_t slots;
+        uint32_t slotBytes;
+        uint32_t cellsOffset, attrsOffset; // Into a slot
+        alignas(LINE) std::atomic<uint64_t> latest;
+        std::atomic<uint32_t> closed;
+    };
+
+    struct alignas(LINE) SlotHeader {
+        std::atomic<uint64_t> sequence; // The frame the slot holds, 0 while it is written
+        int64_t publishedNs;
+    };
+
+    size_t AlignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    RingHeader* HeaderOf(const SharedMemory& memory) {
+        return reinterpret_cast<RingHeader*>(memory.GetData());
+    }
+
+    SlotHeader* SlotOf(const SharedMemory& memory, uint64_t sequence) {
+        const RingHeader* header = HeaderOf(memory);
+        size_t slot = static_cast<size_t>(sequence % header->slots);
+        return reinterpret_cast<SlotHeader*>(memory.GetData() + sizeof(RingHeader) + slot * header->slotBytes);
+    }
+
+    int64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+#ifdef _WIN32
+    // Local\ keeps the name to the session, readers run next to the game
+    std::wstring MappingName(std::string_view name) {
+        std::wstring wide = L"Local\\";
+        for (char c : name) {
+            wide += static_cast<wchar_t>(static_cast<unsigned char>(c));
+        }
+        return wide;
+    }
+#endif
+}
+
+SharedMemory::~SharedMemory() {
+    Close();
+}
+
+bool SharedMemory::Create(std::string_view name, size_t size) {
+    Close();
+
+#ifdef _WIN32
+    uint64_t size64 = size;
+    HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32),
+        static_cast<DWORD>(size64), MappingName(name).c_str());
+    if (mapping == nullptr) {
+        return false;
+    }
+
+    // A reader still holding an old ring keeps the mapping alive, it is reused and cleared
+    bool existed = GetLastError() == ERROR_ALREADY_EXISTS;
+    void* mapped = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (mapped == nullptr) {
+        CloseHandle(mapping);
+        return false;
+    }
+    if (existed) {
+        memset(mapped, 0, size);
+    }
+    mappingHandle = mapping;
+#else
+    if (name.size() + 2 > sizeof(path)) {
+        return false;
+    }
+    path[0] = '/';
+    memcpy(path + 1, name.data(), name.size());
+    path[name.size() + 1] = '\0';
+
+    // Whatever a crashed writer left behind goes, readers still mapping it keep their copy
+    shm_unlink(path);
+    int descriptor = shm_open(path, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (descriptor < 0) {
+        return false;
+    }
+
+    void* mapped = MAP_FAILED;
+    if (ftruncate(descriptor, static_cast<off_t>(size)) == 0) {
+        mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    }
+    ::close(descriptor);
+    if (mapped == MAP_FAILED) {
+        shm_unlink(path);
+        return false;
+    }
+#endif
+
+    data = static_cast<uint8_t*>(mapped);
+    this->size = size;
+    owner = true;
+    return true;
+}
+
+bool SharedMemory::Open(std::string_view name) {
+    Close();
+
+#ifdef _WIN32
+    HANDLE mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, MappingName(name).c_str());
+    if (mapping == nullptr) {
+        return false;
+    }
+
+    void* mapped = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info = {};
+    if (mapped == nullptr || VirtualQuery(mapped, &info, sizeof(info)) == 0) {
+        if (mapped != nullptr) {
+            UnmapViewOfFile(mapped);
+        }
+        CloseHandle(mapping);
+        return false;
+    }
+    mappingHandle = mapping;
+    size = info.RegionSize;
+#else
+    std::string shmName = "/" + std::string(name);
+    int descriptor = shm_open(shmName.c_str(), O_RDONLY, 0);
+    if (descriptor < 0) {
+        return false;
+    }
+
+    struct stat info = {};
+    void* mapped = MAP_FAILED;
+    if (fstat(descriptor, &info) == 0 && info.st_size > 0) {
+        mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, descriptor, 0);
+    }
+    ::close(descriptor);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    size = static_cast<size_t>(info.st_size);
+#endif
+
+    data = static_cast<uint8_t*>(mapped);
+    owner = false;
+    return true;
+}
+
+void SharedMemory::Close() {
+    if (data == nullptr) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(mappingHandle);
+    mappingHandle = nullptr;
+#else
+    munmap(data, size);
+    if (owner) {
+        shm_unlink(path);
+    }
+#endif
+    data = nullptr;
+    size = 0;
+    owner = false;
+}
+
+bool FrameRingWriter::Create(std::string_view name, int width, int height, int slots) {
+    Close();
+    if (width <= 0 || height <= 0 || slots < 2) {
+        return false;
+    }
+
+    size_t cells = static_cast<size_t>(width) * height;
+    size_t cellsOffset = sizeof(SlotHeader);
+    size_t attrsOffset = AlignUp(cellsOffset + cells * sizeof(Cell), alignof(CellAttr));
+    size_t slotBytes = AlignUp(attrsOffset + cells * sizeof(CellAttr), LINE);
+    if (!memory.Create(name, sizeof(RingHeader) + slots * slotBytes)) {
+        return false;
+    }
+
+    RingHeader* header = HeaderOf(memory);
+    header->version = RING_VERSION;
+    header->width = static_cast<uint32_t>(width);
+    header->height = static_cast<uint32_t>(height);
+    header->slots = static_cast<uint32_t>(slots);
+    header->slotBytes = static_cast<uint32_t>(slotBytes);
+    header->cellsOffset = static_cast<uint32_t>(cellsOffset);
+    header->attrsOffset = static_cast<uint32_t>(attrsOffset);
+    header->magic.store(RING_MAGIC, std::memory_order_release);
+    published = 0;
+    return true;
+}
+
+void FrameRingWriter::Publish(const Cell* cells, const CellAttr* attrs) {
+    if (!IsOpen()) {
+        return;
+    }
+
+    RingHeader* header = HeaderOf(memory);
+    uint64_t sequence = ++published;
+    SlotHeader* slot = SlotOf(memory, sequence);
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(slot);
+    size_t count = static_cast<size_t>(header->width) * header->height;
+
+    // Readers that see the cleared sequence, or a different one once done, drop what they read
+    slot->sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(bytes + header->cellsOffset, cells, count * sizeof(Cell));
+    memcpy(bytes + header->attrsOffset, attrs, count * sizeof(CellAttr));
+    slot->publishedNs = NowNs();
+    slot->sequence.store(sequence, std::memory_order_release);
+    header->latest.store(sequence, std::memory_order_release);
+}
+
+void FrameRingWriter::Close() {
+    if (IsOpen()) {
+        HeaderOf(memory)->closed.store(1, std::memory_order_release);
+        memory.Close();
+    }
+}
+
+bool FrameRingReader::Open(std::string_view name) {
+    if (!memory.Open(name)) {
+        return false;
+    }
+
+    const RingHeader* header = HeaderOf(memory);
+    bool valid = memory.GetSize() >= sizeof(RingHeader) && header->magic.load(std::memory_order_acquire) == RING_MAGIC &&
+        header->version == RING_VERSION && header->slots >= 2 &&
+        memory.GetSize() >= sizeof(RingHeader) + static_cast<size_t>(header->slots) * header->slotBytes;
+    if (!valid) {
+        memory.Close();
+    }
+    return valid;
+}
+
+int FrameRingReader::GetWidth() const {
+    return static_cast<int>(HeaderOf(memory)->width);
+}
+
+int FrameRingReader::GetHeight() const {
+    return static_cast<int>(HeaderOf(memory)->height);
+}
+
+int FrameRingReader::GetSlots() const {
+    return static_cast<int>(HeaderOf(memory)->slots);
+}
+
+uint64_t FrameRingReader::GetLatest() const {
+    return HeaderOf(memory)->latest.load(std::memory_order_acquire);
+}
+
+bool FrameRingReader::IsClosed() const {
+    return HeaderOf(memory)->closed.load(std::memory_order_acquire) != 0;
+}
+
+bool FrameRingReader::Acquire(uint64_t sequence, SharedFrame& frame) const {
+    const RingHeader* header = HeaderOf(memory);
+    const SlotHeader* slot = SlotOf(memory, sequence);
+    if (sequence == 0 || slot->sequence.load(std::memory_order_acquire) != sequence) {
+        return false;
+    }
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(slot);
+    frame.sequence = sequence;
+    frame.publishedNs = slot->publishedNs;
+    frame.cells = reinterpret_cast<const Cell*>(bytes + header->cellsOffset);
+    frame.attrs = reinterpret_cast<const CellAttr*>(bytes + header->attrsOffset);
+    return true;
+}
+
+bool FrameRingReader::Validate(const SharedFrame& frame) const {
+    // Orders the reads of the frame before the second look at its sequence
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return SlotOf(memory, frame.sequence)->sequence.load(std::memory_order_relaxed) == frame.sequence;
+}
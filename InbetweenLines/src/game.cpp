@@ -0,0 +1,716 @@
+#include "game.h"
+#include "levelgen.h"
+
+#include <algorithm> // For std::remove_if
+#include <string_view>
+
+using namespace IL::literals;
+
+void SpawnCoin(State_t& state, uint64_t firstTick);
+
+// What a timer is for, packed into its payload above the coin id or player index it belongs to
+enum TimerKind : uint32_t {
+    TIMER_SPAWN = 0,   // Coin spawn check
+    TIMER_COIN_EXPIRY, // A coin's lifetime ran out
+    TIMER_MOVE_END,    // A player stopped moving
+};
+
+constexpr uint64_t TimerPayload(TimerKind kind, uint32_t target) {
+    return (static_cast<uint64_t>(kind) << 32) | target;
+}
+
+constexpr TimerKind TimerKindOf(uint64_t payload) {
+    return static_cast<TimerKind>(payload >> 32);
+}
+
+constexpr uint32_t TimerTarget(uint64_t payload) {
+    return static_cast<uint32_t>(payload);
+}
+
+constexpr int MOVE_TICKS = 10;       // Ticks a player counts as moving after the last step
+constexpr int BLINK_INTERVAL = 120;  // Ticks between blink checks, ~2 seconds
+constexpr int BLINK_TICKS = 11;      // Ticks a blink lasts
+
+
+// Player body poses, picked from movement each frame
+enum PlayerPose {
+    POSE_IDLE = 0,
+    POSE_SQUASH,    // Moving horizontally on the ground
+    POSE_JUMP,      // Stretched upward while rising
+    POSE_FALL,      // Stretched further while falling fast
+    POSE_COUNT
+};
+
+// Body dimensions and offsets of a pose, in player units
+struct PlayerShape {
+    int width, height;
+    int xOffset, yOffset;
+    int eyeSpacing;     // Spacing between the eyes
+};
+
+// Computes a pose's shape from how much it squashes or stretches the default body
+constexpr PlayerShape MakePlayerShape(int widthModifier, int heightModifier, int eyeSpacing) {
+    PlayerShape shape = {};
+    shape.width = PLAYER_WIDTH - widthModifier;
+    shape.height = PLAYER_HEIGHT - heightModifier;
+    shape.eyeSpacing = eyeSpacing;
+
+    // Center the character horizontally
+    shape.xOffset = (PLAYER_WIDTH - shape.width) / 2;
+
+    if (heightModifier > 0) {
+        // For squash: maintain bottom position
+        shape.yOffset = heightModifier;
+    } else if (heightModifier < 0) {
+        // For stretch: center the stretch effect
+        shape.yOffset = (PLAYER_HEIGHT - shape.height) / 2;
+    }
+
+    return shape;
+}
+
+constexpr PlayerShape PLAYER_SHAPES[POSE_COUNT] = {
+    MakePlayerShape(0, 0, 3),   // Idle
+    MakePlayerShape(-1, 1, 4),  // Squash: wider, shorter and eyes further apart
+    MakePlayerShape(1, -1, 2),  // Jump: narrower, taller and eyes closer together
+    MakePlayerShape(1, -2, 2),  // Fall: even taller
+};
+
+// Different character shape and colour for each player
+struct PlayerLook {
+    IL::Cell border;
+    IL::Cell eye;
+    IL::Cell mouth;
+    IL::CellAttr attr;
+};
+
+constexpr PlayerLook PLAYER_LOOKS[2] = {
+    { u'#', u'O', u'~', { IL::Color::Blue, IL::Color::Default, IL::STYLE_BOLD } },  // Left player
+    { u'@', u'X', u'-', { IL::Color::Red, IL::Color::Default, IL::STYLE_BOLD } },   // Right player
+};
+
+constexpr IL::CellAttr COIN_ATTR = { IL::Color::DarkYellow, IL::Color::Default, IL::STYLE_BOLD };
+
+// Sprites are twice as wide in cells as the body is in player units
+using PlayerSprite = IL::Sprite<(PLAYER_WIDTH + 1) * 2, PLAYER_HEIGHT + 2>;
+
+// Bakes the body outline, eyes and mouth exactly as the rectangle and text calls used to draw them
+constexpr PlayerSprite BakePlayerSprite(const PlayerLook& look, const PlayerShape& shape, bool blinking) {
+    PlayerSprite sprite(shape.width * 2, shape.height);
+
+    for (int y = 0; y < sprite.height; y++) {
+        for (int x = 0; x < sprite.width; x++) {
+            if (x == 0 || x == sprite.width - 1 || y == 0 || y == sprite.height - 1) {
+                sprite.Set(x, y, look.border);
+            }
+        }
+    }
+
+    // Eyes: " O  O", starting one player unit in
+    IL::Cell eye = blinking ? u'-' : look.eye;
+    for (int x = 2; x <= 2 + shape.eyeSpacing; x++) {
+        sprite.Set(x, 1, u' ');
+    }
+    sprite.Set(3, 1, eye);
+    sprite.Set(2 + shape.eyeSpacing, 1, eye);
+
+    // Mouth: " ~  ~", two rows from the bottom
+    int mouthY = shape.height - 2;
+    for (int x = 2; x <= shape.width; x++) {
+        sprite.Set(x, mouthY, u' ');
+    }
+    sprite.Set(3, mouthY, look.mouth);
+    sprite.Set(shape.width, mouthY, look.mouth);
+
+    return sprite;
+}
+
+// Every player look in every pose, with eyes open and closed
+struct PlayerAtlas {
+    PlayerSprite sprites[2][POSE_COUNT][2];
+};
+
+consteval PlayerAtlas BakePlayerAtlas() {
+    PlayerAtlas atlas = {};
+    for (int look = 0; look < 2; look++) {
+        for (int pose = 0; pose < POSE_COUNT; pose++) {
+            atlas.sprites[look][pose][0] = BakePlayerSprite(PLAYER_LOOKS[look], PLAYER_SHAPES[pose], false);
+            atlas.sprites[look][pose][1] = BakePlayerSprite(PLAYER_LOOKS[look], PLAYER_SHAPES[pose], true);
+        }
+    }
+    return atlas;
+}
+
+static constexpr PlayerAtlas PLAYER_ATLAS = BakePlayerAtlas();
+
+// Picks the squash/stretch pose from the player's movement
+PlayerPose GetPlayerPose(const Player& player) {
+    // Stretch when jumping or falling fast
+    if (!player.physics.isOnGround) {
+        if (player.physics.velocityY < 0) {
+            return POSE_JUMP;
+        } else if (player.physics.velocityY > IL::CellsToFixed(2)) {
+            return POSE_FALL;
+        }
+    }
+
+    // Squash when moving horizontally
+    return player.isMovingHorizontal ? POSE_SQUASH : POSE_IDLE;
+}
+
+// Picks the pose, its dimensions are used for collisions on the next tick
+void UpdatePlayerAnimation(Player& player) {
+    PlayerPose pose = GetPlayerPose(player);
+    const PlayerShape& shape = PLAYER_SHAPES[pose];
+    
+    // Store current dimensions and offsets for collision detection
+    player.currentWidth = shape.width;
+    player.currentHeight = shape.height;
+    player.xOffset = shape.xOffset;
+    player.yOffset = shape.yOffset;
+}
+
+// Randomly blinks, checked every ~2 seconds from ~2 seconds in
+IL::Behavior Blink(IL::BehaviorScheduler&, State_t& state, int playerIndex) {
+    Player& player = state.players[playerIndex];
+    uint32_t untilCheck = BLINK_INTERVAL;
+    for (;;) {
+        co_await IL::Frames(untilCheck);
+
+        // 70% chance to blink, the next check counts from this one
+        untilCheck = BLINK_INTERVAL;
+        if (state.random.Next() % 100 < 70) {
+            player.isBlinking = true;
+            co_await IL::Frames(BLINK_TICKS);
+            player.isBlinking = false;
+            untilCheck -= BLINK_TICKS;
+        }
+    }
+}
+
+// Counts the player as moving for the next MOVE_TICKS ticks
+void RestartMoveTimer(State_t& state, int playerIndex) {
+    // Players step nearly every tick, so the timer is left alone and re-armed for the rest when it fires early
+    Player& player = state.players[playerIndex];
+    player.movingUntil = state.timers.Now() + MOVE_TICKS;
+    if (!state.timers.IsPending(player.moveTimer)) {
+        player.moveTimer = state.timers.Schedule(MOVE_TICKS, TimerPayload(TIMER_MOVE_END, playerIndex));
+    }
+}
+
+// Stops counting the player as moving, unless they stepped again since the timer was set
+void EndMove(State_t& state, int playerIndex) {
+    Player& player = state.players[playerIndex];
+    uint64_t now = state.timers.Now();
+    if (player.movingUntil > now) {
+        player.moveTimer = state.timers.Schedule(player.movingUntil - now, TimerPayload(TIMER_MOVE_END, playerIndex));
+    } else {
+        player.isMovingHorizontal = false;
+    }
+}
+
+// Function to render a player with blinking eyes
+void RenderPlayer(IL::Canvas& canvas, const Player& player, int playerIndex) {
+    PlayerPose pose = GetPlayerPose(player);
+    const PlayerShape& shape = PLAYER_SHAPES[pose];
+    const PlayerSprite& sprite = PLAYER_ATLAS.sprites[playerIndex][pose][player.isBlinking ? 1 : 0];
+    canvas.Blit(sprite.View(), player.position.x + shape.xOffset, player.position.y + shape.yOffset, true, PLAYER_LOOKS[playerIndex].attr);
+}
+
+// Function to render platforms
+void RenderPlatforms(IL::Canvas& canvas, const std::vector<Platform>& platforms) {
+    for (const auto& platform : platforms) {
+        // draw with block character
+        canvas.Rectangle(platform.x, platform.y, platform.width, platform.height, true);
+    }
+}
+
+// Function to render coins with degradation based on lifetime
+void RenderCoins(IL::Canvas& canvas, const std::vector<Coin>& coins, uint64_t now, const int maxLifetime) {
+    for (const auto& coin : coins) {
+        if (coin.active) {
+            // Calculate the degradation stage based on lifetime
+            int64_t lifetime = static_cast<int64_t>(now) - static_cast<int64_t>(coin.firstTick) + 1;
+            float lifePercentage = static_cast<float>(lifetime) / maxLifetime;
+            
+            // Choose symbol based on degradation stage
+            if (lifePercentage < 0.25f) {
+                canvas.Text("O"_np, coin.x, coin.y, true, COIN_ATTR); // Fresh coin
+            } else if (lifePercentage < 0.5f) {
+                canvas.Text("0"_np, coin.x, coin.y, true, COIN_ATTR); // Slightly degraded
+            } else if (lifePercentage < 0.75f) {
+                canvas.Text("o"_np, coin.x, coin.y, true, COIN_ATTR); // More degraded
+            } else {
+                canvas.Text("."_np, coin.x, coin.y, true, COIN_ATTR); // Almost gone
+            }
+        }
+    }
+}
+
+// Particle looks, registered in this order by InitializeGame
+enum ParticleStyle {
+    STYLE_SPARK = 0, // Coin collected
+    STYLE_SMOKE,     // Coin expired
+};
+
+constexpr IL::CellAttr SMOKE_ATTR = { IL::Color::DarkGray, IL::Color::Default, 0 };
+
+// A ring of sparks flying out from the coin
+constexpr IL::EmitterConfig SPARK_BURST = {
+    .rate = 20.0f, .speedMin = 0.15f, .speedMax = 0.5f, .lifeMin = 4, .lifeMax = 9, .style = STYLE_SPARK,
+};
+
+// A slow puff rising from the coin
+constexpr IL::EmitterConfig SMOKE_BURST = {
+    .rate = 12.0f, .spread = 0.9f, .speedMin = 0.05f, .speedMax = 0.2f, .lifeMin = 6, .lifeMax = 12, .style = STYLE_SMOKE,
+};
+
+// Start an explosion centred on the given player unit
+void StartExplosion(State_t& state, int x, int y, const IL::EmitterConfig& config) {
+    if (!state.rules.effects) {
+        return;
+    }
+
+    state.particles.Burst(config, x * 2 + 0.5f, y + 0.5f);
+}
+
+// The original level, with a more balanced layout
+void InitializeHandPlacedPlatforms(State_t& state) {
+    // Ground level platforms (y=25)
+    state.platforms.push_back({12, 25, 15, 1});
+    state.platforms.push_back({45, 25, 15, 1});
+    
+    // Mid-level platforms (y=18)
+    state.platforms.push_back({5, 18, 10, 1});
+    state.platforms.push_back({30, 18, 15, 1});
+    state.platforms.push_back({60, 18, 12, 1});
+    
+    // Higher level platforms (y=12)
+    state.platforms.push_back({20, 12, 10, 1});
+    state.platforms.push_back({45, 12, 14, 1});
+    
+    // Top level platforms (y=6)
+    state.platforms.push_back({35, 6, 15, 1});
+}
+
+// Initialize platforms, hand-placed or generated
+void InitializePlatforms(State_t& state) {
+    // Clear existing platforms
+    state.platforms.clear();
+
+    // A seed that gives no valid level falls back to the hand-placed one
+    if (state.rules.levelSeed != 0 && !LevelGenerator().Generate(state.rules.levelSeed, state.rules, state.platforms).valid) {
+        state.platforms.clear();
+    }
+    
+    if (state.platforms.empty()) {
+        InitializeHandPlacedPlatforms(state);
+    }
+
+    // Players land on the tops and jump through from below
+    state.ledges.clear();
+    for (const Platform& platform : state.platforms) {
+        state.ledges.push_back({ platform.x, platform.x + platform.width, platform.y });
+    }
+}
+
+// Initialize coins
+void InitializeCoins(State_t& state) {
+    // Clear existing coins
+    state.coins.clear();
+    // Start with a few coins, their lifetimes count from the first tick
+    SpawnCoin(state, state.timers.Now() + 1);
+    SpawnCoin(state, state.timers.Now() + 1);
+
+    int interval = state.rules.coinSpawnInterval > 0 ? state.rules.coinSpawnInterval : 1;
+    state.spawnTimer = state.timers.Schedule(interval, TimerPayload(TIMER_SPAWN, 0));
+}
+
+// Initialize players
+void InitializePlayers(State_t& state) {
+    // Left player (WASD)
+    state.players[0].position = {SpawnX(0), 0};
+    state.players[0].score = 0;
+    
+    // Right player (Arrow keys)
+    state.players[1].position = {SpawnX(1), 0};
+    state.players[1].score = 0;
+
+    for (int i = 0; i < 2; i++) {
+        state.players[i].physics.y = IL::CellsToFixed(state.players[i].position.y);
+        state.behaviors.Start(Blink(state.behaviors, state, i));
+    }
+}
+
+// Check if player collects any coins
+void CheckCoinCollection(State_t& state, int playerIndex) {
+    Player& player = state.players[playerIndex];
+
+    // Use animated dimensions for coin collection detection
+    int playerLeft = player.position.x + player.xOffset;
+    int playerRight = playerLeft + player.currentWidth;
+    int playerTop = player.position.y + player.yOffset;
+    int playerBottom = playerTop + player.currentHeight;
+    
+    for (auto& coin : state.coins) {
+        if (coin.active && 
+            playerLeft < coin.x + 1 && playerRight > coin.x &&
+            playerTop < coin.y + 1 && playerBottom > coin.y) {
+            // Coin collected
+            coin.active = false;
+            state.timers.Cancel(coin.expiry);
+            player.score += 10;
+            state.stats.coinsCollected++;
+            
+            // Create explosion on coin collection
+            StartExplosion(state, coin.x, coin.y, SPARK_BURST);
+        }
+    }
+}
+
+// Spawn a new coin at a random position, counting its lifetime from firstTick
+void SpawnCoin(State_t& state, uint64_t firstTick) {
+    // Don't spawn more coins if we've hit the maximum
+    if (state.coins.size() >= static_cast<size_t>(state.rules.maxCoinsOnScreen)) {
+        return;
+    }
+
+    Coin coin;
+    coin.x = state.random.Next() % (SCREEN_WIDTH - 3); // Avoid spawning right at the edge
+    
+    // 50% chance to spawn on a platform, 50% chance to spawn in air
+    if (state.random.Next() % 2 == 0 && !state.platforms.empty()) {
+        // Choose a random platform
+        const auto& platform = state.platforms[state.random.Next() % state.platforms.size()];
+        // Place the coin right above the platform
+        coin.x = platform.x + (state.random.Next() % (platform.width - 1));
+        coin.y = platform.y - 2;
+    } else {
+        // Random position in air
+        coin.y = (state.random.Next() % (state.players[0].physics.groundLevel - 5)) + 2;  // Avoid spawning too high or too low
+    }
+    
+    coin.active = true;
+    coin.id = state.nextCoinId++;
+    coin.firstTick = firstTick;
+    coin.exploding = false;
+    coin.explosionFrame = 0;
+    coin.value = (state.random.Next() % 3 == 0) ? 20 : 10;  // 33% chance for a high-value coin
+
+    // Expires on the coinLifetime-th tick it lives through, which can be this one when lifetimes are that short
+    int lifetime = state.rules.coinLifetime > 0 ? state.rules.coinLifetime : 1;
+    uint64_t deadline = firstTick + lifetime - 1;
+    uint64_t payload = TimerPayload(TIMER_COIN_EXPIRY, coin.id);
+    if (deadline > state.timers.Now()) {
+        coin.expiry = state.timers.Schedule(deadline - state.timers.Now(), payload);
+    } else {
+        coin.expiry = IL::INVALID_TIMER;
+        state.dueTimers.push_back(payload);
+    }
+
+    state.coins.push_back(coin);
+    state.stats.coinsSpawned++;
+}
+
+// Explodes a coin whose lifetime ran out
+void ExpireCoin(State_t& state, uint32_t id) {
+    for (auto& coin : state.coins) {
+        if (coin.active && coin.id == id) {
+            // Start an explosion at this coin's position
+            StartExplosion(state, coin.x, coin.y, SMOKE_BURST);
+            state.stats.coinsExpired++;
+            coin.active = false;
+            return;
+        }
+    }
+}
+
+// Handles the timers due this tick, a kind at a time in the order the per-tick counters they replace ran
+void HandleTimers(State_t& state) {
+    for (uint64_t payload : state.dueTimers) {
+        if (TimerKindOf(payload) == TIMER_MOVE_END) {
+            EndMove(state, TimerTarget(payload));
+        }
+    }
+
+    // Spawn new coins, before expiring any so they still count towards the limit this tick
+    for (size_t i = 0; i < state.dueTimers.size(); i++) {
+        if (TimerKindOf(state.dueTimers[i]) == TIMER_SPAWN) {
+            int interval = state.rules.coinSpawnInterval > 0 ? state.rules.coinSpawnInterval : 1;
+            state.spawnTimer = state.timers.Schedule(interval, TimerPayload(TIMER_SPAWN, 0));
+
+            // Increased chance to spawn a coin (75%)
+            if (state.random.Next() % 4 < 3) {
+                SpawnCoin(state, state.timers.Now());
+            }
+        }
+    }
+
+    // Indexed, a coin spawned above with a one tick lifetime adds its expiry to the list
+    for (size_t i = 0; i < state.dueTimers.size(); i++) {
+        if (TimerKindOf(state.dueTimers[i]) == TIMER_COIN_EXPIRY) {
+            ExpireCoin(state, TimerTarget(state.dueTimers[i]));
+        }
+    }
+}
+
+void State_t::Reset() {
+    // The behaviors first, they hold references into the rest
+    behaviors.Clear();
+    for (Player& player : players) {
+        player = Player();
+    }
+    platforms.clear();
+    ledges.clear();
+    coins.clear();
+    spawnTimer = IL::INVALID_TIMER;
+    particles.Clear();
+    timers.Reset();
+    dueTimers.clear();
+    nextCoinId = 0;
+    rules = GameRules();
+    random = Random();
+    stats = MatchStats();
+}
+
+void InitializeGame(State_t& state, unsigned int seed, const GameRules& rules) {
+    state.Reset();
+    state.rules = rules;
+    
+    // Seed this match's random number generator
+    state.random.Seed(seed);
+
+    // Explosions draw from their own sequence so they never change how a match plays out
+    state.particles = IL::ParticlePool(MAX_PARTICLES, seed + 1);
+    state.particles.AddStyle(u"*+#+.", COIN_ATTR);  // STYLE_SPARK
+    state.particles.AddStyle(u"@%:. ", SMOKE_ATTR); // STYLE_SMOKE
+
+    // Sized for the busiest tick up front so a running match never allocates: a spawn check, a timer per player
+    // for moving and an expiry per coin, and a blink per player
+    size_t maxCoins = rules.maxCoinsOnScreen > 0 ? static_cast<size_t>(rules.maxCoinsOnScreen) : 0;
+    size_t maxTimers = 1 + 2 + maxCoins;
+    state.coins.reserve(maxCoins);
+    state.timers.Reserve(maxTimers);
+    state.dueTimers.reserve(maxTimers);
+    state.behaviors.Reserve(2);
+    
+    // Initialize platforms, coins, and players
+    InitializePlatforms(state);
+    InitializeCoins(state);
+    InitializePlayers(state);
+}
+
+void ApplyInput(State_t& state, const IL::InputSource& input) {
+    // Process keyboard input for Player 1 (WASD)
+    if (input.IsKeyDown(IL::KEY_A)) {
+        if (state.players[0].position.x > 0) {
+            state.players[0].position.x--;
+            state.players[0].isMovingHorizontal = true;
+            state.players[0].lastMoveDirection = -1;
+            RestartMoveTimer(state, 0);
+        }
+    }
+    
+    if (input.IsKeyDown(IL::KEY_D)) {
+        if (state.players[0].position.x < SCREEN_WIDTH - PLAYER_WIDTH) {
+            state.players[0].position.x++;
+            state.players[0].isMovingHorizontal = true;
+            state.players[0].lastMoveDirection = 1;
+            RestartMoveTimer(state, 0);
+        }
+    }
+    
+    if (input.IsKeyDown(IL::KEY_W)) {
+        // Only allow jumping when on the ground
+        if (state.players[0].physics.isOnGround) {
+            state.players[0].physics.velocityY = IL::ToFixed(state.rules.jumpForce);
+            state.players[0].physics.isOnGround = false;
+        }
+    }
+    
+    // Process keyboard input for Player 2 (Arrow Keys)
+    if (input.IsKeyDown(IL::KEY_LEFT)) {
+        if (state.players[1].position.x > 0) {
+            state.players[1].position.x--;
+            state.players[1].isMovingHorizontal = true;
+            state.players[1].lastMoveDirection = -1;
+            RestartMoveTimer(state, 1);
+        }
+    }
+    
+    if (input.IsKeyDown(IL::KEY_RIGHT)) {
+        if (state.players[1].position.x < SCREEN_WIDTH - PLAYER_WIDTH) {
+            state.players[1].position.x++;
+            state.players[1].isMovingHorizontal = true;
+            state.players[1].lastMoveDirection = 1;
+            RestartMoveTimer(state, 1);
+        }
+    }
+    
+    if (input.IsKeyDown(IL::KEY_UP)) {
+        // Only allow jumping when on the ground
+        if (state.players[1].physics.isOnGround) {
+            state.players[1].physics.velocityY = IL::ToFixed(state.rules.jumpForce);
+            state.players[1].physics.isOnGround = false;
+        }
+    }
+    
+    // Process escape key for both players
+    if (input.IsKeyDown(IL::KEY_ESCAPE)) {
+        // Handle escape key (could add pause menu)
+    }
+}
+
+// Update physics for a player, it only touches that player
+void StepPlayer(State_t& state, int playerIndex) {
+    Player& player = state.players[playerIndex];
+
+    // Fall in sub-cells and land on the first platform or the ground the feet sweep past. Collisions use the
+    // idle body, squashing and stretching is only drawn, so changing pose can never sink a player into a platform.
+    int32_t left = player.position.x;
+    int32_t right = left + PLAYER_WIDTH;
+    int32_t height = PLAYER_HEIGHT;
+    uint8_t grounded = 0;
+    IL::BodyArrays body = { &player.physics.y, &player.physics.velocityY, &left, &right, &height, &grounded, 1 };
+    IL::FallRules fall = { IL::ToFixed(state.rules.gravity), player.physics.terminalVelocity, player.physics.groundLevel };
+    IL::StepBodies(body, fall, state.ledges.data(), state.ledges.size());
+
+    player.physics.isOnGround = grounded != 0;
+    player.position.y = IL::FixedToCell(player.physics.y);
+
+    // Enforce side boundaries (in case other code moves the player)
+    if (player.position.x < 0) {
+        player.position.x = 0;
+    }
+    else if (player.position.x > SCREEN_WIDTH - PLAYER_WIDTH) {
+        player.position.x = SCREEN_WIDTH - PLAYER_WIDTH;
+    }
+}
+
+// Advance every timer, only the ones due this tick do any work
+void AdvanceTimers(State_t& state) {
+    state.dueTimers.clear();
+    state.timers.Advance([&state](uint64_t payload) { state.dueTimers.push_back(payload); });
+    HandleTimers(state);
+}
+
+// Everything after the timers but the explosions, it never touches the particle pool
+void FinishTick(State_t& state) {
+    // Remove inactive coins
+    state.coins.erase(
+        std::remove_if(state.coins.begin(), state.coins.end(), 
+            [](const Coin& coin) { return !coin.active; }),
+        state.coins.end()
+    );
+
+    // Animation picks the collision box for the next tick, then blinks start and end
+    for (int i = 0; i < 2; i++) {
+        UpdatePlayerAnimation(state.players[i]);
+    }
+    state.behaviors.Tick();
+}
+
+void UpdateGame(State_t& state, const IL::InputSource& input, FrameJobs* jobs) {
+    ApplyInput(state, input);
+
+    if (jobs == nullptr) {
+        for (int i = 0; i < 2; i++) {
+            StepPlayer(state, i);
+            CheckCoinCollection(state, i);
+        }
+        AdvanceTimers(state);
+        state.particles.Update();  // Update explosions
+        FinishTick(state);
+    } else {
+        // The players fall side by side, but collect in order as both can touch the same coin. Explosions are
+        // updated next to the rest of the tick, they only need the ones the timers started.
+        IL::JobGraph& graph = jobs->graph;
+        graph.Clear();
+        IL::JobIndex stepP1 = graph.Add([&state] { StepPlayer(state, 0); });
+        IL::JobIndex stepP2 = graph.Add([&state] { StepPlayer(state, 1); });
+        IL::JobIndex collect = graph.Add([&state] {
+            CheckCoinCollection(state, 0);
+            CheckCoinCollection(state, 1);
+        });
+        graph.Depend(collect, stepP1);
+        graph.Depend(collect, stepP2);
+        IL::JobIndex timers = graph.Add([&state] { AdvanceTimers(state); });
+        graph.Depend(timers, collect);
+        graph.Depend(graph.Add([&state] { state.particles.Update(); }), timers);
+        graph.Depend(graph.Add([&state] { FinishTick(state); }), timers);
+        jobs->system.Run(graph);
+    }
+
+    state.stats.ticks++;
+}
+
+// Platforms and footer never change, so they are only drawn when the cached layer is invalidated
+void RenderBackground(const State_t& state, IL::Canvas& canvas) {
+    if (canvas.BeginLayer(IL::Layer::Background)) {
+        RenderPlatforms(canvas, state.platforms);  // Render platforms
+
+        // Sized in cells across the canvas so the controls line fits on one line, longer text wraps and ends with
+        // an ellipsis rather than running off the edge
+        canvas.TextBox("By Ben McAvoy (https://github.com/BenMcAvoy)\n"
+                       "P1: WASD to move/jump. P2: Arrows to move/jump. Collect coins before they explode!",
+                       2, IL::CANVAS_HEIGHT - 2, IL::CANVAS_WIDTH - 4, 2, IL::TextAlign::Left, false);
+    }
+}
+
+void RenderWorld(const State_t& state, IL::Canvas& canvas) {
+    canvas.BeginLayer(IL::Layer::World);
+    RenderCoins(canvas, state.coins, state.timers.Now(), state.rules.coinLifetime);  // Render coins with degradation
+    state.particles.Render(canvas);  // Render explosions
+}
+
+// Render both players
+void RenderEntities(const State_t& state, IL::Canvas& canvas) {
+    canvas.BeginLayer(IL::Layer::Entities);
+    RenderPlayer(canvas, state.players[0], 0);  // Left player
+    RenderPlayer(canvas, state.players[1], 1);  // Right player
+}
+
+void RenderHUD(const State_t& state, IL::Canvas& canvas) {
+    // Display scores for both players
+    canvas.BeginLayer(IL::Layer::HUD);
+    canvas.Text(1, 1, PLAYER_LOOKS[0].attr, "P1 Score: {}"_np, state.players[0].score);
+    canvas.Text(SCREEN_WIDTH - 15, 1, PLAYER_LOOKS[1].attr, "P2 Score: {}"_np, state.players[1].score);
+    
+    // Display coin info in center
+    std::string_view coinInfo = canvas.Format("Coins: {} Next: {}", state.coins.size(),
+                                              (state.timers.GetDeadline(state.spawnTimer) - state.timers.Now()) / 10);
+    canvas.Text(coinInfo, (SCREEN_WIDTH - static_cast<int>(coinInfo.length())) / 2, 1);
+}
+
+void RenderGame(const State_t& state, IL::Canvas& canvas, FrameJobs* jobs) {
+    canvas.Begin();
+
+    if (jobs == nullptr) {
+        RenderBackground(state, canvas);
+        RenderWorld(state, canvas);
+        RenderEntities(state, canvas);
+        RenderHUD(state, canvas);
+    } else {
+        // World and entities are drawn into canvases of their own and swapped in, the canvas itself gets the rest
+        IL::JobGraph& graph = jobs->graph;
+        graph.Clear();
+        graph.Add([&state, jobs] {
+            jobs->world.Begin();
+            RenderWorld(state, jobs->world);
+        });
+        graph.Add([&state, jobs] {
+            jobs->entities.Begin();
+            RenderEntities(state, jobs->entities);
+        });
+        graph.Add([&state, &canvas] {
+            RenderBackground(state, canvas);
+            RenderHUD(state, canvas);
+        });
+        jobs->system.Run(graph);
+
+        canvas.TakeLayer(IL::Layer::World, jobs->world);
+        canvas.TakeLayer(IL::Layer::Entities, jobs->entities);
+    }
+
+    canvas.End();
+}
@@ -0,0 +1,326 @@
+#include "glyphimage.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <emmintrin.h>
+
+using namespace IL;
+
+namespace {
+    // How much of a cell each glyph covers in its four quadrants
+    struct GlyphCoverage {
+        Cell glyph;
+        float ink[4]; // Top left, top right, bottom left, bottom right
+    };
+
+    constexpr GlyphCoverage GLYPHS[] = {
+        { u' ', { 0.0f, 0.0f, 0.0f, 0.0f } },
+        { u'\u2591', { 0.25f, 0.25f, 0.25f, 0.25f } }, // Light shade
+        { u'\u2592', { 0.5f, 0.5f, 0.5f, 0.5f } },     // Medium shade
+        { u'\u2593', { 0.75f, 0.75f, 0.75f, 0.75f } }, // Dark shade
+        { u'\u2588', { 1.0f, 1.0f, 1.0f, 1.0f } },     // Full block
+        { u'\u2580', { 1.0f, 1.0f, 0.0f, 0.0f } },     // Upper half
+        { u'\u2584', { 0.0f, 0.0f, 1.0f, 1.0f } },     // Lower half
+        { u'\u258C', { 1.0f, 0.0f, 1.0f, 0.0f } },     // Left half
+        { u'\u2590', { 0.0f, 1.0f, 0.0f, 1.0f } },     // Right half
+    };
+
+    constexpr int GLYPH_COUNT = static_cast<int>(sizeof(GLYPHS) / sizeof(GLYPHS[0]));
+
+    // Ordered dithering nudges each cell by up to half the step between two shades
+    constexpr float SHADE_STEP = 0.25f;
+    constexpr int BAYER4[4][4] = {
+        { 0, 8, 2, 10 },
+        { 12, 4, 14, 6 },
+        { 3, 11, 1, 9 },
+        { 15, 7, 13, 5 },
+    };
+
+    struct DitherOffsets {
+        float rows[4][4];
+    };
+
+    constexpr DitherOffsets MakeDitherOffsets() {
+        DitherOffsets offsets = {};
+        for (int y = 0; y < 4; y++) {
+            for (int x = 0; x < 4; x++) {
+                offsets.rows[y][x] = ((BAYER4[y][x] + 0.5f) / 16.0f - 0.5f) * SHADE_STEP;
+            }
+        }
+        return offsets;
+    }
+
+    constexpr DitherOffsets ORDERED_OFFSETS = MakeDitherOffsets();
+    constexpr float NO_OFFSETS[4] = {};
+
+    // Luminance weights scaled to 256 (BT.601)
+    constexpr uint32_t LUMA_R = 77;
+    constexpr uint32_t LUMA_G = 150;
+    constexpr uint32_t LUMA_B = 29;
+
+    int BytesPerPixel(PixelFormat format) {
+        switch (format) {
+            case PixelFormat::Gray8: return 1;
+            case PixelFormat::Rgb8: return 3;
+            default: return 4;
+        }
+    }
+
+    // Adds the luminance * 256 of every pixel of a row to its column's sum
+    void AccumulateRowScalar(const uint8_t* row, int width, PixelFormat format, uint32_t* sums) {
+        switch (format) {
+            case PixelFormat::Gray8:
+                for (int x = 0; x < width; x++) {
+                    sums[x] += static_cast<uint32_t>(row[x]) << 8;
+                }
+                break;
+            case PixelFormat::Rgb8:
+                for (int x = 0; x < width; x++) {
+                    sums[x] += LUMA_R * row[x * 3] + LUMA_G * row[x * 3 + 1] + LUMA_B * row[x * 3 + 2];
+                }
+                break;
+            case PixelFormat::Rgba8:
+                for (int x = 0; x < width; x++) {
+                    sums[x] += LUMA_R * row[x * 4] + LUMA_G * row[x * 4 + 1] + LUMA_B * row[x * 4 + 2];
+                }
+                break;
+            case PixelFormat::Bgra8:
+                for (int x = 0; x < width; x++) {
+                    sums[x] += LUMA_B * row[x * 4] + LUMA_G * row[x * 4 + 1] + LUMA_R * row[x * 4 + 2];
+                }
+                break;
+        }
+    }
+
+    void AccumulateRowSse2(const uint8_t* row, int width, PixelFormat format, uint32_t* sums) {
+        const __m128i zero = _mm_setzero_si128();
+        int x = 0;
+
+        if (format == PixelFormat::Gray8) {
+            // Sixteen pixels widened to four vectors of 32-bit lanes
+            for (; x + 16 <= width; x += 16) {
+                __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+                __m128i halves[2] = { _mm_unpacklo_epi8(pixels, zero), _mm_unpackhi_epi8(pixels, zero) };
+                for (int h = 0; h < 2; h++) {
+                    __m128i quarters[2] = { _mm_unpacklo_epi16(halves[h], zero), _mm_unpackhi_epi16(halves[h], zero) };
+                    for (int q = 0; q < 2; q++) {
+                        __m128i* lane = reinterpret_cast<__m128i*>(sums + x + h * 8 + q * 4);
+                        _mm_storeu_si128(lane, _mm_add_epi32(_mm_loadu_si128(lane), _mm_slli_epi32(quarters[q], 8)));
+                    }
+                }
+            }
+        } else if (format == PixelFormat::Rgba8 || format == PixelFormat::Bgra8) {
+            const __m128i weights = format == PixelFormat::Rgba8
+                ? _mm_setr_epi16(LUMA_R, LUMA_G, LUMA_B, 0, LUMA_R, LUMA_G, LUMA_B, 0)
+                : _mm_setr_epi16(LUMA_B, LUMA_G, LUMA_R, 0, LUMA_B, LUMA_G, LUMA_R, 0);
+
+            // Four pixels, madd leaves r*wr + g*wg and b*wb in neighbouring lanes which are then regrouped and added
+            for (; x + 4 <= width; x += 4) {
+                __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4));
+                __m128i low = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), weights);
+                __m128i high = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), weights);
+                low = _mm_shuffle_epi32(low, _MM_SHUFFLE(3, 1, 2, 0));
+                high = _mm_shuffle_epi32(high, _MM_SHUFFLE(3, 1, 2, 0));
+                __m128i luma = _mm_add_epi32(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));
+
+                __m128i* lane = reinterpret_cast<__m128i*>(sums + x);
+                _mm_storeu_si128(lane, _mm_add_epi32(_mm_loadu_si128(lane), luma));
+            }
+        }
+
+        // Three byte pixels do not split into lanes, they and the tail are left to the scalar loop
+        AccumulateRowScalar(row + static_cast<size_t>(x) * BytesPerPixel(format), width - x, format, sums + x);
+    }
+
+    int MatchCell(float q0, float q1, float q2, float q3) {
+        int best = 0;
+        float bestError = FLT_MAX;
+        for (int g = 0; g < GLYPH_COUNT; g++) {
+            float d0 = q0 - GLYPHS[g].ink[0];
+            float d1 = q1 - GLYPHS[g].ink[1];
+            float d2 = q2 - GLYPHS[g].ink[2];
+            float d3 = q3 - GLYPHS[g].ink[3];
+            float error = d0 * d0 + d1 * d1 + d2 * d2 + d3 * d3;
+            if (error < bestError) {
+                best = g;
+                bestError = error;
+            }
+        }
+        return best;
+    }
+
+    // Same comparisons as MatchCell for four neighbouring cells at once
+    void MatchFourCellsSse2(const float* q0, const float* q1, const float* q2, const float* q3, __m128 offset, Cell* out) {
+        __m128 a0 = _mm_add_ps(_mm_loadu_ps(q0), offset);
+        __m128 a1 = _mm_add_ps(_mm_loadu_ps(q1), offset);
+        __m128 a2 = _mm_add_ps(_mm_loadu_ps(q2), offset);
+        __m128 a3 = _mm_add_ps(_mm_loadu_ps(q3), offset);
+
+        __m128 bestError = _mm_set1_ps(FLT_MAX);
+        __m128i best = _mm_setzero_si128();
+        for (int g = 0; g < GLYPH_COUNT; g++) {
+            __m128 d0 = _mm_sub_ps(a0, _mm_set1_ps(GLYPHS[g].ink[0]));
+            __m128 d1 = _mm_sub_ps(a1, _mm_set1_ps(GLYPHS[g].ink[1]));
+            __m128 d2 = _mm_sub_ps(a2, _mm_set1_ps(GLYPHS[g].ink[2]));
+            __m128 d3 = _mm_sub_ps(a3, _mm_set1_ps(GLYPHS[g].ink[3]));
+            __m128 error = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(d0, d0), _mm_mul_ps(d1, d1)), _mm_mul_ps(d2, d2)), _mm_mul_ps(d3, d3));
+
+            __m128i better = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+            best = _mm_or_si128(_mm_and_si128(better, _mm_set1_epi32(g)), _mm_andnot_si128(better, best));
+            bestError = _mm_min_ps(error, bestError);
+        }
+
+        alignas(16) int32_t indices[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(indices), best);
+        for (int i = 0; i < 4; i++) {
+            out[i] = GLYPHS[indices[i]].glyph;
+        }
+    }
+}
+
+GlyphConverter::GlyphConverter(int columns, int rows)
+    : columns(std::max(columns, 0)), rows(std::max(rows, 0)) {
+    size_t count = static_cast<size_t>(this->columns) * this->rows;
+    cells.assign(count, u' ');
+    mask.assign(count, static_cast<Cell>(0xFFFF));
+    for (std::vector<float>& plane : ink) {
+        plane.assign(count, 0.0f);
+    }
+    diffusion.assign(static_cast<size_t>(this->columns + 2) * 2, 0.0f);
+}
+
+void GlyphConverter::Prepare(const ImageView& image) {
+    if (image.width == boundsWidth && image.height == boundsHeight) {
+        return;
+    }
+
+    // Spread the pixels evenly over the half cells, images smaller than the grid repeat pixels
+    auto spread = [](std::vector<int>& bounds, int pixels, int parts) {
+        bounds.resize(static_cast<size_t>(parts) + 1);
+        for (int i = 0; i <= parts; i++) {
+            bounds[i] = static_cast<int>(static_cast<int64_t>(i) * pixels / parts);
+        }
+    };
+    spread(xBounds, image.width, columns * 2);
+    spread(yBounds, image.height, rows * 2);
+    columnSums.resize(image.width);
+    boundsWidth = image.width;
+    boundsHeight = image.height;
+}
+
+void GlyphConverter::Downsample(const ImageView& image, bool simd, bool darkInk) {
+    int quadColumns = columns * 2;
+    int quadRows = rows * 2;
+
+    for (int qy = 0; qy < quadRows; qy++) {
+        int top = yBounds[qy];
+        int bottom = std::max(yBounds[qy + 1], top + 1);
+
+        // Box filter, vertical part first so the wide row loop stays simple
+        std::fill(columnSums.begin(), columnSums.end(), 0u);
+        for (int y = top; y < bottom; y++) {
+            const uint8_t* row = image.pixels + static_cast<size_t>(y) * image.stride;
+            if (simd) {
+                AccumulateRowSse2(row, image.width, image.format, columnSums.data());
+            } else {
+                AccumulateRowScalar(row, image.width, image.format, columnSums.data());
+            }
+        }
+
+        float rowScale = 1.0f / (255.0f * 256.0f * static_cast<float>(bottom - top));
+        float* plane = ink[(qy & 1) * 2].data() + static_cast<size_t>(qy / 2) * columns;
+        float* planeRight = ink[(qy & 1) * 2 + 1].data() + static_cast<size_t>(qy / 2) * columns;
+        for (int qx = 0; qx < quadColumns; qx++) {
+            int left = xBounds[qx];
+            int right = std::max(xBounds[qx + 1], left + 1);
+            uint64_t sum = 0;
+            for (int x = left; x < right; x++) {
+                sum += columnSums[x];
+            }
+
+            float luminance = static_cast<float>(sum) * rowScale / static_cast<float>(right - left);
+            float value = darkInk ? 1.0f - luminance : luminance;
+            ((qx & 1) ? planeRight : plane)[qx / 2] = value;
+        }
+    }
+}
+
+void GlyphConverter::Match(Dither dither, bool simd) {
+    const float* q0 = ink[0].data();
+    const float* q1 = ink[1].data();
+    const float* q2 = ink[2].data();
+    const float* q3 = ink[3].data();
+
+    if (dither == Dither::ErrorDiffusion) {
+        // Each cell's error feeds the next one, so this stays one cell at a time
+        std::fill(diffusion.begin(), diffusion.end(), 0.0f);
+        for (int y = 0; y < rows; y++) {
+            float* current = diffusion.data() + (y & 1) * (columns + 2) + 1;
+            float* next = diffusion.data() + ((y + 1) & 1) * (columns + 2) + 1;
+            std::fill(next - 1, next + columns + 1, 0.0f);
+
+            for (int x = 0; x < columns; x++) {
+                size_t i = static_cast<size_t>(y) * columns + x;
+                float carried = current[x];
+                float a0 = q0[i] + carried;
+                float a1 = q1[i] + carried;
+                float a2 = q2[i] + carried;
+                float a3 = q3[i] + carried;
+                int g = MatchCell(a0, a1, a2, a3);
+                cells[i] = GLYPHS[g].glyph;
+
+                const float* covered = GLYPHS[g].ink;
+                float error = ((a0 + a1 + a2 + a3) - (covered[0] + covered[1] + covered[2] + covered[3])) * 0.25f;
+                current[x + 1] += error * (7.0f / 16.0f);
+                next[x - 1] += error * (3.0f / 16.0f);
+                next[x] += error * (5.0f / 16.0f);
+                next[x + 1] += error * (1.0f / 16.0f);
+            }
+        }
+        return;
+    }
+
+    for (int y = 0; y < rows; y++) {
+        const float* offsets = dither == Dither::Ordered ? ORDERED_OFFSETS.rows[y & 3] : NO_OFFSETS;
+        size_t rowStart = static_cast<size_t>(y) * columns;
+        int x = 0;
+
+        // Groups start at multiples of four, so lane i always takes column offset i
+        if (simd) {
+            __m128 offset = _mm_loadu_ps(offsets);
+            for (; x + 4 <= columns; x += 4) {
+                size_t i = rowStart + x;
+                MatchFourCellsSse2(q0 + i, q1 + i, q2 + i, q3 + i, offset, &cells[i]);
+            }
+        }
+
+        for (; x < columns; x++) {
+            size_t i = rowStart + x;
+            float offset = offsets[x & 3];
+            cells[i] = GLYPHS[MatchCell(q0[i] + offset, q1[i] + offset, q2[i] + offset, q3[i] + offset)].glyph;
+        }
+    }
+}
+
+void GlyphConverter::Convert(const ImageView& image, const GlyphOptions& options) {
+    if (image.pixels == nullptr || image.width <= 0 || image.height <= 0 || columns == 0 || rows == 0) {
+        std::fill(cells.begin(), cells.end(), u' ');
+        return;
+    }
+
+    Prepare(image);
+    Downsample(image, true, options.darkInk);
+    Match(options.dither, true);
+}
+
+void GlyphConverter::ConvertScalar(const ImageView& image, const GlyphOptions& options) {
+    if (image.pixels == nullptr || image.width <= 0 || image.height <= 0 || columns == 0 || rows == 0) {
+        std::fill(cells.begin(), cells.end(), u' ');
+        return;
+    }
+
+    Prepare(image);
+    Downsample(image, false, options.darkInk);
+    Match(options.dither, false);
+}
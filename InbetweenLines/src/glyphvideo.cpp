@@ -0,0 +1,335 @@
+#include "glyphvideo.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace IL;
+
+// Spans of changed cells closer than this are merged, a new span costs at least two bytes of varints
+static constexpr uint32_t MERGE_GAP = 2;
+
+static void WriteVarint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static void WriteCell(std::vector<uint8_t>& out, Cell cell) {
+    out.push_back(static_cast<uint8_t>(cell));
+    out.push_back(static_cast<uint8_t>(cell >> 8));
+}
+
+static bool ReadVarint(const uint8_t*& p, const uint8_t* end, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (p == end) {
+            return false;
+        }
+        uint8_t byte = *p++;
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ReadCells(const uint8_t*& p, const uint8_t* end, Cell* out, uint32_t count) {
+    if (static_cast<size_t>(end - p) / sizeof(Cell) < count) {
+        return false;
+    }
+    memcpy(out, p, count * sizeof(Cell)); // Little endian hosts only, like the writer
+    p += count * sizeof(Cell);
+    return true;
+}
+
+GlyphVideoWriter::~GlyphVideoWriter() {
+    if (file.is_open()) {
+        Finish();
+    }
+}
+
+bool GlyphVideoWriter::Open(const std::filesystem::path& path, int columns, int rows, double fps, uint32_t keyInterval) {
+    if (columns <= 0 || rows <= 0 || columns > UINT16_MAX || rows > UINT16_MAX || fps <= 0.0 || keyInterval == 0) {
+        return false;
+    }
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+
+    header = {};
+    header.columns = static_cast<uint16_t>(columns);
+    header.rows = static_cast<uint16_t>(rows);
+    header.fpsMilli = static_cast<uint32_t>(std::lround(fps * 1000.0));
+    header.keyInterval = keyInterval;
+
+    // Placeholder, rewritten by Finish once the frame count and index are known
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    offset = sizeof(header);
+    previous.assign(static_cast<size_t>(columns) * rows, 0);
+    index.clear();
+    return static_cast<bool>(file);
+}
+
+bool GlyphVideoWriter::AddFrame(const Cell* cells) {
+    if (!file.is_open()) {
+        return false;
+    }
+
+    size_t count = previous.size();
+    uint32_t frame = static_cast<uint32_t>(index.size());
+
+    key.assign(1, VIDEO_FRAME_KEY);
+    for (size_t i = 0; i < count;) {
+        size_t run = 1;
+        while (i + run < count && cells[i + run] == cells[i]) {
+            run++;
+        }
+        WriteVarint(key, static_cast<uint32_t>(run));
+        WriteCell(key, cells[i]);
+        i += run;
+    }
+
+    bool isKey = frame % header.keyInterval == 0;
+    const std::vector<uint8_t>* body = &key;
+    if (!isKey) {
+        // Changed spans, with short unchanged gaps folded into them
+        std::vector<std::pair<uint32_t, uint32_t>> spans;
+        for (size_t i = 0; i < count; i++) {
+            if (cells[i] == previous[i]) {
+                continue;
+            }
+            if (!spans.empty() && i - (spans.back().first + spans.back().second) <= MERGE_GAP) {
+                spans.back().second = static_cast<uint32_t>(i + 1 - spans.back().first);
+            } else {
+                spans.push_back({ static_cast<uint32_t>(i), 1 });
+            }
+        }
+
+        delta.assign(1, VIDEO_FRAME_DELTA);
+        WriteVarint(delta, static_cast<uint32_t>(spans.size()));
+        uint32_t position = 0;
+        for (const auto& [start, length] : spans) {
+            WriteVarint(delta, start - position);
+            WriteVarint(delta, length);
+            for (uint32_t i = start; i < start + length; i++) {
+                WriteCell(delta, cells[i]);
+            }
+            position = start + length;
+        }
+
+        // A scene cut is cheaper as a keyframe, which also shortens seeks
+        if (delta.size() < key.size()) {
+            body = &delta;
+        } else {
+            isKey = true;
+        }
+    }
+
+    file.write(reinterpret_cast<const char*>(body->data()), static_cast<std::streamsize>(body->size()));
+    index.push_back({ offset, static_cast<uint32_t>(body->size()), isKey ? VIDEO_ENTRY_KEY : 0u });
+    offset += body->size();
+    header.maxFrameSize = std::max(header.maxFrameSize, static_cast<uint32_t>(body->size()));
+    memcpy(previous.data(), cells, count * sizeof(Cell));
+    return static_cast<bool>(file);
+}
+
+bool GlyphVideoWriter::Finish() {
+    if (!file.is_open()) {
+        return false;
+    }
+
+    header.frameCount = static_cast<uint32_t>(index.size());
+    header.indexOffset = offset;
+    file.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(VideoIndexEntry)));
+    offset += index.size() * sizeof(VideoIndexEntry);
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    bool ok = static_cast<bool>(file);
+    file.close();
+    index.clear();
+    index.shrink_to_fit();
+    return ok;
+}
+
+bool GlyphVideoPlayer::Open(const std::filesystem::path& path) {
+    Close();
+    if (!file.Open(path)) {
+        IL_ERROR("Failed to open video {}", path.string());
+        return false;
+    }
+
+    indexWindow.Attach(file, INDEX_WINDOW);
+    const uint8_t* data = indexWindow.Get(0, sizeof(VideoHeader));
+    if (data == nullptr) {
+        IL_ERROR("Video {} is too short", path.string());
+        Close();
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    uint64_t indexSize = static_cast<uint64_t>(header.frameCount) * sizeof(VideoIndexEntry);
+    if (header.magic != VIDEO_MAGIC || header.version != VIDEO_VERSION || header.columns == 0 || header.rows == 0 ||
+        header.fpsMilli == 0 || header.keyInterval == 0 || header.indexOffset < sizeof(VideoHeader) ||
+        header.indexOffset > file.GetSize() || indexSize > file.GetSize() - header.indexOffset) {
+        IL_ERROR("Video {} has a bad header", path.string());
+        Close();
+        return false;
+    }
+
+    // The frame window always holds a few of the largest frames
+    frames.Attach(file, std::max<size_t>(FRAME_WINDOW, static_cast<size_t>(header.maxFrameSize) * 4));
+    size_t count = static_cast<size_t>(header.columns) * header.rows;
+    cells.assign(count, u' ');
+    mask.assign(count, static_cast<Cell>(0xFFFF));
+    current = UINT32_MAX;
+    return true;
+}
+
+void GlyphVideoPlayer::Close() {
+    frames.Unmap();
+    indexWindow.Unmap();
+    file.Close();
+    header = {};
+    cells.clear();
+    mask.clear();
+    current = UINT32_MAX;
+}
+
+bool GlyphVideoPlayer::ReadEntry(uint32_t frame, VideoIndexEntry& entry) {
+    const uint8_t* data = indexWindow.Get(header.indexOffset + static_cast<uint64_t>(frame) * sizeof(VideoIndexEntry), sizeof(VideoIndexEntry));
+    if (data == nullptr) {
+        return false;
+    }
+    memcpy(&entry, data, sizeof(entry));
+    return entry.size > 0 && entry.offset >= sizeof(VideoHeader) && entry.offset <= header.indexOffset &&
+        entry.size <= header.indexOffset - entry.offset;
+}
+
+bool GlyphVideoPlayer::DecodeFrame(uint32_t frame) {
+    VideoIndexEntry entry;
+    if (!ReadEntry(frame, entry)) {
+        return false;
+    }
+
+    const uint8_t* p = frames.Get(entry.offset, entry.size);
+    if (p == nullptr) {
+        return false;
+    }
+    const uint8_t* end = p + entry.size;
+    frames.ReadAhead(entry.offset + entry.size, READ_AHEAD_BYTES);
+
+    uint32_t count = static_cast<uint32_t>(cells.size());
+    uint8_t type = *p++;
+    if (type == VIDEO_FRAME_KEY) {
+        uint32_t position = 0;
+        while (position < count) {
+            uint32_t run;
+            Cell cell;
+            if (!ReadVarint(p, end, run) || run == 0 || run > count - position || !ReadCells(p, end, &cell, 1)) {
+                return false;
+            }
+            std::fill_n(&cells[position], run, cell);
+            position += run;
+        }
+    } else if (type == VIDEO_FRAME_DELTA) {
+        // Deltas only apply on top of the frame before them
+        if (current != frame - 1 || frame == 0) {
+            return false;
+        }
+
+        uint32_t spans;
+        if (!ReadVarint(p, end, spans)) {
+            return false;
+        }
+
+        uint32_t position = 0;
+        for (uint32_t s = 0; s < spans; s++) {
+            uint32_t skip, length;
+            if (!ReadVarint(p, end, skip) || !ReadVarint(p, end, length) || skip > count - position ||
+                length > count - position - skip) {
+                return false;
+            }
+            position += skip;
+            if (!ReadCells(p, end, &cells[position], length)) {
+                return false;
+            }
+            position += length;
+        }
+    } else {
+        return false;
+    }
+
+    current = frame;
+    return p == end;
+}
+
+bool GlyphVideoPlayer::Seek(uint32_t frame) {
+    if (frame >= header.frameCount) {
+        return false;
+    }
+    if (frame == current) {
+        return true;
+    }
+
+    // Walk back to the keyframe, unless the frames already decoded get there sooner
+    uint32_t start = frame;
+    if (current == UINT32_MAX || frame < current || frame - current > header.keyInterval) {
+        while (true) {
+            VideoIndexEntry entry;
+            if (!ReadEntry(start, entry)) {
+                current = UINT32_MAX;
+                return false;
+            }
+            if ((entry.flags & VIDEO_ENTRY_KEY) != 0) {
+                break;
+            }
+            if (start == 0) {
+                current = UINT32_MAX;
+                return false;
+            }
+            start--;
+        }
+
+        if (current != UINT32_MAX && current < frame && current >= start) {
+            start = current + 1;
+        }
+    } else {
+        start = current + 1;
+    }
+
+    for (uint32_t f = start; f <= frame; f++) {
+        if (!DecodeFrame(f)) {
+            IL_ERROR("Video frame {} is corrupt", f);
+            current = UINT32_MAX;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool GlyphVideoPlayer::DecodeNext() {
+    return Seek(current == UINT32_MAX ? 0 : current + 1);
+}
+
+void GlyphVideoPlayer::Play(uint32_t frame) {
+    playFrom = frame;
+    playStart = std::chrono::steady_clock::now();
+    Seek(frame);
+}
+
+bool GlyphVideoPlayer::Update() {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - playStart;
+    uint64_t due = playFrom + static_cast<uint64_t>(elapsed.count() * header.fpsMilli / 1000.0);
+    if (due >= header.frameCount) {
+        return false;
+    }
+    return Seek(static_cast<uint32_t>(due));
+}
@@ -0,0 +1,244 @@
+#include "jobs.h"
+#include "log.h"
+
+#include <emmintrin.h>
+
+using namespace IL;
+
+// Rounds of looking for work before a worker that ran dry sleeps, tens of microseconds, so the jobs a graph makes
+// ready one after another find a worker awake
+constexpr int SPIN_ROUNDS = 2048;
+
+void JobGraph::Depend(JobIndex job, JobIndex on) {
+    if (on >= job || job >= jobs.size()) {
+        IL_ERROR("Job {} can only wait on a job added before it, not {}", job, on);
+        return;
+    }
+
+    edges.push_back({ job, on });
+    jobs[job].waitsOn++;
+}
+
+void JobGraph::RunSerial() {
+    for (Job& job : jobs) {
+        job.run(job.storage);
+    }
+}
+
+void JobGraph::Clear() {
+    jobs.clear();
+    edges.clear();
+}
+
+void JobGraph::Reserve(size_t jobCount, size_t dependencies) {
+    jobs.reserve(jobCount);
+    edges.reserve(dependencies);
+    successors.reserve(dependencies);
+}
+
+void JobGraph::Prepare() {
+    for (Job& job : jobs) {
+        job.pending = job.waitsOn;
+        job.successorCount = 0;
+    }
+    for (const Edge& edge : edges) {
+        jobs[edge.on].successorCount++;
+    }
+
+    // Counting sort of the edges by the job they wait on
+    uint32_t first = 0;
+    for (Job& job : jobs) {
+        job.firstSuccessor = first;
+        first += job.successorCount;
+        job.successorCount = 0;
+    }
+    successors.resize(edges.size());
+    for (const Edge& edge : edges) {
+        Job& on = jobs[edge.on];
+        successors[on.firstSuccessor + on.successorCount++] = edge.job;
+    }
+
+    remaining.store(static_cast<uint32_t>(jobs.size()), std::memory_order_relaxed);
+}
+
+// Chase-Lev with the fences of Le et al., "Correct and Efficient Work-Stealing for Weak Memory Models"
+bool JobSystem::Queue::Push(Job* job) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    if (b - t >= QUEUE_CAPACITY) {
+        return false;
+    }
+
+    slots[b & (QUEUE_CAPACITY - 1)].store(job, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+JobSystem::Job* JobSystem::Queue::Pop() {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+    if (t > b) {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = slots[b & (QUEUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (t == b) {
+        // The last job, a thief may be taking it at the same time
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            job = nullptr;
+        }
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+JobSystem::Job* JobSystem::Queue::Steal() {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b) {
+        return nullptr;
+    }
+
+    Job* job = slots[t & (QUEUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return job;
+}
+
+JobSystem::JobSystem(unsigned int workers) : queues(workers + 1) {
+    threads.reserve(workers);
+    for (unsigned int thread = 1; thread <= workers; thread++) {
+        threads.emplace_back(&JobSystem::WorkerMain, this, thread);
+    }
+}
+
+JobSystem::~JobSystem() {
+    stopping.store(true);
+    wake.fetch_add(1);
+    wake.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+unsigned int JobSystem::DefaultWorkers() {
+    unsigned int hardware = std::thread::hardware_concurrency();
+    return hardware > 1 ? hardware - 1 : 0;
+}
+
+void JobSystem::Run(JobGraph& graph) {
+    if (graph.jobs.empty()) {
+        return;
+    }
+    if (threads.empty()) {
+        graph.RunSerial();
+        return;
+    }
+
+    graph.Prepare();
+    this->graph = &graph;
+
+    for (Job& job : graph.jobs) {
+        if (job.waitsOn == 0 && !queues[0].Push(&job)) {
+            Execute(&job, 0);
+        }
+    }
+    Notify();
+
+    // The caller works until the last job is done, every job's writes are visible once remaining reads 0. Waiting
+    // on a long job it gives its core up now and then, in case the job's thread shares it.
+    int idle = 0;
+    while (graph.remaining.load(std::memory_order_acquire) != 0) {
+        if (Job* job = Find(0)) {
+            Execute(job, 0);
+            idle = 0;
+        } else if (++idle < SPIN_ROUNDS) {
+            _mm_pause();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    this->graph = nullptr;
+}
+
+void JobSystem::WorkerMain(unsigned int thread) {
+    int idle = 0;
+    while (!stopping.load(std::memory_order_relaxed)) {
+        if (Job* job = Find(thread)) {
+            Execute(job, thread);
+            idle = 0;
+            continue;
+        }
+        if (++idle < SPIN_ROUNDS) {
+            _mm_pause();
+            continue;
+        }
+
+        // Announce the sleep before looking one last time, Notify either sees a sleeper or the job is found here
+        sleeping.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint32_t seen = wake.load();
+        Job* job = stopping.load() ? nullptr : Find(thread);
+        if (job == nullptr && !stopping.load()) {
+            wake.wait(seen);
+        }
+        sleeping.fetch_sub(1);
+
+        if (job != nullptr) {
+            Execute(job, thread);
+        }
+        idle = 0;
+    }
+}
+
+JobSystem::Job* JobSystem::Find(unsigned int thread) {
+    if (Job* job = queues[thread].Pop()) {
+        return job;
+    }
+
+    size_t count = queues.size();
+    for (size_t i = 1; i < count; i++) {
+        if (Job* job = queues[(thread + i) % count].Steal()) {
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::Execute(Job* job, unsigned int thread) {
+    job->run(job->storage);
+
+    bool pushed = false;
+    for (uint32_t i = 0; i < job->successorCount; i++) {
+        Job& next = graph->jobs[graph->successors[job->firstSuccessor + i]];
+        if (std::atomic_ref<uint32_t>(next.pending).fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            continue;
+        }
+
+        if (queues[thread].Push(&next)) {
+            pushed = true;
+        } else {
+            Execute(&next, thread);
+        }
+    }
+    if (pushed) {
+        Notify();
+    }
+
+    // Last, so the graph is not done before the jobs this one made ready were pushed
+    graph->remaining.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::Notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed) > 0) {
+        wake.fetch_add(1);
+        wake.notify_all();
+    }
+}
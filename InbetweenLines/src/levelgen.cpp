@@ -0,0 +1,159 @@
+#include "levelgen.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+    constexpr int SIDE_MARGIN = 2;     // Cells between platforms side by side that count as touching
+    constexpr int SCATTER_TRIES = 16;  // Places tried for a platform before leaving it out
+    constexpr int REPAIR_STEP = 3;     // Rows a repair lowers a platform by at least
+    constexpr int POSE_WIDTH = PLAYER_WIDTH - 1; // The narrowest pose, what a jump is sure to touch
+
+    // The lowest a platform may sit, players on the ground walk under it
+    int LowestTop(const LevelSpec& spec) {
+        return spec.floor - PLAYER_HEIGHT - 1;
+    }
+}
+
+bool LevelGenerator::Fits(const Platform& platform, const std::vector<Platform>& platforms, size_t skip) const {
+    for (size_t i = 0; i < platforms.size(); i++) {
+        const Platform& other = platforms[i];
+        bool sideBySide = platform.x < other.x + other.width + SIDE_MARGIN && other.x < platform.x + platform.width + SIDE_MARGIN;
+        if (i != skip && sideBySide && std::abs(platform.y - other.y) < spec.minSpacing) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void LevelGenerator::Scatter(Random& random, int count, std::vector<Platform>& platforms) const {
+    int lowest = LowestTop(spec);
+    int widths = std::max(1, spec.maxPlatformWidth - spec.minPlatformWidth + 1);
+    int rows = std::max(1, lowest - spec.minTop + 1);
+    for (int i = 0; i < count; i++) {
+        for (int tries = 0; tries < SCATTER_TRIES; tries++) {
+            Platform platform = {};
+            platform.width = std::min(spec.width, spec.minPlatformWidth + static_cast<int>(random.Next() % widths));
+            platform.x = static_cast<int>(random.Next() % (spec.width - platform.width + 1));
+            platform.y = spec.minTop + static_cast<int>(random.Next() % rows);
+            platform.height = 1;
+            if (Fits(platform, platforms, platforms.size())) {
+                platforms.push_back(platform);
+                break;
+            }
+        }
+    }
+}
+
+LevelReport LevelGenerator::Validate(const std::vector<Platform>& platforms, const GameRules& rules) {
+    LevelReport report;
+
+    ledges.clear();
+    for (const Platform& platform : platforms) {
+        ledges.push_back({ platform.x, platform.x + platform.width, platform.y });
+    }
+    IL::FallRules fall = { IL::ToFixed(rules.gravity), Physics_t().terminalVelocity, spec.floor };
+    graph.Build(ledges, fall, IL::ToFixed(rules.jumpForce), spec.width);
+
+    // Players drop in from the top of the world
+    int starts[2] = { graph.DropAt(SpawnX(0, spec.width), 0), graph.DropAt(SpawnX(1, spec.width), 0) };
+    graph.FindReachable(starts, reachable);
+
+    // Every cell a straight jump from a reachable stand touches
+    reached.assign(platforms.size(), 0);
+    cells.assign(static_cast<size_t>(spec.width) * spec.floor, 0);
+    for (int stand = 0; stand < graph.GetStandCount(); stand++) {
+        if (!reachable[stand]) {
+            continue;
+        }
+
+        int surface = graph.SurfaceOf(stand);
+        if (graph.LedgeOf(surface) >= 0) {
+            reached[graph.LedgeOf(surface)] = 1;
+        }
+
+        int x = graph.XOf(stand);
+        int right = std::min(x + POSE_WIDTH, spec.width);
+        for (int y = std::max(0, graph.ApexOf(surface)); y < graph.TopOf(surface); y++) {
+            std::fill(cells.begin() + static_cast<size_t>(y) * spec.width + x, cells.begin() + static_cast<size_t>(y) * spec.width + right, 1);
+        }
+    }
+
+    // Coin spots as SpawnCoin picks them: two rows above a platform along all but its last cell, or anywhere in
+    // the air away from the right edge and the ground
+    for (size_t i = 0; i < platforms.size(); i++) {
+        const Platform& platform = platforms[i];
+        report.unreachable += reached[i] ? 0 : 1;
+
+        int y = platform.y - 2;
+        for (int x = platform.x; y >= 0 && x <= platform.x + platform.width - 2 && x < spec.width; x++) {
+            report.unreachableCoins += cells[static_cast<size_t>(y) * spec.width + x] ? 0 : 1;
+        }
+    }
+
+    int airCells = 0;
+    int airReached = 0;
+    for (int y = 2; y <= spec.floor - 4; y++) {
+        for (int x = 0; x <= spec.width - 4; x++) {
+            airCells++;
+            airReached += cells[static_cast<size_t>(y) * spec.width + x];
+        }
+    }
+    report.airCoverage = airCells > 0 ? static_cast<float>(airReached) / airCells : 1.0f;
+
+    report.valid = report.unreachable == 0 && report.unreachableCoins == 0 && report.airCoverage >= spec.minAirCoverage;
+    return report;
+}
+
+bool LevelGenerator::Repair(std::vector<Platform>& platforms) const {
+    auto stranded = std::find(reached.begin(), reached.end(), 0);
+    if (stranded == reached.end()) {
+        return false;
+    }
+
+    // Lower it to the first free row that is a real step down, the ground is always reachable so low enough works
+    size_t index = static_cast<size_t>(stranded - reached.begin());
+    Platform lowered = platforms[index];
+    for (lowered.y += REPAIR_STEP; lowered.y <= LowestTop(spec); lowered.y++) {
+        if (Fits(lowered, platforms, index)) {
+            platforms[index] = lowered;
+            return true;
+        }
+    }
+
+    if (static_cast<int>(platforms.size()) > spec.minPlatforms) {
+        platforms.erase(platforms.begin() + index);
+        return true;
+    }
+    return false;
+}
+
+LevelReport LevelGenerator::Generate(uint64_t seed, const GameRules& rules, std::vector<Platform>& platforms) {
+    Random random;
+    random.Seed(seed);
+
+    LevelReport report;
+    int repairs = 0;
+    int platformCounts = std::max(1, spec.maxPlatforms - spec.minPlatforms + 1);
+    for (int candidate = 1; candidate <= spec.maxCandidates; candidate++) {
+        platforms.clear();
+        Scatter(random, spec.minPlatforms + static_cast<int>(random.Next() % platformCounts), platforms);
+
+        report = Validate(platforms, rules);
+        for (int step = 0; !report.valid && report.unreachable > 0 && step < spec.maxRepairs; step++) {
+            if (!Repair(platforms)) {
+                break;
+            }
+            repairs++;
+            report = Validate(platforms, rules);
+        }
+
+        report.candidates = candidate;
+        report.repairs = repairs;
+        if (report.valid) {
+            break;
+        }
+    }
+
+    return report;
+}
@@ -0,0 +1,162 @@
+#include "log.h"
+
+#include <cstring>
+
+using namespace IL;
+
+Logger::Slot Logger::s_slots[Logger::CAPACITY];
+std::atomic<size_t> Logger::s_enqueuePos = 0;
+size_t Logger::s_dequeuePos = 0;
+std::atomic<uint64_t> Logger::s_dropped = 0;
+
+static_assert((Logger::CAPACITY & (Logger::CAPACITY - 1)) == 0, "Logger capacity must be a power of two");
+
+static constexpr const char* LEVEL_NAMES[] = { "TRACE", "INFO", "WARN", "ERROR" };
+
+// FNV-1a, only used to spot repeats of the same message
+static uint64_t HashMessage(const char* text, size_t length) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ static_cast<unsigned char>(text[i])) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Sequences are stored relative to the slot index, so the zero-initialized ring is already free for the first
+// lap and messages logged before any Logger exists are kept
+size_t Logger::SlotSequence(size_t index) {
+    return s_slots[index].sequence.load(std::memory_order_acquire) + index;
+}
+
+void Logger::SetSlotSequence(size_t index, size_t sequence) {
+    s_slots[index].sequence.store(sequence - index, std::memory_order_release);
+}
+
+bool Logger::Admit(LogSite& site, int64_t now) {
+    // Start a new one second window, racing producers may both reset it which only admits a few extra messages
+    int64_t windowStart = site.windowStart.load(std::memory_order_relaxed);
+    if (now - windowStart >= 1'000'000'000) {
+        site.windowStart.store(now, std::memory_order_relaxed);
+        site.windowCount.store(0, std::memory_order_relaxed);
+    }
+
+    if (site.windowCount.fetch_add(1, std::memory_order_relaxed) >= MAX_PER_SECOND) {
+        site.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    return true;
+}
+
+void Logger::Push(LogSite& site, LogLevel level, int64_t now, const char* text, size_t length) {
+    // Fold repeats of the last message from this site into a count
+    uint64_t hash = HashMessage(text, length);
+    if (site.lastHash.load(std::memory_order_relaxed) == hash &&
+        now - site.lastTime.load(std::memory_order_relaxed) < DEDUP_WINDOW_NS) {
+        site.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    site.lastHash.store(hash, std::memory_order_relaxed);
+    site.lastTime.store(now, std::memory_order_relaxed);
+
+    // Claim a slot, a slot is free for the lap at `pos` when its sequence equals pos
+    size_t pos = s_enqueuePos.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    for (;;) {
+        slot = &s_slots[pos & (CAPACITY - 1)];
+        size_t sequence = SlotSequence(pos & (CAPACITY - 1));
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (s_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // The writer has not caught up, drop rather than wait
+            s_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = s_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->level = level;
+    slot->site = &site;
+    slot->suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+    slot->time = now;
+    slot->length = length;
+    memcpy(slot->text, text, length);
+
+    // Publish to the writer
+    SetSlotSequence(pos & (CAPACITY - 1), pos + 1);
+}
+
+bool Logger::Drain(FILE* out) {
+    bool wrote = false;
+    for (;;) {
+        size_t index = s_dequeuePos & (CAPACITY - 1);
+        Slot& slot = s_slots[index];
+        if (SlotSequence(index) != s_dequeuePos + 1) {
+            break;
+        }
+
+        double seconds = static_cast<double>(slot.time) / 1e9;
+        fprintf(out, "[%.3f] [%s] %.*s (%s, %s:%d)", seconds, LEVEL_NAMES[static_cast<int>(slot.level)],
+            static_cast<int>(slot.length), slot.text, slot.site->function, slot.site->file, slot.site->line);
+        if (slot.suppressed > 0) {
+            fprintf(out, " [%u similar messages suppressed]", slot.suppressed);
+        }
+        fputc('\n', out);
+
+        // Hand the slot back to producers for the next lap
+        SetSlotSequence(index, s_dequeuePos + CAPACITY);
+        s_dequeuePos++;
+        wrote = true;
+    }
+
+    return wrote;
+}
+
+Logger::Logger(const std::string& path) {
+    if (!path.empty()) {
+        FILE* file = fopen(path.c_str(), "a");
+        if (file != nullptr) {
+            out = file;
+            ownsFile = true;
+        }
+    }
+
+    writer = std::thread(&Logger::Run, this);
+}
+
+Logger::~Logger() {
+    running.store(false, std::memory_order_relaxed);
+    if (writer.joinable()) {
+        writer.join();
+    }
+
+    if (ownsFile) {
+        fclose(out);
+    }
+}
+
+void Logger::Run() {
+    uint64_t reportedDrops = 0;
+
+    while (running.load(std::memory_order_relaxed)) {
+        if (Drain(out)) {
+            fflush(out);
+        } else {
+            // Producers never signal, so idle with a short sleep instead
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        uint64_t dropped = Dropped();
+        if (dropped != reportedDrops) {
+            fprintf(out, "[WARN] %llu log messages dropped, the ring was full\n", static_cast<unsigned long long>(dropped - reportedDrops));
+            reportedDrops = dropped;
+        }
+    }
+
+    Drain(out);
+    fflush(out);
+}
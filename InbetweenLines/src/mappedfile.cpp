@@ -0,0 +1,172 @@
+#include "mappedfile.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace IL;
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+size_t MappedFile::GetGranularity() {
+#ifdef _WIN32
+    SYSTEM_INFO info = {};
+    GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+bool MappedFile::Open(const std::filesystem::path& path) {
+    Close();
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(handle);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(handle);
+        return false;
+    }
+
+    fileHandle = handle;
+    mappingHandle = mapping;
+    size = static_cast<uint64_t>(fileSize.QuadPart);
+#else
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+
+    struct stat info = {};
+    if (fstat(descriptor, &info) != 0 || info.st_size == 0) {
+        ::close(descriptor);
+        return false;
+    }
+
+    fd = descriptor;
+    size = static_cast<uint64_t>(info.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::Close() {
+#ifdef _WIN32
+    if (mappingHandle != nullptr) {
+        CloseHandle(mappingHandle);
+        mappingHandle = nullptr;
+    }
+    if (fileHandle != nullptr) {
+        CloseHandle(fileHandle);
+        fileHandle = nullptr;
+    }
+#else
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+#endif
+    size = 0;
+}
+
+MappedFile::Window::~Window() {
+    Unmap();
+}
+
+void MappedFile::Window::Attach(const MappedFile& file, size_t windowSize) {
+    Unmap();
+    size_t granularity = GetGranularity();
+    this->file = &file;
+    this->windowSize = std::max(granularity, (windowSize + granularity - 1) / granularity * granularity);
+}
+
+const uint8_t* MappedFile::Window::Get(uint64_t offset, size_t length) {
+    if (file == nullptr || offset > file->size || length > file->size - offset) {
+        return nullptr;
+    }
+
+    if (view != nullptr && offset >= viewOffset && offset + length <= viewOffset + viewSize) {
+        return view + (offset - viewOffset);
+    }
+
+    // Map from the granule holding offset, wider than the window only for a request that needs it
+    Unmap();
+    uint64_t base = offset / GetGranularity() * GetGranularity();
+    uint64_t wanted = std::max<uint64_t>(windowSize, offset - base + length);
+    size_t mapSize = static_cast<size_t>(std::min<uint64_t>(wanted, file->size - base));
+
+#ifdef _WIN32
+    void* mapped = MapViewOfFile(file->mappingHandle, FILE_MAP_READ, static_cast<DWORD>(base >> 32), static_cast<DWORD>(base), mapSize);
+    if (mapped == nullptr) {
+        return nullptr;
+    }
+#else
+    void* mapped = mmap(nullptr, mapSize, PROT_READ, MAP_SHARED, file->fd, static_cast<off_t>(base));
+    if (mapped == MAP_FAILED) {
+        return nullptr;
+    }
+#endif
+
+    view = static_cast<const uint8_t*>(mapped);
+    viewOffset = base;
+    viewSize = mapSize;
+    return view + (offset - viewOffset);
+}
+
+void MappedFile::Window::ReadAhead(uint64_t offset, size_t length) const {
+    if (view == nullptr || offset >= viewOffset + viewSize) {
+        return;
+    }
+
+    uint64_t start = std::max(offset, viewOffset);
+    uint64_t end = std::min<uint64_t>(offset + length, viewOffset + viewSize);
+    if (start >= end) {
+        return;
+    }
+
+#ifdef _WIN32
+    WIN32_MEMORY_RANGE_ENTRY range = { const_cast<uint8_t*>(view + (start - viewOffset)), static_cast<SIZE_T>(end - start) };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+    // madvise wants a page aligned start
+    size_t page = GetGranularity();
+    uint64_t alignedStart = (start - viewOffset) / page * page;
+    madvise(const_cast<uint8_t*>(view + alignedStart), static_cast<size_t>(end - viewOffset - alignedStart), MADV_WILLNEED);
+#endif
+}
+
+void MappedFile::Window::Unmap() {
+    if (view == nullptr) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(view);
+#else
+    munmap(const_cast<uint8_t*>(view), viewSize);
+#endif
+    view = nullptr;
+    viewOffset = 0;
+    viewSize = 0;
+}
@@ -0,0 +1,406 @@
+#include "navigation.h"
+
+#include <algorithm>
+
+namespace {
+    // Direction held and whether the move starts with a jump, by NavMove
+    constexpr int MOVE_DIRECTIONS[NAV_MOVES] = { -1, 1, -1, 0, 1 };
+    constexpr bool MOVE_JUMPS[NAV_MOVES] = { false, false, true, true, true };
+}
+
+void NavGraph::Build(const State_t& state) {
+    IL::FallRules fall = { IL::ToFixed(state.rules.gravity), state.players[0].physics.terminalVelocity,
+                           state.players[0].physics.groundLevel };
+    Build(state.ledges, fall, IL::ToFixed(state.rules.jumpForce));
+}
+
+void NavGraph::Build(const std::vector<IL::Ledge>& newLedges, const IL::FallRules& newFall, IL::Fixed newJump, int newWidth) {
+    bool sameLedges = std::equal(ledges.begin(), ledges.end(), newLedges.begin(), newLedges.end(),
+        [](const IL::Ledge& a, const IL::Ledge& b) { return a.left == b.left && a.right == b.right && a.top == b.top; });
+    if (built && sameLedges && newFall.gravity == fall.gravity && newFall.terminalVelocity == fall.terminalVelocity &&
+        newFall.floor == fall.floor && newJump == jumpForce && newWidth == width) {
+        return;
+    }
+
+    ledges.assign(newLedges.begin(), newLedges.end());
+    fall = newFall;
+    jumpForce = newJump;
+    width = newWidth;
+    columns = std::max(0, width - PLAYER_WIDTH + 1);
+    built = true;
+
+    // Every platform top a player fits on, then the ground
+    surfaces.clear();
+    for (int l = 0; l < static_cast<int>(ledges.size()); l++) {
+        const IL::Ledge& ledge = ledges[l];
+        if (ledge.top < PLAYER_HEIGHT || ledge.top >= fall.floor) {
+            continue;
+        }
+
+        Surface surface = {};
+        surface.top = ledge.top;
+        surface.minX = std::max(0, ledge.left - PLAYER_WIDTH + 1);
+        surface.maxX = std::min(columns - 1, ledge.right - 1);
+        surface.ledge = l;
+        if (surface.minX <= surface.maxX) {
+            surfaces.push_back(surface);
+        }
+    }
+    surfaces.push_back({ fall.floor, 0, columns - 1, 0, -1 });
+
+    // Stands, where two surfaces share a row and a player x the first one listed owns it
+    rows = fall.floor - PLAYER_HEIGHT + 1;
+    standAt.assign(static_cast<size_t>(rows) * columns, -1);
+    stands.clear();
+    for (int s = 0; s < static_cast<int>(surfaces.size()); s++) {
+        const Surface& surface = surfaces[s];
+        int32_t* row = &standAt[static_cast<size_t>(surface.top - PLAYER_HEIGHT) * columns];
+        for (int x = surface.minX; x <= surface.maxX; x++) {
+            if (row[x] < 0) {
+                row[x] = static_cast<int32_t>(stands.size());
+            }
+
+            Stand stand = {};
+            stand.surface = static_cast<int16_t>(s);
+            stand.x = static_cast<int16_t>(x);
+            stands.push_back(stand);
+        }
+    }
+
+    FlyMoves();
+
+    // How high a straight jump reaches from each surface, and how long it takes, for coins in the air
+    riseTicks = 0;
+    for (Surface& surface : surfaces) {
+        IL::Fixed y = IL::CellsToFixed(surface.top - PLAYER_HEIGHT);
+        IL::Fixed velocity = jumpForce;
+        int32_t left = surface.minX;
+        int32_t right = left + PLAYER_WIDTH;
+        int32_t height = PLAYER_HEIGHT;
+        uint8_t grounded = 0;
+        IL::BodyArrays body = { &y, &velocity, &left, &right, &height, &grounded, 1 };
+
+        int ticks = 0;
+        surface.apexY = surface.top - PLAYER_HEIGHT;
+        while (velocity < 0 && ticks < MAX_FLIGHT_TICKS) {
+            IL::StepBodiesScalar(body, fall, ledges.data(), ledges.size());
+            surface.apexY = std::min(surface.apexY, IL::FixedToCell(y));
+            ticks++;
+        }
+        riseTicks = std::max(riseTicks, ticks);
+    }
+
+    routes.assign(stands.size() * surfaces.size(), Route());
+    knownRoutes = 0;
+
+    open.clear();
+    open.reserve(stands.size() * NAV_MOVES + 1);
+    cost.assign(stands.size(), 0);
+    parent.assign(stands.size(), -1);
+    parentMove.assign(stands.size(), 0);
+    seen.assign(stands.size(), 0);
+    closed.assign(stands.size(), 0);
+    frontier.clear();
+    frontier.reserve(stands.size());
+    search = 0;
+}
+
+int NavGraph::StandAt(int x, int y) const {
+    if (x < 0 || x >= columns || y < 0 || y >= rows) {
+        return -1;
+    }
+    return standAt[static_cast<size_t>(y) * columns + x];
+}
+
+int NavGraph::DropAt(int x, int y) const {
+    int ticks = 0;
+    return Fly(std::clamp(x, 0, columns - 1), IL::CellsToFixed(y), 0, 0, ticks);
+}
+
+void NavGraph::FindReachable(std::span<const int> starts, std::vector<uint8_t>& reachable) {
+    reachable.assign(stands.size(), 0);
+    frontier.clear();
+    for (int start : starts) {
+        if (start >= 0 && !reachable[start]) {
+            reachable[start] = 1;
+            frontier.push_back(start);
+        }
+    }
+
+    // Breadth first, frontier holds every stand found so far and head walks it
+    for (size_t head = 0; head < frontier.size(); head++) {
+        const Stand& stand = stands[frontier[head]];
+        for (int move = 0; move < NAV_MOVES; move++) {
+            int next = stand.to[move];
+            if (next >= 0 && !reachable[next]) {
+                reachable[next] = 1;
+                frontier.push_back(next);
+            }
+        }
+    }
+}
+
+void NavGraph::FlyMoves() {
+    // Every move from every stand at once, as bodies stepped four at a time
+    size_t count = stands.size() * NAV_MOVES;
+    for (std::vector<int32_t>* array : { &flight.y, &flight.velocityY, &flight.left, &flight.right, &flight.height, &flight.direction, &flight.move }) {
+        array->resize(count);
+    }
+    flight.grounded.resize(count);
+
+    for (size_t i = 0; i < count; i++) {
+        const Stand& stand = stands[i / NAV_MOVES];
+        int move = static_cast<int>(i % NAV_MOVES);
+        flight.y[i] = IL::CellsToFixed(surfaces[stand.surface].top - PLAYER_HEIGHT);
+        flight.velocityY[i] = MOVE_JUMPS[move] ? jumpForce : 0;
+        flight.left[i] = stand.x;
+        flight.height[i] = PLAYER_HEIGHT;
+        flight.direction[i] = MOVE_DIRECTIONS[move];
+        flight.move[i] = static_cast<int32_t>(i);
+        stands[i / NAV_MOVES].to[move] = -1;
+        stands[i / NAV_MOVES].ticks[move] = 0;
+    }
+
+    // As UpdateGame plays the keys: step sideways inside the world, then fall. Landed moves are swapped out, so
+    // each tick only steps the ones still in the air.
+    size_t flying = count;
+    for (int tick = 1; tick <= MAX_FLIGHT_TICKS && flying > 0; tick++) {
+        for (size_t i = 0; i < flying; i++) {
+            flight.left[i] = std::clamp(flight.left[i] + flight.direction[i], 0, columns - 1);
+            flight.right[i] = flight.left[i] + PLAYER_WIDTH;
+        }
+
+        IL::BodyArrays bodies = { flight.y.data(), flight.velocityY.data(), flight.left.data(), flight.right.data(),
+                                  flight.height.data(), flight.grounded.data(), flying };
+        IL::StepBodies(bodies, fall, ledges.data(), ledges.size());
+
+        size_t kept = 0;
+        for (size_t i = 0; i < flying; i++) {
+            if (flight.grounded[i]) {
+                int from = flight.move[i] / NAV_MOVES;
+                int move = flight.move[i] % NAV_MOVES;
+                int landed = StandAt(flight.left[i], IL::FixedToCell(flight.y[i]));
+                stands[from].to[move] = landed != from ? landed : -1;
+                stands[from].ticks[move] = static_cast<uint16_t>(tick);
+                continue;
+            }
+
+            flight.y[kept] = flight.y[i];
+            flight.velocityY[kept] = flight.velocityY[i];
+            flight.left[kept] = flight.left[i];
+            flight.direction[kept] = flight.direction[i];
+            flight.move[kept] = flight.move[i];
+            kept++;
+        }
+        flying = kept;
+    }
+}
+
+int NavGraph::Fly(int x, IL::Fixed y, IL::Fixed velocity, int direction, int& ticks) const {
+    int32_t left = x;
+    int32_t right = left + PLAYER_WIDTH;
+    int32_t height = PLAYER_HEIGHT;
+    uint8_t grounded = 0;
+    IL::BodyArrays body = { &y, &velocity, &left, &right, &height, &grounded, 1 };
+
+    // As FlyMoves, for a single body
+    for (ticks = 1; ticks <= MAX_FLIGHT_TICKS; ticks++) {
+        left = std::clamp(left + direction, 0, columns - 1);
+        right = left + PLAYER_WIDTH;
+
+        IL::StepBodiesScalar(body, fall, ledges.data(), ledges.size());
+        if (grounded) {
+            return StandAt(left, IL::FixedToCell(y));
+        }
+    }
+
+    return -1;
+}
+
+int NavGraph::Distance(int x, const Surface& surface) const {
+    if (x < surface.minX) {
+        return surface.minX - x;
+    }
+    return x > surface.maxX ? x - surface.maxX : 0;
+}
+
+const NavGraph::Route& NavGraph::FindRoute(int stand, int surface) {
+    Route& route = routes[static_cast<size_t>(stand) * surfaces.size() + surface];
+    if (route.ticks < 0) {
+        if (stands[stand].surface == surface) {
+            route.ticks = 0;
+            route.arrivalX = stands[stand].x;
+            knownRoutes++;
+        } else {
+            Search(stand, surface);
+        }
+    }
+    return route;
+}
+
+void NavGraph::Search(int start, int goal) {
+    searches++;
+    if (++search == 0) {
+        // Stamps wrapped, forget the old ones rather than mistake them for this search's
+        std::fill(seen.begin(), seen.end(), 0);
+        std::fill(closed.begin(), closed.end(), 0);
+        search = 1;
+    }
+
+    const Surface& target = surfaces[goal];
+    size_t surfaceCount = surfaces.size();
+    // Ties go to the lower stand, so routes do not depend on the heap's layout
+    auto later = [](const Open& a, const Open& b) {
+        return a.estimate != b.estimate ? a.estimate > b.estimate : a.stand > b.stand;
+    };
+
+    open.clear();
+    cost[start] = 0;
+    parent[start] = -1;
+    seen[start] = search;
+    open.push_back({ Distance(stands[start].x, target), start });
+
+    int found = -1;
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), later);
+        int current = open.back().stand;
+        open.pop_back();
+        if (closed[current] == search) {
+            continue;
+        }
+        closed[current] = search;
+
+        if (stands[current].surface == goal) {
+            found = current;
+            break;
+        }
+
+        const Stand& stand = stands[current];
+        for (int move = 0; move < NAV_MOVES; move++) {
+            int next = stand.to[move];
+            if (next < 0 || closed[next] == search) {
+                continue;
+            }
+
+            int32_t reached = cost[current] + stand.ticks[move];
+            if (seen[next] != search || reached < cost[next]) {
+                seen[next] = search;
+                cost[next] = reached;
+                parent[next] = current;
+                parentMove[next] = static_cast<uint8_t>(move);
+                open.push_back({ reached + Distance(stands[next].x, target), next });
+                std::push_heap(open.begin(), open.end(), later);
+            }
+        }
+    }
+
+    if (found < 0) {
+        // Nothing the search reached leads to the surface
+        for (int i = 0; i < static_cast<int>(stands.size()); i++) {
+            Route& route = routes[static_cast<size_t>(i) * surfaceCount + goal];
+            if (closed[i] == search && route.ticks < 0) {
+                route.ticks = UNREACHABLE;
+                knownRoutes++;
+            }
+        }
+        return;
+    }
+
+    // Only the start learns its route: stands further along could have other routes just as quick, and which one
+    // they kept would then depend on the order routes were asked for
+    int first = found;
+    while (parent[first] != start) {
+        first = parent[first];
+    }
+
+    Route& route = routes[static_cast<size_t>(start) * surfaceCount + goal];
+    route.ticks = cost[found];
+    route.arrivalX = stands[found].x;
+    route.move = static_cast<NavMove>(parentMove[first]);
+    knownRoutes++;
+}
+
+void NavGraph::FindTargets(const State_t& state, std::vector<NavTarget>& targets) const {
+    targets.clear();
+    for (const Coin& coin : state.coins) {
+        uint64_t expires = state.timers.GetDeadline(coin.expiry);
+        if (!coin.active || expires == 0) {
+            continue;
+        }
+
+        for (int s = 0; s < static_cast<int>(surfaces.size()); s++) {
+            const Surface& surface = surfaces[s];
+
+            // The narrowest pose is four cells wide, from x - 3 to x every pose touches the coin's column. Walking
+            // squashes the body a row down, so only the lower four rows are reached without jumping.
+            int left = std::max(surface.minX, coin.x - (PLAYER_WIDTH - 2));
+            int right = std::min(surface.maxX, coin.x);
+            if (left > right || coin.y >= surface.top || coin.y < surface.apexY) {
+                continue;
+            }
+
+            bool jump = coin.y < surface.top - (PLAYER_HEIGHT - 1);
+            targets.push_back({ s, left, right, jump, coin.value, expires });
+        }
+    }
+}
+
+NavKeys NavBot::Think(NavGraph& graph, int x, int y, bool grounded, std::span<const NavTarget> targets, uint64_t now) {
+    NavKeys keys;
+    if (!grounded) {
+        keys.left = flightDirection < 0;
+        keys.right = flightDirection > 0;
+        return keys;
+    }
+
+    flightDirection = 0;
+    target = -1;
+    int stand = graph.StandAt(x, y);
+    if (stand < 0) {
+        return keys;
+    }
+
+    // The most coin per tick of travel, counting the walk from where the route lands and the jump up to the coin
+    const NavGraph::Route* best = nullptr;
+    int64_t bestValue = 0;
+    int64_t bestTicks = 1;
+    for (int i = 0; i < static_cast<int>(targets.size()); i++) {
+        const NavTarget& candidate = targets[i];
+        const NavGraph::Route& route = graph.FindRoute(stand, candidate.surface);
+        if (route.ticks == NavGraph::UNREACHABLE) {
+            continue;
+        }
+
+        int arrival = route.arrivalX;
+        int walk = arrival < candidate.left ? candidate.left - arrival : arrival > candidate.right ? arrival - candidate.right : 0;
+        int64_t ticks = static_cast<int64_t>(route.ticks) + walk + (candidate.jump ? graph.GetRiseTicks() : 0) + 1;
+        if (now + static_cast<uint64_t>(ticks) >= candidate.expires) {
+            continue;
+        }
+
+        if (best == nullptr || candidate.value * bestTicks > bestValue * ticks) {
+            best = &route;
+            bestValue = candidate.value;
+            bestTicks = ticks;
+            target = i;
+        }
+    }
+
+    if (best == nullptr) {
+        return keys;
+    }
+
+    const NavTarget& chosen = targets[target];
+    if (graph.SurfaceOf(stand) == chosen.surface) {
+        keys.left = x > chosen.right;
+        keys.right = x < chosen.left;
+        keys.jump = chosen.jump && !keys.left && !keys.right;
+        return keys;
+    }
+
+    flightDirection = MOVE_DIRECTIONS[best->move];
+    keys.left = flightDirection < 0;
+    keys.right = flightDirection > 0;
+    keys.jump = MOVE_JUMPS[best->move];
+    return keys;
+}
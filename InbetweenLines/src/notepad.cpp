@@ -1,15 +1,39 @@
 #include "notepad.h"
+#include "log.h"
+#include "pe.h"
+#include "sigscan.h"
 
+#include <algorithm>
 #include <format>
 #include <cstdlib>
 #include <thread>
 
 #undef ERROR
-#define INFO(x) MessageBoxA(nullptr, x, "InbetweenLines - Info", MB_OK)
-#define ERROR(x) MessageBoxA(nullptr, std::format("[!] {} ({}, {}:{})", x, __FUNCTION__, __FILE__, __LINE__).c_str(), "InbetweenLines - Error", MB_OK)
+#define INFO(...) IL_INFO(__VA_ARGS__)
+#define ERROR(...) IL_ERROR(__VA_ARGS__)
 
 using namespace IL; // InbetweenLines implementation file, this is fine
 
+// GDI colours of the palette, matching the classic console colours
+static constexpr COLORREF PALETTE[] = {
+    RGB(0, 0, 0),       RGB(128, 0, 0),     RGB(0, 128, 0),     RGB(128, 128, 0),
+    RGB(0, 0, 128),     RGB(128, 0, 128),   RGB(0, 128, 128),   RGB(192, 192, 192),
+    RGB(128, 128, 128), RGB(255, 0, 0),     RGB(0, 255, 0),     RGB(255, 255, 0),
+    RGB(0, 0, 255),     RGB(255, 0, 255),   RGB(0, 255, 255),   RGB(255, 255, 255),
+};
+
+// Where known notepad.exe builds keep the edit control's text handle, tried before scanning the module
+static constexpr uint32_t KNOWN_BUFFER_SLOTS[] = {
+    0x356C0, // Windows 10 notepad.exe
+};
+
+// Frames between checks that the slot still holds the edit control's text handle
+static constexpr int SLOT_CHECK_INTERVAL = 60;
+
+static COLORREF ToColorRef(Color color, COLORREF fallback) {
+    return color == Color::Default ? fallback : PALETTE[static_cast<int>(color) - 1];
+}
+
 // Keyboard hook procedure implementation
 LRESULT CALLBACK Notepad::KeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
     if (nCode < 0) {
@@ -84,46 +108,85 @@ LRESULT CALLBACK Notepad::EditWndProc(HWND hWnd, UINT message, WPARAM wParam, LP
                 CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY,
                 FIXED_PITCH | FF_MODERN, L"Consolas"
             );
+            HFONT hBoldFont = CreateFont(
+                fontHeight, fontWidth > 0 ? fontWidth : 0,
+                0, 0, FW_BOLD, FALSE, FALSE, FALSE,
+                DEFAULT_CHARSET, OUT_DEFAULT_PRECIS,
+                CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY,
+                FIXED_PITCH | FF_MODERN, L"Consolas"
+            );
             HFONT oldFont = (HFONT)SelectObject(memDC, hFont);
             
             // Set up text drawing with UTF-8 support
             SetTextColor(memDC, RGB(0, 0, 0));
             SetBkColor(memDC, RGB(255, 255, 255));
             SetBkMode(memDC, OPAQUE);
+            CellAttr currentAttr = DEFAULT_ATTR;
+            const CellAttr* attrs = pThis->frontAttrs.get();
             
             // Get text metrics
             TEXTMETRIC tm;
             GetTextMetrics(memDC, &tm);
             int lineHeight = fontHeight; // Use exact font height for consistent spacing
+
+            // Advance every cell by the same amount so glyphs from fallback fonts (CJK, emoji) keep the grid aligned
+            int cellAdvance[NOTEPAD_WIDTH];
+            for (int& advance : cellAdvance) {
+                advance = tm.tmAveCharWidth;
+            }
             
             // Draw each line of text with proper clipping
             for (int y = 0; y < NOTEPAD_HEIGHT; y++) {
                 // Calculate the Y position for this line
                 int yPos = y * lineHeight;
-                
-                // Define the rectangle where this line will be drawn
-                RECT lineRect = {
-                    0,              // Left
-                    yPos,           // Top
-                    width,          // Right
-                    yPos + lineHeight  // Bottom
-                };
-                
-                // Draw a complete line at a time with proper clipping
-                ExtTextOutW(
-                    memDC,
-                    0, yPos,
-                    ETO_CLIPPED | ETO_OPAQUE,
-                    &lineRect,
-                    &buffer[y * NOTEPAD_WIDTH],
-                    NOTEPAD_WIDTH,
-                    nullptr
-                );
+                const CellAttr* lineAttrs = &attrs[y * NOTEPAD_WIDTH];
+
+                // Draw one run of cells with the same attributes at a time, a monochrome line is a single call
+                int runStart = 0;
+                while (runStart < NOTEPAD_WIDTH) {
+                    int runEnd = runStart + 1;
+                    while (runEnd < NOTEPAD_WIDTH && lineAttrs[runEnd] == lineAttrs[runStart]) {
+                        runEnd++;
+                    }
+
+                    // Only touch the DC state when the attributes actually change
+                    const CellAttr& attr = lineAttrs[runStart];
+                    if (attr != currentAttr) {
+                        SetTextColor(memDC, ToColorRef(attr.fg, RGB(0, 0, 0)));
+                        SetBkColor(memDC, ToColorRef(attr.bg, RGB(255, 255, 255)));
+                        if ((attr.style & STYLE_BOLD) != (currentAttr.style & STYLE_BOLD)) {
+                            SelectObject(memDC, (attr.style & STYLE_BOLD) ? hBoldFont : hFont);
+                        }
+                        currentAttr = attr;
+                    }
+
+                    // Define the rectangle where this run will be drawn, the last run extends to the edge
+                    int xPos = runStart * tm.tmAveCharWidth;
+                    RECT runRect = {
+                        xPos,                                                       // Left
+                        yPos,                                                       // Top
+                        runEnd == NOTEPAD_WIDTH ? width : runEnd * tm.tmAveCharWidth, // Right
+                        yPos + lineHeight                                           // Bottom
+                    };
+
+                    ExtTextOutW(
+                        memDC,
+                        xPos, yPos,
+                        ETO_CLIPPED | ETO_OPAQUE,
+                        &runRect,
+                        &buffer[y * NOTEPAD_WIDTH + runStart],
+                        runEnd - runStart,
+                        cellAdvance
+                    );
+
+                    runStart = runEnd;
+                }
             }
             
             // Clean up font
             SelectObject(memDC, oldFont);
             DeleteObject(hFont);
+            DeleteObject(hBoldFont);
         }
         
         // Blit from memory DC to screen DC
@@ -170,8 +233,15 @@ Notepad::Notepad() {
         return;
     }
 
-    SetWindowLong(mainhWnd, GWL_STYLE, GetWindowLong(mainhWnd, GWL_STYLE) & ~WS_MAXIMIZEBOX & ~WS_SIZEBOX);
+    if (!ResolveBufferSlot()) {
+        return;
+    }
+
+    originalStyle = GetWindowLong(mainhWnd, GWL_STYLE);
+    GetWindowRect(mainhWnd, &originalRect);
+    SetWindowLong(mainhWnd, GWL_STYLE, originalStyle & ~WS_MAXIMIZEBOX & ~WS_SIZEBOX);
     SetWindowPos(mainhWnd, nullptr, 0, 0, 1365, 768, SWP_NOMOVE | SWP_NOZORDER);
+    reshaped = true;
 
     size_t charCount = NOTEPAD_WIDTH * NOTEPAD_HEIGHT;
     size_t utf16CharCount = charCount * 2;
@@ -200,7 +270,6 @@ Notepad::Notepad() {
 
     // Wipe out the text buffer
     memset(GetBuffer(), 0, utf16CharCount);
-    memset(this->backBuffer.get(), 0, utf16CharCount);
     Flush();
     
     // Install the keyboard hook to prevent user typing
@@ -217,14 +286,20 @@ Notepad::~Notepad() {
     // Uninstall the keyboard hook before destroying the notepad
     UninstallKeyboardHook();
 
-    // Restore the wndproc for the edit control
-    SetWindowLongPtr(editWnd, GWLP_WNDPROC, (LONG_PTR)oEditWndProc);
-    
-    // Clear the user data pointer
-    SetWindowLongPtr(editWnd, GWLP_USERDATA, 0);
-    
-    SetWindowLong(mainhWnd, GWL_STYLE, GetWindowLong(mainhWnd, GWL_STYLE) | WS_MAXIMIZEBOX | WS_SIZEBOX);
-    SetWindowPos(mainhWnd, nullptr, 0, 0, 1365, 768, SWP_NOMOVE | SWP_NOZORDER);
+    // Restore the wndproc for the edit control, unless the constructor gave up before subclassing it
+    if (oEditWndProc != nullptr) {
+        SetWindowLongPtr(editWnd, GWLP_WNDPROC, (LONG_PTR)oEditWndProc);
+        oEditWndProc = nullptr;
+
+        // Clear the user data pointer
+        SetWindowLongPtr(editWnd, GWLP_USERDATA, 0);
+    }
+
+    if (reshaped) {
+        SetWindowLong(mainhWnd, GWL_STYLE, originalStyle);
+        SetWindowPos(mainhWnd, nullptr, 0, 0, originalRect.right - originalRect.left,
+            originalRect.bottom - originalRect.top, SWP_NOMOVE | SWP_NOZORDER | SWP_FRAMECHANGED);
+    }
 }
 
 bool Notepad::InstallKeyboardHook() const {
@@ -247,7 +322,7 @@ bool Notepad::InstallKeyboardHook() const {
     s_keyboardHook = SetWindowsHookEx(WH_KEYBOARD, KeyboardProc, NULL, threadId);
     
     if (s_keyboardHook == NULL) {
-        ERROR(std::format("SetWindowsHookEx failed with error code: {}", GetLastError()).c_str());
+        ERROR("SetWindowsHookEx failed with error code: {}", GetLastError());
         return false;
     }
 
@@ -262,103 +337,126 @@ bool Notepad::UninstallKeyboardHook() const {
     
     bool result = UnhookWindowsHookEx(s_keyboardHook);
     if (!result) {
-        ERROR(std::format("UnhookWindowsHookEx failed with error code: {}", GetLastError()).c_str());
+        ERROR("UnhookWindowsHookEx failed with error code: {}", GetLastError());
     }
     
     s_keyboardHook = NULL;
     return result;
 }
 
-void Notepad::Text(const std::string_view& text, int x, int y, bool widthEqualsHeight) {
-    wchar_t* buffer = GetBuffer();
-    if (buffer == nullptr) {
-        ERROR("Failed to get text buffer address");
-        return;
+void Notepad::Flush() {
+    // Invalidate without erasing the background
+    if (editWnd) {
+        InvalidateRect(editWnd, nullptr, FALSE);
     }
+}
 
-    // Calculate the index to write to
-    size_t index = (y * NOTEPAD_WIDTH) + (widthEqualsHeight ? x * 2 : x);
-    
-    // Convert UTF-8 string to UTF-16 (Windows Unicode)
-    std::wstring wtext;
-    int requiredSize = MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0);
-    if (requiredSize > 0) {
-        wtext.resize(requiredSize);
-        MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), &wtext[0], requiredSize);
-    }
-    
-    // Check if we're going out of bounds
-    if (index + wtext.length() > NOTEPAD_WIDTH * NOTEPAD_HEIGHT) {
-        ERROR("Write out of bounds");
-        return;
+wchar_t* Notepad::GetBuffer() {
+    HLOCAL* slot = s_bufferSlot.load(std::memory_order_acquire);
+    if (slot == nullptr || *slot == nullptr) {
+        return nullptr;
     }
 
-    // Copy the text to the buffer
-    memcpy(&this->backBuffer.get()[index], wtext.c_str(), wtext.length() * sizeof(wchar_t));
+    // The edit control's text is moveable local memory, the handle points at the current buffer address
+    return *reinterpret_cast<wchar_t**>(*slot);
+}
+
+static bool IsDataSection(const PeSection& section) {
+    return (section.characteristics & PE_SECTION_WRITE) != 0 && (section.characteristics & PE_SECTION_EXECUTE) == 0;
 }
 
-void Notepad::Rectangle(int x, int y, int width, int height, bool fill, bool widthEqualsHeight, wchar_t fillChar) {
-    if (widthEqualsHeight) {
-        x *= 2;
-        width *= 2;
+bool Notepad::ResolveBufferSlot() {
+    const uint8_t* module = reinterpret_cast<const uint8_t*>(GetModuleHandle(nullptr));
+
+    // The headers fit in the first page of the loaded module
+    PeImage image;
+    if (!ParsePeImage(module, 0x1000, image)) {
+        ERROR("Failed to parse the notepad.exe headers");
+        s_bufferSlot = nullptr;
+        return false;
     }
 
-    wchar_t* buffer = GetBuffer();
-    if (buffer == nullptr) {
-        ERROR("Failed to get text buffer address");
-        return;
+    HLOCAL handle = reinterpret_cast<HLOCAL>(SendMessage(editWnd, EM_GETHANDLE, 0, 0));
+
+    // Known builds first, the slot must lie in a data section and hold the edit control's handle
+    for (uint32_t rva : KNOWN_BUFFER_SLOTS) {
+        bool inData = false;
+        for (const PeSection& section : image.sections) {
+            uint32_t size = max(section.virtualSize, section.rawSize);
+            inData |= IsDataSection(section) && rva >= section.virtualAddress && rva + sizeof(HLOCAL) <= section.virtualAddress + size;
+        }
+
+        HLOCAL* slot = reinterpret_cast<HLOCAL*>(const_cast<uint8_t*>(module) + rva);
+        if (!inData || (handle != nullptr && *slot != handle)) {
+            continue;
+        }
+
+        if (handle == nullptr) {
+            IL_WARN("EM_GETHANDLE returned nothing, using notepad.exe+{:#x} unverified", rva);
+        }
+        INFO("Edit buffer handle found at known slot notepad.exe+{:#x}", rva);
+        s_bufferSlot = slot;
+        return true;
     }
 
-    // Ensure we don't draw outside the buffer boundaries
-    int endX = min(x + width, NOTEPAD_WIDTH);
-    int endY = min(y + height, NOTEPAD_HEIGHT);
+    if (handle == nullptr) {
+        ERROR("Edit control has no text handle to look for");
+        s_bufferSlot = nullptr;
+        return false;
+    }
 
-    // Draw the rectangle ensuring we always have borders
-    for (int j = y; j < endY; j++) {
-        for (int i = x; i < endX; i++) {
-            int index = (j * NOTEPAD_WIDTH) + i;
-            if (index < 0 || index >= NOTEPAD_WIDTH * NOTEPAD_HEIGHT) {
-                continue;  // Skip if outside buffer
+    // Unknown build, look for a pointer aligned copy of the handle in the module's data
+    Signature signature = Signature::FromBytes(&handle, sizeof(handle));
+    for (const PeSection& section : image.sections) {
+        if (!IsDataSection(section)) {
+            continue;
+        }
+
+        std::span<const uint8_t> bytes = PeSectionBytes(module, image.sizeOfImage, section, true);
+        size_t offset = 0;
+        while (offset < bytes.size()) {
+            size_t found = FindSignature(bytes.data() + offset, bytes.size() - offset, signature);
+            if (found == SIZE_MAX) {
+                break;
             }
-            bool isBorder = (i == x || i == endX - 1 || j == y || j == endY - 1);
-            if (fill || isBorder) {
-                this->backBuffer.get()[index] = fillChar;
+
+            const uint8_t* at = bytes.data() + offset + found;
+            if (reinterpret_cast<uintptr_t>(at) % alignof(HLOCAL) == 0) {
+                INFO("Edit buffer handle found by scanning at notepad.exe+{:#x}", at - module);
+                s_bufferSlot = reinterpret_cast<HLOCAL*>(const_cast<uint8_t*>(at));
+                return true;
             }
+            offset += found + 1;
         }
     }
-}
 
-void Notepad::Flush() {
-    // Invalidate without erasing the background
-    if (editWnd) {
-        InvalidateRect(editWnd, nullptr, FALSE);
-    }
+    ERROR("Failed to locate the edit control's text handle in notepad.exe");
+    s_bufferSlot = nullptr;
+    return false;
 }
 
-wchar_t* Notepad::GetBuffer() {
-    return (wchar_t*)**(uintptr_t**)((uintptr_t)GetModuleHandle(nullptr) + 0x356C0);
-}
-
-void Notepad::Begin() {
-    // Clear the back buffer completely - note that Begin() is no longer const
-    if (backBuffer) {
-        size_t bufferSize = NOTEPAD_WIDTH * NOTEPAD_HEIGHT * sizeof(wchar_t);
-        ZeroMemory(backBuffer.get(), bufferSize);
+void Notepad::Present() {
+    // Notepad swapping the text handle (File > New and the like) is followed by the slot, only re-resolve if it went stale
+    if (++framesSinceSlotCheck >= SLOT_CHECK_INTERVAL) {
+        framesSinceSlotCheck = 0;
+        HLOCAL handle = reinterpret_cast<HLOCAL>(SendMessage(editWnd, EM_GETHANDLE, 0, 0));
+        HLOCAL* slot = s_bufferSlot.load(std::memory_order_acquire);
+        if (handle != nullptr && (slot == nullptr || *slot != handle)) {
+            IL_WARN("Edit buffer slot went stale, locating it again");
+            ResolveBufferSlot();
+        }
     }
-}
 
-void Notepad::End(int targetFPS) {
-    // Ensure we have valid buffers
+    // Ensure we have a buffer to present to
     wchar_t* frontBuffer = GetBuffer();
-    if (!frontBuffer || !backBuffer) {
+    if (!frontBuffer) {
         ERROR("Invalid buffer pointers");
         return;
     }
-    
-    // Calculate frame timing for consistent FPS
-    static std::chrono::steady_clock::time_point lastTime = std::chrono::steady_clock::now();
+
+    // Calculate frame timing for consistent FPS, the frame was already composited so that counts towards it
     auto currentTime = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - lastTime).count();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - lastPresent).count();
     
     // Sleep for frame timing if needed
     int delay = 1000 / targetFPS - static_cast<int>(elapsed);
@@ -366,11 +464,13 @@ void Notepad::End(int targetFPS) {
         std::this_thread::sleep_for(std::chrono::milliseconds(delay));
     }
     
-    lastTime = std::chrono::steady_clock::now();
+    lastPresent = std::chrono::steady_clock::now();
     
-    // Swap buffers in one atomic operation
-    size_t bufferSize = NOTEPAD_WIDTH * NOTEPAD_HEIGHT * sizeof(wchar_t);
-    memcpy(frontBuffer, backBuffer.get(), bufferSize);
+    // Cells are UTF-16 code units on both sides
+    static_assert(sizeof(wchar_t) == sizeof(Cell), "Notepad's buffer holds UTF-16 code units");
+    memcpy(frontBuffer, GetCells(), NOTEPAD_CELLS * sizeof(Cell));
+    memcpy(frontAttrs.get(), GetAttrs(), NOTEPAD_CELLS * sizeof(CellAttr));
+    frameRing.Publish(GetCells(), GetAttrs());
     
     // Request a repaint WITHOUT erasing the background
     if (editWnd) {
@@ -380,5 +480,5 @@ void Notepad::End(int targetFPS) {
 }
 
 bool Notepad::IsValid() const {
-    return (editWnd != nullptr && backBuffer != nullptr && GetBuffer() != nullptr);
+    return (editWnd != nullptr && GetBuffer() != nullptr);
 }
\ No newline at end of file
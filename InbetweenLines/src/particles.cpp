@@ -0,0 +1,237 @@
+#include "particles.h"
+
+#include <cmath>
+#include <emmintrin.h>
+
+using namespace IL;
+
+namespace {
+    // Arrays are padded to whole groups of four so the SSE2 loops never need a scalar tail
+    size_t PadToGroup(size_t count) {
+        return (count + 3) & ~size_t(3);
+    }
+
+    // Unit vectors for 256 directions, a cell grid cannot show the difference and bursts skip sin and cos per particle
+    constexpr int DIRECTIONS = 256;
+
+    struct DirectionTable {
+        float cosines[DIRECTIONS];
+        float sines[DIRECTIONS];
+
+        DirectionTable() {
+            for (int i = 0; i < DIRECTIONS; i++) {
+                double angle = i * 6.283185307179586 / DIRECTIONS;
+                cosines[i] = static_cast<float>(std::cos(angle));
+                sines[i] = static_cast<float>(std::sin(angle));
+            }
+        }
+    };
+
+    const DirectionTable DIRECTION_TABLE;
+}
+
+ParticlePool::ParticlePool(size_t capacity, uint32_t seed)
+    : capacity(capacity), random(seed != 0 ? seed : 0x9E3779B9u) {
+    size_t padded = PadToGroup(capacity);
+    for (std::vector<float>* array : { &x, &y, &velocityX, &velocityY, &gravity, &age, &life }) {
+        array->resize(padded);
+    }
+    style.resize(padded);
+    splatIndices.resize(padded);
+    splatProgress.resize(padded);
+    splatCells.resize(padded);
+    splatAttrs.resize(padded);
+}
+
+int ParticlePool::AddStyle(std::u16string_view ramp, CellAttr attr) {
+    if (styles.size() == MAX_STYLES || ramp.empty()) {
+        return -1;
+    }
+
+    Style added = {};
+    added.length = static_cast<int>(ramp.size() < MAX_RAMP ? ramp.size() : MAX_RAMP);
+    for (int i = 0; i < added.length; i++) {
+        added.ramp[i] = ramp[i];
+    }
+    added.attr = attr;
+    styles.push_back(added);
+    return static_cast<int>(styles.size() - 1);
+}
+
+void ParticlePool::SetBounds(float width, float height) {
+    boundsWidth = width;
+    boundsHeight = height;
+}
+
+float ParticlePool::NextFloat() {
+    // xorshift32, the top 24 bits fill a float's mantissa
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    return (random >> 8) * (1.0f / 16777216.0f);
+}
+
+bool ParticlePool::Emit(float px, float py, float vx, float vy, float g, int lifetime, int styleIndex) {
+    if (count == capacity || styleIndex < 0 || styleIndex >= static_cast<int>(styles.size()) || lifetime <= 0) {
+        return false;
+    }
+
+    x[count] = px;
+    y[count] = py;
+    velocityX[count] = vx;
+    velocityY[count] = vy;
+    gravity[count] = g;
+    age[count] = 0.0f;
+    life[count] = static_cast<float>(lifetime);
+    style[count] = static_cast<uint8_t>(styleIndex);
+    count++;
+    return true;
+}
+
+void ParticlePool::EmitFrom(const EmitterConfig& config, float px, float py) {
+    float angle = config.direction + (NextFloat() * 2.0f - 1.0f) * config.spread;
+    int direction = static_cast<int>(std::lround(angle * (DIRECTIONS / 6.283185307179586f))) & (DIRECTIONS - 1);
+    float speed = config.speedMin + NextFloat() * (config.speedMax - config.speedMin);
+    int lifetime = config.lifeMin + static_cast<int>(NextFloat() * (config.lifeMax - config.lifeMin + 1));
+    Emit(px, py, DIRECTION_TABLE.cosines[direction] * speed * config.stretchX, DIRECTION_TABLE.sines[direction] * speed,
+        config.gravity, lifetime, config.style);
+}
+
+void ParticlePool::Burst(const EmitterConfig& config, float px, float py) {
+    int total = static_cast<int>(config.rate);
+    for (int i = 0; i < total; i++) {
+        EmitFrom(config, px, py);
+    }
+}
+
+void ParticlePool::Remove(size_t i) {
+    count--;
+    x[i] = x[count];
+    y[i] = y[count];
+    velocityX[i] = velocityX[count];
+    velocityY[i] = velocityY[count];
+    gravity[i] = gravity[count];
+    age[i] = age[count];
+    life[i] = life[count];
+    style[i] = style[count];
+}
+
+void ParticlePool::Cull(bool simd) {
+    const __m128 right = _mm_set1_ps(boundsWidth);
+    const __m128 bottom = _mm_set1_ps(boundsHeight);
+    const __m128 zero = _mm_setzero_ps();
+
+    size_t i = 0;
+    while (i < count) {
+        // Skip whole groups where everyone lives, only groups with a death fall through to the scalar check
+        if (simd && i + 4 <= count) {
+            __m128 alive = _mm_cmplt_ps(_mm_loadu_ps(&age[i]), _mm_loadu_ps(&life[i]));
+            __m128 px = _mm_loadu_ps(&x[i]);
+            alive = _mm_and_ps(alive, _mm_cmpge_ps(px, zero));
+            alive = _mm_and_ps(alive, _mm_cmplt_ps(px, right));
+            alive = _mm_and_ps(alive, _mm_cmplt_ps(_mm_loadu_ps(&y[i]), bottom));
+            if (_mm_movemask_ps(alive) == 0xF) {
+                i += 4;
+                continue;
+            }
+        }
+
+        bool alive = age[i] < life[i] && x[i] >= 0.0f && x[i] < boundsWidth && y[i] < boundsHeight;
+        if (alive) {
+            i++;
+        } else {
+            Remove(i); // The particle moved into i is checked next
+        }
+    }
+}
+
+void ParticlePool::Update() {
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (size_t i = 0; i < count; i += 4) {
+        __m128 vx = _mm_loadu_ps(&velocityX[i]);
+        __m128 vy = _mm_loadu_ps(&velocityY[i]);
+        _mm_storeu_ps(&x[i], _mm_add_ps(_mm_loadu_ps(&x[i]), vx));
+        _mm_storeu_ps(&y[i], _mm_add_ps(_mm_loadu_ps(&y[i]), vy));
+        _mm_storeu_ps(&velocityY[i], _mm_add_ps(vy, _mm_loadu_ps(&gravity[i])));
+        _mm_storeu_ps(&age[i], _mm_add_ps(_mm_loadu_ps(&age[i]), one));
+    }
+
+    Cull(true);
+}
+
+void ParticlePool::UpdateScalar() {
+    for (size_t i = 0; i < count; i++) {
+        x[i] += velocityX[i];
+        y[i] += velocityY[i];
+        velocityY[i] += gravity[i];
+        age[i] += 1.0f;
+    }
+
+    Cull(false);
+}
+
+void ParticlePool::Render(Canvas& canvas) const {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 width = _mm_set1_ps(static_cast<float>(CANVAS_WIDTH));
+    const __m128 height = _mm_set1_ps(static_cast<float>(CANVAS_HEIGHT));
+    const __m128i outside = _mm_set1_epi32(-1);
+
+    // Cell index and how far through its life every particle is, particles off the canvas get index -1
+    for (size_t i = 0; i < count; i += 4) {
+        __m128 px = _mm_loadu_ps(&x[i]);
+        __m128 py = _mm_loadu_ps(&y[i]);
+        __m128 inside = _mm_and_ps(_mm_cmpge_ps(px, zero), _mm_cmplt_ps(px, width));
+        inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpge_ps(py, zero), _mm_cmplt_ps(py, height)));
+
+        // Whole cells, then row * width + column in float, exact far beyond the canvas size
+        __m128 column = _mm_cvtepi32_ps(_mm_cvttps_epi32(px));
+        __m128 row = _mm_cvtepi32_ps(_mm_cvttps_epi32(py));
+        __m128i index = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(row, width), column));
+        __m128i mask = _mm_castps_si128(inside);
+        index = _mm_or_si128(_mm_and_si128(mask, index), _mm_andnot_si128(mask, outside));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&splatIndices[i]), index);
+        _mm_storeu_ps(&splatProgress[i], _mm_div_ps(_mm_loadu_ps(&age[i]), _mm_loadu_ps(&life[i])));
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const Style& look = styles[style[i]];
+        int stage = static_cast<int>(splatProgress[i] * look.length);
+        splatCells[i] = look.ramp[stage < look.length ? stage : look.length - 1];
+        splatAttrs[i] = look.attr;
+    }
+
+    canvas.Splat(splatIndices.data(), splatCells.data(), splatAttrs.data(), count);
+}
+
+void ParticleEmitter::MoveTo(float newX, float newY) {
+    x = newX;
+    y = newY;
+}
+
+void ParticleEmitter::Update(ParticlePool& pool) {
+    if (config.kind == EmitterKind::Burst) {
+        if (!done) {
+            pool.Burst(config, x, y);
+            done = true;
+        }
+        return;
+    }
+
+    carry += config.rate;
+    int total = static_cast<int>(carry);
+    carry -= total;
+
+    for (int i = 0; i < total; i++) {
+        if (config.kind == EmitterKind::Trail) {
+            // Evenly along the way from the last tick's position, ending at the current one
+            float t = static_cast<float>(i + 1) / total;
+            pool.EmitFrom(config, lastX + (x - lastX) * t, lastY + (y - lastY) * t);
+        } else {
+            pool.EmitFrom(config, x, y);
+        }
+    }
+
+    lastX = x;
+    lastY = y;
+}
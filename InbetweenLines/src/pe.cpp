@@ -0,0 +1,78 @@
+#include "pe.h"
+
+#include <cstring>
+
+using namespace IL;
+
+template<typename T>
+static bool Read(const uint8_t* image, size_t size, size_t offset, T& out) {
+    if (offset > size || size - offset < sizeof(T)) {
+        return false;
+    }
+    memcpy(&out, image + offset, sizeof(T));
+    return true;
+}
+
+bool IL::ParsePeImage(const uint8_t* image, size_t size, PeImage& out) {
+    uint16_t dosMagic = 0;
+    uint32_t peOffset = 0;
+    if (!Read(image, size, 0, dosMagic) || dosMagic != 0x5A4D || !Read(image, size, 0x3C, peOffset)) {
+        return false;
+    }
+
+    uint32_t peMagic = 0;
+    if (!Read(image, size, peOffset, peMagic) || peMagic != 0x00004550) {
+        return false;
+    }
+
+    // IMAGE_FILE_HEADER follows the signature, the optional header follows that
+    size_t fileHeader = peOffset + 4;
+    uint16_t sectionCount = 0;
+    uint16_t optionalHeaderSize = 0;
+    if (!Read(image, size, fileHeader, out.machine) ||
+        !Read(image, size, fileHeader + 2, sectionCount) ||
+        !Read(image, size, fileHeader + 4, out.timeDateStamp) ||
+        !Read(image, size, fileHeader + 16, optionalHeaderSize)) {
+        return false;
+    }
+
+    // SizeOfImage sits at the same offset in PE32 and PE32+
+    size_t optionalHeader = fileHeader + 20;
+    if (optionalHeaderSize < 60 || !Read(image, size, optionalHeader + 56, out.sizeOfImage)) {
+        return false;
+    }
+
+    size_t sectionTable = optionalHeader + optionalHeaderSize;
+    out.sections.clear();
+    out.sections.reserve(sectionCount);
+    for (uint16_t i = 0; i < sectionCount; i++) {
+        size_t header = sectionTable + i * 40;
+        PeSection section;
+        if (header > size || size - header < 40) {
+            return false;
+        }
+
+        memcpy(section.name, image + header, 8);
+        Read(image, size, header + 8, section.virtualSize);
+        Read(image, size, header + 12, section.virtualAddress);
+        Read(image, size, header + 16, section.rawSize);
+        Read(image, size, header + 20, section.rawOffset);
+        Read(image, size, header + 36, section.characteristics);
+        out.sections.push_back(section);
+    }
+
+    return true;
+}
+
+std::span<const uint8_t> IL::PeSectionBytes(const uint8_t* image, size_t size, const PeSection& section, bool mapped) {
+    // Loaded sections span their virtual size (the tail past the raw data is zero filled), on disk only the raw data exists
+    size_t offset = mapped ? section.virtualAddress : section.rawOffset;
+    size_t length = mapped && section.virtualSize != 0 ? section.virtualSize : section.rawSize;
+    if (offset >= size) {
+        return {};
+    }
+    if (length > size - offset) {
+        length = size - offset;
+    }
+    return { image + offset, length };
+}
@@ -0,0 +1,121 @@
+#include "physics.h"
+
+#include <climits>
+#include <emmintrin.h>
+
+using namespace IL;
+
+namespace {
+    // Moves one body, the same steps as a lane of the SSE2 loop
+    void StepBody(const BodyArrays& bodies, size_t i, const FallRules& rules, const Ledge* ledges, size_t ledgeCount) {
+        Fixed velocity = bodies.velocityY[i] + rules.gravity;
+        if (velocity > rules.terminalVelocity) {
+            velocity = rules.terminalVelocity;
+        }
+
+        Fixed y = bodies.y[i] + velocity;
+        if (y < 0) {
+            y = 0;
+            velocity = 0;
+        }
+
+        // Sweep the bottom edge over the move, the highest top it crosses wins
+        Fixed height = CellsToFixed(bodies.height[i]);
+        Fixed from = bodies.y[i] + height;
+        Fixed to = y + height;
+        Fixed landing = INT_MAX;
+        if (velocity > 0) {
+            for (size_t l = 0; l < ledgeCount; l++) {
+                Fixed top = CellsToFixed(ledges[l].top);
+                bool overlaps = bodies.right[i] > ledges[l].left && bodies.left[i] < ledges[l].right;
+                if (overlaps && from <= top && to >= top && top < landing) {
+                    landing = top;
+                }
+            }
+        }
+
+        Fixed floor = CellsToFixed(rules.floor);
+        if (to >= floor && floor < landing) {
+            landing = floor;
+        }
+
+        bool landed = landing != INT_MAX;
+        if (landed) {
+            y = landing - height;
+            velocity = 0;
+        }
+
+        bodies.y[i] = y;
+        bodies.velocityY[i] = velocity;
+        bodies.grounded[i] = landed ? 1 : 0;
+    }
+
+    // a where mask is set, b elsewhere
+    __m128i Select(__m128i mask, __m128i a, __m128i b) {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+}
+
+void IL::StepBodies(const BodyArrays& bodies, const FallRules& rules, const Ledge* ledges, size_t ledgeCount) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i gravity = _mm_set1_epi32(rules.gravity);
+    const __m128i terminal = _mm_set1_epi32(rules.terminalVelocity);
+    const __m128i floor = _mm_set1_epi32(CellsToFixed(rules.floor));
+    const __m128i none = _mm_set1_epi32(INT_MAX);
+
+    size_t i = 0;
+    for (; i + 4 <= bodies.count; i += 4) {
+        __m128i start = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&bodies.y[i]));
+        __m128i velocity = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&bodies.velocityY[i])), gravity);
+        velocity = Select(_mm_cmpgt_epi32(velocity, terminal), terminal, velocity);
+
+        __m128i y = _mm_add_epi32(start, velocity);
+        __m128i above = _mm_cmplt_epi32(y, zero);
+        y = _mm_andnot_si128(above, y);
+        velocity = _mm_andnot_si128(above, velocity);
+
+        __m128i height = _mm_slli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&bodies.height[i])), FIXED_SHIFT);
+        __m128i from = _mm_add_epi32(start, height);
+        __m128i to = _mm_add_epi32(y, height);
+        __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&bodies.left[i]));
+        __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&bodies.right[i]));
+        __m128i falling = _mm_cmpgt_epi32(velocity, zero);
+
+        // Every ledge against all four bodies, lanes keep the highest top crossed
+        __m128i landing = none;
+        if (_mm_movemask_epi8(falling) != 0) {
+            for (size_t l = 0; l < ledgeCount; l++) {
+                __m128i top = _mm_set1_epi32(CellsToFixed(ledges[l].top));
+                __m128i overlaps = _mm_and_si128(_mm_cmpgt_epi32(right, _mm_set1_epi32(ledges[l].left)),
+                                                 _mm_cmplt_epi32(left, _mm_set1_epi32(ledges[l].right)));
+                __m128i crosses = _mm_andnot_si128(_mm_or_si128(_mm_cmpgt_epi32(from, top), _mm_cmpgt_epi32(top, to)), overlaps);
+                __m128i higher = _mm_and_si128(_mm_and_si128(crosses, falling), _mm_cmplt_epi32(top, landing));
+                landing = Select(higher, top, landing);
+            }
+        }
+
+        __m128i onFloor = _mm_andnot_si128(_mm_cmpgt_epi32(floor, to), _mm_cmplt_epi32(floor, landing));
+        landing = Select(onFloor, floor, landing);
+
+        __m128i landed = _mm_xor_si128(_mm_cmpeq_epi32(landing, none), _mm_set1_epi32(-1));
+        y = Select(landed, _mm_sub_epi32(landing, height), y);
+        velocity = _mm_andnot_si128(landed, velocity);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&bodies.y[i]), y);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&bodies.velocityY[i]), velocity);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(landed));
+        for (int lane = 0; lane < 4; lane++) {
+            bodies.grounded[i + lane] = (mask >> lane) & 1;
+        }
+    }
+
+    for (; i < bodies.count; i++) {
+        StepBody(bodies, i, rules, ledges, ledgeCount);
+    }
+}
+
+void IL::StepBodiesScalar(const BodyArrays& bodies, const FallRules& rules, const Ledge* ledges, size_t ledgeCount) {
+    for (size_t i = 0; i < bodies.count; i++) {
+        StepBody(bodies, i, rules, ledges, ledgeCount);
+    }
+}
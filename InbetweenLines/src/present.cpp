@@ -0,0 +1,90 @@
+#include "present.h"
+#include "cellwidth.h"
+
+using namespace IL;
+
+// Appends the SGR parameters of a colour, 30-37/90-97 for foreground and 40-47/100-107 for background
+static void AppendColor(Color color, int base, std::string& out) {
+    int index = static_cast<int>(color);
+    if (index == 0) {
+        return;
+    }
+
+    int code = index <= 8 ? base + index - 1 : base + 60 + index - 9;
+    out += ';';
+    out += std::to_string(code);
+}
+
+static void AppendUtf8(char32_t codepoint, std::string& out) {
+    if (codepoint < 0x80) {
+        out += static_cast<char>(codepoint);
+    } else if (codepoint < 0x800) {
+        out += static_cast<char>(0xC0 | (codepoint >> 6));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else if (codepoint < 0x10000) {
+        out += static_cast<char>(0xE0 | (codepoint >> 12));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (codepoint >> 18));
+        out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+}
+
+// Appends the glyph at x of a line, returning the last cell it used (a surrogate pair takes two)
+static int AppendCell(const Cell* line, int x, int width, std::string& out) {
+    Cell cell = line[x];
+    if (cell == 0) {
+        out += ' ';
+    } else if (cell == CELL_CONTINUATION) {
+        // The terminal already advanced two columns for the wide glyph before it
+    } else if (cell >= 0xD800 && cell <= 0xDBFF && x + 1 < width && line[x + 1] >= 0xDC00 && line[x + 1] <= 0xDFFF) {
+        AppendUtf8(0x10000 + ((static_cast<char32_t>(cell) - 0xD800) << 10) + (line[x + 1] - 0xDC00), out);
+        x++;
+    } else {
+        AppendUtf8(static_cast<char32_t>(cell), out);
+    }
+    return x;
+}
+
+void IL::AppendAnsiFrame(const Cell* cells, const CellAttr* attrs, int width, int height, std::string& out) {
+    out += "\x1b[H\x1b[0m";
+
+    CellAttr current = DEFAULT_ATTR;
+    for (int y = 0; y < height; y++) {
+        const Cell* line = &cells[y * width];
+        const CellAttr* lineAttrs = &attrs[y * width];
+
+        for (int x = 0; x < width; x++) {
+            // Only emit an escape where a new run of attributes starts
+            if (lineAttrs[x] != current) {
+                current = lineAttrs[x];
+                out += "\x1b[0";
+                if (current.style & STYLE_BOLD) {
+                    out += ";1";
+                }
+                AppendColor(current.fg, 30, out);
+                AppendColor(current.bg, 40, out);
+                out += 'm';
+            }
+
+            x = AppendCell(line, x, width, out);
+        }
+
+        out += '\n';
+    }
+
+    out += "\x1b[0m";
+}
+
+void IL::AppendTextFrame(const Cell* cells, int width, int height, std::string& out) {
+    for (int y = 0; y < height; y++) {
+        const Cell* line = &cells[y * width];
+        for (int x = 0; x < width; x++) {
+            x = AppendCell(line, x, width, out);
+        }
+        out += '\n';
+    }
+}
@@ -0,0 +1,186 @@
+#include "sigscan.h"
+
+#include <cstring>
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SIGSCAN_AVX2
+#else
+#define SIGSCAN_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace IL;
+
+static int HexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool HasFixedByte(const Signature& signature) {
+    for (uint8_t m : signature.mask) {
+        if (m != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Signature::Parse(std::string_view text, Signature& out) {
+    out.bytes.clear();
+    out.mask.clear();
+
+    size_t i = 0;
+    while (i < text.size()) {
+        if (text[i] == ' ') {
+            i++;
+            continue;
+        }
+
+        if (text[i] == '?') {
+            i += (i + 1 < text.size() && text[i + 1] == '?') ? 2 : 1;
+            out.bytes.push_back(0);
+            out.mask.push_back(0);
+            continue;
+        }
+
+        int high = HexDigit(text[i]);
+        int low = i + 1 < text.size() ? HexDigit(text[i + 1]) : -1;
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        out.bytes.push_back(static_cast<uint8_t>(high << 4 | low));
+        out.mask.push_back(0xFF);
+        i += 2;
+    }
+
+    return HasFixedByte(out);
+}
+
+Signature Signature::FromBytes(const void* data, size_t size) {
+    Signature signature;
+    signature.bytes.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+    signature.mask.assign(size, 0xFF);
+    return signature;
+}
+
+static bool Matches(const uint8_t* at, const Signature& signature) {
+    for (size_t i = 0; i < signature.bytes.size(); i++) {
+        if ((at[i] & signature.mask[i]) != signature.bytes[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The first and last bytes that must match, they filter candidates before the full comparison
+struct Anchors {
+    size_t first = 0;
+    size_t last = 0;
+};
+
+static Anchors FindAnchors(const Signature& signature) {
+    Anchors anchors;
+    while (signature.mask[anchors.first] == 0) {
+        anchors.first++;
+    }
+    anchors.last = signature.mask.size() - 1;
+    while (signature.mask[anchors.last] == 0) {
+        anchors.last--;
+    }
+    return anchors;
+}
+
+size_t IL::FindSignatureScalar(const uint8_t* data, size_t size, const Signature& signature) {
+    size_t length = signature.bytes.size();
+    if (length == 0 || length > size) {
+        return SIZE_MAX;
+    }
+    if (!HasFixedByte(signature)) {
+        return 0;
+    }
+
+    Anchors anchors = FindAnchors(signature);
+    size_t end = size - length + 1; // Number of possible start positions
+    uint8_t first = signature.bytes[anchors.first];
+
+    const uint8_t* cursor = data + anchors.first;
+    const uint8_t* limit = data + anchors.first + end;
+    while (cursor < limit) {
+        const uint8_t* hit = static_cast<const uint8_t*>(memchr(cursor, first, limit - cursor));
+        if (hit == nullptr) {
+            break;
+        }
+
+        const uint8_t* start = hit - anchors.first;
+        if (Matches(start, signature)) {
+            return start - data;
+        }
+        cursor = hit + 1;
+    }
+
+    return SIZE_MAX;
+}
+
+SIGSCAN_AVX2 static size_t FindSignatureAvx2(const uint8_t* data, size_t size, const Signature& signature) {
+    size_t length = signature.bytes.size();
+    Anchors anchors = FindAnchors(signature);
+    size_t end = size - length + 1;
+
+    const __m256i first = _mm256_set1_epi8(static_cast<char>(signature.bytes[anchors.first]));
+    const __m256i last = _mm256_set1_epi8(static_cast<char>(signature.bytes[anchors.last]));
+
+    // Both anchor loads stay inside the buffer as long as all 32 start positions can hold a whole pattern
+    size_t i = 0;
+    for (; i + 32 <= end; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + anchors.first));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + anchors.last));
+        uint32_t candidates = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))));
+
+        while (candidates != 0) {
+#ifdef _MSC_VER
+            unsigned long bit;
+            _BitScanForward(&bit, candidates);
+#else
+            unsigned bit = __builtin_ctz(candidates);
+#endif
+            if (Matches(data + i + bit, signature)) {
+                return i + bit;
+            }
+            candidates &= candidates - 1;
+        }
+    }
+
+    // Fewer than 32 start positions left
+    size_t tail = FindSignatureScalar(data + i, size - i, signature);
+    return tail == SIZE_MAX ? SIZE_MAX : i + tail;
+}
+
+static bool HasAvx2() {
+#ifdef _MSC_VER
+    int info[4] = {};
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osSavesYmm && (info[1] & (1 << 5));
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+size_t IL::FindSignature(const uint8_t* data, size_t size, const Signature& signature) {
+    static const bool avx2 = HasAvx2();
+
+    size_t length = signature.bytes.size();
+    if (length == 0 || length > size) {
+        return SIZE_MAX;
+    }
+
+    if (!avx2 || !HasFixedByte(signature)) {
+        return FindSignatureScalar(data, size, signature);
+    }
+    return FindSignatureAvx2(data, size, signature);
+}
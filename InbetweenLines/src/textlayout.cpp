@@ -0,0 +1,233 @@
+#include "textlayout.h"
+#include "fixedtext.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace IL;
+
+namespace {
+    // The second cell of a wide glyph or the low half of a surrogate pair, lines never start or end inside one
+    bool IsGlyphStart(Cell cell) {
+        return cell != CELL_CONTINUATION && (cell < 0xDC00 || cell > 0xDFFF);
+    }
+}
+
+void TextLayout::Layout(std::string_view text, int width, int height, TextAlign align) {
+    this->width = std::max(width, 0);
+    lines = 0;
+    truncated = false;
+    glyphs.clear();
+    breaks.clear();
+
+    // Each paragraph is laid out into cells, then wrapped on its own
+    size_t begin = 0;
+    while (true) {
+        size_t end = std::min(text.find('\n', begin), text.size());
+        std::string_view paragraph = text.substr(begin, end - begin);
+
+        units.resize(Utf8ToUtf16(paragraph));
+        Utf8ToUtf16(paragraph, units.data(), units.size());
+
+        size_t start = glyphs.size();
+        glyphs.resize(start + LayoutCells(units.data(), units.size()));
+        LayoutCells(units.data(), units.size(), &glyphs[start], glyphs.size() - start);
+        Wrap(start, glyphs.size());
+
+        if (end == text.size()) {
+            break;
+        }
+        begin = end + 1;
+    }
+
+    size_t shown = std::min(breaks.size(), static_cast<size_t>(std::max(height, 0)));
+    truncated = shown < breaks.size();
+    lines = static_cast<int>(shown);
+
+    // Cut the last line back to make room for the ellipsis, without splitting a glyph
+    if (truncated && shown > 0) {
+        Line& last = breaks[shown - 1];
+        last.length = std::min(last.length, static_cast<size_t>(this->width - 1));
+        while (last.length > 0) {
+            size_t next = last.start + last.length;
+            if ((next == glyphs.size() || IsGlyphStart(glyphs[next])) && glyphs[next - 1] != u' ') {
+                break;
+            }
+            last.length--;
+        }
+    }
+
+    cells.assign(static_cast<size_t>(this->width) * lines, 0);
+    mask.assign(cells.size(), 0);
+    for (int y = 0; y < lines; y++) {
+        const Line& line = breaks[y];
+        bool ellipsis = truncated && y == lines - 1;
+        size_t length = std::min(line.length + (ellipsis ? 1 : 0), static_cast<size_t>(this->width));
+
+        size_t free = this->width - length;
+        size_t offset = align == TextAlign::Center ? free / 2 : align == TextAlign::Right ? free : 0;
+        Cell* row = &cells[static_cast<size_t>(y) * this->width + offset];
+        std::copy_n(&glyphs[line.start], std::min(line.length, length), row);
+        if (ellipsis) {
+            row[length - 1] = ELLIPSIS;
+        }
+        std::fill_n(&mask[static_cast<size_t>(y) * this->width + offset], length, static_cast<Cell>(0xFFFF));
+    }
+}
+
+void TextLayout::Wrap(size_t start, size_t end) {
+    if (width == 0) {
+        return;
+    }
+
+    // Greedy: take as much as fits, breaking at the last space that still fits or splitting a long word
+    size_t i = start;
+    do {
+        size_t cut = end;
+        if (end - i > static_cast<size_t>(width)) {
+            size_t limit = i + width; // The first cell that does not fit
+            cut = limit;
+            while (cut > i && glyphs[cut] != u' ') {
+                cut--;
+            }
+
+            if (cut == i) {
+                // No space to break at, split the word before the first glyph that does not fit
+                cut = limit;
+                while (cut > i && !IsGlyphStart(glyphs[cut])) {
+                    cut--;
+                }
+                if (cut == i) {
+                    cut = limit; // A glyph wider than the box, it is clipped
+                }
+            }
+        }
+
+        size_t length = cut - i;
+        while (length > 0 && glyphs[i + length - 1] == u' ') {
+            length--;
+        }
+        breaks.push_back({ i, length });
+
+        // The spaces the line broke at belong to neither line
+        i = cut;
+        while (i < end && glyphs[i] == u' ') {
+            i++;
+        }
+    } while (i < end);
+}
+
+SpriteView TextLayout::View() const {
+    return { cells.data(), mask.data(), width, lines, width };
+}
+
+TextLayoutCache::TextLayoutCache(size_t capacity) : capacity(std::max(capacity, size_t(1))) {
+    size_t size = 2;
+    while (size < this->capacity * 2) {
+        size *= 2;
+    }
+    table.assign(size, EMPTY);
+    tableMask = size - 1;
+    entries.reserve(this->capacity);
+}
+
+uint64_t TextLayoutCache::Key(std::string_view text, int width, int height, TextAlign align) {
+    // Eight bytes per multiply, every lookup hashes the whole text so byte at a time hashing was most of a hit
+    constexpr uint64_t MULTIPLIER = 0x9E3779B97F4A7C15ull;
+    auto mix = [](uint64_t hash, uint64_t value) {
+        hash = (hash ^ value) * MULTIPLIER;
+        return hash ^ (hash >> 29);
+    };
+
+    uint64_t hash = mix(text.size(), (static_cast<uint64_t>(width) << 32) | (static_cast<uint64_t>(height) << 2) | static_cast<uint64_t>(align));
+    size_t i = 0;
+    for (; i + 8 <= text.size(); i += 8) {
+        uint64_t word;
+        memcpy(&word, &text[i], sizeof(word));
+        hash = mix(hash, word);
+    }
+    if (i < text.size()) {
+        uint64_t word = 0;
+        memcpy(&word, &text[i], text.size() - i);
+        hash = mix(hash, word);
+    }
+    return hash;
+}
+
+size_t TextLayoutCache::Find(uint64_t key) const {
+    size_t slot = key & tableMask;
+    while (table[slot] != EMPTY && entries[table[slot]].key != key) {
+        slot = (slot + 1) & tableMask;
+    }
+    return slot;
+}
+
+void TextLayoutCache::Erase(size_t slot) {
+    table[slot] = EMPTY;
+    size_t next = slot;
+    while (true) {
+        next = (next + 1) & tableMask;
+        if (table[next] == EMPTY) {
+            return;
+        }
+
+        // Entries whose home slot is not between the gap and where they sit would no longer be found, move them
+        size_t home = entries[table[next]].key & tableMask;
+        bool reachable = slot <= next ? (home > slot && home <= next) : (home > slot || home <= next);
+        if (!reachable) {
+            table[slot] = table[next];
+            table[next] = EMPTY;
+            slot = next;
+        }
+    }
+}
+
+const TextLayout& TextLayoutCache::Get(std::string_view text, int width, int height, TextAlign align) {
+    uses++;
+    uint64_t key = Key(text, width, height, align);
+    size_t slot = Find(key);
+    if (table[slot] != EMPTY) {
+        Entry& entry = entries[table[slot]];
+        if (entry.text == text && entry.width == width && entry.height == height && entry.align == align) {
+            entry.lastUse = uses;
+            hits++;
+            return entry.layout;
+        }
+
+        // A different text with the same hash, it takes the entry over
+        Erase(slot);
+        slot = Find(key);
+    }
+    misses++;
+
+    size_t index;
+    if (entries.size() < capacity) {
+        index = entries.size();
+        entries.emplace_back();
+    } else {
+        index = 0;
+        for (size_t i = 1; i < entries.size(); i++) {
+            if (entries[i].lastUse < entries[index].lastUse) {
+                index = i;
+            }
+        }
+        Erase(Find(entries[index].key));
+        slot = Find(key);
+    }
+
+    Entry& entry = entries[index];
+    entry.key = key;
+    entry.text.assign(text);
+    entry.width = width;
+    entry.height = height;
+    entry.align = align;
+    entry.lastUse = uses;
+    entry.layout.Layout(text, width, height, align);
+    table[slot] = static_cast<uint32_t>(index);
+    return entry.layout;
+}
+
+void TextLayoutCache::Clear() {
+    entries.clear();
+    std::fill(table.begin(), table.end(), EMPTY);
+}
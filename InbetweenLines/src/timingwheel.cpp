@@ -0,0 +1,134 @@
+#include "timingwheel.h"
+
+#include <algorithm>
+
+using namespace IL;
+
+TimingWheel::TimingWheel() {
+    std::fill(std::begin(heads), std::end(heads), NIL);
+    std::fill(std::begin(tails), std::end(tails), NIL);
+}
+
+uint32_t TimingWheel::Find(TimerId id) const {
+    uint32_t index = static_cast<uint32_t>(id);
+    uint32_t generation = static_cast<uint32_t>(id >> 32);
+    if (index >= nodes.size() || !nodes[index].used || nodes[index].generation != generation) {
+        return NIL;
+    }
+    return index;
+}
+
+TimerId TimingWheel::Schedule(uint64_t delay, uint64_t payload) {
+    uint32_t node;
+    if (freeList != NIL) {
+        node = freeList;
+        freeList = nodes[node].next;
+    } else {
+        node = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+    }
+
+    Node& timer = nodes[node];
+    timer.deadline = now + (delay > 0 ? delay : 1);
+    timer.payload = payload;
+    timer.used = true;
+    Insert(node);
+    pending++;
+
+    return (static_cast<TimerId>(timer.generation) << 32) | node;
+}
+
+bool TimingWheel::Cancel(TimerId id) {
+    uint32_t node = Find(id);
+    if (node == NIL) {
+        return false;
+    }
+
+    Release(node);
+    return true;
+}
+
+uint64_t TimingWheel::GetDeadline(TimerId id) const {
+    uint32_t node = Find(id);
+    return node != NIL ? nodes[node].deadline : 0;
+}
+
+void TimingWheel::Clear() {
+    for (uint32_t node = 0; node < nodes.size(); node++) {
+        if (nodes[node].used) {
+            Release(node);
+        }
+    }
+}
+
+void TimingWheel::Insert(uint32_t node) {
+    Node& timer = nodes[node];
+    uint64_t delta = timer.deadline - now;
+
+    // The lowest level whose span covers the delay, slots are picked by the deadline's own bits so a slot comes
+    // round (and cascades) exactly when the block of ticks it holds begins
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (uint64_t(1) << ((level + 1) * SLOT_BITS))) {
+        level++;
+    }
+
+    // Beyond the wheel's reach, park in the top level and move down again once it comes round
+    uint64_t position = delta > MAX_DELAY ? now + MAX_DELAY : timer.deadline;
+    uint32_t slot = level * SLOTS + static_cast<uint32_t>((position >> (level * SLOT_BITS)) & (SLOTS - 1));
+
+    timer.slot = static_cast<uint16_t>(slot);
+    timer.previous = tails[slot];
+    timer.next = NIL;
+    if (tails[slot] != NIL) {
+        nodes[tails[slot]].next = node;
+    } else {
+        heads[slot] = node;
+    }
+    tails[slot] = node;
+}
+
+void TimingWheel::Unlink(uint32_t node) {
+    Node& timer = nodes[node];
+    if (timer.previous != NIL) {
+        nodes[timer.previous].next = timer.next;
+    } else {
+        heads[timer.slot] = timer.next;
+    }
+    if (timer.next != NIL) {
+        nodes[timer.next].previous = timer.previous;
+    } else {
+        tails[timer.slot] = timer.previous;
+    }
+}
+
+void TimingWheel::Release(uint32_t node) {
+    Unlink(node);
+
+    Node& timer = nodes[node];
+    timer.used = false;
+    timer.generation = timer.generation == UINT32_MAX ? 1 : timer.generation + 1;
+    timer.next = freeList;
+    freeList = node;
+    pending--;
+}
+
+void TimingWheel::Cascade() {
+    for (int level = 1; level < LEVELS; level++) {
+        // A level's slot comes round when every level below it has wrapped
+        uint64_t span = uint64_t(1) << (level * SLOT_BITS);
+        if ((now & (span - 1)) != 0) {
+            return;
+        }
+
+        // Re-inserting by deadline moves each timer down at least one level, keeping their order
+        uint32_t slot = level * SLOTS + static_cast<uint32_t>((now >> (level * SLOT_BITS)) & (SLOTS - 1));
+        uint32_t node = heads[slot];
+        heads[slot] = NIL;
+        tails[slot] = NIL;
+        while (node != NIL) {
+            uint32_t next = nodes[node].next;
+            Insert(node);
+            node = next;
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+"""Generates include/cellwidth_table.h, the two-stage cell width lookup used by cellwidth.h.
+
+Widths come from the Unicode database bundled with Python (unicodedata):
+  0 - combining marks, format and control characters (they do not take a cell)
+  2 - East Asian Wide and Fullwidth characters, which covers CJK and emoji presentation
+  1 - everything else
+
+Stage 1 maps each block of 256 code points to a stage 2 block, stage 2 stores the widths of
+the unique blocks packed as 2 bits per code point.
+
+Usage: python tools/gen_cellwidth.py > include/cellwidth_table.h
+"""
+
+import unicodedata
+
+BLOCK_SIZE = 256
+MAX_CODEPOINT = 0x110000
+
+
+def width(cp):
+    # Hangul Jamo medial vowels and final consonants combine with the leading consonant
+    if 0x1160 <= cp <= 0x11FF or 0xD7B0 <= cp <= 0xD7FF:
+        return 0
+
+    ch = chr(cp)
+    category = unicodedata.category(ch)
+    if category in ("Mn", "Me", "Cc", "Cf") and cp != 0x00AD:
+        return 0
+
+    if unicodedata.east_asian_width(ch) in ("W", "F"):
+        return 2
+
+    # Unassigned code points in the CJK planes default to wide
+    if category == "Cn" and (0x20000 <= cp <= 0x2FFFD or 0x30000 <= cp <= 0x3FFFD):
+        return 2
+
+    return 1
+
+
+def main():
+    stage1 = []
+    blocks = []
+    index = {}
+
+    for base in range(0, MAX_CODEPOINT, BLOCK_SIZE):
+        packed = bytearray(BLOCK_SIZE // 4)
+        for offset in range(BLOCK_SIZE):
+            packed[offset // 4] |= width(base + offset) << ((offset % 4) * 2)
+
+        key = bytes(packed)
+        if key not in index:
+            index[key] = len(blocks)
+            blocks.append(key)
+        stage1.append(index[key])
+
+    assert len(blocks) <= 256, "Stage 2 block indices no longer fit in a byte"
+
+    print("#pragma once")
+    print()
+    print("// Generated by tools/gen_cellwidth.py from Unicode {}, do not edit by hand".format(unicodedata.unidata_version))
+    print()
+    print("#include <cstdint>")
+    print()
+    print("namespace IL {")
+    print("    constexpr int CELL_WIDTH_BLOCK_SIZE = {};".format(BLOCK_SIZE))
+    print()
+    print("    /// @brief Stage 2 block index of every {} code points".format(BLOCK_SIZE))
+    print("    constexpr uint8_t CELL_WIDTH_STAGE1[{}] = {{".format(len(stage1)))
+    for i in range(0, len(stage1), 32):
+        print("        " + ", ".join(str(v) for v in stage1[i:i + 32]) + ",")
+    print("    };")
+    print()
+    print("    /// @brief Unique blocks of cell widths, 2 bits per code point")
+    print("    constexpr uint8_t CELL_WIDTH_STAGE2[{}] = {{".format(len(blocks) * BLOCK_SIZE // 4))
+    for block in blocks:
+        for i in range(0, len(block), 32):
+            print("        " + ", ".join("0x{:02X}".format(v) for v in block[i:i + 32]) + ",")
+    print("    };")
+    print("}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,323 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "console.h"
+#include "staging.h"
+
+// Drives the staging cache the way the launcher does, without notepad: a first launch, a relaunch with nothing
+// changed, a relaunch after a rebuild changed one file, a cache whose stages live on another filesystem so hard
+// links fail, garbage collection after several rebuilds, collection while another launch is still staging and a
+// stage collection could only partly remove. Every stage is compared byte for byte with the files it was staged from.
+//
+//   stagingbench [CACHE_DIR] [OTHER_FS_DIR]
+//
+// CACHE_DIR defaults to a directory under the temp directory, OTHER_FS_DIR to /dev/shm and has to be on another
+// filesystem than CACHE_DIR for the hard link fallback to be taken. What the bench writes to either is removed again.
+
+namespace fs = std::filesystem;
+
+constexpr size_t DLL_SIZE = 24 << 20;   // The injected DLL, by far the largest file
+constexpr size_t SMALL_FILES = 30;      // Intros, configs and the like, 4 KiB to 256 KiB
+constexpr size_t DUPLICATES = 2;        // Small files with the same contents as another, stored once
+constexpr size_t REBUILDS = 5;          // Stages made before garbage collection
+constexpr size_t STAGES_TO_KEEP = 3;
+
+using Clock = std::chrono::steady_clock;
+
+struct SourceFile {
+    fs::path path;
+    std::string contents; // What the file held when it was last staged
+};
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+bool writeFile(const fs::path& path, const std::string& contents) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    return static_cast<bool>(file);
+}
+
+bool readFile(const fs::path& path, std::string& contents) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+std::string randomBytes(std::mt19937_64& random, size_t size) {
+    std::string bytes(size, '\0');
+    for (size_t i = 0; i < size; i += sizeof(uint64_t)) {
+        uint64_t value = random();
+        std::memcpy(bytes.data() + i, &value, size - i < sizeof(value) ? size - i : sizeof(value));
+    }
+    return bytes;
+}
+
+// A rebuild: new contents of a different size, and a later write time in case the clock is coarse
+bool rewriteFile(SourceFile& file, std::mt19937_64& random) {
+    auto written = fs::last_write_time(file.path);
+    file.contents = randomBytes(random, file.contents.size() + 1 + random() % 4096);
+    if (!writeFile(file.path, file.contents)) {
+        return false;
+    }
+
+    std::error_code ec;
+    fs::last_write_time(file.path, written + std::chrono::seconds(1), ec);
+    return !ec;
+}
+
+std::vector<fs::path> pathsOf(const std::vector<SourceFile>& files) {
+    std::vector<fs::path> paths;
+    for (const SourceFile& file : files) {
+        paths.push_back(file.path);
+    }
+    return paths;
+}
+
+// Every source file is in the stage under its name with the same bytes, and nothing else is
+bool verifyStage(const fs::path& stage, const std::vector<SourceFile>& files, bool expectLinks) {
+    if (stage.empty()) {
+        ERROR("Staging failed");
+        return false;
+    }
+
+    size_t entries = 0;
+    std::error_code ec;
+    for (const auto& item : fs::directory_iterator(stage, ec)) {
+        (void)item;
+        entries++;
+    }
+    if (ec || entries != files.size()) {
+        ERROR("Stage " + stage.string() + " holds " + std::to_string(entries) + " files, expected " + std::to_string(files.size()));
+        return false;
+    }
+
+    std::string staged;
+    for (const SourceFile& file : files) {
+        fs::path target = stage / file.path.filename();
+        if (!readFile(target, staged) || staged != file.contents) {
+            ERROR("Staged " + target.string() + " differs from its source");
+            return false;
+        }
+
+        // Linked entries share the object's inode, copies have their own
+        bool linked = fs::hard_link_count(target, ec) > 1;
+        if (linked != expectLinks) {
+            ERROR("Staged " + target.string() + (expectLinks ? " was copied" : " was linked") + " unexpectedly");
+            return false;
+        }
+    }
+    return true;
+}
+
+void printStats(const char* name, double ms, const StagingStats& stats) {
+    std::printf("%-13s %8.2f ms  hashed %2zu, stored %2zu, linked %2zu, copied %2zu of %zu%s\n", name, ms, stats.hashed,
+        stats.stored, stats.linked, stats.copied, stats.files, stats.reused ? ", reused" : "");
+}
+
+bool expect(bool condition, const char* what) {
+    if (!condition) {
+        ERROR(what);
+    }
+    return condition;
+}
+
+int main(int argc, char** argv) {
+    fs::path cache = argc > 1 ? fs::path(argv[1]) : fs::temp_directory_path() / "InbetweenLinesStagingBench";
+    fs::path otherFs = argc > 2 ? fs::path(argv[2]) : fs::path("/dev/shm");
+
+    std::error_code ec;
+    fs::remove_all(cache, ec);
+    fs::path sourceDir = cache / "source";
+    fs::path root = cache / "cache";
+    if (!fs::create_directories(sourceDir, ec)) {
+        ERROR("Failed to create " + sourceDir.string() + ": " + ec.message());
+        return 1;
+    }
+
+    // A build's output directory
+    std::mt19937_64 random(33);
+    std::vector<SourceFile> files;
+    files.push_back({ sourceDir / "InbetweenLines.dll", randomBytes(random, DLL_SIZE) });
+    for (size_t i = 0; i < SMALL_FILES; i++) {
+        size_t size = 4096 + random() % (256 << 10);
+        // The last few repeat earlier files that no rebuild below changes
+        std::string contents = i >= SMALL_FILES - DUPLICATES ? files[1 + i - DUPLICATES].contents : randomBytes(random, size);
+        files.push_back({ sourceDir / ("asset" + std::to_string(i) + ".bin"), contents });
+    }
+    size_t totalBytes = 0;
+    for (const SourceFile& file : files) {
+        if (!writeFile(file.path, file.contents)) {
+            ERROR("Failed to write " + file.path.string());
+            return 1;
+        }
+        totalBytes += file.contents.size();
+    }
+    std::printf("%zu files, %.1f MiB, %zu with duplicate contents\n", files.size(), totalBytes / (1024.0 * 1024.0), DUPLICATES);
+
+    bool correct = true;
+    StagingStats stats;
+
+    // First launch: everything is hashed, stored once and linked into a new stage
+    Clock::time_point start = Clock::now();
+    fs::path cold = stageFiles(pathsOf(files), root, &stats);
+    double ms = elapsedMs(start);
+    printStats("cold", ms, stats);
+    std::printf("%-13s %8.0f MiB/s hashed and stored\n", "", totalBytes / (1024.0 * 1024.0) / (ms / 1000.0));
+    correct = verifyStage(cold, files, true) && correct;
+    correct = expect(stats.hashed == files.size() && stats.stored == files.size() - DUPLICATES &&
+        stats.linked == files.size() && !stats.reused, "Cold stage did the wrong work") && correct;
+
+    // Relaunch with nothing changed: the index spares every hash and the stage is handed out again
+    start = Clock::now();
+    fs::path warm = stageFiles(pathsOf(files), root, &stats);
+    printStats("warm", elapsedMs(start), stats);
+    correct = verifyStage(warm, files, true) && correct;
+    correct = expect(warm == cold && stats.reused && stats.hashed == 0, "Warm relaunch did not reuse the stage") && correct;
+
+    // A rebuild changed the DLL: only it is hashed and stored, the rest are linked to the objects they had
+    if (!rewriteFile(files[0], random)) {
+        ERROR("Failed to rewrite " + files[0].path.string());
+        return 1;
+    }
+    start = Clock::now();
+    fs::path changed = stageFiles(pathsOf(files), root, &stats);
+    printStats("one changed", elapsedMs(start), stats);
+    correct = verifyStage(changed, files, true) && correct;
+    correct = expect(changed != cold && !stats.reused && stats.hashed == 1 && stats.stored == 1,
+        "Changing one file did the wrong work") && correct;
+
+    // Stages on another filesystem than the objects cannot be hard links, they are copies
+    fs::path fallbackRoot = cache / "fallback";
+    fs::path fallbackStages = otherFs / "InbetweenLinesStagingBenchStages";
+    fs::remove_all(fallbackStages, ec);
+    fs::create_directories(fallbackRoot, ec);
+    fs::create_directories(fallbackStages, ec);
+    fs::create_directory_symlink(fallbackStages, fallbackRoot / "stages", ec);
+    if (ec) {
+        ERROR("Failed to put stages on " + otherFs.string() + ": " + ec.message());
+        correct = false;
+    } else {
+        start = Clock::now();
+        fs::path copied = stageFiles(pathsOf(files), fallbackRoot, &stats);
+        printStats("no hard links", elapsedMs(start), stats);
+        if (stats.copied == 0) {
+            ERROR(otherFs.string() + " is on the same filesystem as " + cache.string() + ", pass another directory");
+            correct = false;
+        } else {
+            correct = verifyStage(copied, files, false) && correct;
+            correct = expect(stats.linked == 0 && stats.copied == files.size(), "Fallback mixed links and copies") && correct;
+        }
+    }
+    fs::remove_all(fallbackStages, ec);
+
+    // Rebuilds, each changing one of the first small files, then only the newest stages and the objects they use are kept
+    std::vector<std::vector<SourceFile>> staged = { files };
+    std::vector<fs::path> stages = { changed };
+    for (size_t i = 0; i < REBUILDS; i++) {
+        if (!rewriteFile(files[1 + i % SMALL_FILES], random)) {
+            ERROR("Failed to rewrite a file");
+            return 1;
+        }
+        stages.push_back(stageFiles(pathsOf(files), root, &stats));
+        staged.push_back(files);
+        correct = verifyStage(stages.back(), files, true) && correct;
+    }
+
+    StagingStats collected;
+    start = Clock::now();
+    collectGarbage(root, stages.back(), STAGES_TO_KEEP, &collected, std::chrono::seconds(0));
+    std::printf("%-13s %8.2f ms  removed %zu stages and %zu objects\n", "collect", elapsedMs(start),
+        collected.removedStages, collected.removedObjects);
+
+    size_t remaining = 0;
+    for (const auto& item : fs::directory_iterator(root / "stages", ec)) {
+        remaining += item.is_directory() ? 1 : 0;
+    }
+    correct = expect(remaining == STAGES_TO_KEEP && collected.removedStages == stages.size() + 1 - STAGES_TO_KEEP,
+        "Garbage collection kept the wrong number of stages") && correct;
+
+    // The newest stages still hold their files, the older ones are gone
+    for (size_t i = 0; i < stages.size(); i++) {
+        bool kept = i + STAGES_TO_KEEP >= stages.size();
+        if (kept) {
+            correct = verifyStage(stages[i], staged[i], true) && correct;
+        } else {
+            correct = expect(!fs::exists(stages[i], ec), "Garbage collection kept an old stage") && correct;
+        }
+    }
+
+    // Objects: the newest files minus the duplicates, and the older version of each file changed since the oldest
+    // stage kept
+    size_t objects = 0;
+    for (const auto& item : fs::directory_iterator(root / "objects", ec)) {
+        (void)item;
+        objects++;
+    }
+    correct = expect(objects == files.size() - DUPLICATES + STAGES_TO_KEEP - 1,
+        "Garbage collection kept the wrong objects") && correct;
+
+    // Another launch still staging: its stage being built, its stage published before the manifest is written and an
+    // object it stored that no manifest refers to yet. All of them stay until they are older than the grace period.
+    fs::path building = root / "stages" / "concurrent.tmp1-1";
+    fs::path unpublished = root / "stages" / "concurrent";
+    fs::path fresh = root / "objects" / "0123456789abcdef-5";
+    fs::create_directories(building, ec);
+    fs::create_directories(unpublished, ec);
+    if (!writeFile(building / "asset.bin", "asset") || !writeFile(unpublished / "asset.bin", "asset") || !writeFile(fresh, "asset")) {
+        ERROR("Failed to write a concurrent launch's files");
+        return 1;
+    }
+
+    StagingStats concurrent;
+    collectGarbage(root, stages.back(), STAGES_TO_KEEP, &concurrent);
+    correct = expect(fs::exists(building, ec) && fs::exists(unpublished, ec) && fs::exists(fresh, ec) &&
+        concurrent.removedStages == 0 && concurrent.removedObjects == 0,
+        "Garbage collection removed the files of a launch still staging") && correct;
+
+    for (const fs::path& path : { building, unpublished, fresh }) {
+        fs::last_write_time(path, fs::file_time_type::clock::now() - 2 * STAGING_GRACE_PERIOD, ec);
+    }
+    collectGarbage(root, stages.back(), STAGES_TO_KEEP, &concurrent);
+    std::printf("%-13s %11s  removed %zu abandoned stages and %zu objects\n", "concurrent", "",
+        concurrent.removedStages, concurrent.removedObjects);
+    correct = expect(!fs::exists(building, ec) && !fs::exists(unpublished, ec) && !fs::exists(fresh, ec) &&
+        concurrent.removedStages == 2 && concurrent.removedObjects == 1,
+        "Garbage collection kept the files of an interrupted launch") && correct;
+    correct = verifyStage(stages.back(), files, true) && correct;
+
+    // A stage collection could only partly remove because its files were in use. Its manifest went first, so the
+    // next launch of the same files stages them again: under a temporary name while the leftover may still be in
+    // use, and under its own name once the leftover is old enough to replace.
+    fs::path manifest = stages.back();
+    manifest += ".manifest";
+    fs::remove(manifest, ec);
+    fs::remove(stages.back() / files[0].path.filename(), ec);
+    start = Clock::now();
+    fs::path aside = stageFiles(pathsOf(files), root, &stats);
+    printStats("partial", elapsedMs(start), stats);
+    correct = verifyStage(aside, files, true) && correct;
+    correct = expect(aside != stages.back() && !stats.reused, "A partly removed stage was reused") && correct;
+
+    fs::last_write_time(stages.back(), fs::file_time_type::clock::now() - 2 * STAGING_GRACE_PERIOD, ec);
+    start = Clock::now();
+    fs::path replaced = stageFiles(pathsOf(files), root, &stats);
+    printStats("partial, old", elapsedMs(start), stats);
+    correct = verifyStage(replaced, files, true) && correct;
+    correct = expect(replaced == stages.back() && !stats.reused, "A partly removed stage was not replaced") && correct;
+
+    fs::remove_all(cache, ec);
+    std::printf("stages %s\n", correct ? "match their sources byte for byte" : "are INCORRECT");
+    return correct ? 0 : 1;
+}
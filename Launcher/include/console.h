@@ -0,0 +1,17 @@
+#pragma once
+
+#include <iostream>
+
+// Windows.h defines ERROR as a constant
+#ifdef ERROR
+#undef ERROR
+#endif
+
+// Terminal color definitions
+#define GREEN_TEXT "\033[32m"
+#define RED_TEXT "\033[91m"
+#define RESET_TEXT "\033[0m"
+
+// Log helpers
+#define INFO(x) std::cout << GREEN_TEXT << "[+] " << x << RESET_TEXT << std::endl
+#define ERROR(x) std::cerr << RED_TEXT << "[!] " << x << " (" << __FUNCTION__ << " | " __FILE__ << ":" << __LINE__ << ")"  << RESET_TEXT << std::endl
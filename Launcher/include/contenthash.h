@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Streaming 64-bit content hash in the style of XXH3: eight 64-bit lanes are accumulated over 64 byte stripes,
+// using SSE2 where available, and scrambled every 1 KiB block. The result is not interoperable with xxHash, it
+// only names files in the staging cache.
+class ContentHasher {
+public:
+    /// @brief Feeds more bytes into the hash
+    void update(const void* data, size_t size);
+
+    /// @brief Returns the hash of everything fed so far, the hasher can keep being updated afterwards
+    uint64_t digest() const;
+
+    static constexpr size_t STRIPE_SIZE = 64;
+    static constexpr size_t STRIPES_PER_BLOCK = 16;
+    static constexpr size_t BLOCK_SIZE = STRIPE_SIZE * STRIPES_PER_BLOCK;
+
+private:
+    alignas(16) uint64_t acc[8] = {
+        0x00000000C2B2AE3Dull, 0x9E3779B185EBCA87ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull,
+        0x85EBCA77C2B2AE63ull, 0x0000000085EBCA77ull, 0x27D4EB2F165667C5ull, 0x000000009E3779B1ull,
+    };
+    alignas(16) unsigned char pending[BLOCK_SIZE];
+    size_t pendingSize = 0;
+    uint64_t totalSize = 0;
+};
+
+/// @brief Hashes a buffer in one call
+uint64_t hashBytes(const void* data, size_t size);
+
+/// @brief Hashes a file's contents
+/// @param path The file to hash
+/// @param outHash Receives the hash
+/// @return Whether the file could be read
+bool hashFile(const std::filesystem::path& path, uint64_t& outHash);
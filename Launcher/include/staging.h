@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+// Content addressed staging cache for the files the launcher hands to notepad.
+//
+//   <root>/objects/<hash>-<size>   One copy of each distinct file content
+//   <root>/stages/<id>/            The staged files by name, hard linked to their objects where possible
+//   <root>/stages/<id>.manifest    Hash, size and name of every staged file, written once the stage is complete
+//   <root>/index                   Size, write time and hash of source files, so unchanged files are not rehashed
+//
+// The stage id is derived from the manifest, so launching the same files again reuses the same directory.
+
+// Stage directories without a manifest and objects used more recently than this may belong to another launch that
+// is still staging, so collectGarbage leaves them alone
+constexpr std::chrono::seconds STAGING_GRACE_PERIOD(10 * 60);
+
+struct StagingStats {
+    size_t files = 0;          // Files staged
+    size_t hashed = 0;         // Files hashed because the index had no matching entry
+    size_t stored = 0;         // New objects copied into the store
+    size_t linked = 0;         // Stage entries hard linked to their object
+    size_t copied = 0;         // Stage entries copied because the filesystem refused a hard link
+    bool reused = false;       // The whole stage already existed
+    size_t removedStages = 0;  // Stages removed by collectGarbage
+    size_t removedObjects = 0; // Objects removed by collectGarbage
+};
+
+/// @brief Stages files into the cache, reusing stored objects and whole stages where the contents match
+/// @param files The files to stage, file names must be unique
+/// @param root The cache directory, created if missing
+/// @param stats Optional counters describing the work done
+/// @return The stage directory holding every file by its file name, or an empty path on failure
+std::filesystem::path stageFiles(const std::vector<std::filesystem::path>& files, const std::filesystem::path& root, StagingStats* stats = nullptr);
+
+/// @brief Removes old stages and the objects no remaining stage references, files still in use are skipped
+/// @param root The cache directory
+/// @param current The stage in use, never removed
+/// @param keepStages How many of the most recently used stages to keep, including current
+/// @param stats Optional counters describing the work done
+/// @param gracePeriod How long incomplete stages and unreferenced objects are left for a launch that may still be
+///                    staging them
+void collectGarbage(const std::filesystem::path& root, const std::filesystem::path& current, size_t keepStages = 3,
+    StagingStats* stats = nullptr, std::chrono::seconds gracePeriod = STAGING_GRACE_PERIOD);
@@ -0,0 +1,184 @@
+#include "contenthash.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define CONTENTHASH_SSE2 1
+#endif
+
+static constexpr uint64_t PRIME32_1 = 0x9E3779B1ull;
+static constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ull;
+static constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+static constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ull;
+static constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+
+// Each stripe of a block reads the secret 8 bytes further along, the scramble uses the last 64 bytes
+static constexpr size_t SECRET_SIZE = 192;
+
+struct Secret {
+    alignas(16) unsigned char bytes[SECRET_SIZE] = {};
+};
+
+static constexpr Secret makeSecret() {
+    // splitmix64, any fixed pseudo-random bytes will do
+    Secret secret;
+    uint64_t state = PRIME64_3;
+    for (size_t i = 0; i < SECRET_SIZE; i += 8) {
+        state += 0x9E3779B97F4A7C15ull;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        for (size_t b = 0; b < 8; b++) {
+            secret.bytes[i + b] = static_cast<unsigned char>(z >> (b * 8));
+        }
+    }
+    return secret;
+}
+
+static constexpr Secret SECRET = makeSecret();
+
+static_assert(ContentHasher::STRIPE_SIZE + (ContentHasher::STRIPES_PER_BLOCK - 1) * 8 <= SECRET_SIZE, "Secret too short for a block");
+
+static uint64_t read64(const unsigned char* p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value; // Little endian hosts only, like everything else here
+}
+
+static uint64_t rotl64(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// acc[i ^ 1] += data[i], acc[i] += lo32(data[i] ^ key[i]) * hi32(data[i] ^ key[i])
+static void accumulateStripe(uint64_t* acc, const unsigned char* data, const unsigned char* key) {
+#ifdef CONTENTHASH_SSE2
+    __m128i* lanes = reinterpret_cast<__m128i*>(acc);
+    for (int i = 0; i < 4; i++) {
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data) + i);
+        __m128i keyed = _mm_xor_si128(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(key) + i));
+        __m128i product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+        __m128i swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+        lanes[i] = _mm_add_epi64(_mm_add_epi64(lanes[i], swapped), product);
+    }
+#else
+    for (int i = 0; i < 8; i++) {
+        uint64_t value = read64(data + i * 8);
+        uint64_t keyed = value ^ read64(key + i * 8);
+        acc[i ^ 1] += value;
+        acc[i] += (keyed & 0xFFFFFFFFull) * (keyed >> 32);
+    }
+#endif
+}
+
+static void scramble(uint64_t* acc) {
+    const unsigned char* key = SECRET.bytes + SECRET_SIZE - ContentHasher::STRIPE_SIZE;
+    for (int i = 0; i < 8; i++) {
+        uint64_t lane = acc[i];
+        lane ^= lane >> 47;
+        lane ^= read64(key + i * 8);
+        acc[i] = lane * PRIME32_1;
+    }
+}
+
+static void accumulateBlock(uint64_t* acc, const unsigned char* block) {
+    for (size_t s = 0; s < ContentHasher::STRIPES_PER_BLOCK; s++) {
+        accumulateStripe(acc, block + s * ContentHasher::STRIPE_SIZE, SECRET.bytes + s * 8);
+    }
+    scramble(acc);
+}
+
+void ContentHasher::update(const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    totalSize += size;
+
+    // Top up a partial block first
+    if (pendingSize > 0) {
+        size_t take = size < BLOCK_SIZE - pendingSize ? size : BLOCK_SIZE - pendingSize;
+        memcpy(pending + pendingSize, bytes, take);
+        pendingSize += take;
+        bytes += take;
+        size -= take;
+        if (pendingSize < BLOCK_SIZE) {
+            return;
+        }
+        accumulateBlock(acc, pending);
+        pendingSize = 0;
+    }
+
+    // Whole blocks straight from the caller's buffer
+    while (size >= BLOCK_SIZE) {
+        accumulateBlock(acc, bytes);
+        bytes += BLOCK_SIZE;
+        size -= BLOCK_SIZE;
+    }
+
+    memcpy(pending, bytes, size);
+    pendingSize = size;
+}
+
+uint64_t ContentHasher::digest() const {
+    alignas(16) uint64_t lanes[8];
+    memcpy(lanes, acc, sizeof(lanes));
+
+    // The tail of the last block, a partial stripe is zero padded and told apart by the length below
+    size_t stripes = (pendingSize + STRIPE_SIZE - 1) / STRIPE_SIZE;
+    for (size_t s = 0; s < stripes; s++) {
+        alignas(16) unsigned char stripe[STRIPE_SIZE] = {};
+        size_t offset = s * STRIPE_SIZE;
+        size_t count = pendingSize - offset < STRIPE_SIZE ? pendingSize - offset : STRIPE_SIZE;
+        memcpy(stripe, pending + offset, count);
+        accumulateStripe(lanes, stripe, SECRET.bytes + s * 8);
+    }
+
+    // Fold the lanes together with XXH64 style rounds and avalanche
+    uint64_t hash = totalSize * PRIME64_1;
+    for (int i = 0; i < 8; i++) {
+        uint64_t lane = lanes[i] ^ read64(SECRET.bytes + 11 + i * 8);
+        lane = rotl64(lane * PRIME64_2, 31) * PRIME64_1;
+        hash = rotl64(hash ^ lane, 27) * PRIME64_1 + PRIME64_4;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+uint64_t hashBytes(const void* data, size_t size) {
+    ContentHasher hasher;
+    hasher.update(data, size);
+    return hasher.digest();
+}
+
+bool hashFile(const std::filesystem::path& path, uint64_t& outHash) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    // One buffer per thread, files are hashed in parallel
+    static thread_local std::vector<char> buffer(1 << 20);
+
+    ContentHasher hasher;
+    while (file) {
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        std::streamsize got = file.gcount();
+        if (got <= 0) {
+            break;
+        }
+        hasher.update(buffer.data(), static_cast<size_t>(got));
+    }
+
+    if (file.bad()) {
+        return false;
+    }
+
+    outHash = hasher.digest();
+    return true;
+}
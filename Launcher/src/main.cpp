@@ -1,7 +1,6 @@
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
 #include <TlHelp32.h>
-#undef ERROR
 
 #include <algorithm>
 #include <filesystem>
@@ -11,14 +10,8 @@
 #include <chrono>
 #include <vector>
 
-// Terminal color definitions
-#define GREEN_TEXT "\033[32m"
-#define RED_TEXT "\033[91m"
-#define RESET_TEXT "\033[0m"
-
-// Log helpers
-#define INFO(x) std::cout << GREEN_TEXT << "[+] " << x << RESET_TEXT << std::endl
-#define ERROR(x) std::cerr << RED_TEXT << "[!] " << x << " (" << __FUNCTION__ << " | " __FILE__ << ":" << __LINE__ << ")"  << RESET_TEXT << std::endl
+#include "console.h"
+#include "staging.h"
 
 namespace fs = std::filesystem;
 
@@ -26,6 +19,8 @@ namespace fs = std::filesystem;
 constexpr const char* TARGET_PROCESS = "notepad.exe";
 constexpr const char* TARGET_PATH = "C:\\Windows\\System32\\notepad.exe";
 constexpr int PROCESS_STARTUP_DELAY_MS = 200;
+constexpr const char* STAGING_DIRECTORY = "InbetweenLines";
+constexpr size_t STAGES_TO_KEEP = 3;
 
 // Function declarations
 std::vector<fs::path> findFiles();
@@ -34,8 +29,9 @@ DWORD findOrStartProcess(const std::string_view& processName, const std::string_
 bool injectDll(DWORD pid, const fs::path& dllPath);
 bool isDllInjected(DWORD pid, const fs::path& dllPath, MODULEENTRY32* outModule = nullptr);
 bool unloadDll(DWORD pid, MODULEENTRY32& module);
-fs::path getTempDirectory();
-fs::path copyFilesToTemp(const std::vector<fs::path>& files);
+fs::path getStagingRoot();
+fs::path stageFilesToTemp(const std::vector<fs::path>& files);
+void removeLegacyTempDirectories();
 fs::path getTempFilePath(const fs::path& tempDir, const fs::path& file);
 
 int main(void) {
@@ -67,10 +63,10 @@ int main(void) {
     // Give process time to initialize
     std::this_thread::sleep_for(std::chrono::milliseconds(PROCESS_STARTUP_DELAY_MS));
 
-    // Create temp directory and copy all files
-    fs::path tempDir = copyFilesToTemp(files);
+    // Stage the files in the temp directory, unchanged files from earlier launches are reused
+    fs::path tempDir = stageFilesToTemp(files);
     if (tempDir.empty()) {
-        ERROR("Failed to copy files to temp directory");
+        ERROR("Failed to stage files in temp directory");
         return 1;
     }
 
@@ -98,6 +94,14 @@ int main(void) {
         return 1;
     }
 
+    // Stages from earlier launches are only collected now, after the old DLL was unloaded
+    StagingStats stats;
+    collectGarbage(getStagingRoot(), tempDir, STAGES_TO_KEEP, &stats);
+    removeLegacyTempDirectories();
+    if (stats.removedStages > 0 || stats.removedObjects > 0) {
+        INFO("Removed " + std::to_string(stats.removedStages) + " old stages and " + std::to_string(stats.removedObjects) + " unused files");
+    }
+
     // No need to keep the launcher running anymore - hook is managed by the DLL
     return 0;
 }
@@ -139,59 +143,48 @@ fs::path findDllToInject(const std::vector<fs::path>& files) {
     return {};
 }
 
-fs::path getTempDirectory() {
-    fs::path tempBase = fs::temp_directory_path();
-    
-    // Create a unique directory name using timestamp
-    auto now = std::chrono::system_clock::now();
-    auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()).count();
-    
-    fs::path tempDir = tempBase / ("InbetweenLines_" + std::to_string(timestamp));
-    
-    try {
-        // Create the directory if it doesn't exist
-        if (!fs::exists(tempDir)) {
-            fs::create_directory(tempDir);
-        }
-    } catch (const fs::filesystem_error& e) {
-        ERROR("Failed to create temp directory: " + std::string(e.what()));
-        return {};
-    }
-    
-    return tempDir;
+fs::path getStagingRoot() {
+    return fs::temp_directory_path() / STAGING_DIRECTORY;
 }
 
-fs::path copyFilesToTemp(const std::vector<fs::path>& files) {
+fs::path stageFilesToTemp(const std::vector<fs::path>& files) {
     if (files.empty()) {
-        ERROR("No files to copy");
+        ERROR("No files to stage");
         return {};
     }
-    
-    fs::path tempDir = getTempDirectory();
-    if (tempDir.empty()) {
+
+    StagingStats stats;
+    fs::path stageDir = stageFiles(files, getStagingRoot(), &stats);
+    if (stageDir.empty()) {
         return {};
     }
-    
-    INFO("Created temp directory: " + tempDir.string());
-    
-    int copyCount = 0;
-    for (const auto& file : files) {
-        try {
-            fs::path destPath = tempDir / file.filename();
-            
-            // Copy the file to the temp directory
-            fs::copy_file(file, destPath, fs::copy_options::overwrite_existing);
-            copyCount++;
-            
-        } catch (const fs::filesystem_error& e) {
-            ERROR("Failed to copy file " + file.filename().string() + ": " + std::string(e.what()));
+
+    if (stats.reused) {
+        INFO("Reusing staged files in: " + stageDir.string());
+    } else {
+        INFO("Staged files in: " + stageDir.string());
+        INFO("Hashed " + std::to_string(stats.hashed) + ", stored " + std::to_string(stats.stored) + ", linked " +
+            std::to_string(stats.linked) + " and copied " + std::to_string(stats.copied) + " of " + std::to_string(stats.files) + " files");
+    }
+
+    return stageDir;
+}
+
+void removeLegacyTempDirectories() {
+    // Older launchers copied everything into a new InbetweenLines_<milliseconds> directory on every launch
+    std::string prefix = std::string(STAGING_DIRECTORY) + "_";
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(fs::temp_directory_path(), ec)) {
+        std::string name = entry.path().filename().string();
+        if (!entry.is_directory(ec) || name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+
+        if (std::all_of(name.begin() + prefix.size(), name.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            std::error_code removeEc;
+            fs::remove_all(entry.path(), removeEc);
         }
     }
-    
-    INFO("Copied " + std::to_string(copyCount) + " files to temp directory");
-    
-    return tempDir;
 }
 
 fs::path getTempFilePath(const fs::path& tempDir, const fs::path& file) {
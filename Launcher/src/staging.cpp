@@ -0,0 +1,416 @@
+#include "staging.h"
+#include "contenthash.h"
+#include "console.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace {
+    struct Entry {
+        fs::path source;
+        uint64_t size = 0;
+        int64_t writeTime = 0;
+        uint64_t hash = 0;
+    };
+
+    struct IndexRecord {
+        uint64_t size;
+        int64_t writeTime;
+        uint64_t hash;
+    };
+
+    // Runs fn(i) for every i below count on a few worker threads
+    template<typename Fn>
+    void parallelFor(size_t count, Fn fn) {
+        size_t workers = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count);
+        if (workers <= 1) {
+            for (size_t i = 0; i < count; i++) {
+                fn(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next = 0;
+        std::vector<std::thread> threads;
+        threads.reserve(workers);
+        for (size_t w = 0; w < workers; w++) {
+            threads.emplace_back([&]() {
+                for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+                    fn(i);
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // Paths are kept as UTF-8 in the index and manifests
+    std::string toUtf8(const fs::path& path) {
+        auto text = path.u8string();
+        return std::string(text.begin(), text.end());
+    }
+
+    std::string toHex(uint64_t value) {
+        char text[17];
+        snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+        return text;
+    }
+
+    std::string objectName(const Entry& entry) {
+        return toHex(entry.hash) + "-" + std::to_string(entry.size);
+    }
+
+    // Suffix for temporary names, so an interrupted or concurrent launch never sees half written files
+    std::string uniqueSuffix() {
+        auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+        return ".tmp" + std::to_string(now) + "-" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    }
+
+    std::unordered_map<std::string, IndexRecord> loadIndex(const fs::path& path) {
+        std::unordered_map<std::string, IndexRecord> index;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream fields(line);
+            IndexRecord record = {};
+            std::string hash;
+            fields >> record.size >> record.writeTime >> hash;
+            if (!fields || hash.size() != 16) {
+                continue;
+            }
+            record.hash = std::stoull(hash, nullptr, 16);
+
+            std::string source;
+            fields.get();
+            std::getline(fields, source);
+            index[source] = record;
+        }
+        return index;
+    }
+
+    void saveIndex(const fs::path& path, const std::vector<Entry>& entries) {
+        fs::path temp = path;
+        temp += uniqueSuffix();
+        {
+            std::ofstream file(temp, std::ios::trunc);
+            for (const Entry& entry : entries) {
+                file << entry.size << ' ' << entry.writeTime << ' ' << toHex(entry.hash) << ' ' << toUtf8(entry.source) << '\n';
+            }
+        }
+
+        std::error_code ec;
+        fs::rename(temp, path, ec);
+        if (ec) {
+            fs::remove(temp, ec);
+        }
+    }
+
+    std::string makeManifest(const std::vector<Entry>& entries) {
+        std::string manifest;
+        for (const Entry& entry : entries) {
+            manifest += objectName(entry);
+            manifest += ' ';
+            manifest += toUtf8(entry.source.filename());
+            manifest += '\n';
+        }
+        return manifest;
+    }
+
+    // Whether path was last written within age, which also holds for a path that cannot be read
+    bool isRecent(const fs::path& path, std::chrono::seconds age) {
+        std::error_code ec;
+        auto written = fs::last_write_time(path, ec);
+        return ec || fs::file_time_type::clock::now() - written < age;
+    }
+
+    // Marks a file as used now, so collectGarbage spares it while the launch using it finishes
+    void touch(const fs::path& path) {
+        std::error_code ec;
+        fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    }
+
+    bool writeFile(const fs::path& path, const std::string& contents) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        return static_cast<bool>(file);
+    }
+
+    // Copies the source into the store under a temporary name first, so objects are only ever complete. Stored and
+    // reused objects alike are marked as used, since no manifest refers to them until the stage is published.
+    bool storeObject(const Entry& entry, const fs::path& object) {
+        std::error_code ec;
+        if (fs::exists(object, ec)) {
+            touch(object);
+            return true;
+        }
+
+        fs::path temp = object;
+        temp += uniqueSuffix();
+        if (!fs::copy_file(entry.source, temp, fs::copy_options::overwrite_existing, ec)) {
+            ERROR("Failed to store " + entry.source.filename().string() + ": " + ec.message());
+            return false;
+        }
+
+        touch(temp);
+        fs::rename(temp, object, ec);
+        if (ec) {
+            fs::remove(temp, ec);
+            return fs::exists(object, ec);
+        }
+        return true;
+    }
+}
+
+fs::path stageFiles(const std::vector<fs::path>& files, const fs::path& root, StagingStats* stats) {
+    StagingStats local;
+    StagingStats& counters = stats != nullptr ? *stats : local;
+    counters = {};
+
+    fs::path objects = root / "objects";
+    fs::path stages = root / "stages";
+    std::error_code ec;
+    fs::create_directories(objects, ec);
+    fs::create_directories(stages, ec);
+    if (ec) {
+        ERROR("Failed to create staging cache: " + ec.message());
+        return {};
+    }
+
+    // Sort by name so the manifest, and with it the stage id, does not depend on directory order
+    std::vector<Entry> entries(files.size());
+    for (size_t i = 0; i < files.size(); i++) {
+        entries[i].source = files[i];
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.source.filename() < b.source.filename();
+    });
+    counters.files = entries.size();
+
+    // Files whose size and write time match the index keep their old hash, the rest are hashed in parallel
+    auto index = loadIndex(root / "index");
+    std::vector<size_t> toHash;
+    for (size_t i = 0; i < entries.size(); i++) {
+        Entry& entry = entries[i];
+        entry.size = fs::file_size(entry.source, ec);
+        if (ec) {
+            ERROR("Failed to stat " + entry.source.string() + ": " + ec.message());
+            return {};
+        }
+        entry.writeTime = fs::last_write_time(entry.source, ec).time_since_epoch().count();
+
+        auto it = index.find(toUtf8(entry.source));
+        if (it != index.end() && it->second.size == entry.size && it->second.writeTime == entry.writeTime) {
+            entry.hash = it->second.hash;
+        } else {
+            toHash.push_back(i);
+        }
+    }
+
+    std::atomic<bool> failed = false;
+    parallelFor(toHash.size(), [&](size_t i) {
+        Entry& entry = entries[toHash[i]];
+        if (!hashFile(entry.source, entry.hash)) {
+            ERROR("Failed to hash " + entry.source.string());
+            failed = true;
+        }
+    });
+    if (failed) {
+        return {};
+    }
+    counters.hashed = toHash.size();
+    saveIndex(root / "index", entries);
+
+    std::string manifest = makeManifest(entries);
+    std::string id = toHex(hashBytes(manifest.data(), manifest.size()));
+    fs::path stage = stages / id;
+    fs::path manifestPath = stages / (id + ".manifest");
+
+    // A complete stage with the same contents already exists, mark it as used and hand it out again
+    if (fs::exists(manifestPath, ec) && fs::is_directory(stage, ec)) {
+        fs::last_write_time(manifestPath, fs::file_time_type::clock::now(), ec);
+        counters.reused = true;
+        return stage;
+    }
+
+    // Store each distinct content once
+    std::vector<size_t> unique;
+    std::unordered_set<std::string> seen;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (seen.insert(objectName(entries[i])).second) {
+            unique.push_back(i);
+        }
+    }
+
+    std::atomic<size_t> stored = 0;
+    parallelFor(unique.size(), [&](size_t i) {
+        const Entry& entry = entries[unique[i]];
+        fs::path object = objects / objectName(entry);
+        std::error_code existsEc;
+        bool existed = fs::exists(object, existsEc);
+        if (!storeObject(entry, object)) {
+            failed = true;
+        } else if (!existed) {
+            stored++;
+        }
+    });
+    if (failed) {
+        return {};
+    }
+    counters.stored = stored;
+
+    // A directory without a manifest is incomplete: another launch about to write its manifest, or a stage
+    // collectGarbage could only partly remove. Only the latter is replaced here, and only if nothing holds it open.
+    if (!isRecent(stage, STAGING_GRACE_PERIOD)) {
+        fs::remove_all(stage, ec);
+    }
+
+    // Build the stage under a temporary name, hard links cost no space and no copy when the filesystem allows them
+    fs::path temp = stages / (id + uniqueSuffix());
+    fs::create_directory(temp, ec);
+    if (ec) {
+        ERROR("Failed to create stage directory: " + ec.message());
+        return {};
+    }
+
+    std::atomic<size_t> linked = 0;
+    std::atomic<size_t> copied = 0;
+    parallelFor(entries.size(), [&](size_t i) {
+        const Entry& entry = entries[i];
+        fs::path object = objects / objectName(entry);
+        fs::path target = temp / entry.source.filename();
+
+        std::error_code linkEc;
+        fs::create_hard_link(object, target, linkEc);
+        if (!linkEc) {
+            linked++;
+            return;
+        }
+
+        if (fs::copy_file(object, target, fs::copy_options::overwrite_existing, linkEc)) {
+            copied++;
+        } else {
+            ERROR("Failed to stage " + entry.source.filename().string() + ": " + linkEc.message());
+            failed = true;
+        }
+    });
+    counters.linked = linked;
+    counters.copied = copied;
+
+    if (failed) {
+        fs::remove_all(temp, ec);
+        return {};
+    }
+
+    // With the directory still taken, the complete stage is handed out under its temporary name instead
+    fs::rename(temp, stage, ec);
+    if (ec) {
+        stage = temp;
+        manifestPath = temp;
+        manifestPath += ".manifest";
+    }
+
+    if (!writeFile(manifestPath, manifest)) {
+        ERROR("Failed to write stage manifest");
+        return {};
+    }
+
+    return stage;
+}
+
+void collectGarbage(const fs::path& root, const fs::path& current, size_t keepStages, StagingStats* stats, std::chrono::seconds gracePeriod) {
+    fs::path stages = root / "stages";
+    fs::path objects = root / "objects";
+    std::error_code ec;
+
+    // Stages by last use, newest first. Directories without a manifest are leftovers of interrupted launches once
+    // they are older than the grace period, until then they may be stages another launch is still building.
+    struct Stage {
+        fs::path directory;
+        fs::file_time_type used;
+    };
+    std::vector<Stage> complete;
+    std::vector<fs::path> abandoned;
+    for (const auto& item : fs::directory_iterator(stages, ec)) {
+        if (!item.is_directory(ec)) {
+            continue;
+        }
+
+        fs::path manifest = item.path();
+        manifest += ".manifest";
+        auto used = fs::last_write_time(manifest, ec);
+        if (!ec) {
+            complete.push_back({ item.path(), used });
+        } else if (!isRecent(item.path(), gracePeriod)) {
+            abandoned.push_back(item.path());
+        }
+    }
+
+    std::sort(complete.begin(), complete.end(), [](const Stage& a, const Stage& b) {
+        return a.used > b.used;
+    });
+
+    // The current stage always counts towards the stages kept. The manifest of an old stage goes first, so a stage
+    // only partly removed is never reused as if it were complete, and it is kept if another launch reused it since.
+    size_t kept = 1;
+    for (const Stage& stage : complete) {
+        if (stage.directory == current) {
+            continue;
+        }
+
+        if (kept < keepStages) {
+            kept++;
+            continue;
+        }
+
+        fs::path manifest = stage.directory;
+        manifest += ".manifest";
+        if (fs::last_write_time(manifest, ec) == stage.used && !ec && fs::remove(manifest, ec)) {
+            abandoned.push_back(stage.directory);
+        }
+    }
+
+    // A stage whose DLL is still loaded somewhere keeps the files in use, and its objects through their hard links
+    for (const fs::path& directory : abandoned) {
+        fs::remove_all(directory, ec);
+        if (!ec && stats != nullptr) {
+            stats->removedStages++;
+        }
+    }
+
+    // Objects no remaining manifest refers to
+    std::unordered_set<std::string> referenced;
+    for (const auto& item : fs::directory_iterator(stages, ec)) {
+        if (item.path().extension() != ".manifest") {
+            continue;
+        }
+
+        std::ifstream file(item.path());
+        std::string line;
+        while (std::getline(file, line)) {
+            referenced.insert(line.substr(0, line.find(' ')));
+        }
+    }
+
+    // Objects and temporary copies used within the grace period may be part of a stage not published yet
+    for (const auto& item : fs::directory_iterator(objects, ec)) {
+        if (referenced.count(item.path().filename().string()) > 0 || isRecent(item.path(), gracePeriod)) {
+            continue;
+        }
+
+        std::error_code removeEc;
+        if (fs::remove(item.path(), removeEc) && stats != nullptr) {
+            stats->removedObjects++;
+        }
+    }
+}